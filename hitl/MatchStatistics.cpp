@@ -0,0 +1,45 @@
+#include "MatchStatistics.h"
+
+MatchStatistics::MatchStatistics(const b2Body* robot, const b2Body* opponent)
+    : robot(robot)
+    , opponent(opponent)
+    , last_position(robot->GetPosition())
+{
+}
+
+void MatchStatistics::BeginContact(b2Contact* contact)
+{
+    const b2Body* a = contact->GetFixtureA()->GetBody();
+    const b2Body* b = contact->GetFixtureB()->GetBody();
+
+    if (a != robot && b != robot) {
+        return;
+    }
+
+    const b2Body* other = a == robot ? b : a;
+    if (other == opponent) {
+        opponent_collisions++;
+        collisions++;
+    } else if (other->GetType() == b2_staticBody) {
+        collisions++;
+    }
+}
+
+void MatchStatistics::update()
+{
+    b2Vec2 position = robot->GetPosition();
+    path_length += (position - last_position).Length();
+    last_position = position;
+}
+
+void MatchStatistics::write_json(std::ostream& out, float match_time) const
+{
+    out << "{\n";
+    out << "  \"match_time_s\": " << match_time << ",\n";
+    out << "  \"path_length_m\": " << path_length << ",\n";
+    out << "  \"collisions\": " << collisions << ",\n";
+    out << "  \"opponent_collisions\": " << opponent_collisions << ",\n";
+    out << "  \"final_x_m\": " << last_position.x << ",\n";
+    out << "  \"final_y_m\": " << last_position.y << "\n";
+    out << "}\n";
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <ostream>
+#include <box2d/box2d.h>
+
+/** Collects statistics about the simulated robot during a match.
+ *
+ * It must be registered as the contact listener of the world to count
+ * collisions. Contacts with movable game elements are part of the game and are
+ * not counted, only the ones with the borders and the opponent are.
+ */
+class MatchStatistics : public b2ContactListener {
+    const b2Body* robot;
+    const b2Body* opponent;
+
+    b2Vec2 last_position;
+    float path_length = 0.f;
+    int collisions = 0;
+    int opponent_collisions = 0;
+
+public:
+    MatchStatistics(const b2Body* robot, const b2Body* opponent);
+
+    void BeginContact(b2Contact* contact) override;
+
+    /** Must be called after each world step. */
+    void update();
+
+    float get_path_length() const
+    {
+        return path_length;
+    }
+
+    int get_collisions() const
+    {
+        return collisions;
+    }
+
+    int get_opponent_collisions() const
+    {
+        return opponent_collisions;
+    }
+
+    /** Writes the statistics as a flat JSON object. */
+    void write_json(std::ostream& out, float match_time) const;
+};
@@ -22,4 +22,9 @@ public:
     {
         robotBody->SetTransform(pos, 0.f);
     }
+
+    const b2Body* GetBody() const
+    {
+        return robotBody;
+    }
 };
@@ -0,0 +1,45 @@
+#include <sstream>
+#include <string>
+#include "OpponentScript.h"
+
+bool OpponentScript::load(std::istream& input)
+{
+    std::string line;
+    while (std::getline(input, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        float time, x, y;
+        char sep1, sep2;
+        if (!(fields >> time >> sep1 >> x >> sep2 >> y) || sep1 != ',' || sep2 != ',') {
+            return false;
+        }
+        add_waypoint(time, {x, y});
+    }
+    return true;
+}
+
+void OpponentScript::add_waypoint(float time, b2Vec2 position)
+{
+    waypoints.push_back({time, position});
+}
+
+b2Vec2 OpponentScript::position_at(float time) const
+{
+    if (time <= waypoints.front().time) {
+        return waypoints.front().position;
+    }
+
+    for (size_t i = 1; i < waypoints.size(); i++) {
+        const auto& a = waypoints[i - 1];
+        const auto& b = waypoints[i];
+        if (time < b.time) {
+            float t = (time - a.time) / (b.time - a.time);
+            return a.position + t * (b.position - a.position);
+        }
+    }
+
+    return waypoints.back().position;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <istream>
+#include <vector>
+#include <box2d/box2d.h>
+
+/** Trajectory of the opponent robot, as waypoints in time.
+ *
+ * The opponent moves in a straight line between waypoints, stays at the first
+ * one before it and at the last one after it.
+ */
+class OpponentScript {
+public:
+    struct Waypoint {
+        float time; // [s]
+        b2Vec2 position; // [m]
+    };
+
+    /** Reads waypoints from a CSV with one "time,x,y" line per waypoint, in
+     * increasing time. Empty lines and lines starting with # are ignored.
+     *
+     * @returns false if a line could not be parsed.
+     */
+    bool load(std::istream& input);
+
+    void add_waypoint(float time, b2Vec2 position);
+
+    bool empty() const
+    {
+        return waypoints.empty();
+    }
+
+    b2Vec2 position_at(float time) const;
+
+private:
+    std::vector<Waypoint> waypoints;
+};
@@ -29,4 +29,14 @@ public:
     {
         return robotBody->GetAngle();
     }
+
+    float GetAngularVelocity() const
+    {
+        return robotBody->GetAngularVelocity();
+    }
+
+    const b2Body* GetBody() const
+    {
+        return robotBody;
+    }
 };
@@ -6,14 +6,18 @@ constexpr float reflector_diameter = 0.08f;
 // TODO: Calibrate this
 constexpr float min_detection_distance = 1.5f;
 
-ProximityBeaconEmulator::ProximityBeaconEmulator(std::string can_iface, std::string board_name, int node_number)
-    : driver(clock)
+ProximityBeaconEmulator::ProximityBeaconEmulator(std::string can_iface, std::string board_name, int node_number,
+                                                 virtual_clock_t* virtual_clock)
 {
+    /* Must be set before the node and its timers read the clock */
+    clock.use_virtual_clock(virtual_clock);
+
     NOTICE("Proximity beacon emulator on %s", can_iface.c_str());
-    if (driver.addIface(can_iface) < 0) {
+    driver = can_driver_open(can_iface, clock);
+    if (!driver) {
         ERROR("Failed to add iface %s", can_iface.c_str());
     }
-    node = std::make_unique<Node>(driver, clock);
+    node = std::make_unique<Node>(*driver, clock);
     node->setHealthOk();
     node->setModeOperational();
     if (!node->setNodeID(node_number)) {
@@ -36,6 +40,9 @@ ProximityBeaconEmulator::ProximityBeaconEmulator(std::string can_iface, std::str
                 distance = delta.Length();
                 angle = atan2f(delta.y, delta.x);
                 msg.start_angle = angle - robot_heading;
+                if (angle_noise_stddev > 0.f) {
+                    msg.start_angle += angle_noise_stddev * normal(rng);
+                }
             }
 
             if (distance < min_detection_distance) {
@@ -62,3 +69,16 @@ void ProximityBeaconEmulator::spin()
         }
     }
 }
+
+void ProximityBeaconEmulator::start_lockstep()
+{
+    node->start();
+}
+
+void ProximityBeaconEmulator::spin_once()
+{
+    const int res = node->spinOnce();
+    if (res < 0) {
+        WARNING("UAVCAN failure: %d", res);
+    }
+}
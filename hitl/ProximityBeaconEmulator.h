@@ -1,15 +1,19 @@
 #pragma once
 
 #include <uavcan_linux/uavcan_linux.hpp>
+#include <virtual_clock/uavcan_clock.hpp>
+#include <can_bus_shm/can_driver.hpp>
 #include "uavcan_node.h"
 #include <thread>
+#include <memory>
+#include <random>
 #include <cvra/proximity_beacon/Signal.hpp>
 #include <absl/synchronization/mutex.h>
 #include <box2d/box2d.h>
 
 class ProximityBeaconEmulator {
-    uavcan_linux::SystemClock clock;
-    uavcan_linux::SocketCanDriver driver;
+    VirtualUavcanClock clock;
+    std::unique_ptr<uavcan::ICanDriver> driver;
     std::unique_ptr<Node> node;
     std::thread can_thread;
     std::unique_ptr<uavcan::Timer> publish_timer;
@@ -19,15 +23,36 @@ class ProximityBeaconEmulator {
     b2Vec2 opponent_pos;
     float robot_heading;
 
+    /* Measurement noise, seeded so that simulations are reproducible */
+    std::mt19937 rng;
+    std::normal_distribution<float> normal;
+    float angle_noise_stddev = 0.f;
+
     using Publisher = uavcan::Publisher<cvra::proximity_beacon::Signal>;
     std::unique_ptr<Publisher> pub;
 
     void spin();
 
 public:
-    ProximityBeaconEmulator(std::string can_iface, std::string board_name, int node_number);
+    ProximityBeaconEmulator(std::string can_iface, std::string board_name, int node_number,
+                            virtual_clock_t* virtual_clock = nullptr);
     void start();
 
+    /** Lockstep mode: starts the node without a thread, the simulation loop
+     * then spins it with spin_once() at each step. */
+    void start_lockstep();
+    void spin_once();
+
+    /** Adds gaussian noise of the given standard deviation (in radians) to the
+     * measured angle. */
+    void set_angle_noise(float stddev, uint32_t seed)
+    {
+        absl::MutexLock _(&lock);
+        rng.seed(seed);
+        normal.reset();
+        angle_noise_stddev = stddev;
+    }
+
     void set_positions(b2Vec2 robot_pos_, float robot_heading_, b2Vec2 opponent_pos_)
     {
         absl::MutexLock _(&lock);
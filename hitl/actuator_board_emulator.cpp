@@ -2,19 +2,23 @@
 #include <thread>
 #include <error/error.h>
 
-ActuatorBoardEmulator::ActuatorBoardEmulator(std::string can_iface, std::string board_name, int node_number)
-    : driver(clock)
-    , digital_input(false)
+ActuatorBoardEmulator::ActuatorBoardEmulator(std::string can_iface, std::string board_name, int node_number,
+                                             virtual_clock_t* virtual_clock)
+    : digital_input(false)
 {
+    /* Must be set before the node and its timers read the clock */
+    clock.use_virtual_clock(virtual_clock);
+
     pressure_pa[0] = 0.f;
     pressure_pa[1] = 0.f;
 
     NOTICE("Actuator board emulator on %s", can_iface.c_str());
 
-    if (driver.addIface(can_iface) < 0) {
+    driver = can_driver_open(can_iface, clock);
+    if (!driver) {
         ERROR("Failed to add iface %s", can_iface.c_str());
     }
-    node = std::make_unique<Node>(driver, clock);
+    node = std::make_unique<Node>(*driver, clock);
     node->setHealthOk();
     node->setModeOperational();
     if (!node->setNodeID(node_number)) {
@@ -72,3 +76,16 @@ void ActuatorBoardEmulator::spin()
         }
     }
 }
+
+void ActuatorBoardEmulator::start_lockstep()
+{
+    node->start();
+}
+
+void ActuatorBoardEmulator::spin_once()
+{
+    const int res = node->spinOnce();
+    if (res < 0) {
+        WARNING("UAVCAN failure: %d", res);
+    }
+}
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <cmath>
 #include <fstream>
 #include <absl/synchronization/mutex.h>
 #include <cvra/motor/control/Voltage.hpp>
@@ -6,6 +7,12 @@
 #include <box2d/box2d.h>
 #include <uavcan_linux/uavcan_linux.hpp>
 #include <thread>
+#include <csignal>
+#include <cstdlib>
+#include <pthread.h>
+#include <virtual_clock/virtual_clock.h>
+#include <can_bus_shm/can_driver.hpp>
+#include <position_log/position_log.h>
 #include "absl/flags/flag.h"
 #include "absl/flags/parse.h"
 #include "absl/flags/usage.h"
@@ -20,15 +27,41 @@
 #include "viewer.h"
 #include "PhysicsRobot.h"
 #include "OpponentRobot.h"
+#include "OpponentScript.h"
+#include "MatchStatistics.h"
 #include "PhysicsCup.h"
 #include "png_loader.h"
 
 ABSL_FLAG(int, first_uavcan_id, 42, "UAVCAN ID of the first board."
                                     " Subsequent ones will be incremented by 1 each.");
-ABSL_FLAG(std::string, can_iface, "vcan0", "SocketCAN interface to connect the emulation to");
-ABSL_FLAG(std::string, position_log, "robot_pos.txt", "File in which to write the position log.");
+ABSL_FLAG(std::string, can_iface, "vcan0",
+          "SocketCAN interface to connect the emulation to, or shm:/name for a shared memory bus");
+ABSL_FLAG(std::string, position_log, "robot_pos.bin",
+          "File in which to write the position log (see lib/position_log).");
 ABSL_FLAG(std::string, table_texture, "hitl/table.png", "File to use as table texture (PNG format).");
 ABSL_FLAG(bool, enable_gui, true, "Enables or not the graphical view.");
+ABSL_FLAG(bool, lockstep, false, "Runs the simulation on a virtual clock shared with the"
+                                 " master firmware, as fast as the CPU allows.");
+ABSL_FLAG(std::string, virtual_clock, "/cvra_hitl_clock", "Name of the shared memory holding the virtual clock"
+                                                          " in lockstep mode (see master's --virtual_clock).");
+ABSL_FLAG(int, lockstep_participants, 3, "Number of threads on the virtual clock to wait for before"
+                                         " starting: 1 for the simulator and 2 for the master firmware"
+                                         " (3 if it plays a game with --play_game).");
+ABSL_FLAG(double, duration, 0., "Simulated time after which the simulator exits, in seconds."
+                                " 0 runs forever.");
+ABSL_FLAG(int, seed, 0, "Seed of the random number generators of the simulation.");
+ABSL_FLAG(double, beacon_angle_noise, 0., "Standard deviation of the proximity beacon angle noise [rad].");
+ABSL_FLAG(std::string, opponent_script, "", "CSV file of time,x,y waypoints [s, m] the opponent follows.");
+ABSL_FLAG(std::string, match_report, "", "JSON file in which to write the match statistics when the"
+                                         " simulation ends (see --duration).");
+
+/* Participant id of the simulation loop on the virtual clock. It must run
+ * before the master firmware at a given time, so that the master sees the
+ * result of the physics step. */
+constexpr int LOCKSTEP_PARTICIPANT_ID = 0;
+
+/* Period of the lockstep loop, at which the emulated boards are spun */
+constexpr uint64_t LOCKSTEP_PERIOD_US = 1000;
 
 OpponentRobot* opponent_robot = nullptr;
 
@@ -189,14 +222,61 @@ std::vector<CupRenderer> create_cups(b2World& world)
     return renderers;
 }
 
+/* Too large for the stack. Closed by whichever comes first: the end of the
+ * match, SIGINT/SIGTERM, or exit() (for example when the viewer window is
+ * closed), so that the records still in memory are not lost. */
+static position_log_writer_t position_log;
+static absl::Mutex position_log_lock;
+static bool position_log_open = false;
+
+static void position_log_append(const position_log_record_t* record)
+{
+    absl::MutexLock _(&position_log_lock);
+    if (position_log_open) {
+        position_log_writer_append(&position_log, record);
+    }
+}
+
+static void position_log_close()
+{
+    absl::MutexLock _(&position_log_lock);
+    if (!position_log_open) {
+        return;
+    }
+    position_log_open = false;
+    if (!position_log_writer_close(&position_log)) {
+        WARNING("Could not write the position log");
+    }
+}
+
+/* Must be called before starting any thread: SIGINT and SIGTERM are blocked
+ * in all threads and waited for by a dedicated one, which, unlike a signal
+ * handler, can take locks. */
+static void handle_stop_signals()
+{
+    static sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, nullptr);
+
+    std::thread([]() {
+        int sig;
+        sigwait(&stop_signals, &sig);
+        NOTICE("Got signal %d, stopping", sig);
+        exit(128 + sig);
+    }).detach();
+
+    std::atexit(position_log_close);
+}
+
 int main(int argc, char** argv)
 {
     absl::SetProgramUsageMessage("Emulates one of CVRA "
                                  "motor control board over UAVCAN");
     absl::ParseCommandLine(argc, argv);
 
-    std::ofstream position_log;
-    position_log.open(absl::GetFlag(FLAGS_position_log), std::ios::trunc);
+    handle_stop_signals();
 
     b2Vec2 gravity(0.0f, 0.0f);
     b2World world(gravity);
@@ -213,75 +293,180 @@ int main(int argc, char** argv)
     OpponentRobot opponent(world, {3.f, 0.f});
     opponent_robot = &opponent;
 
+    OpponentScript opponent_script;
+    if (!absl::GetFlag(FLAGS_opponent_script).empty()) {
+        std::ifstream script_file(absl::GetFlag(FLAGS_opponent_script));
+        if (!script_file || !opponent_script.load(script_file)) {
+            ERROR("Could not read opponent script %s", absl::GetFlag(FLAGS_opponent_script).c_str());
+        }
+    }
+
+    MatchStatistics match_stats(robot.GetBody(), opponent.GetBody());
+    world.SetContactListener(&match_stats);
+    float match_time = 0.f;
+
     logging_init();
 
+    if (position_log_writer_open(&position_log, absl::GetFlag(FLAGS_position_log).c_str())) {
+        position_log_open = true;
+    } else {
+        ERROR("Could not open position log %s", absl::GetFlag(FLAGS_position_log).c_str());
+    }
+
+    virtual_clock_t* virtual_clock = nullptr;
+    if (absl::GetFlag(FLAGS_lockstep)) {
+        const auto name = absl::GetFlag(FLAGS_virtual_clock);
+        virtual_clock = virtual_clock_create_shared(name.c_str(), absl::GetFlag(FLAGS_lockstep_participants));
+        if (virtual_clock == nullptr) {
+            ERROR("Could not create virtual clock %s", name.c_str());
+        }
+        NOTICE("Lockstep mode, waiting for %d participants on %s",
+               absl::GetFlag(FLAGS_lockstep_participants), name.c_str());
+    }
+
     int board_id = absl::GetFlag(FLAGS_first_uavcan_id);
     std::string iface = absl::GetFlag(FLAGS_can_iface);
 
-    UavcanMotorEmulator left_motor(iface, "left-wheel", board_id++);
-    UavcanMotorEmulator right_motor(iface, "right-wheel", board_id++);
-    WheelEncoderEmulator wheels(iface, "encoders", board_id++);
-    SensorBoardEmulator sensor(iface, "front-left-sensor", board_id++);
+    UavcanMotorEmulator left_motor(iface, "left-wheel", board_id++, virtual_clock);
+    UavcanMotorEmulator right_motor(iface, "right-wheel", board_id++, virtual_clock);
+    WheelEncoderEmulator wheels(iface, "encoders", board_id++, virtual_clock);
+    SensorBoardEmulator sensor(iface, "front-left-sensor", board_id++, virtual_clock);
     sensor.set_distance(42);
 
-    ActuatorBoardEmulator actuator(iface, "actuator-front-left", board_id++);
+    ActuatorBoardEmulator actuator(iface, "actuator-front-left", board_id++, virtual_clock);
 
     float pressure[2] = {50e3, 80e3};
     actuator.set_pressure(pressure);
 
-    ProximityBeaconEmulator proximity_beacon(iface, "proximity-beacon", board_id++);
-
-    right_motor.start();
-    left_motor.start();
-    wheels.start();
-    sensor.start();
-    actuator.start();
-    proximity_beacon.start();
+    ProximityBeaconEmulator proximity_beacon(iface, "proximity-beacon", board_id++, virtual_clock);
+    proximity_beacon.set_angle_noise(absl::GetFlag(FLAGS_beacon_angle_noise), absl::GetFlag(FLAGS_seed));
 
     auto cups = create_cups(world);
 
-    std::thread world_update([&]() {
-        while (true) {
-            const float dt = 0.01;
-            std::this_thread::sleep_for(dt * std::chrono::seconds(1));
-
-            const float f_max = 8.;
-            robot.ApplyWheelbaseForces(
-                clamp(-f_max, -left_motor.get_voltage(), f_max),
-                clamp(-f_max, right_motor.get_voltage(), f_max));
-
-            // number of iterations taken from box2d manual
-            const int velocityIterations = 8;
-            const int posIterations = 3;
-
-            world.Step(dt, velocityIterations, posIterations);
-
-            // Publish wheel encoders
-            robot.AccumulateWheelEncoders(dt);
-            int left, right;
-            robot.GetWheelEncoders(left, right);
-            wheels.set_encoders(-left, right);
-
-            // Publish beacon signal
-            proximity_beacon.set_positions(robot.GetPosition(), robot.GetAngle(), opponent.GetPosition());
-
-            auto pos = robot.GetPosition();
-            auto vel = robot.GetLinearVelocity();
-
-            NOTICE_EVERY_N(10, "pos: %.3f %.3f", pos.x, pos.y);
-            position_log << pos.x << ",";
-            position_log << pos.y << ",";
-            position_log << vel.x << ",";
-            position_log << vel.y << std::endl;
-
-            /* Dummy simulation, to test that the integration works. */
-            float pressures[2];
-            pressures[0] = actuator.get_servo_pos(0) * 1000 * 50e3;
-            pressures[1] = actuator.get_pwm(0) * 50e3;
-            actuator.set_pressure(pressures);
-            actuator.set_digital_input(actuator.get_solenoid(0));
+    auto step_world = [&](float dt) {
+        if (!opponent_script.empty()) {
+            opponent.SetPosition(opponent_script.position_at(match_time));
         }
-    });
+
+        const float f_max = 8.;
+        robot.ApplyWheelbaseForces(
+            clamp(-f_max, -left_motor.get_voltage(), f_max),
+            clamp(-f_max, right_motor.get_voltage(), f_max));
+
+        // number of iterations taken from box2d manual
+        const int velocityIterations = 8;
+        const int posIterations = 3;
+
+        world.Step(dt, velocityIterations, posIterations);
+        match_stats.update();
+        match_time += dt;
+
+        // Publish wheel encoders
+        robot.AccumulateWheelEncoders(dt);
+        int left, right;
+        robot.GetWheelEncoders(left, right);
+        wheels.set_encoders(-left, right);
+
+        // Publish beacon signal
+        proximity_beacon.set_positions(robot.GetPosition(), robot.GetAngle(), opponent.GetPosition());
+
+        auto pos = robot.GetPosition();
+        auto vel = robot.GetLinearVelocity();
+
+        NOTICE_EVERY_N(10, "pos: %.3f %.3f", pos.x, pos.y);
+        position_log_record_t record;
+        record.timestamp_us = std::llround(match_time * 1e6);
+        record.x = pos.x;
+        record.y = pos.y;
+        record.heading = robot.GetAngle();
+        record.vx = vel.x;
+        record.vy = vel.y;
+        record.omega = robot.GetAngularVelocity();
+        record.left_voltage = left_motor.get_voltage();
+        record.right_voltage = right_motor.get_voltage();
+        record.left_encoder = -left;
+        record.right_encoder = right;
+        position_log_append(&record);
+
+        /* Dummy simulation, to test that the integration works. */
+        float pressures[2];
+        pressures[0] = actuator.get_servo_pos(0) * 1000 * 50e3;
+        pressures[1] = actuator.get_pwm(0) * 50e3;
+        actuator.set_pressure(pressures);
+        actuator.set_digital_input(actuator.get_solenoid(0));
+    };
+
+    auto end_match = [&]() {
+        NOTICE("Simulated %.1f s, stopping", match_time);
+        position_log_close();
+        if (!absl::GetFlag(FLAGS_match_report).empty()) {
+            std::ofstream report(absl::GetFlag(FLAGS_match_report), std::ios::trunc);
+            match_stats.write_json(report, match_time);
+        }
+    };
+
+    const float dt = 0.01;
+    const float duration = absl::GetFlag(FLAGS_duration);
+    std::thread world_update;
+
+    if (virtual_clock) {
+        /* Everything runs in this single thread, in a fixed order, and only
+         * when the master firmware is waiting for the next point in time. */
+        right_motor.start_lockstep();
+        left_motor.start_lockstep();
+        wheels.start_lockstep();
+        sensor.start_lockstep();
+        actuator.start_lockstep();
+        proximity_beacon.start_lockstep();
+
+        world_update = std::thread([&]() {
+            const uint64_t physics_period_us = std::lround(dt * 1e6);
+            const uint64_t end_us = duration * 1e6;
+
+            virtual_clock_join(virtual_clock, LOCKSTEP_PARTICIPANT_ID);
+            uint64_t now = virtual_clock_now(virtual_clock);
+            while (end_us == 0 || now < end_us) {
+                right_motor.spin_once();
+                left_motor.spin_once();
+                wheels.spin_once();
+                sensor.spin_once();
+                actuator.spin_once();
+                proximity_beacon.spin_once();
+
+                if (now % physics_period_us == 0) {
+                    step_world(dt);
+                }
+
+                virtual_clock_sleep_until(virtual_clock, LOCKSTEP_PARTICIPANT_ID, now + LOCKSTEP_PERIOD_US);
+                now = virtual_clock_now(virtual_clock);
+            }
+
+            end_match();
+            virtual_clock_stop(virtual_clock);
+            virtual_clock_unlink_shared(absl::GetFlag(FLAGS_virtual_clock).c_str());
+            const std::string can_bus = can_driver_shm_name(iface);
+            if (!can_bus.empty()) {
+                can_bus_shm_unlink(can_bus.c_str());
+            }
+            exit(0);
+        });
+    } else {
+        right_motor.start();
+        left_motor.start();
+        wheels.start();
+        sensor.start();
+        actuator.start();
+        proximity_beacon.start();
+
+        world_update = std::thread([&]() {
+            while (duration == 0.f || match_time < duration) {
+                std::this_thread::sleep_for(dt * std::chrono::seconds(1));
+                step_world(dt);
+            }
+            end_match();
+            exit(0);
+        });
+    }
 
     if (absl::GetFlag(FLAGS_enable_gui)) {
         viewer_init(argc, argv);
@@ -307,8 +492,7 @@ int main(int argc, char** argv)
         startRendering(&renderables);
     }
 
-    while (true) {
-    }
+    world_update.join();
 
     return 0;
 }
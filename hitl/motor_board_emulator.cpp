@@ -1,16 +1,26 @@
 #include "motor_board_emulator.h"
 #include <thread>
+#include <algorithm>
 #include <error/error.h>
 
-UavcanMotorEmulator::UavcanMotorEmulator(std::string can_iface, std::string board_name, int node_number)
-    : driver(clock)
-    , voltage(0.f)
+UavcanMotorEmulator::UavcanMotorEmulator(std::string can_iface, std::string board_name, int node_number,
+                                         virtual_clock_t* virtual_clock)
+    : voltage(0.f)
+    , setpoint_count(0)
+    , max_setpoint_interval_us(0)
+    , total_latency_us(0)
+    , max_latency_us(0)
+    , report_start_frames(0)
 {
+    /* Must be set before the node and its timers read the clock */
+    clock.use_virtual_clock(virtual_clock);
+
     NOTICE("Motor board emulator on %s", can_iface.c_str());
-    if (driver.addIface(can_iface) < 0) {
+    driver = can_driver_open(can_iface, clock);
+    if (!driver) {
         ERROR("Failed to add iface %s", can_iface.c_str());
     }
-    node = std::make_unique<Node>(driver, clock);
+    node = std::make_unique<Node>(*driver, clock);
     node->setHealthOk();
     node->setModeOperational();
     if (!node->setNodeID(node_number)) {
@@ -26,14 +36,99 @@ UavcanMotorEmulator::UavcanMotorEmulator(std::string can_iface, std::string boar
         }
 
         DEBUG("Received voltage setpoint %.2f for board %d", msg.voltage, msg.node_id);
+        set_voltage(msg.voltage, msg.getMonotonicTimestamp());
+    });
+
+    setpoint_batch_sub = std::make_unique<UavcanMotorEmulator::SetpointBatchSub>(*node);
+    setpoint_batch_sub->start([&](const uavcan::ReceivedDataStructure<cvra::motor::control::SetpointBatch>& msg) {
+        using cvra::motor::control::Setpoint;
+        for (const auto& setpoint : msg.setpoints) {
+            if (setpoint.node_id != node->getNodeID().get()) {
+                continue;
+            }
 
-        {
-            absl::MutexLock _(&lock);
-            voltage = msg.voltage;
+            if (setpoint.mode != Setpoint::MODE_VOLTAGE) {
+                WARNING_EVERY_N(100, "Only voltage setpoints are emulated, got mode %d", setpoint.mode);
+                return;
+            }
+
+            set_voltage(setpoint.value, msg.getMonotonicTimestamp());
+            record_setpoint(msg.timestamp);
         }
     });
 }
 
+/* Frames seen on the bus: the ones received from the other nodes, whether
+ * this node subscribes to them or not, and its own */
+uint64_t UavcanMotorEmulator::bus_frame_count()
+{
+    auto& can_io = node->getDispatcher().getCanIOManager();
+    uint64_t frames = 0;
+    for (auto i = 0; i < can_io.getNumIfaces(); i++) {
+        auto counters = can_io.getIfacePerfCounters(i);
+        frames += counters.frames_rx + counters.frames_tx;
+    }
+    return frames;
+}
+
+void UavcanMotorEmulator::record_setpoint(uint32_t sent_timestamp)
+{
+    /* The master and the simulator share the same clock: the monotonic clock
+     * of the host, or the virtual clock in lockstep mode. */
+    auto now = clock.getMonotonic();
+    int64_t latency = (int32_t)((uint32_t)now.toUSec() - sent_timestamp);
+
+    absl::MutexLock _(&lock);
+    total_latency_us += latency;
+    max_latency_us = std::max(max_latency_us, latency);
+
+    if (setpoint_count == 1) {
+        report_start_time = now;
+        report_start_frames = bus_frame_count();
+    }
+
+    if (setpoint_count % SETPOINT_REPORT_PERIOD == 0) {
+        /* A CAN 2.0B frame with 8 bytes of data takes up to 160 bits on the
+         * wire with bit stuffing, so this is an upper bound of the load. */
+        const float bitrate = 1e6;
+        const float frame_bits = 160;
+        auto elapsed = (now - report_start_time).toUSec() * 1e-6;
+        auto frames = bus_frame_count();
+        auto frame_rate = (frames - report_start_frames) / elapsed;
+
+        NOTICE("%s: setpoint latency from the master's control loop: mean %ld us, max %ld us",
+               node->getName().c_str(),
+               (long)(total_latency_us / SETPOINT_REPORT_PERIOD), (long)max_latency_us);
+        NOTICE("%s: bus load %.0f frames/s, at most %.1f%% of 1 Mbit/s",
+               node->getName().c_str(), frame_rate, 100 * frame_rate * frame_bits / bitrate);
+
+        total_latency_us = 0;
+        max_latency_us = 0;
+        report_start_time = now;
+        report_start_frames = frames;
+    }
+}
+
+void UavcanMotorEmulator::set_voltage(float new_voltage, uavcan::MonotonicTime timestamp)
+{
+    absl::MutexLock _(&lock);
+    voltage = new_voltage;
+
+    if (setpoint_count > 0) {
+        auto interval = (timestamp - last_setpoint_time).toUSec();
+        max_setpoint_interval_us = std::max(max_setpoint_interval_us, interval);
+    }
+    last_setpoint_time = timestamp;
+    setpoint_count++;
+
+    /* The master's control loop runs at 100 Hz, so this is every ~10 s */
+    if (setpoint_count % SETPOINT_REPORT_PERIOD == 0) {
+        NOTICE("%s: %d setpoints received, at most %ld us apart",
+               node->getName().c_str(), setpoint_count, (long)max_setpoint_interval_us);
+        max_setpoint_interval_us = 0;
+    }
+}
+
 void UavcanMotorEmulator::start()
 {
     std::thread new_thread(&UavcanMotorEmulator::spin, this);
@@ -56,3 +151,16 @@ void UavcanMotorEmulator::spin()
         }
     }
 }
+
+void UavcanMotorEmulator::start_lockstep()
+{
+    node->start();
+}
+
+void UavcanMotorEmulator::spin_once()
+{
+    const int res = node->spinOnce();
+    if (res < 0) {
+        WARNING("UAVCAN failure: %d", res);
+    }
+}
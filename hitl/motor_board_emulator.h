@@ -5,28 +5,54 @@
 #include <memory>
 #include <absl/synchronization/mutex.h>
 #include <cvra/motor/control/Voltage.hpp>
+#include <cvra/motor/control/SetpointBatch.hpp>
 #include <uavcan_linux/uavcan_linux.hpp>
+#include <virtual_clock/uavcan_clock.hpp>
+#include <can_bus_shm/can_driver.hpp>
 #include "uavcan_node.h"
 
 class UavcanMotorEmulator {
-    uavcan_linux::SystemClock clock;
-    uavcan_linux::SocketCanDriver driver;
+    VirtualUavcanClock clock;
+    std::unique_ptr<uavcan::ICanDriver> driver;
     std::unique_ptr<Node> node;
     std::thread can_thread;
 
     using VoltageSub = uavcan::Subscriber<cvra::motor::control::Voltage>;
     std::unique_ptr<VoltageSub> voltage_sub;
+    using SetpointBatchSub = uavcan::Subscriber<cvra::motor::control::SetpointBatch>;
+    std::unique_ptr<SetpointBatchSub> setpoint_batch_sub;
     float voltage;
 
+    /* Setpoint statistics, to measure the command rate, the latency from the
+     * master's control loop and the bus load. They are logged every
+     * SETPOINT_REPORT_PERIOD setpoints. */
+    static constexpr int SETPOINT_REPORT_PERIOD = 1000;
+    int setpoint_count;
+    uavcan::MonotonicTime last_setpoint_time;
+    int64_t max_setpoint_interval_us;
+    int64_t total_latency_us, max_latency_us;
+    uavcan::MonotonicTime report_start_time;
+    uint64_t report_start_frames;
+
     absl::Mutex lock;
 
 public:
-    UavcanMotorEmulator(std::string can_iface, std::string board_name, int node_number);
+    UavcanMotorEmulator(std::string can_iface, std::string board_name, int node_number,
+                        virtual_clock_t* virtual_clock = nullptr);
     void start();
+
+    /** Lockstep mode: starts the node without a thread, the simulation loop
+     * then spins it with spin_once() at each step. */
+    void start_lockstep();
+    void spin_once();
+
     float get_voltage();
 
 private:
     void spin();
+    void set_voltage(float voltage, uavcan::MonotonicTime timestamp);
+    void record_setpoint(uint32_t sent_timestamp);
+    uint64_t bus_frame_count();
 };
 
 #endif
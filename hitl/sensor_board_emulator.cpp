@@ -1,15 +1,19 @@
 #include "sensor_board_emulator.h"
 #include <error/error.h>
 
-SensorBoardEmulator::SensorBoardEmulator(std::string can_iface, std::string board_name, int node_number)
-    : driver(clock)
-    , distance_mm(0)
+SensorBoardEmulator::SensorBoardEmulator(std::string can_iface, std::string board_name, int node_number,
+                                         virtual_clock_t* virtual_clock)
+    : distance_mm(0)
 {
+    /* Must be set before the node and its timers read the clock */
+    clock.use_virtual_clock(virtual_clock);
+
     NOTICE("Motor board emulator on %s", can_iface.c_str());
-    if (driver.addIface(can_iface) < 0) {
+    driver = can_driver_open(can_iface, clock);
+    if (!driver) {
         ERROR("Failed to add iface %s", can_iface.c_str());
     }
-    node = std::make_unique<Node>(driver, clock);
+    node = std::make_unique<Node>(*driver, clock);
     node->setHealthOk();
     node->setModeOperational();
     if (!node->setNodeID(node_number)) {
@@ -54,3 +58,16 @@ void SensorBoardEmulator::spin()
         }
     }
 }
+
+void SensorBoardEmulator::start_lockstep()
+{
+    node->start();
+}
+
+void SensorBoardEmulator::spin_once()
+{
+    const int res = node->spinOnce();
+    if (res < 0) {
+        WARNING("UAVCAN failure: %d", res);
+    }
+}
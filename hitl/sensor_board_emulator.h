@@ -3,12 +3,14 @@
 #include <memory>
 #include <thread>
 #include <uavcan_linux/uavcan_linux.hpp>
+#include <virtual_clock/uavcan_clock.hpp>
+#include <can_bus_shm/can_driver.hpp>
 #include "uavcan_node.h"
 #include <cvra/sensor/DistanceVL6180X.hpp>
 
 class SensorBoardEmulator {
-    uavcan_linux::SystemClock clock;
-    uavcan_linux::SocketCanDriver driver;
+    VirtualUavcanClock clock;
+    std::unique_ptr<uavcan::ICanDriver> driver;
     std::unique_ptr<Node> node;
     std::thread can_thread;
     std::unique_ptr<uavcan::Timer> publish_timer;
@@ -21,8 +23,15 @@ class SensorBoardEmulator {
     int distance_mm GUARDED_BY(lock);
 
 public:
-    SensorBoardEmulator(std::string can_iface, std::string board_name, int node_number);
+    SensorBoardEmulator(std::string can_iface, std::string board_name, int node_number,
+                        virtual_clock_t* virtual_clock = nullptr);
     void start();
+
+    /** Lockstep mode: starts the node without a thread, the simulation loop
+     * then spins it with spin_once() at each step. */
+    void start_lockstep();
+    void spin_once();
+
     void set_distance(int distance_mm);
 
 private:
@@ -0,0 +1,57 @@
+#include <CppUTest/TestHarness.h>
+#include <memory>
+#include <sstream>
+#include "../PhysicsRobot.h"
+#include "../OpponentRobot.h"
+#include "../MatchStatistics.h"
+
+TEST_GROUP (MatchStatisticsTestGroup) {
+    std::unique_ptr<b2World> world;
+    std::unique_ptr<PhysicsRobot> robot;
+    std::unique_ptr<OpponentRobot> opponent;
+    std::unique_ptr<MatchStatistics> stats;
+
+    void setup() override
+    {
+        world = std::make_unique<b2World>(b2Vec2(0.f, 0.f));
+        robot = std::make_unique<PhysicsRobot>(*world, 0.2, 0.2, 4., 100, b2Vec2(0.5, 0.5), 0.);
+        opponent = std::make_unique<OpponentRobot>(*world, b2Vec2(1.5, 0.5));
+        stats = std::make_unique<MatchStatistics>(robot->GetBody(), opponent->GetBody());
+        world->SetContactListener(stats.get());
+    }
+
+    void drive(float force, int steps)
+    {
+        for (int i = 0; i < steps; i++) {
+            robot->ApplyWheelbaseForces(force, force);
+            world->Step(0.01, 8, 3);
+            stats->update();
+        }
+    }
+};
+
+TEST(MatchStatisticsTestGroup, MeasuresPathLength)
+{
+    drive(1., 50);
+
+    DOUBLES_EQUAL(robot->GetPosition().x - 0.5, stats->get_path_length(), 1e-4);
+    CHECK_EQUAL(0, stats->get_collisions());
+}
+
+TEST(MatchStatisticsTestGroup, CountsCollisionsWithTheOpponent)
+{
+    drive(8., 300);
+
+    CHECK_EQUAL(1, stats->get_opponent_collisions());
+    CHECK_EQUAL(1, stats->get_collisions());
+}
+
+TEST(MatchStatisticsTestGroup, WritesJSON)
+{
+    std::ostringstream out;
+
+    stats->write_json(out, 12.5);
+
+    CHECK_TRUE(out.str().find("\"match_time_s\": 12.5") != std::string::npos);
+    CHECK_TRUE(out.str().find("\"collisions\": 0") != std::string::npos);
+}
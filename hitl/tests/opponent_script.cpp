@@ -0,0 +1,44 @@
+#include <CppUTest/TestHarness.h>
+#include <sstream>
+#include "../OpponentScript.h"
+
+TEST_GROUP (OpponentScriptTestGroup) {
+    OpponentScript script;
+};
+
+TEST(OpponentScriptTestGroup, InterpolatesBetweenWaypoints)
+{
+    script.add_waypoint(1.f, {0.f, 0.f});
+    script.add_waypoint(3.f, {2.f, 1.f});
+
+    auto pos = script.position_at(2.f);
+
+    DOUBLES_EQUAL(1.f, pos.x, 1e-6);
+    DOUBLES_EQUAL(0.5f, pos.y, 1e-6);
+}
+
+TEST(OpponentScriptTestGroup, StaysAtTheEnds)
+{
+    script.add_waypoint(1.f, {0.f, 0.f});
+    script.add_waypoint(3.f, {2.f, 1.f});
+
+    DOUBLES_EQUAL(0.f, script.position_at(0.f).x, 1e-6);
+    DOUBLES_EQUAL(2.f, script.position_at(10.f).x, 1e-6);
+}
+
+TEST(OpponentScriptTestGroup, LoadsCSV)
+{
+    std::istringstream csv("# time,x,y\n0,1.5,1\n\n10,2.5,0.5\n");
+
+    CHECK_TRUE(script.load(csv));
+
+    DOUBLES_EQUAL(2.f, script.position_at(5.f).x, 1e-6);
+    DOUBLES_EQUAL(0.75f, script.position_at(5.f).y, 1e-6);
+}
+
+TEST(OpponentScriptTestGroup, RejectsInvalidLines)
+{
+    std::istringstream csv("0,1.5\n");
+
+    CHECK_FALSE(script.load(csv));
+}
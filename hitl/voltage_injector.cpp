@@ -1,5 +1,6 @@
 #include <cvra/motor/control/Voltage.hpp>
 #include <uavcan_linux/uavcan_linux.hpp>
+#include <can_bus_shm/can_driver.hpp>
 #include "absl/flags/flag.h"
 #include "absl/flags/parse.h"
 #include "absl/flags/usage.h"
@@ -10,7 +11,7 @@ typedef uavcan::Node<16384> Node;
 
 ABSL_FLAG(int, uavcan_id, 10, "UAVCAN ID to use");
 ABSL_FLAG(int, dst_id, 42, "ID of the board to which send messages");
-ABSL_FLAG(std::string, can_iface, "vcan0", "SocketCAN interface to connect the emulation to");
+ABSL_FLAG(std::string, can_iface, "vcan0", "SocketCAN interface to connect the emulation to, or shm:/name for a shared memory bus");
 
 int main(int argc, char** argv)
 {
@@ -19,11 +20,12 @@ int main(int argc, char** argv)
     logging_init();
 
     uavcan_linux::SystemClock clock;
-    uavcan_linux::SocketCanDriver driver(clock);
-
-    driver.addIface(absl::GetFlag(FLAGS_can_iface).c_str());
+    auto driver = can_driver_open(absl::GetFlag(FLAGS_can_iface), clock);
+    if (!driver) {
+        ERROR("Failed to add iface %s", absl::GetFlag(FLAGS_can_iface).c_str());
+    }
 
-    Node node(driver, clock);
+    Node node(*driver, clock);
 
     node.setNodeID(absl::GetFlag(FLAGS_uavcan_id));
     node.setName("ch.cvra.hitl.voltage_injector");
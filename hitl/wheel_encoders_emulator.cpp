@@ -1,16 +1,20 @@
 #include "wheel_encoders_emulator.h"
 #include <error/error.h>
 
-WheelEncoderEmulator::WheelEncoderEmulator(std::string can_iface, std::string board_name, int node_number)
-    : driver(clock)
-    , left_encoder(0)
+WheelEncoderEmulator::WheelEncoderEmulator(std::string can_iface, std::string board_name, int node_number,
+                                           virtual_clock_t* virtual_clock)
+    : left_encoder(0)
     , right_encoder(0)
 {
+    /* Must be set before the node and its timers read the clock */
+    clock.use_virtual_clock(virtual_clock);
+
     NOTICE("Motor board emulator on %s", can_iface.c_str());
-    if (driver.addIface(can_iface) < 0) {
+    driver = can_driver_open(can_iface, clock);
+    if (!driver) {
         ERROR("Failed to add iface %s", can_iface.c_str());
     }
-    node = std::make_unique<Node>(driver, clock);
+    node = std::make_unique<Node>(*driver, clock);
     node->setHealthOk();
     node->setModeOperational();
     if (!node->setNodeID(node_number)) {
@@ -58,3 +62,16 @@ void WheelEncoderEmulator::spin()
         }
     }
 }
+
+void WheelEncoderEmulator::start_lockstep()
+{
+    node->start();
+}
+
+void WheelEncoderEmulator::spin_once()
+{
+    const int res = node->spinOnce();
+    if (res < 0) {
+        WARNING("UAVCAN failure: %d", res);
+    }
+}
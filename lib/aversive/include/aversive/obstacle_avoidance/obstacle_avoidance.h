@@ -41,6 +41,10 @@
  *
  * The algorithm executes Dijkstra to find the shortest path to go
  * from A to B.
+ *
+ * Obstacles which never move (walls, fixed game elements) can be marked as
+ * static. The rays between their vertices are computed once and cached, so
+ * that each query only checks the moving obstacles and the start/stop points.
  */
 
 /*
@@ -110,6 +114,11 @@ struct obstacle_avoidance {
     int rays[MAX_RAYS * 2]; /**< All valid rays given by Dijkstra. */
     point_t res[MAX_CHKPOINTS]; /**< Resulting path. */
     int res_len; /** Path length */
+
+    uint8_t static_poly[MAX_POLY]; /**< Set for polygons which never move. */
+    int static_rays_valid; /**< Set if static_rays is up to date. */
+    int static_ray_n; /**< Number of cached static rays. */
+    int static_rays[MAX_RAYS * 2]; /**< Rays between static polygons, not crossing any static polygon. */
 };
 
 /** Init the obstacle avoidance structure. */
@@ -131,6 +140,17 @@ void oa_new_poly_(struct obstacle_avoidance* oa, int size, poly_t* poly);
 void oa_add_poly_obstacle(struct obstacle_avoidance* oa, circle_t circle, int samples, float angle_offset);
 void oa_get_poly(struct obstacle_avoidance* oa, int i, poly_t* poly);
 
+/** Marks a polygon as static, meaning its points will not change anymore.
+ *
+ * The visibility between static polygons is then only computed once. If the
+ * points of a static polygon are modified without using oa_poly_set_point,
+ * or if the bounding box changes, oa_invalidate_static_rays must be called.
+ */
+void oa_poly_set_static(struct obstacle_avoidance* oa, poly_t* pol);
+
+/** Forces the recomputation of the rays between static polygons. */
+void oa_invalidate_static_rays(struct obstacle_avoidance* oa);
+
 /** Dump status of the obstacle avoidance. */
 void oa_dump(struct obstacle_avoidance* oa);
 
@@ -28,5 +28,58 @@ static void BM_ObstacleAvoidance(benchmark::State& state)
     }
 }
 
+/* Static obstacles spread over the table and a moving opponent, which moves
+ * before each query. Without static obstacles marked, every ray is
+ * recomputed on each query. */
+static void static_obstacles_benchmark(benchmark::State& state, bool mark_static)
+{
+    struct obstacle_avoidance oa;
+    point_t* points;
+
+    polygon_set_boundingbox(0, 0, 3000, 2000);
+    oa_init(&oa);
+    oa_start_end_points(&oa, 200, 200, 2800, 1800);
+
+    auto opponent = oa_new_poly(&oa, 4);
+
+    for (int i = 0; i < state.range(0); i++) {
+        auto obstacle = oa_new_poly(&oa, 4);
+        int x = 300 + (i % 4) * 700, y = 400 + (i / 4) * 600;
+        oa_poly_set_point(&oa, obstacle, x + 100, y - 50, 0);
+        oa_poly_set_point(&oa, obstacle, x + 100, y + 50, 1);
+        oa_poly_set_point(&oa, obstacle, x - 100, y + 50, 2);
+        oa_poly_set_point(&oa, obstacle, x - 100, y - 50, 3);
+        if (mark_static) {
+            oa_poly_set_static(&oa, obstacle);
+        }
+    }
+
+    int x = 0;
+    for (auto _ : state) {
+        x = (x + 37) % 2600;
+        oa_poly_set_point(&oa, opponent, x + 300, 900, 0);
+        oa_poly_set_point(&oa, opponent, x + 300, 1100, 1);
+        oa_poly_set_point(&oa, opponent, x + 100, 1100, 2);
+        oa_poly_set_point(&oa, opponent, x + 100, 900, 3);
+
+        oa_process(&oa);
+
+        auto point_cnt = oa_get_path(&oa, &points);
+        benchmark::DoNotOptimize(point_cnt);
+    }
+}
+
+static void BM_MovingOpponent(benchmark::State& state)
+{
+    static_obstacles_benchmark(state, false);
+}
+
+static void BM_MovingOpponentStaticObstacles(benchmark::State& state)
+{
+    static_obstacles_benchmark(state, true);
+}
+
 BENCHMARK(BM_ObstacleAvoidance)->RangeMultiplier(2)->Range(1, 8);
+BENCHMARK(BM_MovingOpponent)->RangeMultiplier(2)->Range(1, 8);
+BENCHMARK(BM_MovingOpponentStaticObstacles)->RangeMultiplier(2)->Range(1, 8);
 BENCHMARK_MAIN();
@@ -81,8 +81,17 @@ void oa_init(struct obstacle_avoidance* oa)
 
 void oa_copy(struct obstacle_avoidance* dst, const struct obstacle_avoidance* oa)
 {
+    int i;
+
     memset(dst, 0, sizeof(struct obstacle_avoidance));
     memcpy(dst, oa, sizeof(struct obstacle_avoidance));
+
+    /* The polygons point into the points array, which moved */
+    for (i = 0; i < MAX_POLY; i++) {
+        if (oa->polys[i].pts != NULL) {
+            dst->polys[i].pts = dst->points + (oa->polys[i].pts - oa->points);
+        }
+    }
 }
 
 /**
@@ -135,6 +144,7 @@ poly_t* oa_new_poly(struct obstacle_avoidance* oa, int size)
 
     oa->polys[oa->cur_poly_idx].l = size;
     oa->polys[oa->cur_poly_idx].pts = &oa->points[oa->cur_pt_idx];
+    oa->static_poly[oa->cur_poly_idx] = 0;
     oa->cur_pt_idx += size;
 
     return &oa->polys[oa->cur_poly_idx++];
@@ -167,6 +177,21 @@ void oa_poly_set_point(struct obstacle_avoidance* oa,
     pol->pts[i].y = y;
     oa->valid[GET_PT(pol->pts[i])] = 0;
     oa->pweight[GET_PT(pol->pts[i])] = 0;
+
+    if (oa->static_poly[pol - oa->polys]) {
+        oa_invalidate_static_rays(oa);
+    }
+}
+
+void oa_poly_set_static(struct obstacle_avoidance* oa, poly_t* pol)
+{
+    oa->static_poly[pol - oa->polys] = 1;
+    oa_invalidate_static_rays(oa);
+}
+
+void oa_invalidate_static_rays(struct obstacle_avoidance* oa)
+{
+    oa->static_rays_valid = 0;
 }
 
 int oa_get_path(struct obstacle_avoidance* oa, point_t** path)
@@ -319,6 +344,134 @@ int8_t get_path(struct obstacle_avoidance* oa, poly_t* polys)
     return i;
 }
 
+/* Which obstacles are checked by is_ray_crossed */
+enum {
+    OA_ALL_POLYS,
+    OA_STATIC_POLYS,
+    OA_DYNAMIC_POLYS,
+};
+
+static int poly_is_static(struct obstacle_avoidance* oa, int i)
+{
+    /* The first polygon holds the start and end points, which always move */
+    return i > 0 && oa->static_poly[i];
+}
+
+/* Returns 1 if the segment crosses one of the selected obstacles, ignoring
+ * the polygon skip. */
+static int is_ray_crossed(struct obstacle_avoidance* oa, point_t p1, point_t p2, int skip, int which)
+{
+    int i;
+
+    for (i = 1; i < oa->cur_poly_idx; i++) {
+        if (i == skip) {
+            continue;
+        }
+        if (which == OA_STATIC_POLYS && !oa->static_poly[i]) {
+            continue;
+        }
+        if (which == OA_DYNAMIC_POLYS && oa->static_poly[i]) {
+            continue;
+        }
+        if (is_crossing_poly(p1, p2, NULL, &oa->polys[i]) == 1) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Returns 1 if the given ray is the next one in the static rays cache. As
+ * rays are always enumerated in the same order, a single cursor is needed. */
+static int is_next_static_ray(struct obstacle_avoidance* oa, int* cursor, int p1, int pt1, int p2, int pt2)
+{
+    int* ray = &oa->static_rays[*cursor];
+
+    if (*cursor < oa->static_ray_n && ray[0] == p1 && ray[1] == pt1 && ray[2] == p2 && ray[3] == pt2) {
+        *cursor += 4;
+        return 1;
+    }
+    return 0;
+}
+
+/* Checks if a ray between two vertices is valid.
+ *
+ * When building the cache, only rays between static polygons are considered,
+ * and they are only checked against static polygons. Otherwise rays between
+ * static polygons are taken from the cache and only checked against the
+ * moving ones. */
+static int is_ray_valid(struct obstacle_avoidance* oa, int build_cache, int* cursor, int p1, int pt1, int p2, int pt2, int skip)
+{
+    point_t a = oa->polys[p1].pts[pt1];
+    point_t b = oa->polys[p2].pts[pt2];
+    int is_static = poly_is_static(oa, p1) && poly_is_static(oa, p2);
+
+    if (build_cache) {
+        return is_static && !is_ray_crossed(oa, a, b, skip, OA_STATIC_POLYS);
+    }
+
+    if (is_static) {
+        return is_next_static_ray(oa, cursor, p1, pt1, p2, pt2)
+            && !is_ray_crossed(oa, a, b, skip, OA_DYNAMIC_POLYS);
+    }
+
+    return !is_ray_crossed(oa, a, b, skip, OA_ALL_POLYS);
+}
+
+/* Same as calc_rays, giving the rays in the same order, but using the cache
+ * of static rays (or building it if build_cache is set). */
+static int oa_calc_rays(struct obstacle_avoidance* oa, int* rays, int build_cache)
+{
+    int i, ii, pt1, pt2, n;
+    int ray_n = 0;
+    int cursor = 0;
+    poly_t* polys = oa->polys;
+    int npolys = oa->cur_poly_idx;
+
+    /* 1: rays along the edges of each polygon */
+    for (i = 0; i < npolys; i++) {
+        for (ii = 0; ii < polys[i].l; ii++) {
+            n = (ii + 1) % polys[i].l;
+
+            if (!is_in_boundingbox(&polys[i].pts[ii]) || !is_in_boundingbox(&polys[i].pts[n])) {
+                continue;
+            }
+
+            if (is_ray_valid(oa, build_cache, &cursor, i, ii, i, n, i)) {
+                rays[ray_n++] = i;
+                rays[ray_n++] = ii;
+                rays[ray_n++] = i;
+                rays[ray_n++] = n;
+            }
+        }
+    }
+
+    /* 2: rays between vertices of different polygons */
+    for (i = 0; i < npolys - 1; i++) {
+        for (pt1 = 0; pt1 < polys[i].l; pt1++) {
+            if (!is_in_boundingbox(&polys[i].pts[pt1])) {
+                continue;
+            }
+
+            for (ii = i + 1; ii < npolys; ii++) {
+                for (pt2 = 0; pt2 < polys[ii].l; pt2++) {
+                    if (!is_in_boundingbox(&polys[ii].pts[pt2])) {
+                        continue;
+                    }
+
+                    if (is_ray_valid(oa, build_cache, &cursor, i, pt1, ii, pt2, -1)) {
+                        rays[ray_n++] = i;
+                        rays[ray_n++] = pt1;
+                        rays[ray_n++] = ii;
+                        rays[ray_n++] = pt2;
+                    }
+                }
+            }
+        }
+    }
+
+    return ray_n;
+}
+
 int8_t
 oa_process(struct obstacle_avoidance* oa)
 {
@@ -327,8 +480,13 @@ oa_process(struct obstacle_avoidance* oa)
 
     oa_reset(oa);
 
-    /* First we compute the visibility graph */
-    ret = calc_rays(oa->polys, oa->cur_poly_idx, oa->rays);
+    /* First we compute the visibility graph, reusing the rays between static
+     * obstacles which were computed before */
+    if (!oa->static_rays_valid) {
+        oa->static_ray_n = oa_calc_rays(oa, oa->static_rays, 1);
+        oa->static_rays_valid = 1;
+    }
+    ret = oa_calc_rays(oa, oa->rays, 0);
     DEBUG_OA_PRINTF("%s: %d rays\r", __FUNCTION__, ret);
 
     DEBUG_OA_PRINTF("Ray list\r");
@@ -103,3 +103,139 @@ TEST(ObstacleAvoidance, FindsPathWithTwoOverlappingObstacles)
     CHECK_EQUAL(end.x, points[2].x);
     CHECK_EQUAL(end.y, points[2].y);
 }
+
+TEST(ObstacleAvoidance, CopyFindsTheSamePath)
+{
+    auto obstacle = oa_new_poly(&oa, 4);
+    oa_poly_set_point(&oa, obstacle, 1400, 900, 3);
+    oa_poly_set_point(&oa, obstacle, 1400, 1300, 2);
+    oa_poly_set_point(&oa, obstacle, 1600, 1300, 1);
+    oa_poly_set_point(&oa, obstacle, 1600, 900, 0);
+
+    struct obstacle_avoidance copy;
+    oa_copy(&copy, &oa);
+
+    // The copy must not share its points with the original
+    oa_start_end_points(&oa, 0, 0, 100, 100);
+    oa_poly_set_point(&oa, obstacle, 0, 0, 0);
+
+    point_t* points;
+    oa_process(&copy);
+    auto point_cnt = oa_get_path(&copy, &points);
+
+    CHECK_EQUAL(3, point_cnt);
+    CHECK_EQUAL(1400, points[0].x);
+    CHECK_EQUAL(900, points[0].y);
+    CHECK_EQUAL(1600, points[1].x);
+    CHECK_EQUAL(900, points[1].y);
+    CHECK_EQUAL(end.x, points[2].x);
+    CHECK_EQUAL(end.y, points[2].y);
+}
+
+TEST_GROUP (ObstacleAvoidanceStaticObstacles) {
+    struct obstacle_avoidance oa;
+    poly_t* opponent;
+    poly_t* walls[3];
+
+    void setup(void)
+    {
+        polygon_set_boundingbox(0, 0, 3000, 2000);
+        oa_init(&oa);
+        oa_start_end_points(&oa, 200, 200, 2800, 1800);
+
+        opponent = oa_new_poly(&oa, 4);
+        set_square(opponent, 1500, 1000, 100);
+
+        for (auto i = 0; i < 3; i++) {
+            walls[i] = oa_new_poly(&oa, 4);
+            set_square(walls[i], 700 + 800 * i, 600 + 400 * i, 150);
+            oa_poly_set_static(&oa, walls[i]);
+        }
+    }
+
+    void set_square(poly_t * poly, int x, int y, int half_size)
+    {
+        oa_poly_set_point(&oa, poly, x + half_size, y - half_size, 0);
+        oa_poly_set_point(&oa, poly, x + half_size, y + half_size, 1);
+        oa_poly_set_point(&oa, poly, x - half_size, y + half_size, 2);
+        oa_poly_set_point(&oa, poly, x - half_size, y - half_size, 3);
+    }
+
+    /* Checks that the cached visibility graph matches the one computed from
+     * scratch, and so does the resulting path. */
+    void check_matches_full_computation()
+    {
+        static int rays[MAX_RAYS * 2];
+        struct obstacle_avoidance reference;
+
+        oa_process(&oa);
+
+        auto ray_n = calc_rays(oa.polys, oa.cur_poly_idx, rays);
+        CHECK_EQUAL(ray_n, oa.ray_n);
+        for (auto i = 0; i < ray_n; i++) {
+            CHECK_EQUAL(rays[i], oa.rays[i]);
+        }
+
+        // Same obstacles, none of them static
+        oa_init(&reference);
+        oa_start_end_points(&reference, oa.points[1].x, oa.points[1].y, oa.points[0].x, oa.points[0].y);
+        for (auto i = 1; i < oa.cur_poly_idx; i++) {
+            auto poly = oa_new_poly(&reference, oa.polys[i].l);
+            for (auto j = 0; j < poly->l; j++) {
+                oa_poly_set_point(&reference, poly, oa.polys[i].pts[j].x, oa.polys[i].pts[j].y, j);
+            }
+        }
+        oa_process(&reference);
+
+        CHECK_EQUAL(reference.res_len, oa.res_len);
+        for (auto i = 0; i < oa.res_len; i++) {
+            CHECK_EQUAL(reference.res[i].x, oa.res[i].x);
+            CHECK_EQUAL(reference.res[i].y, oa.res[i].y);
+        }
+    }
+};
+
+TEST(ObstacleAvoidanceStaticObstacles, SameRaysAsFullComputation)
+{
+    check_matches_full_computation();
+}
+
+TEST(ObstacleAvoidanceStaticObstacles, SameRaysWhenOpponentMoves)
+{
+    for (auto x = 100; x < 3000; x += 150) {
+        for (auto y = 100; y < 2000; y += 150) {
+            set_square(opponent, x, y, 100);
+            check_matches_full_computation();
+        }
+    }
+}
+
+TEST(ObstacleAvoidanceStaticObstacles, SameRaysWhenStartAndEndMove)
+{
+    for (auto x = 100; x < 3000; x += 300) {
+        oa_start_end_points(&oa, x, 200, 3000 - x, 1800);
+        check_matches_full_computation();
+    }
+}
+
+TEST(ObstacleAvoidanceStaticObstacles, StaticRaysAreOnlyComputedOnce)
+{
+    oa_process(&oa);
+    CHECK_TRUE(oa.static_rays_valid);
+    auto static_ray_n = oa.static_ray_n;
+    CHECK_TRUE(static_ray_n > 0);
+
+    set_square(opponent, 1000, 1000, 100);
+    CHECK_TRUE(oa.static_rays_valid);
+    check_matches_full_computation();
+    CHECK_EQUAL(static_ray_n, oa.static_ray_n);
+}
+
+TEST(ObstacleAvoidanceStaticObstacles, MovingStaticObstacleInvalidatesCache)
+{
+    oa_process(&oa);
+
+    set_square(walls[1], 1500, 300, 200);
+    CHECK_FALSE(oa.static_rays_valid);
+    check_matches_full_computation();
+}
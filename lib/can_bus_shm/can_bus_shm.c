@@ -0,0 +1,198 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include "can_bus_shm/can_bus_shm.h"
+
+#define CAN_BUS_SHM_MAGIC 0x4342534d
+#define CAN_BUS_SHM_MASK (CAN_BUS_SHM_SIZE - 1)
+
+/* How long to wait for another process to initialize the bus */
+#define CAN_BUS_SHM_OPEN_RETRIES 1000
+#define CAN_BUS_SHM_OPEN_RETRY_US 1000
+
+static void sleep_us(uint64_t us)
+{
+    struct timespec t = {(time_t)(us / 1000000), (long)(us % 1000000) * 1000};
+    nanosleep(&t, NULL);
+}
+
+/* The futex is not private, so that it works across processes */
+static void notify_wait(uint32_t* addr, uint32_t value, uint64_t timeout_us)
+{
+#ifdef __linux__
+    struct timespec t = {(time_t)(timeout_us / 1000000), (long)(timeout_us % 1000000) * 1000};
+    syscall(SYS_futex, addr, FUTEX_WAIT, value, &t, NULL, 0);
+#else
+    (void)addr;
+    (void)value;
+    sleep_us(timeout_us < 100 ? timeout_us : 100);
+#endif
+}
+
+static void notify_wake(uint32_t* addr)
+{
+#ifdef __linux__
+    syscall(SYS_futex, addr, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#else
+    (void)addr;
+#endif
+}
+
+void can_bus_shm_init(can_bus_shm_t* bus)
+{
+    memset(bus, 0, sizeof(can_bus_shm_t));
+    __atomic_store_n(&bus->magic, CAN_BUS_SHM_MAGIC, __ATOMIC_RELEASE);
+}
+
+can_bus_shm_t* can_bus_shm_open(const char* name)
+{
+    bool created = true;
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        created = false;
+        fd = shm_open(name, O_RDWR, 0);
+    }
+    if (fd < 0) {
+        return NULL;
+    }
+
+    if (created) {
+        if (ftruncate(fd, sizeof(can_bus_shm_t)) < 0) {
+            close(fd);
+            return NULL;
+        }
+    } else {
+        /* The creator might not have resized it yet */
+        struct stat st;
+        int retries = CAN_BUS_SHM_OPEN_RETRIES;
+        while (fstat(fd, &st) == 0 && st.st_size < (off_t)sizeof(can_bus_shm_t) && retries-- > 0) {
+            sleep_us(CAN_BUS_SHM_OPEN_RETRY_US);
+        }
+        if (st.st_size < (off_t)sizeof(can_bus_shm_t)) {
+            close(fd);
+            return NULL;
+        }
+    }
+
+    void* mem = mmap(NULL, sizeof(can_bus_shm_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        return NULL;
+    }
+
+    can_bus_shm_t* bus = (can_bus_shm_t*)mem;
+    if (created) {
+        can_bus_shm_init(bus);
+        return bus;
+    }
+
+    int retries = CAN_BUS_SHM_OPEN_RETRIES;
+    while (__atomic_load_n(&bus->magic, __ATOMIC_ACQUIRE) != CAN_BUS_SHM_MAGIC) {
+        if (retries-- == 0) {
+            munmap(mem, sizeof(can_bus_shm_t));
+            return NULL;
+        }
+        sleep_us(CAN_BUS_SHM_OPEN_RETRY_US);
+    }
+
+    return bus;
+}
+
+void can_bus_shm_unlink(const char* name)
+{
+    shm_unlink(name);
+}
+
+void can_bus_shm_endpoint_init(can_bus_shm_endpoint_t* endpoint, can_bus_shm_t* bus)
+{
+    endpoint->bus = bus;
+    endpoint->id = __atomic_fetch_add(&bus->endpoint_count, 1, __ATOMIC_RELAXED);
+    endpoint->read_index = __atomic_load_n(&bus->write_index, __ATOMIC_ACQUIRE);
+    endpoint->overruns = 0;
+}
+
+void can_bus_shm_send(can_bus_shm_endpoint_t* endpoint, const can_bus_shm_frame_t* frame)
+{
+    can_bus_shm_t* bus = endpoint->bus;
+
+    uint64_t index = __atomic_fetch_add(&bus->write_index, 1, __ATOMIC_RELAXED);
+    can_bus_shm_slot_t* slot = &bus->slots[index & CAN_BUS_SHM_MASK];
+
+    /* Same protocol as a seqlock, so that readers notice when a slot is
+     * overwritten while they copy it */
+    __atomic_store_n(&slot->seq, 2 * index + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    slot->frame = *frame;
+    slot->frame.sender = endpoint->id;
+
+    __atomic_store_n(&slot->seq, 2 * (index + 1), __ATOMIC_RELEASE);
+
+    __atomic_add_fetch(&bus->notify, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&bus->waiters, __ATOMIC_SEQ_CST) > 0) {
+        notify_wake(&bus->notify);
+    }
+}
+
+bool can_bus_shm_receive(can_bus_shm_endpoint_t* endpoint, can_bus_shm_frame_t* frame)
+{
+    can_bus_shm_t* bus = endpoint->bus;
+
+    while (true) {
+        uint64_t index = endpoint->read_index;
+        can_bus_shm_slot_t* slot = &bus->slots[index & CAN_BUS_SHM_MASK];
+        uint64_t expected = 2 * (index + 1);
+
+        uint64_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if (seq < expected) {
+            /* Not sent yet, or still being written */
+            return false;
+        }
+
+        if (seq == expected) {
+            *frame = slot->frame;
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == seq) {
+                endpoint->read_index++;
+                if (frame->sender == endpoint->id) {
+                    continue;
+                }
+                return true;
+            }
+        }
+
+        /* The slot was reused by a later frame: we fell a whole ring behind.
+         * Skip to the middle of the ring, so that the frames left are not
+         * overwritten again right away. */
+        endpoint->overruns++;
+        endpoint->read_index = __atomic_load_n(&bus->write_index, __ATOMIC_ACQUIRE) - CAN_BUS_SHM_SIZE / 2;
+    }
+}
+
+bool can_bus_shm_wait(can_bus_shm_endpoint_t* endpoint, uint64_t timeout_us)
+{
+    can_bus_shm_t* bus = endpoint->bus;
+
+    __atomic_add_fetch(&bus->waiters, 1, __ATOMIC_SEQ_CST);
+    uint32_t notify = __atomic_load_n(&bus->notify, __ATOMIC_SEQ_CST);
+
+    bool pending = __atomic_load_n(&bus->write_index, __ATOMIC_ACQUIRE) != endpoint->read_index;
+    if (!pending && timeout_us > 0) {
+        notify_wait(&bus->notify, notify, timeout_us);
+        pending = __atomic_load_n(&bus->write_index, __ATOMIC_ACQUIRE) != endpoint->read_index;
+    }
+
+    __atomic_sub_fetch(&bus->waiters, 1, __ATOMIC_SEQ_CST);
+    return pending;
+}
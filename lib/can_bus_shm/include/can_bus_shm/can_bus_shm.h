@@ -0,0 +1,98 @@
+#ifndef CAN_BUS_SHM_H
+#define CAN_BUS_SHM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of frames the bus holds, must be a power of two. A receiver which
+ * falls behind by more than that loses frames. */
+#define CAN_BUS_SHM_SIZE 4096
+
+typedef struct {
+    uint32_t id; /* CAN ID with the UAVCAN flags (extended, RTR, error) */
+    uint8_t dlc;
+    uint8_t data[8];
+    uint16_t sender; /* Endpoint which sent the frame */
+} can_bus_shm_frame_t;
+
+typedef struct {
+    /* 2 * (index + 1) once frame index is written, odd while it is written */
+    uint64_t seq;
+    can_bus_shm_frame_t frame;
+} can_bus_shm_slot_t;
+
+/** Emulated CAN bus in memory, which can be shared between processes.
+ *
+ * Every frame sent on the bus is received by every other endpoint, like on a
+ * real bus. Frames are written once in a ring, from which each endpoint copies
+ * them at its own pace, so sending never blocks and never goes through the
+ * kernel (unless a receiver is waiting for frames).
+ *
+ * Senders claim slots with an atomic increment and publish them with a
+ * sequence number, so several endpoints can send at the same time without
+ * locks.
+ */
+typedef struct {
+    uint32_t magic;
+
+    /* Index of the next frame to be sent */
+    uint64_t write_index;
+
+    /* Incremented after each frame, waited on by idle receivers (futex) */
+    uint32_t notify;
+    uint32_t waiters;
+
+    uint32_t endpoint_count;
+
+    can_bus_shm_slot_t slots[CAN_BUS_SHM_SIZE];
+} can_bus_shm_t;
+
+/** One node connected to the bus. */
+typedef struct {
+    can_bus_shm_t* bus;
+    uint64_t read_index;
+    uint16_t id;
+
+    /* Number of times the endpoint fell behind and lost frames */
+    uint32_t overruns;
+} can_bus_shm_endpoint_t;
+
+void can_bus_shm_init(can_bus_shm_t* bus);
+
+/** Opens the bus in the POSIX shared memory object of the given name (for
+ * example "/cvra_can"), creating it if this is the first user.
+ *
+ * @returns The bus, or NULL if the shared memory could not be mapped.
+ */
+can_bus_shm_t* can_bus_shm_open(const char* name);
+
+/** Removes the name of a shared bus, processes using it keep doing so. */
+void can_bus_shm_unlink(const char* name);
+
+/** Connects an endpoint to the bus. It receives the frames sent after that. */
+void can_bus_shm_endpoint_init(can_bus_shm_endpoint_t* endpoint, can_bus_shm_t* bus);
+
+/** Sends a frame to all the other endpoints. Never blocks. */
+void can_bus_shm_send(can_bus_shm_endpoint_t* endpoint, const can_bus_shm_frame_t* frame);
+
+/** Copies the next frame sent by another endpoint.
+ *
+ * @returns false if there is no frame to read.
+ */
+bool can_bus_shm_receive(can_bus_shm_endpoint_t* endpoint, can_bus_shm_frame_t* frame);
+
+/** Blocks until another frame may have been sent, or for at most timeout_us.
+ *
+ * @returns true if there may be a frame to read.
+ */
+bool can_bus_shm_wait(can_bus_shm_endpoint_t* endpoint, uint64_t timeout_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAN_BUS_SHM_H */
@@ -0,0 +1,52 @@
+#ifndef CAN_BUS_SHM_CAN_DRIVER_HPP
+#define CAN_BUS_SHM_CAN_DRIVER_HPP
+
+#include <memory>
+#include <string>
+#include <uavcan_linux/uavcan_linux.hpp>
+#include "uavcan_driver.hpp"
+
+/** Prefix of interface names designating a shared memory bus, for example
+ * "shm:/cvra_can". */
+#define CAN_BUS_SHM_IFACE_PREFIX "shm:"
+
+/** @returns The name of the shared memory bus designated by an interface
+ * name, or an empty string for a SocketCAN interface. */
+inline std::string can_driver_shm_name(const std::string& iface)
+{
+    const std::string prefix = CAN_BUS_SHM_IFACE_PREFIX;
+
+    if (iface.compare(0, prefix.size(), prefix) != 0) {
+        return "";
+    }
+    return iface.substr(prefix.size());
+}
+
+/** Opens a CAN interface for a node running on Linux: a shared memory bus if
+ * the name starts with CAN_BUS_SHM_IFACE_PREFIX, a SocketCAN interface
+ * otherwise.
+ *
+ * @returns The driver, or nullptr if the interface could not be opened.
+ */
+inline std::unique_ptr<uavcan::ICanDriver> can_driver_open(const std::string& iface,
+                                                           uavcan_linux::SystemClock& clock)
+{
+    const std::string shm_name = can_driver_shm_name(iface);
+
+    if (!shm_name.empty()) {
+        /* Stays mapped until the process exits */
+        can_bus_shm_t* bus = can_bus_shm_open(shm_name.c_str());
+        if (bus == nullptr) {
+            return nullptr;
+        }
+        return std::unique_ptr<uavcan::ICanDriver>(new ShmCanDriver(clock, bus));
+    }
+
+    std::unique_ptr<uavcan_linux::SocketCanDriver> driver(new uavcan_linux::SocketCanDriver(clock));
+    if (driver->addIface(iface) < 0) {
+        return nullptr;
+    }
+    return std::move(driver);
+}
+
+#endif /* CAN_BUS_SHM_CAN_DRIVER_HPP */
@@ -0,0 +1,130 @@
+#ifndef CAN_BUS_SHM_UAVCAN_DRIVER_HPP
+#define CAN_BUS_SHM_UAVCAN_DRIVER_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <uavcan/driver/can.hpp>
+#include <uavcan/driver/system_clock.hpp>
+#include "can_bus_shm.h"
+
+/** UAVCAN driver for a single interface on a shared memory bus.
+ *
+ * It replaces the SocketCAN driver when all the nodes run on the same
+ * machine: frames are copied once into the bus instead of going through the
+ * kernel once per listener.
+ */
+class ShmCanDriver : public uavcan::ICanDriver, public uavcan::ICanIface {
+    uavcan::ISystemClock& clock;
+    can_bus_shm_endpoint_t endpoint;
+
+    /* Frames sent with the loopback flag, which uavcan expects to receive
+     * back for its transfer timestamps */
+    std::deque<uavcan::CanFrame> loopback;
+
+public:
+    ShmCanDriver(uavcan::ISystemClock& clock, can_bus_shm_t* bus)
+        : clock(clock)
+    {
+        can_bus_shm_endpoint_init(&endpoint, bus);
+    }
+
+    int16_t send(const uavcan::CanFrame& frame, uavcan::MonotonicTime tx_deadline,
+                 uavcan::CanIOFlags flags) override
+    {
+        (void)tx_deadline;
+
+        can_bus_shm_frame_t f;
+        f.id = frame.id;
+        f.dlc = frame.dlc;
+        std::memcpy(f.data, frame.data, sizeof(f.data));
+        can_bus_shm_send(&endpoint, &f);
+
+        if (flags & uavcan::CanIOFlagLoopback) {
+            loopback.push_back(frame);
+        }
+        return 1;
+    }
+
+    int16_t receive(uavcan::CanFrame& out_frame, uavcan::MonotonicTime& out_ts_monotonic,
+                    uavcan::UtcTime& out_ts_utc, uavcan::CanIOFlags& out_flags) override
+    {
+        out_ts_monotonic = clock.getMonotonic();
+        out_ts_utc = clock.getUtc();
+
+        if (!loopback.empty()) {
+            out_frame = loopback.front();
+            out_flags = uavcan::CanIOFlagLoopback;
+            loopback.pop_front();
+            return 1;
+        }
+
+        can_bus_shm_frame_t f;
+        if (!can_bus_shm_receive(&endpoint, &f)) {
+            return 0;
+        }
+
+        out_frame = uavcan::CanFrame(f.id, f.data, std::min<uint8_t>(f.dlc, 8));
+        out_flags = 0;
+        return 1;
+    }
+
+    /* No hardware filters: uavcan filters the frames itself */
+    int16_t configureFilters(const uavcan::CanFilterConfig* filter_configs,
+                             uint16_t num_configs) override
+    {
+        (void)filter_configs;
+        (void)num_configs;
+        return 0;
+    }
+
+    uint16_t getNumFilters() const override
+    {
+        return 0;
+    }
+
+    uint64_t getErrorCount() const override
+    {
+        return endpoint.overruns;
+    }
+
+    uavcan::ICanIface* getIface(uint8_t iface_index) override
+    {
+        return iface_index == 0 ? this : nullptr;
+    }
+
+    uint8_t getNumIfaces() const override
+    {
+        return 1;
+    }
+
+    int16_t select(uavcan::CanSelectMasks& inout_masks,
+                   const uavcan::CanFrame* (&pending_tx)[uavcan::MaxCanIfaces],
+                   uavcan::MonotonicTime blocking_deadline) override
+    {
+        (void)pending_tx;
+
+        /* Sending never blocks */
+        const bool want_write = inout_masks.write & 1;
+        bool readable = !loopback.empty();
+
+        if (!readable) {
+            /* In lockstep mode the node is spun with spinOnce(), whose
+             * deadline is now, so this only polls */
+            uint64_t timeout_us = 0;
+            if (!want_write) {
+                const uavcan::MonotonicTime now = clock.getMonotonic();
+                if (blocking_deadline > now) {
+                    timeout_us = (blocking_deadline - now).toUSec();
+                }
+            }
+            readable = can_bus_shm_wait(&endpoint, timeout_us);
+        }
+
+        inout_masks.read = readable ? 1 : 0;
+        inout_masks.write = want_write ? 1 : 0;
+        return 1;
+    }
+};
+
+#endif /* CAN_BUS_SHM_UAVCAN_DRIVER_HPP */
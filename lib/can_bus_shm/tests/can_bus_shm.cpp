@@ -0,0 +1,198 @@
+#include <CppUTest/TestHarness.h>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <can_bus_shm/can_bus_shm.h>
+
+static can_bus_shm_frame_t make_frame(uint32_t id)
+{
+    can_bus_shm_frame_t frame = {};
+    frame.id = id;
+    frame.dlc = 4;
+    for (int i = 0; i < 4; i++) {
+        frame.data[i] = (id >> (8 * i)) & 0xff;
+    }
+    return frame;
+}
+
+TEST_GROUP (CanBusShmTestGroup) {
+    /* Too large for the stack */
+    std::unique_ptr<can_bus_shm_t> bus{new can_bus_shm_t};
+    can_bus_shm_endpoint_t a, b, c;
+    can_bus_shm_frame_t frame;
+
+    void setup() override
+    {
+        can_bus_shm_init(bus.get());
+        can_bus_shm_endpoint_init(&a, bus.get());
+        can_bus_shm_endpoint_init(&b, bus.get());
+        can_bus_shm_endpoint_init(&c, bus.get());
+    }
+};
+
+TEST(CanBusShmTestGroup, NothingToReceiveOnAnEmptyBus)
+{
+    CHECK_FALSE(can_bus_shm_receive(&a, &frame));
+}
+
+TEST(CanBusShmTestGroup, EveryOtherEndpointReceivesTheFrame)
+{
+    auto sent = make_frame(0x1234);
+    can_bus_shm_send(&a, &sent);
+
+    CHECK_TRUE(can_bus_shm_receive(&b, &frame));
+    CHECK_EQUAL(0x1234, frame.id);
+    CHECK_EQUAL(4, frame.dlc);
+    MEMCMP_EQUAL(sent.data, frame.data, 4);
+    CHECK_EQUAL(a.id, frame.sender);
+
+    CHECK_TRUE(can_bus_shm_receive(&c, &frame));
+    CHECK_EQUAL(0x1234, frame.id);
+
+    CHECK_FALSE(can_bus_shm_receive(&b, &frame));
+}
+
+TEST(CanBusShmTestGroup, SenderDoesNotReceiveItsOwnFrames)
+{
+    auto sent = make_frame(1);
+    can_bus_shm_send(&a, &sent);
+
+    CHECK_FALSE(can_bus_shm_receive(&a, &frame));
+}
+
+TEST(CanBusShmTestGroup, FramesAreReceivedInOrder)
+{
+    for (uint32_t i = 0; i < 10; i++) {
+        auto sent = make_frame(i);
+        can_bus_shm_send(i % 2 ? &a : &c, &sent);
+    }
+
+    for (uint32_t i = 0; i < 10; i++) {
+        CHECK_TRUE(can_bus_shm_receive(&b, &frame));
+        CHECK_EQUAL(i, frame.id);
+    }
+}
+
+TEST(CanBusShmTestGroup, LateEndpointOnlyReceivesNewFrames)
+{
+    auto sent = make_frame(1);
+    can_bus_shm_send(&a, &sent);
+
+    can_bus_shm_endpoint_t late;
+    can_bus_shm_endpoint_init(&late, bus.get());
+    CHECK_FALSE(can_bus_shm_receive(&late, &frame));
+
+    sent = make_frame(2);
+    can_bus_shm_send(&a, &sent);
+    CHECK_TRUE(can_bus_shm_receive(&late, &frame));
+    CHECK_EQUAL(2, frame.id);
+}
+
+TEST(CanBusShmTestGroup, SlowReceiverSkipsToRecentFrames)
+{
+    for (uint32_t i = 0; i < CAN_BUS_SHM_SIZE + 10; i++) {
+        auto sent = make_frame(i);
+        can_bus_shm_send(&a, &sent);
+    }
+
+    CHECK_TRUE(can_bus_shm_receive(&b, &frame));
+    CHECK_EQUAL(1, b.overruns);
+    CHECK_EQUAL(CAN_BUS_SHM_SIZE / 2 + 10, frame.id);
+}
+
+TEST(CanBusShmTestGroup, WaitReturnsImmediatelyWhenFramesArePending)
+{
+    auto sent = make_frame(1);
+    can_bus_shm_send(&a, &sent);
+
+    CHECK_TRUE(can_bus_shm_wait(&b, 10000000));
+}
+
+TEST(CanBusShmTestGroup, WaitTimesOut)
+{
+    CHECK_FALSE(can_bus_shm_wait(&b, 1000));
+}
+
+TEST(CanBusShmTestGroup, WaitIsWokenUpBySend)
+{
+    std::thread receiver([&]() {
+        while (!can_bus_shm_receive(&b, &frame)) {
+            can_bus_shm_wait(&b, 10000000);
+        }
+    });
+
+    usleep(1000);
+    auto sent = make_frame(42);
+    can_bus_shm_send(&a, &sent);
+    receiver.join();
+
+    CHECK_EQUAL(42, frame.id);
+}
+
+TEST(CanBusShmTestGroup, ConcurrentSendersDoNotLoseFrames)
+{
+    const uint32_t frames_per_sender = 1000;
+
+    std::vector<std::thread> senders;
+    for (auto* endpoint : {&a, &c}) {
+        senders.emplace_back([endpoint, frames_per_sender]() {
+            for (uint32_t i = 0; i < frames_per_sender; i++) {
+                auto sent = make_frame((endpoint->id << 16) | i);
+                can_bus_shm_send(endpoint, &sent);
+            }
+        });
+    }
+
+    std::set<uint32_t> received;
+    while (received.size() < 2 * frames_per_sender) {
+        if (can_bus_shm_receive(&b, &frame)) {
+            CHECK_EQUAL(frame.id >> 16, frame.sender);
+            CHECK_EQUAL((frame.id >> 8) & 0xff, frame.data[1]);
+            received.insert(frame.id);
+        } else {
+            can_bus_shm_wait(&b, 1000);
+        }
+    }
+
+    for (auto& t : senders) {
+        t.join();
+    }
+    CHECK_EQUAL(0, b.overruns);
+}
+
+TEST_GROUP (CanBusShmSharedTestGroup) {
+    const char* name = "/can_bus_shm_test";
+
+    void setup() override
+    {
+        can_bus_shm_unlink(name);
+    }
+
+    void teardown() override
+    {
+        can_bus_shm_unlink(name);
+    }
+};
+
+TEST(CanBusShmSharedTestGroup, SecondOpenSharesTheBus)
+{
+    can_bus_shm_t* first = can_bus_shm_open(name);
+    can_bus_shm_t* second = can_bus_shm_open(name);
+    CHECK_TRUE(first != nullptr);
+    CHECK_TRUE(second != nullptr);
+    CHECK_TRUE(first != second);
+
+    can_bus_shm_endpoint_t a, b;
+    can_bus_shm_endpoint_init(&a, first);
+    can_bus_shm_endpoint_init(&b, second);
+
+    auto sent = make_frame(7);
+    can_bus_shm_send(&a, &sent);
+
+    can_bus_shm_frame_t frame;
+    CHECK_TRUE(can_bus_shm_receive(&b, &frame));
+    CHECK_EQUAL(7, frame.id);
+    CHECK_TRUE(a.id != b.id);
+}
@@ -0,0 +1,142 @@
+#include <vector>
+#include <random>
+#include <climits>
+#include <benchmark/benchmark.h>
+#include <dijkstra/dijkstra.hpp>
+
+struct Cell {
+    int x, y;
+};
+
+using GridNode = pathfinding::Node<Cell, 4>;
+
+/* Square grid with random edge costs, each cost being at least 1 so that the
+ * manhattan distance is a valid A* heuristic. */
+static std::vector<GridNode> make_grid(int size)
+{
+    std::vector<GridNode> grid;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> cost(1, 10);
+
+    for (auto y = 0; y < size; y++) {
+        for (auto x = 0; x < size; x++) {
+            grid.push_back(GridNode({x, y}));
+        }
+    }
+
+    for (auto y = 0; y < size; y++) {
+        for (auto x = 0; x < size; x++) {
+            if (x < size - 1) {
+                connect_bidirectional(grid[y * size + x], grid[y * size + x + 1], cost(rng));
+            }
+            if (y < size - 1) {
+                connect_bidirectional(grid[y * size + x], grid[(y + 1) * size + x], cost(rng));
+            }
+        }
+    }
+
+    return grid;
+}
+
+static int manhattan(const Cell& a, const Cell& b)
+{
+    return abs(a.x - b.x) + abs(a.y - b.y);
+}
+
+static const int MAX_NODES = 256 * 256;
+
+static void BM_Dijkstra(benchmark::State& state)
+{
+    const int size = state.range(0);
+    auto grid = make_grid(size);
+    static pathfinding::Pathfinder<GridNode, MAX_NODES> pathfinder;
+
+    for (auto _ : state) {
+        auto len = pathfinder.dijkstra(grid.front(), grid.back());
+        benchmark::DoNotOptimize(len);
+    }
+    state.SetComplexityN(size * size);
+}
+
+static void BM_AStar(benchmark::State& state)
+{
+    const int size = state.range(0);
+    auto grid = make_grid(size);
+    static pathfinding::Pathfinder<GridNode, MAX_NODES> pathfinder;
+
+    for (auto _ : state) {
+        auto len = pathfinder.astar(grid.front(), grid.back(), manhattan);
+        benchmark::DoNotOptimize(len);
+    }
+    state.SetComplexityN(size * size);
+}
+
+/* Queries between close nodes of a large graph, showing that the cost of a
+ * query does not depend on the size of the graph. */
+static void BM_ShortQueries(benchmark::State& state)
+{
+    const int size = state.range(0);
+    auto grid = make_grid(size);
+    static pathfinding::Pathfinder<GridNode, MAX_NODES> pathfinder;
+    int i = 0;
+
+    for (auto _ : state) {
+        auto start = (i * 7919) % (size * size - 2 * size);
+        auto len = pathfinder.dijkstra(grid[start], grid[start + size + 1]);
+        benchmark::DoNotOptimize(len);
+        i++;
+    }
+}
+
+/* Previous implementation, unit costs and linear scan for the next node. */
+static void legacy_dijkstra(std::vector<GridNode>& nodes, std::vector<int>& distance, std::vector<bool>& visited, int start, int end)
+{
+    const int count = nodes.size();
+    for (auto i = 0; i < count; i++) {
+        visited[i] = false;
+        distance[i] = INT_MAX;
+    }
+    distance[start] = 0;
+    auto size = nodes.back().data.x + 1;
+    auto v = start;
+
+    while (!visited[v] && v != end) {
+        visited[v] = true;
+        auto c = nodes[v].data;
+        int neighbors[4] = {v - 1, v + 1, v - size, v + size};
+        bool valid[4] = {c.x > 0, c.x < size - 1, c.y > 0, c.y < size - 1};
+        for (auto i = 0; i < 4; i++) {
+            if (valid[i] && distance[neighbors[i]] > distance[v] + 1) {
+                distance[neighbors[i]] = distance[v] + 1;
+            }
+        }
+
+        int min_distance = INT_MAX;
+        for (auto i = 0; i < count; i++) {
+            if (!visited[i] && min_distance > distance[i]) {
+                min_distance = distance[i];
+                v = i;
+            }
+        }
+    }
+}
+
+static void BM_LegacyDijkstra(benchmark::State& state)
+{
+    const int size = state.range(0);
+    auto grid = make_grid(size);
+    std::vector<int> distance(grid.size());
+    std::vector<bool> visited(grid.size());
+
+    for (auto _ : state) {
+        legacy_dijkstra(grid, distance, visited, 0, grid.size() - 1);
+        benchmark::DoNotOptimize(distance.data());
+    }
+    state.SetComplexityN(size * size);
+}
+
+BENCHMARK(BM_Dijkstra)->RangeMultiplier(2)->Range(16, 256)->Complexity();
+BENCHMARK(BM_AStar)->RangeMultiplier(2)->Range(16, 256)->Complexity();
+BENCHMARK(BM_ShortQueries)->RangeMultiplier(2)->Range(16, 256);
+BENCHMARK(BM_LegacyDijkstra)->RangeMultiplier(2)->Range(16, 64)->Complexity();
+BENCHMARK_MAIN();
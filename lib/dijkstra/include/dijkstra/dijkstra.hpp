@@ -1,10 +1,17 @@
 #pragma once
 
+#include <atomic>
 #include <iterator>
 #include <climits>
 
 namespace pathfinding {
 
+template <typename Node>
+class PathfinderBase;
+
+template <typename Node>
+class IndexedHeap;
+
 /** Class storing a node in the graph for Dijkstra
  *
  * @parameter Data an application-specific piece of data, such as an arm configuration.
@@ -13,94 +20,283 @@ namespace pathfinding {
 template <typename Data, int N = 10>
 class Node {
 protected:
-    Node<Data>* edges[N];
+    Node<Data, N>* edges[N];
+    int costs[N];
     int edge_count;
 
-    /* Used for dijkstra */
+    /* Used for dijkstra. Those fields are only valid if query matches the
+     * query currently running, which avoids resetting every node. */
+    unsigned query;
     bool visited;
     int distance;
-    Node<Data>* parent;
+    int heap_index;
+    int heap_priority;
+    Node<Data, N>* parent;
 
 public:
-    template <typename T>
-    friend int dijkstra(T* nodes, int node_count, T& start, T& end);
+    friend class PathfinderBase<Node<Data, N>>;
+    friend class IndexedHeap<Node<Data, N>>;
 
     Node(Data d)
         : edge_count(0)
+        , query(0)
+        , path_next(nullptr)
         , data{d}
     {
     }
 
-    void connect(Node<Data>& n)
+    /** Adds an edge to n, going through it costing cost. */
+    void connect(Node<Data, N>& n, int cost = 1)
     {
         edges[edge_count] = &n;
+        costs[edge_count] = cost;
         edge_count += 1;
     }
 
-    Node<Data>* path_next; ///< Pointer to the next node in the calculated path
+    /** Cost of the shortest path from the start of the last search to this
+     * node. Only valid for nodes on the found path. */
+    int path_cost() const
+    {
+        return distance;
+    }
+
+    Node<Data, N>* path_next; ///< Pointer to the next node in the calculated path
     Data data;
 };
 
 /** Connects two nodes in both directions
  */
-template <typename Data>
-void connect_bidirectional(Node<Data>& lhs, Node<Data>& rhs)
+template <typename Data, int N>
+void connect_bidirectional(Node<Data, N>& lhs, Node<Data, N>& rhs, int cost = 1)
 {
-    lhs.connect(rhs);
-    rhs.connect(lhs);
+    lhs.connect(rhs, cost);
+    rhs.connect(lhs, cost);
 }
 
-/** Computes the shortest path in the given graph.
- *
- * The path will be stored in the nodes themselves as a linked list. To traverse the path, follow the path_next pointer.
- * Ex:
- *
- * for (auto *p = &start; p->path_next != nullptr; p = p->path_next) {
- *   move_to(p.data);
- * }
+/** Binary min-heap of nodes ordered by priority, used as the search frontier.
  *
- * @returns The path length.
+ * Each node stores its position in the heap, so that its priority can be
+ * decreased in O(log n). The storage is provided by the caller.
  */
 template <typename Node>
-int dijkstra(Node* nodes, int node_count, Node& start, Node& end)
-{
-    for (auto i = 0; i < node_count; i++) {
-        nodes[i].visited = false;
-        nodes[i].distance = INT_MAX;
-        nodes[i].parent = nullptr;
-        nodes[i].path_next = nullptr;
+class IndexedHeap {
+    Node** heap;
+    int capacity;
+    int len;
+
+    void place(int i, Node* node)
+    {
+        heap[i] = node;
+        node->heap_index = i;
     }
 
-    start.distance = 0;
+public:
+    IndexedHeap(Node** storage, int storage_len)
+        : heap(storage)
+        , capacity(storage_len)
+        , len(0)
+    {
+    }
 
-    auto v = &start;
+    bool empty() const
+    {
+        return len == 0;
+    }
 
-    while (v->visited == false) {
-        v->visited = true;
+    /** Inserts node, or moves it up if it is already in the heap and its
+     * priority decreased.
+     *
+     * @returns false if the node had to be inserted but the heap is full.
+     */
+    bool push_or_decrease(Node* node, int priority)
+    {
+        auto i = node->heap_index;
+        if (i < 0) {
+            if (len == capacity) {
+                return false;
+            }
+            i = len;
+            len++;
+        }
 
-        for (auto i = 0; i < v->edge_count; i++) {
-            if (v->edges[i]->distance > v->distance + 1) {
-                v->edges[i]->distance = v->distance + 1;
-                v->edges[i]->parent = v;
+        while (i > 0) {
+            auto parent = (i - 1) / 2;
+            if (heap[parent]->heap_priority <= priority) {
+                break;
             }
+            place(i, heap[parent]);
+            i = parent;
         }
+        node->heap_priority = priority;
+        place(i, node);
+        return true;
+    }
 
-        int min_distance = INT_MAX;
+    Node* pop()
+    {
+        auto top = heap[0];
+        top->heap_index = -1;
+        len--;
 
-        for (auto i = 0; i < node_count; i++) {
-            if (!nodes[i].visited && min_distance > nodes[i].distance) {
-                min_distance = nodes[i].distance;
-                v = &nodes[i];
+        if (len > 0) {
+            auto last = heap[len];
+            auto i = 0;
+            while (true) {
+                auto child = 2 * i + 1;
+                if (child >= len) {
+                    break;
+                }
+                if (child + 1 < len && heap[child + 1]->heap_priority < heap[child]->heap_priority) {
+                    child++;
+                }
+                if (last->heap_priority <= heap[child]->heap_priority) {
+                    break;
+                }
+                place(i, heap[child]);
+                i = child;
             }
+            place(i, last);
         }
+
+        return top;
     }
+};
+
+/** Runs shortest path queries on a graph, see Pathfinder. */
+template <typename Node>
+class PathfinderBase {
+    Node** storage;
+    int storage_len;
 
-    int len = 0;
-    for (auto* p = &end; p != &start; p = p->parent) {
-        p->parent->path_next = p;
-        len++;
+    /* Shared by all the pathfinders, as they can search the same nodes one
+     * after the other, possibly from different threads. */
+    static unsigned next_query()
+    {
+        static std::atomic<unsigned> counter{0};
+        unsigned query = ++counter;
+        // 0 is the query of nodes which were never searched
+        if (query == 0) {
+            query = ++counter;
+        }
+        return query;
     }
 
-    return len;
-}
+    template <typename Heuristic>
+    int search(Node& start, Node& end, Heuristic heuristic)
+    {
+        auto query = next_query();
+        IndexedHeap<Node> frontier(storage, storage_len);
+
+        auto reach = [query](Node* n) {
+            if (n->query != query) {
+                n->query = query;
+                n->visited = false;
+                n->distance = INT_MAX;
+                n->heap_index = -1;
+                n->parent = nullptr;
+            }
+        };
+
+        reach(&start);
+        start.distance = 0;
+        frontier.push_or_decrease(&start, heuristic(start.data, end.data));
+
+        while (!frontier.empty()) {
+            auto v = frontier.pop();
+            v->visited = true;
+
+            if (v == &end) {
+                break;
+            }
+
+            for (auto i = 0; i < v->edge_count; i++) {
+                auto n = v->edges[i];
+                reach(n);
+
+                auto distance = v->distance + v->costs[i];
+                if (!n->visited && n->distance > distance) {
+                    n->distance = distance;
+                    n->parent = v;
+                    if (!frontier.push_or_decrease(n, distance + heuristic(n->data, end.data))) {
+                        // More nodes than the pathfinder was sized for
+                        return -1;
+                    }
+                }
+            }
+        }
+
+        if (end.query != query || !end.visited) {
+            return -1;
+        }
+
+        int len = 0;
+        end.path_next = nullptr;
+        for (auto* p = &end; p != &start; p = p->parent) {
+            p->parent->path_next = p;
+            len++;
+        }
+
+        return len;
+    }
+
+protected:
+    PathfinderBase(Node** frontier_storage, int frontier_len)
+        : storage(frontier_storage)
+        , storage_len(frontier_len)
+    {
+    }
+
+public:
+    /** Computes the shortest path from start to end.
+     *
+     * The path is stored in the nodes as a linked list. To traverse it,
+     * follow the path_next pointers:
+     *
+     * for (auto *p = &start; p->path_next != nullptr; p = p->path_next) {
+     *   move_to(p->data);
+     * }
+     *
+     * @returns The path length (number of edges), or -1 if there is none
+     * or if the search reached more nodes than the pathfinder can hold.
+     */
+    int dijkstra(Node& start, Node& end)
+    {
+        using Data = decltype(start.data);
+        return search(start, end, [](const Data&, const Data&) { return 0; });
+    }
+
+    /** Same as dijkstra, but uses heuristic(data, goal_data) to explore the
+     * nodes closer to the goal first.
+     *
+     * The heuristic must be consistent: it never overestimates the cost to
+     * reach the goal, and does not decrease by more than the cost of an edge
+     * when following it. Otherwise the found path might not be the shortest.
+     */
+    template <typename Heuristic>
+    int astar(Node& start, Node& end, Heuristic heuristic)
+    {
+        return search(start, end, heuristic);
+    }
+};
+
+/** Runs shortest path queries on a graph without allocating memory.
+ *
+ * Nodes are reset lazily when a query reaches them, so the cost of a query
+ * only depends on the part of the graph it explores. Queries on the same
+ * nodes must not run concurrently.
+ *
+ * @parameter Node The node type of the graph.
+ * @parameter MaxNodes The maximum number of nodes a query can reach.
+ */
+template <typename Node, int MaxNodes>
+class Pathfinder : public PathfinderBase<Node> {
+    Node* frontier[MaxNodes];
+
+public:
+    Pathfinder()
+        : PathfinderBase<Node>(frontier, MaxNodes)
+    {
+    }
+};
+
 } // namespace pathfinding
@@ -1,5 +1,6 @@
 #include <CppUTest/TestHarness.h>
 #include <CppUTestExt/MockSupport.h>
+#include <vector>
 #include "dijkstra/dijkstra.hpp"
 
 TEST_GROUP (DijkstraTestGroup) {
@@ -17,7 +18,8 @@ TEST(DijkstraTestGroup, CanFindPath)
 {
     pathfinding::Node<int> nodes[] = {{0}, {0}};
     nodes[0].connect(nodes[1]);
-    auto n = pathfinding::dijkstra(nodes, 2, nodes[0], nodes[1]);
+    pathfinding::Pathfinder<pathfinding::Node<int>, 2> pathfinder;
+    auto n = pathfinder.dijkstra(nodes[0], nodes[1]);
 
     CHECK_EQUAL(1, n);
     POINTERS_EQUAL(nodes[0].path_next, &nodes[1]);
@@ -51,10 +53,181 @@ TEST(DijkstraTestGroup, MoreComplexSituation)
         connect_bidirectional(nodes[i], nodes[i + 1]);
     }
 
-    auto n = dijkstra(nodes, COUNT, nodes[DEPOSIT], nodes[PICK]);
+    pathfinding::Pathfinder<pathfinding::Node<Point>, COUNT> pathfinder;
+    auto n = pathfinder.dijkstra(nodes[DEPOSIT], nodes[PICK]);
 
     CHECK_EQUAL(3, n);
     POINTERS_EQUAL(&nodes[RETRACT], nodes[DEPOSIT].path_next);
     POINTERS_EQUAL(&nodes[DEPLOY], nodes[RETRACT].path_next);
     POINTERS_EQUAL(&nodes[PICK], nodes[DEPLOY].path_next);
 }
+
+TEST(DijkstraTestGroup, UnreachableNodeHasNoPath)
+{
+    pathfinding::Node<int> nodes[] = {{0}, {0}};
+    nodes[1].connect(nodes[0]);
+
+    pathfinding::Pathfinder<pathfinding::Node<int>, 2> pathfinder;
+    CHECK_EQUAL(-1, pathfinder.dijkstra(nodes[0], nodes[1]));
+}
+
+TEST(DijkstraTestGroup, PathToStartIsEmpty)
+{
+    pathfinding::Node<int> nodes[] = {{0}, {0}};
+    connect_bidirectional(nodes[0], nodes[1]);
+
+    pathfinding::Pathfinder<pathfinding::Node<int>, 2> pathfinder;
+    CHECK_EQUAL(0, pathfinder.dijkstra(nodes[0], nodes[0]));
+    POINTERS_EQUAL(nullptr, nodes[0].path_next);
+}
+
+TEST(DijkstraTestGroup, UsesEdgeCosts)
+{
+    // The direct edge costs more than going through the middle node
+    pathfinding::Node<int> nodes[] = {{0}, {1}, {2}};
+    nodes[0].connect(nodes[2], 10);
+    nodes[0].connect(nodes[1], 3);
+    nodes[1].connect(nodes[2], 4);
+
+    pathfinding::Pathfinder<pathfinding::Node<int>, 3> pathfinder;
+    auto n = pathfinder.dijkstra(nodes[0], nodes[2]);
+
+    CHECK_EQUAL(2, n);
+    POINTERS_EQUAL(&nodes[1], nodes[0].path_next);
+    POINTERS_EQUAL(&nodes[2], nodes[1].path_next);
+    CHECK_EQUAL(7, nodes[2].path_cost());
+}
+
+namespace {
+struct Cell {
+    int x, y;
+};
+
+using GridNode = pathfinding::Node<Cell, 4>;
+
+int manhattan(const Cell& a, const Cell& b)
+{
+    return abs(a.x - b.x) + abs(a.y - b.y);
+}
+
+int path_cost(GridNode& start, GridNode& end)
+{
+    int cost = 0;
+    for (auto* p = &start; p != &end; p = p->path_next) {
+        cost += manhattan(p->data, p->path_next->data) * ((p->data.x % 3) + 1);
+    }
+    return cost;
+}
+} // namespace
+
+TEST_GROUP (PathfinderTestGroup) {
+    static const int SIZE = 8;
+    std::vector<GridNode> grid;
+
+    void setup() override
+    {
+        for (auto y = 0; y < SIZE; y++) {
+            for (auto x = 0; x < SIZE; x++) {
+                grid.push_back(GridNode({x, y}));
+            }
+        }
+
+        // Moving out of a cell costs more depending on its column, which
+        // makes the cheapest path differ from the shortest one.
+        for (auto y = 0; y < SIZE; y++) {
+            for (auto x = 0; x < SIZE; x++) {
+                auto& n = at(x, y);
+                auto cost = (x % 3) + 1;
+                if (x > 0) {
+                    n.connect(at(x - 1, y), cost);
+                }
+                if (x < SIZE - 1) {
+                    n.connect(at(x + 1, y), cost);
+                }
+                if (y > 0) {
+                    n.connect(at(x, y - 1), cost);
+                }
+                if (y < SIZE - 1) {
+                    n.connect(at(x, y + 1), cost);
+                }
+            }
+        }
+    }
+
+    GridNode& at(int x, int y)
+    {
+        return grid[y * SIZE + x];
+    }
+};
+
+TEST(PathfinderTestGroup, FindsCheapestPath)
+{
+    pathfinding::Pathfinder<GridNode, SIZE * SIZE> pathfinder;
+
+    // Going straight along x = 1 costs 2 per step, column 0 costs 1.
+    auto n = pathfinder.dijkstra(at(1, 0), at(1, 7));
+
+    CHECK_EQUAL(9, n);
+    CHECK_EQUAL(2 + 7 + 1, at(1, 7).path_cost());
+    CHECK_EQUAL(10, path_cost(at(1, 0), at(1, 7)));
+}
+
+TEST(PathfinderTestGroup, AStarFindsSameCostAsDijkstra)
+{
+    pathfinding::Pathfinder<GridNode, SIZE * SIZE> pathfinder;
+
+    for (auto i = 0; i < SIZE * SIZE; i++) {
+        auto& start = grid[i];
+        auto& end = grid[(i * 7 + 3) % (SIZE * SIZE)];
+
+        auto n = pathfinder.dijkstra(start, end);
+        auto cost = end.path_cost();
+        CHECK_EQUAL(cost, path_cost(start, end));
+
+        auto m = pathfinder.astar(start, end, manhattan);
+        CHECK_TRUE(m >= 0);
+        CHECK_TRUE(n >= 0);
+        CHECK_EQUAL(cost, end.path_cost());
+        CHECK_EQUAL(cost, path_cost(start, end));
+    }
+}
+
+TEST(PathfinderTestGroup, QueriesDoNotInterfere)
+{
+    pathfinding::Pathfinder<GridNode, SIZE * SIZE> pathfinder;
+
+    pathfinder.dijkstra(at(0, 0), at(7, 7));
+    auto first_cost = at(7, 7).path_cost();
+
+    // A query ending early leaves some nodes in an intermediate state
+    pathfinder.dijkstra(at(3, 3), at(3, 4));
+    pathfinder.dijkstra(at(0, 0), at(7, 7));
+
+    CHECK_EQUAL(first_cost, at(7, 7).path_cost());
+    CHECK_EQUAL(first_cost, path_cost(at(0, 0), at(7, 7)));
+}
+
+TEST(PathfinderTestGroup, AStarExploresFewerNodes)
+{
+    pathfinding::Pathfinder<GridNode, SIZE * SIZE> pathfinder;
+    int calls = 0;
+
+    pathfinder.astar(at(0, 0), at(7, 0), [&](const Cell& a, const Cell& b) {
+        calls++;
+        return manhattan(a, b);
+    });
+
+    // The heuristic is called each time a node gets closer to the start, but
+    // most of the grid is never reached.
+    CHECK_TRUE(calls < SIZE * SIZE);
+}
+
+TEST(PathfinderTestGroup, FailsWhenTheFrontierDoesNotFit)
+{
+    pathfinding::Pathfinder<GridNode, 4> pathfinder;
+
+    CHECK_EQUAL(-1, pathfinder.dijkstra(at(0, 0), at(7, 7)));
+
+    // Next to the start, the frontier never grows past a few nodes
+    CHECK_EQUAL(1, pathfinder.dijkstra(at(0, 0), at(1, 0)));
+}
@@ -0,0 +1,9 @@
+#!/bin/sh
+CC=clang++
+CFLAGS="-I../include -std=c++14"
+
+cd $(dirname $0)
+
+$CC $CFLAGS -o benchmark -O3 \
+    main.cpp \
+    -lbenchmark -lpthread
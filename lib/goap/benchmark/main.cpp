@@ -0,0 +1,99 @@
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <goap/goap.hpp>
+
+/* Synthetic problem used to see how the planner scales with the number of
+ * actions: the state is a set of flags, and each action sets one of them,
+ * provided the previous one is set. Another action clears everything, so
+ * that the graph has cycles. */
+
+struct Flags {
+    uint32_t bits;
+};
+
+bool operator==(const Flags& lhs, const Flags& rhs)
+{
+    return lhs.bits == rhs.bits;
+}
+
+struct SetFlag : goap::Action<Flags> {
+    int flag;
+
+    SetFlag(int f)
+        : flag(f)
+    {
+    }
+
+    bool can_run(const Flags& state) override
+    {
+        return (flag % 4) == 0 || (state.bits & (1 << (flag - 1)));
+    }
+
+    void plan_effects(Flags& state) override
+    {
+        state.bits |= 1 << flag;
+    }
+
+    bool execute(Flags& state) override
+    {
+        plan_effects(state);
+        return true;
+    }
+};
+
+struct ClearFlags : goap::Action<Flags> {
+    bool can_run(const Flags& state) override
+    {
+        return state.bits != 0;
+    }
+
+    void plan_effects(Flags& state) override
+    {
+        state.bits = 0;
+    }
+
+    bool execute(Flags& state) override
+    {
+        plan_effects(state);
+        return true;
+    }
+};
+
+struct AllFlagsSet : goap::Goal<Flags> {
+    uint32_t mask;
+
+    int distance_to(const Flags& state) const override
+    {
+        return __builtin_popcount(mask & ~state.bits);
+    }
+};
+
+static void BM_Plan(benchmark::State& bench)
+{
+    const int action_count = bench.range(0);
+    static goap::Planner<Flags, goap::BytewiseHash<Flags>, 2000> planner;
+
+    std::vector<SetFlag> set_flags;
+    ClearFlags clear;
+    std::vector<goap::Action<Flags>*> actions;
+
+    for (auto i = action_count - 1; i >= 0; i--) {
+        set_flags.emplace_back(i);
+    }
+    for (auto& a : set_flags) {
+        actions.push_back(&a);
+    }
+    actions.push_back(&clear);
+
+    AllFlagsSet goal;
+    goal.mask = (1u << action_count) - 1;
+    Flags state = {0};
+
+    for (auto _ : bench) {
+        auto len = planner.plan(state, goal, actions.data(), actions.size());
+        benchmark::DoNotOptimize(len);
+    }
+}
+
+BENCHMARK(BM_Plan)->DenseRange(4, 16, 4);
+BENCHMARK_MAIN();
@@ -0,0 +1,201 @@
+#ifndef GOAP_BACKGROUND_PLANNER_HPP
+#define GOAP_BACKGROUND_PLANNER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <goap/goap.hpp>
+
+namespace goap {
+
+/** Time spent planning, in real time. */
+struct BackgroundPlannerStats {
+    /* Plans requested by the executor, and how many of them were ready */
+    unsigned plans;
+    unsigned ready;
+
+    /* Actual searches, on either thread */
+    unsigned searches;
+    int64_t search_total_us;
+    int64_t search_max_us;
+
+    /* Time the executor waited for its plans */
+    int64_t wait_total_us;
+};
+
+/** CachingPlanner with a worker thread, which plans ahead while the actions
+ * are being executed.
+ *
+ * Before executing an action, the executor calls speculate() with the states
+ * it may end up in (usually the predicted effects of the action, and the
+ * current state in case it fails) and the goals it may pursue from there. The
+ * worker plans them in the background and caches the results, so that the
+ * following call to plan() usually finds its plan ready.
+ *
+ * The worker plans one request at a time, holding the planner: plan() waits
+ * for at most one search to finish before planning itself. The actions and
+ * goals must therefore not rely on anything but the given state in can_run(),
+ * plan_effects(), cost() and distance_to(), as those run on the worker
+ * thread, or only on thread-safe objects.
+ */
+template <typename State, typename Hash, int N = 100, int CacheSize = 16, int MaxPlanLen = 10>
+class BackgroundPlanner {
+    struct Request {
+        State state;
+        Goal<State>* goal;
+    };
+
+    CachingPlanner<State, Hash, N, CacheSize, MaxPlanLen> planner;
+    Action<State>** actions;
+    unsigned action_count;
+
+    std::mutex lock;
+    std::condition_variable cond;
+    std::deque<Request> pending;
+    bool stopping = false;
+
+    /* The worker yields the planner between two searches when it is set */
+    std::atomic<int> executor_waiting{0};
+    BackgroundPlannerStats stats = {};
+
+    std::thread worker;
+
+    /* Must be called with the lock held */
+    int search(const State& state, Goal<State>& goal, Action<State>** path, int path_len)
+    {
+        auto misses = planner.cache_misses();
+        auto start = std::chrono::steady_clock::now();
+
+        int len = planner.plan(state, goal, actions, action_count, path, path_len);
+
+        if (planner.cache_misses() != misses) {
+            auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+            stats.searches++;
+            stats.search_total_us += us;
+            stats.search_max_us = std::max<int64_t>(stats.search_max_us, us);
+        }
+        return len;
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> l(lock);
+        while (true) {
+            cond.wait(l, [&]() { return stopping || (!pending.empty() && executor_waiting == 0); });
+            if (stopping) {
+                break;
+            }
+
+            Request request = pending.front();
+            pending.pop_front();
+            search(request.state, *request.goal, nullptr, 0);
+        }
+    }
+
+public:
+    /** The action array must outlive the planner. */
+    BackgroundPlanner(Action<State>* all_actions[], unsigned all_action_count)
+        : actions(all_actions)
+        , action_count(all_action_count)
+        , worker([this]() { run(); })
+    {
+    }
+
+    ~BackgroundPlanner()
+    {
+        {
+            std::lock_guard<std::mutex> l(lock);
+            stopping = true;
+        }
+        cond.notify_all();
+        worker.join();
+    }
+
+    BackgroundPlanner(const BackgroundPlanner&) = delete;
+    BackgroundPlanner& operator=(const BackgroundPlanner&) = delete;
+
+    /** Plans each goal from each state in the background, in that order.
+     * Replaces the requests of previous calls which did not start yet. */
+    void speculate(const State* states, unsigned state_count, Goal<State>* goals[], unsigned goal_count)
+    {
+        {
+            std::lock_guard<std::mutex> l(lock);
+            pending.clear();
+            for (auto s = 0u; s < state_count; s++) {
+                for (auto g = 0u; g < goal_count; g++) {
+                    pending.push_back({states[s], goals[g]});
+                }
+            }
+        }
+        cond.notify_one();
+    }
+
+    /** Same as Planner::plan, but returns immediately if the plan was found
+     * in the background. Drops the speculations which did not start yet. */
+    int plan(const State& state, Goal<State>& goal, Action<State>** path = nullptr, int path_len = 10)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        executor_waiting++;
+        std::unique_lock<std::mutex> l(lock);
+        executor_waiting--;
+        pending.clear();
+
+        auto misses = planner.cache_misses();
+        int len = search(state, goal, path, path_len);
+
+        stats.plans++;
+        if (planner.cache_misses() == misses) {
+            stats.ready++;
+        }
+        stats.wait_total_us += std::chrono::duration_cast<std::chrono::microseconds>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count();
+
+        /* The worker might be waiting for us to be done */
+        l.unlock();
+        cond.notify_one();
+
+        return len;
+    }
+
+    /** Forgets all cached plans. */
+    void invalidate()
+    {
+        std::lock_guard<std::mutex> l(lock);
+        planner.invalidate();
+    }
+
+    /** Waits until all the speculations are planned. */
+    void wait_idle()
+    {
+        /* The worker holds the lock while it plans, so once we get it with
+         * nothing pending it is done */
+        while (true) {
+            {
+                std::lock_guard<std::mutex> l(lock);
+                if (pending.empty()) {
+                    return;
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    BackgroundPlannerStats get_stats()
+    {
+        std::lock_guard<std::mutex> l(lock);
+        return stats;
+    }
+};
+
+} // namespace goap
+
+#endif
@@ -25,6 +25,14 @@ public:
     /** Tries to execute the task and returns true if it suceeded. */
     virtual bool execute(State& state) = 0;
 
+    /** Cost of running this action from the given state, for example the
+     * time it takes. Must be at least 1. Plans minimize the sum of costs. */
+    virtual int cost(const State& state)
+    {
+        (void)state;
+        return 1;
+    }
+
     virtual ~Action() = default;
 };
 
@@ -43,9 +51,23 @@ public:
     virtual ~Goal() = default;
 };
 
-template <typename State, int N = 100>
+/** Plans a sequence of actions reaching a goal, using A*.
+ *
+ * The distance from a state to the goal is the heuristic: the plan found is
+ * the cheapest one as long as the distance never exceeds the cost of the
+ * actions still needed.
+ *
+ * The planner does not allocate: it can visit at most N states, kept in a
+ * binary heap (open set) and a hash table indexed by Hash (all visited
+ * states). Hash must give equal states the same hash, see BytewiseHash for
+ * states compared with memcmp.
+ */
+template <typename State, typename Hash, int N = 100>
 class Planner {
     VisitedState<State> nodes[N];
+    NodeHeap<State, N> open;
+    NodeTable<State, N> table;
+    Hash hash;
 
 public:
     /** Finds a plan from state to goal and returns its length.
@@ -55,21 +77,23 @@ public:
     int plan(const State& state, Goal<State>& goal, Action<State>* actions[], unsigned action_count, Action<State>** path = nullptr, int path_len = 10)
     {
         visited_states_array_to_list(nodes, N);
+        open.clear();
+        table.clear();
 
         auto free_nodes = &nodes[0];
 
-        auto open = list_pop_head(free_nodes);
-        VisitedState<State>* close = nullptr;
-
-        open->state = state;
-        open->cost = 0;
-        open->priority = 0;
-        open->parent = nullptr;
-        open->action = nullptr;
+        auto start = list_pop_head(free_nodes);
+        start->state = state;
+        start->hash = hash(state);
+        start->cost = 0;
+        start->priority = 0;
+        start->parent = nullptr;
+        start->action = nullptr;
+        open.push(start);
+        table.insert(start);
 
-        while (open) {
-            auto current = priority_list_pop(open);
-            list_push_head(close, current);
+        while (!open.empty()) {
+            auto current = open.pop();
 
             if (goal.is_reached(current->state)) {
                 auto len = 0;
@@ -97,56 +121,52 @@ public:
                     // Cannot allocate a new node, abort
                     if (free_nodes == nullptr) {
                         // Garbage collect the node that is most unlikely to be
-                        // visited (i.e. lowest priority)
-                        VisitedState<State>*gc, *gc_prev = nullptr;
-                        for (gc = open; gc && gc->next; gc = gc->next) {
-                            gc_prev = gc;
-                        }
+                        // visited (i.e. highest priority). Nodes in the open
+                        // set cannot be the parent of another node.
+                        auto gc = open.worst();
 
                         if (!gc) {
                             return -2;
                         }
 
-                        if (gc_prev) {
-                            gc_prev->next = nullptr;
-                        }
-
-                        free_nodes = gc;
+                        open.remove(gc);
+                        table.remove(gc);
+                        list_push_head(free_nodes, gc);
                     }
 
                     auto neighbor = list_pop_head(free_nodes);
                     neighbor->state = current->state;
                     action->plan_effects(neighbor->state);
-                    neighbor->cost = current->cost + 1;
-                    neighbor->priority = current->priority + 1 + goal.distance_to(neighbor->state);
+                    neighbor->hash = hash(neighbor->state);
+                    neighbor->cost = current->cost + action->cost(current->state);
+                    neighbor->priority = neighbor->cost + goal.distance_to(neighbor->state);
                     neighbor->parent = current;
                     neighbor->action = action;
 
-                    bool should_insert = true;
+                    // Check if the state was already reached, either in the
+                    // open set or in the already visited states.
+                    auto previous = table.find(neighbor->state, neighbor->hash);
 
-                    // Check if the node is already in the list of nodes
-                    // scheduled to be visited
-                    for (auto p = open; p; p = p->next) {
-                        if (p->state == neighbor->state) {
-                            should_insert = false;
-                            update_queued_state(p, neighbor);
-                        }
+                    if (previous == nullptr) {
+                        open.push(neighbor);
+                        table.insert(neighbor);
+                        continue;
                     }
 
-                    // Check if the state is in the list of already visited
-                    // state
-                    for (auto p = close; p; p = p->next) {
-                        if (p->state == neighbor->state) {
-                            should_insert = false;
-                            update_queued_state(p, neighbor);
+                    if (previous->cost > neighbor->cost) {
+                        previous->cost = neighbor->cost;
+                        previous->priority = neighbor->priority;
+                        previous->parent = neighbor->parent;
+                        previous->action = neighbor->action;
+
+                        // Already visited states are not visited again, as
+                        // open nodes must never be the parent of another node
+                        if (previous->heap_index >= 0) {
+                            open.decrease(previous);
                         }
                     }
 
-                    if (should_insert) {
-                        list_push_head(open, neighbor);
-                    } else {
-                        list_push_head(free_nodes, neighbor);
-                    }
+                    list_push_head(free_nodes, neighbor);
                 }
             }
         }
@@ -156,6 +176,102 @@ public:
     }
 };
 
+/** Planner which remembers its recent plans, so that planning again from an
+ * already seen state is almost free.
+ *
+ * A plan is cached for its start state, goal and action array. Once a plan is
+ * found, the remaining part of it is also cached for each intermediate state,
+ * so that replanning after executing some of its actions (warm start) keeps
+ * following the same plan instead of searching again. This continuation
+ * always reaches the goal but might differ from what a fresh search would
+ * return, as the search is not guaranteed to be optimal.
+ *
+ * Goals and actions are identified by their address: call invalidate() if
+ * their behaviour changes.
+ */
+template <typename State, typename Hash, int N = 100, int CacheSize = 16, int MaxPlanLen = 10>
+class CachingPlanner {
+    Planner<State, Hash, N> planner;
+    PlanCache<State, CacheSize, MaxPlanLen> cache;
+    Hash hash;
+    unsigned hits = 0;
+    unsigned misses = 0;
+
+    void remember(const State& state, Goal<State>& goal, Action<State>* actions[], unsigned action_count, Action<State>** path, int len)
+    {
+        auto h = hash(state);
+
+        // Never overwrite the result of an actual search with a continuation
+        if (cache.find(state, h, &goal, actions, action_count)) {
+            return;
+        }
+
+        auto entry = cache.insert(state, h, &goal, actions, action_count);
+        entry->len = len;
+        for (auto i = 0; i < len; i++) {
+            entry->path[i] = path[i];
+        }
+    }
+
+public:
+    /** Same as Planner::plan, but reuses cached plans when possible. */
+    int plan(const State& state, Goal<State>& goal, Action<State>* actions[], unsigned action_count, Action<State>** path = nullptr, int path_len = 10)
+    {
+        auto entry = cache.find(state, hash(state), &goal, actions, action_count);
+
+        if (entry) {
+            hits++;
+            for (auto i = 0; path && i < entry->len && i < path_len; i++) {
+                path[i] = entry->path[i];
+            }
+            return entry->len;
+        }
+
+        misses++;
+
+        Action<State>* found[MaxPlanLen];
+        auto len = planner.plan(state, goal, actions, action_count, found, MaxPlanLen);
+
+        for (auto i = 0; path && i < len && i < path_len && i < MaxPlanLen; i++) {
+            path[i] = found[i];
+        }
+
+        // Plans which do not fit in the cache are not remembered
+        if (len > MaxPlanLen) {
+            if (path && path_len > MaxPlanLen) {
+                planner.plan(state, goal, actions, action_count, path, path_len);
+            }
+            return len;
+        }
+
+        remember(state, goal, actions, action_count, found, len);
+
+        State intermediate = state;
+        for (auto i = 0; i < len - 1; i++) {
+            found[i]->plan_effects(intermediate);
+            remember(intermediate, goal, actions, action_count, &found[i + 1], len - i - 1);
+        }
+
+        return len;
+    }
+
+    /** Forgets all cached plans. */
+    void invalidate()
+    {
+        cache.clear();
+    }
+
+    unsigned cache_hits() const
+    {
+        return hits;
+    }
+
+    unsigned cache_misses() const
+    {
+        return misses;
+    }
+};
+
 // Distance class, used to build distance metrics that read easily
 class Distance {
     int distance;
@@ -1,27 +1,58 @@
 #ifndef GOAP_INTERNALS_HPP
 #define GOAP_INTERNALS_HPP
 
-#include <limits>
+#include <cstddef>
+#include <cstdint>
 
 namespace goap {
 
 template <typename State>
 class Action;
 
+template <typename State>
+class Goal;
+
 template <typename State>
 struct VisitedState {
     int priority;
     int cost;
     State state;
 
+    // Cached hash of the state, used to index the node in the state table
+    uint32_t hash;
+
     // Used to reconstruct the path
     VisitedState<State>* parent;
     Action<State>* action;
 
+    // Position of the node in the open set, or -1 if it is not in it
+    int heap_index;
+
     // Only used for linked list management
     VisitedState<State>* next;
 };
 
+/** State hash over the raw bytes of the state (FNV-1a).
+ *
+ * It is only valid for states without padding whose operator== compares the
+ * raw bytes too (i.e. uses memcmp): otherwise equal states can hash
+ * differently. Other states need a hash over their fields.
+ */
+template <typename State>
+struct BytewiseHash {
+    uint32_t operator()(const State& state) const
+    {
+        auto bytes = reinterpret_cast<const uint8_t*>(&state);
+        uint32_t hash = 2166136261u;
+
+        for (auto i = 0u; i < sizeof(State); i++) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+
+        return hash;
+    }
+};
+
 template <typename State>
 void visited_states_array_to_list(VisitedState<State>* nodes, int len)
 {
@@ -31,36 +62,6 @@ void visited_states_array_to_list(VisitedState<State>* nodes, int len)
     nodes[len - 1].next = nullptr;
 }
 
-/** Returns the node element in the list with the minimal priority */
-template <typename State>
-VisitedState<State>* priority_list_pop(VisitedState<State>*& list)
-{
-    VisitedState<State>* min_elem = nullptr;
-    auto min_prio = std::numeric_limits<int>::max();
-
-    // Find the element with the lowest priority
-    for (auto p = list; p != nullptr; p = p->next) {
-        if (p->priority < min_prio) {
-            min_elem = p;
-            min_prio = p->priority;
-        }
-    }
-
-    // Remove it from the list
-    if (min_elem == list) {
-        list = list->next;
-    } else {
-        for (auto p = list; p != nullptr; p = p->next) {
-            if (p->next == min_elem) {
-                p->next = p->next->next;
-                min_elem->next = nullptr;
-            }
-        }
-    }
-
-    return min_elem;
-}
-
 template <typename State>
 VisitedState<State>* list_pop_head(VisitedState<State>*& head)
 {
@@ -77,17 +78,269 @@ void list_push_head(VisitedState<State>*& head, VisitedState<State>* elem)
     head = elem;
 }
 
-template <typename State>
-void update_queued_state(VisitedState<State>* previous, const VisitedState<State>* current)
+/** Binary min-heap of nodes ordered by priority, used as the open set.
+ *
+ * Each node stores its position in the heap, so that it can be updated or
+ * removed without searching for it.
+ */
+template <typename State, int N>
+class NodeHeap {
+    VisitedState<State>* heap[N];
+    int len = 0;
+
+    void place(int i, VisitedState<State>* node)
+    {
+        heap[i] = node;
+        node->heap_index = i;
+    }
+
+    void sift_up(int i)
+    {
+        auto node = heap[i];
+        while (i > 0) {
+            int parent = (i - 1) / 2;
+            if (heap[parent]->priority <= node->priority) {
+                break;
+            }
+            place(i, heap[parent]);
+            i = parent;
+        }
+        place(i, node);
+    }
+
+    void sift_down(int i)
+    {
+        auto node = heap[i];
+        while (true) {
+            int child = 2 * i + 1;
+            if (child >= len) {
+                break;
+            }
+            if (child + 1 < len && heap[child + 1]->priority < heap[child]->priority) {
+                child++;
+            }
+            if (node->priority <= heap[child]->priority) {
+                break;
+            }
+            place(i, heap[child]);
+            i = child;
+        }
+        place(i, node);
+    }
+
+public:
+    void clear()
+    {
+        len = 0;
+    }
+
+    bool empty() const
+    {
+        return len == 0;
+    }
+
+    int size() const
+    {
+        return len;
+    }
+
+    void push(VisitedState<State>* node)
+    {
+        place(len, node);
+        len++;
+        sift_up(len - 1);
+    }
+
+    /** Removes and returns the node with the lowest priority. */
+    VisitedState<State>* pop()
+    {
+        auto top = heap[0];
+        remove(top);
+        return top;
+    }
+
+    /** Restores the heap order after the priority of node was decreased. */
+    void decrease(VisitedState<State>* node)
+    {
+        sift_up(node->heap_index);
+    }
+
+    void remove(VisitedState<State>* node)
+    {
+        int i = node->heap_index;
+        len--;
+        node->heap_index = -1;
+
+        if (i == len) {
+            return;
+        }
+
+        place(i, heap[len]);
+        sift_up(i);
+        sift_down(i);
+    }
+
+    /** Returns the node with the highest priority, i.e. the one least likely
+     * to be visited. It is always a leaf, so only the leaves are scanned. */
+    VisitedState<State>* worst() const
+    {
+        VisitedState<State>* res = nullptr;
+        for (int i = len / 2; i < len; i++) {
+            if (res == nullptr || heap[i]->priority > res->priority) {
+                res = heap[i];
+            }
+        }
+        return res;
+    }
+};
+
+/** Returns the smallest power of two greater or equal to n. */
+constexpr int next_power_of_two(int n)
 {
-    if (previous->cost > current->cost) {
-        previous->priority = current->cost;
-        previous->priority = current->priority;
-        previous->parent = current->parent;
-        previous->action = current->action;
+    int res = 1;
+    while (res < n) {
+        res *= 2;
     }
+    return res;
 }
 
+/** Hash table from states to the nodes holding them (open or closed), using
+ * open addressing with linear probing. It is sized to stay at most half full
+ * with N nodes. */
+template <typename State, int N>
+class NodeTable {
+    static constexpr int SIZE = next_power_of_two(2 * N);
+    static constexpr uint32_t MASK = SIZE - 1;
+
+    VisitedState<State>* slots[SIZE];
+
+public:
+    void clear()
+    {
+        for (auto& s : slots) {
+            s = nullptr;
+        }
+    }
+
+    VisitedState<State>* find(const State& state, uint32_t hash) const
+    {
+        for (auto i = hash & MASK; slots[i]; i = (i + 1) & MASK) {
+            if (slots[i]->hash == hash && slots[i]->state == state) {
+                return slots[i];
+            }
+        }
+        return nullptr;
+    }
+
+    void insert(VisitedState<State>* node)
+    {
+        auto i = node->hash & MASK;
+        while (slots[i]) {
+            i = (i + 1) & MASK;
+        }
+        slots[i] = node;
+    }
+
+    void remove(VisitedState<State>* node)
+    {
+        auto i = node->hash & MASK;
+        while (slots[i] != node) {
+            i = (i + 1) & MASK;
+        }
+
+        // Backward shift deletion: move back the following entries of the
+        // cluster which would not be reachable anymore because of the hole.
+        auto hole = i;
+        for (auto j = (i + 1) & MASK; slots[j]; j = (j + 1) & MASK) {
+            auto home = slots[j]->hash & MASK;
+            if (((j - home) & MASK) >= ((j - hole) & MASK)) {
+                slots[hole] = slots[j];
+                hole = j;
+            }
+        }
+        slots[hole] = nullptr;
+    }
+};
+
+/** Plan found for a given start state, goal and set of actions. */
+template <typename State, int MaxPlanLen>
+struct CachedPlan {
+    State state;
+    uint32_t hash;
+
+    // Entry is unused if goal is nullptr
+    const Goal<State>* goal;
+    Action<State>* const* actions;
+    unsigned action_count;
+
+    int len;
+    Action<State>* path[MaxPlanLen];
+
+    // Used to evict the least recently used entry
+    unsigned last_use;
+};
+
+/** Small fully associative cache of plans, with least recently used eviction.
+ *
+ * Goals and actions are identified by their address, so they must keep the
+ * same behaviour as long as their plans are cached.
+ */
+template <typename State, int Size, int MaxPlanLen>
+class PlanCache {
+    CachedPlan<State, MaxPlanLen> entries[Size];
+    unsigned use_counter = 0;
+
+public:
+    PlanCache()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        for (auto& e : entries) {
+            e.goal = nullptr;
+        }
+    }
+
+    CachedPlan<State, MaxPlanLen>* find(const State& state, uint32_t hash, const Goal<State>* goal, Action<State>* const* actions, unsigned action_count)
+    {
+        for (auto& e : entries) {
+            if (e.goal == goal && e.hash == hash && e.actions == actions
+                && e.action_count == action_count && e.state == state) {
+                e.last_use = ++use_counter;
+                return &e;
+            }
+        }
+        return nullptr;
+    }
+
+    /** Returns an entry for the given key, evicting the least recently used
+     * one if needed. The caller is responsible for filling the plan. */
+    CachedPlan<State, MaxPlanLen>* insert(const State& state, uint32_t hash, const Goal<State>* goal, Action<State>* const* actions, unsigned action_count)
+    {
+        auto res = &entries[0];
+        for (auto& e : entries) {
+            if (e.goal == nullptr) {
+                res = &e;
+                break;
+            }
+            if (e.last_use < res->last_use) {
+                res = &e;
+            }
+        }
+
+        res->state = state;
+        res->hash = hash;
+        res->goal = goal;
+        res->actions = actions;
+        res->action_count = action_count;
+        res->len = 0;
+        res->last_use = ++use_counter;
+        return res;
+    }
+};
+
 } // namespace goap
 
 #endif
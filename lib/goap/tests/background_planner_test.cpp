@@ -0,0 +1,149 @@
+#include <cstring>
+#include <vector>
+#include <CppUTest/TestHarness.h>
+#include <goap/background_planner.hpp>
+
+namespace {
+struct CounterState {
+    int a;
+    int b;
+};
+
+bool operator==(const CounterState& lhs, const CounterState& rhs)
+{
+    return !memcmp(&lhs, &rhs, sizeof(CounterState));
+}
+
+struct Increment : goap::Action<CounterState> {
+    int CounterState::*counter;
+    Increment(int CounterState::*c)
+        : counter(c)
+    {
+    }
+
+    bool can_run(const CounterState& state) override
+    {
+        return state.*counter < 5;
+    }
+
+    void plan_effects(CounterState& state) override
+    {
+        state.*counter += 1;
+    }
+
+    bool execute(CounterState& state) override
+    {
+        plan_effects(state);
+        return true;
+    }
+};
+
+struct AtLeast : goap::Goal<CounterState> {
+    int CounterState::*counter;
+    int target;
+    AtLeast(int CounterState::*c, int t)
+        : counter(c)
+        , target(t)
+    {
+    }
+
+    int distance_to(const CounterState& state) const override
+    {
+        return state.*counter >= target ? 0 : target - state.*counter;
+    }
+};
+} // namespace
+
+TEST_GROUP (BackgroundPlannerTestGroup) {
+    Increment inc_a{&CounterState::a}, inc_b{&CounterState::b};
+    goap::Action<CounterState>* actions[2] = {&inc_a, &inc_b};
+    AtLeast a_goal{&CounterState::a, 3}, b_goal{&CounterState::b, 2};
+    goap::Goal<CounterState>* goals[2] = {&a_goal, &b_goal};
+    CounterState state = {0, 0};
+    goap::Action<CounterState>* path[10];
+
+    goap::BackgroundPlanner<CounterState, goap::BytewiseHash<CounterState>, 100> planner{actions, 2};
+};
+
+TEST(BackgroundPlannerTestGroup, PlansWithoutSpeculation)
+{
+    CHECK_EQUAL(3, planner.plan(state, a_goal, path));
+    POINTERS_EQUAL(&inc_a, path[0]);
+    POINTERS_EQUAL(&inc_a, path[2]);
+
+    auto stats = planner.get_stats();
+    CHECK_EQUAL(1, stats.plans);
+    CHECK_EQUAL(0, stats.ready);
+    CHECK_EQUAL(1, stats.searches);
+}
+
+TEST(BackgroundPlannerTestGroup, SpeculatedPlanIsReady)
+{
+    planner.speculate(&state, 1, goals, 1);
+    planner.wait_idle();
+
+    CHECK_EQUAL(3, planner.plan(state, a_goal, path));
+    POINTERS_EQUAL(&inc_a, path[0]);
+
+    auto stats = planner.get_stats();
+    CHECK_EQUAL(1, stats.plans);
+    CHECK_EQUAL(1, stats.ready);
+    CHECK_EQUAL(1, stats.searches);
+}
+
+TEST(BackgroundPlannerTestGroup, SpeculatesEveryStateAndGoal)
+{
+    CounterState states[2] = {{0, 0}, {1, 0}};
+    planner.speculate(states, 2, goals, 2);
+    planner.wait_idle();
+
+    CHECK_EQUAL(3, planner.plan(states[0], a_goal, path));
+    CHECK_EQUAL(2, planner.plan(states[0], b_goal, path));
+    CHECK_EQUAL(2, planner.plan(states[1], a_goal, path));
+    CHECK_EQUAL(2, planner.plan(states[1], b_goal, path));
+    POINTERS_EQUAL(&inc_b, path[0]);
+
+    CHECK_EQUAL(4, planner.get_stats().ready);
+}
+
+TEST(BackgroundPlannerTestGroup, WrongSpeculationIsPlannedAgain)
+{
+    CounterState predicted = {1, 0};
+    planner.speculate(&predicted, 1, goals, 2);
+    planner.wait_idle();
+
+    CounterState actual = {0, 1};
+    CHECK_EQUAL(3, planner.plan(actual, a_goal, path));
+    CHECK_EQUAL(0, planner.get_stats().ready);
+}
+
+TEST(BackgroundPlannerTestGroup, ImpossibleGoal)
+{
+    AtLeast impossible{&CounterState::a, 6};
+
+    CHECK_EQUAL(-1, planner.plan(state, impossible, path));
+}
+
+TEST(BackgroundPlannerTestGroup, CanBeDestroyedWithPendingSpeculations)
+{
+    std::vector<CounterState> states;
+    for (int i = 0; i < 100; i++) {
+        states.push_back({i % 5, i / 20});
+    }
+    auto* p = new goap::BackgroundPlanner<CounterState, goap::BytewiseHash<CounterState>, 100>(actions, 2);
+    p->speculate(states.data(), states.size(), goals, 2);
+    delete p;
+}
+
+TEST(BackgroundPlannerTestGroup, ExecutorAndWorkerRunConcurrently)
+{
+    /* Plays the strategy loop: speculates on the next state, then asks for
+     * it, most of the time while the worker is still planning */
+    for (int i = 0; i < 200; i++) {
+        CounterState next = {i % 3, (i / 3) % 2};
+        planner.speculate(&next, 1, goals, 2);
+        CHECK_EQUAL(2 - next.b, planner.plan(next, b_goal, path));
+    }
+
+    CHECK_EQUAL(200, planner.get_stats().plans);
+}
@@ -0,0 +1,250 @@
+#include <cstring>
+#include <vector>
+#include <CppUTest/TestHarness.h>
+#include <goap/goap.hpp>
+
+namespace {
+struct LockState {
+    uint8_t unlocked;
+    bool alarm;
+};
+
+bool operator==(const LockState& lhs, const LockState& rhs)
+{
+    return !memcmp(&lhs, &rhs, sizeof(LockState));
+}
+
+// Unlocks one of the locks, which must be done in order
+struct Unlock : goap::Action<LockState> {
+    int lock;
+    Unlock(int l)
+        : lock(l)
+    {
+    }
+
+    bool can_run(const LockState& state) override
+    {
+        return !state.alarm && (lock == 0 || (state.unlocked & (1 << (lock - 1))));
+    }
+
+    void plan_effects(LockState& state) override
+    {
+        state.unlocked |= 1 << lock;
+    }
+
+    bool execute(LockState& state) override
+    {
+        plan_effects(state);
+        return true;
+    }
+};
+
+struct ResetAlarm : goap::Action<LockState> {
+    bool can_run(const LockState& state) override
+    {
+        return state.alarm;
+    }
+
+    void plan_effects(LockState& state) override
+    {
+        state.alarm = false;
+        state.unlocked = 0;
+    }
+
+    bool execute(LockState& state) override
+    {
+        plan_effects(state);
+        return true;
+    }
+};
+
+struct LocksOpen : goap::Goal<LockState> {
+    uint16_t mask;
+    LocksOpen(uint16_t m)
+        : mask(m)
+    {
+    }
+
+    int distance_to(const LockState& state) const override
+    {
+        return __builtin_popcount(mask & ~state.unlocked);
+    }
+};
+} // namespace
+
+TEST_GROUP (CachingPlannerTestGroup) {
+    std::vector<Unlock> unlocks;
+    ResetAlarm reset;
+    std::vector<goap::Action<LockState>*> actions;
+    LocksOpen all_open{0xff}, first_open{0x0f};
+    LockState state = {0, false};
+
+    goap::CachingPlanner<LockState, goap::BytewiseHash<LockState>, 100> planner;
+    goap::Planner<LockState, goap::BytewiseHash<LockState>, 100> fresh_planner;
+    goap::Action<LockState>* path[10];
+    goap::Action<LockState>* fresh_path[10];
+
+    void setup() override
+    {
+        for (auto i = 7; i >= 0; i--) {
+            unlocks.emplace_back(i);
+        }
+        for (auto& a : unlocks) {
+            actions.push_back(&a);
+        }
+        actions.push_back(&reset);
+    }
+
+    int plan(const LockState& s, goap::Goal<LockState>& goal)
+    {
+        memset(path, 0, sizeof(path));
+        return planner.plan(s, goal, actions.data(), actions.size(), path, 10);
+    }
+
+    int fresh_plan(const LockState& s, goap::Goal<LockState>& goal)
+    {
+        memset(fresh_path, 0, sizeof(fresh_path));
+        return fresh_planner.plan(s, goal, actions.data(), actions.size(), fresh_path, 10);
+    }
+
+    void check_matches_fresh_plan(const LockState& s, goap::Goal<LockState>& goal)
+    {
+        auto len = plan(s, goal);
+        CHECK_EQUAL(fresh_plan(s, goal), len);
+        for (auto i = 0; i < len; i++) {
+            POINTERS_EQUAL(fresh_path[i], path[i]);
+        }
+    }
+};
+
+TEST(CachingPlannerTestGroup, FirstPlanIsAMiss)
+{
+    check_matches_fresh_plan(state, all_open);
+    CHECK_EQUAL(0, planner.cache_hits());
+    CHECK_EQUAL(1, planner.cache_misses());
+}
+
+TEST(CachingPlannerTestGroup, CachedPlanMatchesFreshPlan)
+{
+    plan(state, all_open);
+    check_matches_fresh_plan(state, all_open);
+    CHECK_EQUAL(1, planner.cache_hits());
+    CHECK_EQUAL(1, planner.cache_misses());
+}
+
+TEST(CachingPlannerTestGroup, CachedPlansMatchFreshPlansFromAnyState)
+{
+    for (auto alarm = 0; alarm < 2; alarm++) {
+        for (auto unlocked = 0; unlocked < 256; unlocked++) {
+            LockState s = {(uint8_t)unlocked, alarm == 1};
+            planner.invalidate();
+            plan(s, all_open);
+            check_matches_fresh_plan(s, all_open);
+            check_matches_fresh_plan(s, first_open);
+            check_matches_fresh_plan(s, first_open);
+        }
+    }
+}
+
+TEST(CachingPlannerTestGroup, GoalIsPartOfTheKey)
+{
+    plan(state, all_open);
+    check_matches_fresh_plan(state, first_open);
+    CHECK_EQUAL(0, planner.cache_hits());
+}
+
+TEST(CachingPlannerTestGroup, ActionsArePartOfTheKey)
+{
+    plan(state, all_open);
+    auto len = planner.plan(state, all_open, actions.data(), actions.size() - 1, path, 10);
+    CHECK_EQUAL(8, len);
+    CHECK_EQUAL(0, planner.cache_hits());
+}
+
+TEST(CachingPlannerTestGroup, FailuresAreCached)
+{
+    LocksOpen impossible{0x1ff};
+    CHECK_EQUAL(-1, plan(state, impossible));
+    CHECK_EQUAL(-1, plan(state, impossible));
+    CHECK_EQUAL(1, planner.cache_hits());
+}
+
+TEST(CachingPlannerTestGroup, ReplanningAfterExecutingActionsContinuesThePlan)
+{
+    auto len = plan(state, all_open);
+    std::vector<goap::Action<LockState>*> initial(path, path + len);
+
+    for (auto executed = 1; executed < len; executed++) {
+        initial[executed - 1]->execute(state);
+
+        CHECK_EQUAL(len - executed, plan(state, all_open));
+        for (auto i = 0; i < len - executed; i++) {
+            POINTERS_EQUAL(initial[executed + i], path[i]);
+        }
+
+        // In this scenario the continuation is also the optimal plan
+        CHECK_EQUAL(fresh_plan(state, all_open), len - executed);
+    }
+
+    CHECK_EQUAL(len - 1, planner.cache_hits());
+    CHECK_EQUAL(1, planner.cache_misses());
+}
+
+TEST(CachingPlannerTestGroup, StateChangeCausesNewSearch)
+{
+    plan(state, all_open);
+    state.alarm = true;
+    check_matches_fresh_plan(state, all_open);
+    CHECK_EQUAL(0, planner.cache_hits());
+    CHECK_EQUAL(2, planner.cache_misses());
+}
+
+TEST(CachingPlannerTestGroup, InvalidateForgetsPlans)
+{
+    plan(state, all_open);
+    planner.invalidate();
+    check_matches_fresh_plan(state, all_open);
+    CHECK_EQUAL(0, planner.cache_hits());
+}
+
+TEST(CachingPlannerTestGroup, OnlyCopiesRequestedPathLength)
+{
+    goap::Action<LockState>* short_path[3] = {nullptr};
+    plan(state, all_open);
+    CHECK_EQUAL(8, planner.plan(state, all_open, actions.data(), actions.size(), short_path, 2));
+    POINTERS_EQUAL(path[0], short_path[0]);
+    POINTERS_EQUAL(path[1], short_path[1]);
+    POINTERS_EQUAL(nullptr, short_path[2]);
+}
+
+TEST(CachingPlannerTestGroup, PlansLongerThanTheCacheAreNotCached)
+{
+    goap::CachingPlanner<LockState, goap::BytewiseHash<LockState>, 100, 16, 4> small_planner;
+    auto len = small_planner.plan(state, all_open, actions.data(), actions.size(), path, 10);
+
+    CHECK_EQUAL(fresh_plan(state, all_open), len);
+    for (auto i = 0; i < len; i++) {
+        POINTERS_EQUAL(fresh_path[i], path[i]);
+    }
+
+    small_planner.plan(state, all_open, actions.data(), actions.size(), path, 10);
+    CHECK_EQUAL(0, small_planner.cache_hits());
+}
+
+TEST(CachingPlannerTestGroup, LeastRecentlyUsedPlanIsEvicted)
+{
+    goap::CachingPlanner<LockState, goap::BytewiseHash<LockState>, 100, 2> small_planner;
+    LockState a = {0x7f, false}, b = {0x3f, false}, c = {0x1f, true};
+
+    small_planner.plan(a, all_open, actions.data(), actions.size());
+    small_planner.plan(c, first_open, actions.data(), actions.size());
+    small_planner.plan(a, all_open, actions.data(), actions.size());
+    CHECK_EQUAL(1, small_planner.cache_hits());
+
+    // Evicts the plan for c, which is the least recently used
+    small_planner.plan(b, first_open, actions.data(), actions.size());
+    small_planner.plan(a, all_open, actions.data(), actions.size());
+    CHECK_EQUAL(2, small_planner.cache_hits());
+    small_planner.plan(c, first_open, actions.data(), actions.size());
+    CHECK_EQUAL(2, small_planner.cache_hits());
+}
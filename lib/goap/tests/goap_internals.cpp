@@ -6,9 +6,14 @@
 using namespace goap;
 
 struct MyState {
-    bool dummy;
+    int value;
 };
 
+bool operator==(const MyState& lhs, const MyState& rhs)
+{
+    return lhs.value == rhs.value;
+}
+
 TEST_GROUP (InternalVisitedListState) {
     std::array<VisitedState<MyState>, 10> nodes;
 };
@@ -23,34 +28,6 @@ TEST(InternalVisitedListState, CanConvertToLinkedList)
     POINTERS_EQUAL(nullptr, nodes[nodes.size() - 1].next);
 }
 
-TEST(InternalVisitedListState, CanPopMinimumPriorityEvent)
-{
-    visited_states_array_to_list<MyState>(nodes.data(), nodes.size());
-
-    for (auto& p : nodes) {
-        p.priority = 42;
-    }
-
-    nodes[2].priority = 10;
-    auto* head = nodes.data();
-    auto* p = priority_list_pop<MyState>(head);
-
-    CHECK_EQUAL(p, &nodes[2]);
-
-    // The element should have been removed from the list
-    POINTERS_EQUAL(&nodes[3], nodes[1].next);
-    POINTERS_EQUAL(nullptr, p->next);
-}
-
-TEST(InternalVisitedListState, CanPopPriorityEventHead)
-{
-    visited_states_array_to_list<MyState>(nodes.data(), 1);
-    auto* head = nodes.data();
-    priority_list_pop<MyState>(head);
-
-    POINTERS_EQUAL(nullptr, head);
-}
-
 TEST(InternalVisitedListState, CanPopFromListHead)
 {
     visited_states_array_to_list<MyState>(nodes.data(), nodes.size());
@@ -90,3 +67,138 @@ TEST(InternalVisitedListState, CanPushEmptyList)
     POINTERS_EQUAL(&new_elem, head);
     POINTERS_EQUAL(nullptr, head->next);
 }
+
+TEST_GROUP (InternalNodeHeap) {
+    std::array<VisitedState<MyState>, 10> nodes;
+    NodeHeap<MyState, 10> heap;
+
+    void setup() override
+    {
+        for (auto i = 0u; i < nodes.size(); i++) {
+            nodes[i].priority = (7 * i) % nodes.size();
+        }
+    }
+};
+
+TEST(InternalNodeHeap, IsEmptyInitially)
+{
+    CHECK_TRUE(heap.empty());
+}
+
+TEST(InternalNodeHeap, PopsInPriorityOrder)
+{
+    for (auto& n : nodes) {
+        heap.push(&n);
+    }
+    CHECK_EQUAL(10, heap.size());
+
+    for (auto i = 0; i < 10; i++) {
+        auto p = heap.pop();
+        CHECK_EQUAL(i, p->priority);
+        CHECK_EQUAL(-1, p->heap_index);
+    }
+    CHECK_TRUE(heap.empty());
+}
+
+TEST(InternalNodeHeap, CanDecreasePriority)
+{
+    for (auto& n : nodes) {
+        heap.push(&n);
+    }
+
+    nodes[3].priority = -1;
+    heap.decrease(&nodes[3]);
+
+    POINTERS_EQUAL(&nodes[3], heap.pop());
+}
+
+TEST(InternalNodeHeap, CanRemoveNode)
+{
+    for (auto& n : nodes) {
+        heap.push(&n);
+    }
+
+    // Node 0 has priority 0, node 3 has priority 1
+    heap.remove(&nodes[0]);
+    CHECK_EQUAL(-1, nodes[0].heap_index);
+    CHECK_EQUAL(9, heap.size());
+    POINTERS_EQUAL(&nodes[3], heap.pop());
+
+    for (auto i = 2; i < 10; i++) {
+        CHECK_EQUAL(i, heap.pop()->priority);
+    }
+}
+
+TEST(InternalNodeHeap, CanFindWorstNode)
+{
+    for (auto& n : nodes) {
+        heap.push(&n);
+    }
+
+    CHECK_EQUAL(9, heap.worst()->priority);
+}
+
+TEST(InternalNodeHeap, WorstOfEmptyHeapIsNull)
+{
+    POINTERS_EQUAL(nullptr, heap.worst());
+}
+
+TEST_GROUP (InternalNodeTable) {
+    std::array<VisitedState<MyState>, 10> nodes;
+    NodeTable<MyState, 10> table;
+
+    void setup() override
+    {
+        table.clear();
+        for (auto i = 0u; i < nodes.size(); i++) {
+            nodes[i].state.value = i;
+            // Force collisions to test the probing
+            nodes[i].hash = i % 3;
+        }
+    }
+};
+
+TEST(InternalNodeTable, EmptyTableDoesNotFindAnything)
+{
+    POINTERS_EQUAL(nullptr, table.find(nodes[0].state, nodes[0].hash));
+}
+
+TEST(InternalNodeTable, CanFindInsertedNodes)
+{
+    for (auto& n : nodes) {
+        table.insert(&n);
+    }
+
+    for (auto& n : nodes) {
+        POINTERS_EQUAL(&n, table.find(n.state, n.hash));
+    }
+}
+
+TEST(InternalNodeTable, SameHashDifferentStateIsNotFound)
+{
+    table.insert(&nodes[0]);
+    POINTERS_EQUAL(nullptr, table.find(nodes[3].state, nodes[3].hash));
+}
+
+TEST(InternalNodeTable, CanRemoveNodes)
+{
+    for (auto& n : nodes) {
+        table.insert(&n);
+    }
+
+    for (auto i = 0u; i < nodes.size(); i += 2) {
+        table.remove(&nodes[i]);
+    }
+
+    for (auto i = 0u; i < nodes.size(); i++) {
+        auto expected = (i % 2) ? &nodes[i] : nullptr;
+        POINTERS_EQUAL(expected, table.find(nodes[i].state, nodes[i].hash));
+    }
+}
+
+TEST(InternalNodeTable, BytewiseHashDependsOnContent)
+{
+    BytewiseHash<MyState> hash;
+    CHECK_EQUAL(hash(nodes[1].state), hash(nodes[1].state));
+    CHECK_TRUE(hash(nodes[1].state) != hash(nodes[2].state));
+}
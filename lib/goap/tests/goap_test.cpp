@@ -1,5 +1,6 @@
 #include <iostream>
 #include <cstring>
+#include <vector>
 #include <CppUTest/TestHarness.h>
 #include <CppUTestExt/MockSupport.h>
 #include <goap/goap.hpp>
@@ -103,7 +104,7 @@ TEST(SimpleScenario, CompletedGoalDoesNotRequireAnyAction)
 {
     int action_count = 1;
     goap::Action<TestState>* actions[] = {&cut_wood_action};
-    goap::Planner<TestState> planner;
+    goap::Planner<TestState, goap::BytewiseHash<TestState>> planner;
 
     state.has_wood = true;
 
@@ -117,7 +118,7 @@ TEST(SimpleScenario, DirectActionLeadsToSolution)
 {
     int action_count = 1;
     goap::Action<TestState>* actions[] = {&cut_wood_action};
-    goap::Planner<TestState> planner;
+    goap::Planner<TestState, goap::BytewiseHash<TestState>> planner;
 
     state.has_axe = true;
 
@@ -132,7 +133,7 @@ TEST(SimpleScenario, RespectActionConstrains)
     int action_count = 2;
     goap::Action<TestState>* actions[] = {&cut_wood_action, &grab_axe_action};
 
-    goap::Planner<TestState> planner;
+    goap::Planner<TestState, goap::BytewiseHash<TestState>> planner;
 
     auto path_len = planner.plan(state, goal, actions, action_count);
 
@@ -147,7 +148,7 @@ TEST(SimpleScenario, GetPath)
     const int max_path_len = 10;
     goap::Action<TestState>* path[max_path_len] = {nullptr};
 
-    goap::Planner<TestState> planner;
+    goap::Planner<TestState, goap::BytewiseHash<TestState>> planner;
 
     /* Since the goal is reached, we should not need any plan. */
     auto len = planner.plan(state, goal, actions, action_count, path, max_path_len);
@@ -162,7 +163,7 @@ TEST(SimpleScenario, MinimizeCost)
 {
     int action_count = 2;
     goap::Action<TestState>* actions[] = {&grab_axe_action, &cut_wood_action};
-    goap::Planner<TestState> planner;
+    goap::Planner<TestState, goap::BytewiseHash<TestState>> planner;
 
     /* We have two paths: one costing 2 and one costing 1 */
     state.has_axe = true;
@@ -175,7 +176,7 @@ TEST(SimpleScenario, WhatHappensIfThereIsNoPath)
     int action_count = 1;
     goap::Action<TestState>* actions[] = {&cut_wood_action};
 
-    goap::Planner<TestState> planner;
+    goap::Planner<TestState, goap::BytewiseHash<TestState>> planner;
 
     const int max_path_len = 10;
     goap::Action<TestState>* path[max_path_len] = {nullptr};
@@ -232,13 +233,281 @@ TEST(TooLongPathTestGroup, DoNotFindFarAwayPlan)
     goap::Action<FarAwayState>* actions[] = {&a};
 
     // And feed it to a planner than can do path of at most 10 actions
-    goap::Planner<FarAwayState> planner;
+    goap::Planner<FarAwayState, goap::BytewiseHash<FarAwayState>> planner;
 
     // Of course it will fail
     auto cost = planner.plan(state, goal, actions, 1);
     CHECK_EQUAL(-2, cost);
 }
 
+struct BitsState {
+    uint16_t bits;
+};
+
+bool operator==(const BitsState& lhs, const BitsState& rhs)
+{
+    return lhs.bits == rhs.bits;
+}
+
+struct BitsHash {
+    static int calls;
+    uint32_t operator()(const BitsState& state) const
+    {
+        calls++;
+        return state.bits;
+    }
+};
+int BitsHash::calls = 0;
+
+// Sets one bit, as long as the previous one is set
+struct SetBit : goap::Action<BitsState> {
+    int bit;
+    SetBit(int b)
+        : bit(b)
+    {
+    }
+
+    bool can_run(const BitsState& state) override
+    {
+        return bit == 0 || (state.bits & (1 << (bit - 1)));
+    }
+
+    void plan_effects(BitsState& state) override
+    {
+        state.bits |= 1 << bit;
+    }
+
+    bool execute(BitsState& state) override
+    {
+        plan_effects(state);
+        return true;
+    }
+};
+
+// Clears all the bits, to create cycles in the state graph
+struct ClearBits : goap::Action<BitsState> {
+    bool can_run(const BitsState& state) override
+    {
+        (void)state;
+        return true;
+    }
+
+    void plan_effects(BitsState& state) override
+    {
+        state.bits = 0;
+    }
+
+    bool execute(BitsState& state) override
+    {
+        plan_effects(state);
+        return true;
+    }
+};
+
+struct AllBitsSet : goap::Goal<BitsState> {
+    int distance_to(const BitsState& state) const override
+    {
+        int d = 0;
+        for (auto i = 0; i < 8; i++) {
+            d += (state.bits & (1 << i)) ? 0 : 1;
+        }
+        return d;
+    }
+};
+
+TEST_GROUP (LargerScenario) {
+    std::vector<SetBit> set_bits;
+    ClearBits clear;
+    std::vector<goap::Action<BitsState>*> actions;
+    AllBitsSet goal;
+    BitsState state = {0};
+
+    void setup() override
+    {
+        // Reverse order, so that the planner cannot just take the first
+        // runnable action.
+        for (auto i = 7; i >= 0; i--) {
+            set_bits.emplace_back(i);
+        }
+        for (auto& a : set_bits) {
+            actions.push_back(&a);
+        }
+        actions.push_back(&clear);
+    }
+};
+
+TEST(LargerScenario, FindsShortestPath)
+{
+    goap::Planner<BitsState, BitsHash> planner;
+    goap::Action<BitsState>* path[10];
+
+    auto len = planner.plan(state, goal, actions.data(), actions.size(), path, 10);
+    CHECK_EQUAL(8, len);
+
+    for (auto i = 0; i < len; i++) {
+        path[i]->execute(state);
+    }
+    CHECK_TRUE(goal.is_reached(state));
+}
+
+TEST(LargerScenario, CanPlanFromIntermediateState)
+{
+    goap::Planner<BitsState, BitsHash> planner;
+    state.bits = 0x0f;
+
+    CHECK_EQUAL(4, planner.plan(state, goal, actions.data(), actions.size()));
+}
+
+TEST(LargerScenario, UsesProvidedHash)
+{
+    goap::Planner<BitsState, BitsHash, 100> planner;
+    BitsHash::calls = 0;
+
+    CHECK_EQUAL(8, planner.plan(state, goal, actions.data(), actions.size()));
+    CHECK_TRUE(BitsHash::calls > 0);
+}
+
+TEST(LargerScenario, PlannerCanBeReused)
+{
+    goap::Planner<BitsState, BitsHash> planner;
+
+    CHECK_EQUAL(8, planner.plan(state, goal, actions.data(), actions.size()));
+    state.bits = 0x7f;
+    CHECK_EQUAL(1, planner.plan(state, goal, actions.data(), actions.size()));
+}
+
+TEST(LargerScenario, FindsPathWithFewNodes)
+{
+    // Not enough room to keep all the states, so some of them must be
+    // garbage collected during the search.
+    goap::Planner<BitsState, BitsHash, 12> planner;
+
+    CHECK_EQUAL(8, planner.plan(state, goal, actions.data(), actions.size()));
+}
+
+struct TravelState {
+    int position;
+    uint8_t visited;
+};
+
+bool operator==(const TravelState& lhs, const TravelState& rhs)
+{
+    return lhs.position == rhs.position && lhs.visited == rhs.visited;
+}
+
+// TravelState has padding, so it cannot be hashed bytewise
+struct TravelHash {
+    uint32_t operator()(const TravelState& state) const
+    {
+        return (uint32_t)state.position * 31 + state.visited;
+    }
+};
+
+// Goes to a place on a line, costing the distance traveled
+struct Visit : goap::Action<TravelState> {
+    int place;
+    int index;
+    Visit(int p, int i)
+        : place(p)
+        , index(i)
+    {
+    }
+
+    bool can_run(const TravelState& state) override
+    {
+        return !(state.visited & (1 << index));
+    }
+
+    void plan_effects(TravelState& state) override
+    {
+        state.position = place;
+        state.visited |= 1 << index;
+    }
+
+    bool execute(TravelState& state) override
+    {
+        plan_effects(state);
+        return true;
+    }
+
+    int cost(const TravelState& state) override
+    {
+        return 1 + abs(place - state.position);
+    }
+};
+
+struct AllVisited : goap::Goal<TravelState> {
+    int distance_to(const TravelState& state) const override
+    {
+        return __builtin_popcount(0x3 & ~state.visited);
+    }
+};
+
+TEST_GROUP (ActionCostScenario) {
+    Visit far{10, 0}, near{-5, 1};
+    goap::Action<TravelState>* actions[2] = {&far, &near};
+    AllVisited goal;
+    goap::Action<TravelState>* path[10];
+    goap::Planner<TravelState, TravelHash, 100> planner;
+};
+
+TEST(ActionCostScenario, DefaultCostIsOne)
+{
+    GrabAxe action;
+    TestState state{};
+    CHECK_EQUAL(1, action.cost(state));
+}
+
+TEST(ActionCostScenario, FindsCheapestOrder)
+{
+    TravelState state = {0, 0};
+
+    CHECK_EQUAL(2, planner.plan(state, goal, actions, 2, path, 10));
+    POINTERS_EQUAL(&near, path[0]);
+    POINTERS_EQUAL(&far, path[1]);
+}
+
+TEST(ActionCostScenario, CostDependsOnTheState)
+{
+    TravelState state = {8, 0};
+
+    CHECK_EQUAL(2, planner.plan(state, goal, actions, 2, path, 10));
+    POINTERS_EQUAL(&far, path[0]);
+    POINTERS_EQUAL(&near, path[1]);
+}
+
+TEST(ActionCostScenario, PrefersMoreActionsWhenCheaper)
+{
+    // Going straight to the goal is possible but expensive
+    struct Teleport : goap::Action<TravelState> {
+        bool can_run(const TravelState& state) override
+        {
+            return state.visited == 0;
+        }
+
+        void plan_effects(TravelState& state) override
+        {
+            state.visited = 0x3;
+        }
+
+        bool execute(TravelState& state) override
+        {
+            plan_effects(state);
+            return true;
+        }
+
+        int cost(const TravelState& state) override
+        {
+            (void)state;
+            return 100;
+        }
+    } teleport;
+    goap::Action<TravelState>* all_actions[3] = {&teleport, &far, &near};
+    TravelState state = {0, 0};
+
+    CHECK_EQUAL(2, planner.plan(state, goal, all_actions, 3, path, 10));
+}
+
 TEST_GROUP (InternalDistanceGroup) {
 };
 
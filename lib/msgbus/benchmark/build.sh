@@ -0,0 +1,13 @@
+#!/bin/sh
+CC=clang++
+CFLAGS="-I../include -I../examples/posix/include"
+
+cd $(dirname $0)
+
+$CC $CFLAGS -o benchmark -O3 \
+    main.cpp \
+    latency.cpp \
+    -x c \
+    ../messagebus.c \
+    ../examples/posix/port.c \
+    -lbenchmark -lpthread
@@ -0,0 +1,120 @@
+#include <atomic>
+#include <thread>
+#include <benchmark/benchmark.h>
+#include <msgbus/messagebus.h>
+#include <msgbus/posix/port.h>
+
+/* Measures the time between a publish and the moment a subscriber has
+ * processed the message, comparing a thread dedicated to the topic with
+ * callbacks run by a shared executor. The subscriber acknowledges each
+ * message, and the publisher waits for the acknowledgement before sending the
+ * next one (ping pong).
+ *
+ * The topics keep a small history and subscribers read them through a
+ * cursor, so that no message can be missed even if the subscriber is not
+ * waiting yet when it is published. */
+
+namespace {
+struct LatencyTopic {
+    messagebus_topic_t topic;
+    condvar_wrapper_t sync = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER};
+    int buffer[16];
+    messagebus_cursor_t cursor;
+    messagebus_subscriber_t subscriber;
+    std::atomic<int> ack{0};
+    int sent = 0;
+
+    LatencyTopic()
+    {
+        messagebus_topic_init_history(&topic, &sync, &sync, buffer, sizeof(int), 16);
+        messagebus_cursor_init(&cursor, &topic);
+    }
+
+    void ping_pong(benchmark::State& state)
+    {
+        for (auto _ : state) {
+            sent++;
+            messagebus_topic_publish(&topic, &sent, sizeof(sent));
+            while (ack.load(std::memory_order_acquire) != sent) {
+            }
+        }
+    }
+};
+} // namespace
+
+static void drain_cursor(messagebus_topic_t* topic, void* p)
+{
+    (void)topic;
+    auto* t = static_cast<LatencyTopic*>(p);
+    int value;
+
+    while (messagebus_cursor_read(&t->cursor, &value, sizeof(value))) {
+        t->ack.store(value, std::memory_order_release);
+    }
+}
+
+static messagebus_executor_t* shared_executor()
+{
+    static condvar_wrapper_t sync = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER};
+    static messagebus_executor_t executor;
+    static pthread_t threads[2];
+    static bool started = false;
+
+    if (!started) {
+        messagebus_executor_init(&executor, &sync, &sync);
+        messagebus_executor_start_threads(&executor, threads, 2);
+        started = true;
+    }
+
+    return &executor;
+}
+
+static void BM_DedicatedThreadLatency(benchmark::State& state)
+{
+    static LatencyTopic t;
+    static bool started = false;
+
+    if (!started) {
+        std::thread consumer([]() {
+            int value;
+            while (true) {
+                messagebus_cursor_wait(&t.cursor, &value, sizeof(value));
+                t.ack.store(value, std::memory_order_release);
+            }
+        });
+        consumer.detach();
+        started = true;
+    }
+
+    t.ping_pong(state);
+}
+
+static void BM_ExecutorLatency(benchmark::State& state)
+{
+    static LatencyTopic t;
+    static bool subscribed = false;
+
+    if (!subscribed) {
+        messagebus_subscribe(&t.subscriber, &t.topic, shared_executor(), drain_cursor, &t);
+        subscribed = true;
+    }
+
+    t.ping_pong(state);
+}
+
+static void BM_DirectCallbackLatency(benchmark::State& state)
+{
+    static LatencyTopic t;
+    static bool subscribed = false;
+
+    if (!subscribed) {
+        messagebus_subscribe(&t.subscriber, &t.topic, NULL, drain_cursor, &t);
+        subscribed = true;
+    }
+
+    t.ping_pong(state);
+}
+
+BENCHMARK(BM_DedicatedThreadLatency)->UseRealTime();
+BENCHMARK(BM_ExecutorLatency)->UseRealTime();
+BENCHMARK(BM_DirectCallbackLatency)->UseRealTime();
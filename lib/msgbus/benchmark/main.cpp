@@ -0,0 +1,54 @@
+#include <benchmark/benchmark.h>
+#include <msgbus/messagebus.h>
+#include <msgbus/posix/port.h>
+
+/* Roughly the size of an odometry sample (pose, speed and timestamp). */
+struct Sample {
+    float data[8];
+};
+
+static messagebus_topic_t topic;
+static condvar_wrapper_t topic_sync = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER};
+static Sample topic_buffer;
+
+/* Thread 0 publishes as fast as possible while all other threads read the
+ * topic, which is the pattern we have with the odometry topic. */
+static void contention(benchmark::State& state, bool seqlock)
+{
+    Sample sample = {};
+
+    if (state.thread_index() == 0) {
+        if (seqlock) {
+            messagebus_topic_init_seqlock(&topic, &topic_sync, &topic_sync,
+                                          &topic_buffer, sizeof(topic_buffer));
+        } else {
+            messagebus_topic_init(&topic, &topic_sync, &topic_sync,
+                                  &topic_buffer, sizeof(topic_buffer));
+        }
+        messagebus_topic_publish(&topic, &sample, sizeof(sample));
+    }
+
+    for (auto _ : state) {
+        if (state.thread_index() == 0) {
+            sample.data[0] += 1.f;
+            messagebus_topic_publish(&topic, &sample, sizeof(sample));
+        } else {
+            messagebus_topic_read(&topic, &sample, sizeof(sample));
+            benchmark::DoNotOptimize(sample);
+        }
+    }
+}
+
+static void BM_MutexTopic(benchmark::State& state)
+{
+    contention(state, false);
+}
+
+static void BM_SeqlockTopic(benchmark::State& state)
+{
+    contention(state, true);
+}
+
+BENCHMARK(BM_MutexTopic)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_SeqlockTopic)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_MAIN();
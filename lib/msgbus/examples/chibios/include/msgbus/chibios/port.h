@@ -0,0 +1,30 @@
+#ifndef MESSAGEBUS_CHIBIOS_PORT_H
+#define MESSAGEBUS_CHIBIOS_PORT_H
+
+#include <ch.h>
+#include <msgbus/messagebus.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Starts a thread running the callbacks of the given executor.
+ *
+ * Call it several times with different working areas to get a pool of
+ * threads sharing the executor.
+ *
+ * @parameter [in] wa,wa_size Working area of the thread, declared with
+ * THD_WORKING_AREA. It must be big enough for the callbacks run by the
+ * executor.
+ * @parameter [in] prio Priority of the executor thread.
+ */
+thread_t* messagebus_executor_start_thread(messagebus_executor_t* executor,
+                                           void* wa,
+                                           size_t wa_size,
+                                           tprio_t prio);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
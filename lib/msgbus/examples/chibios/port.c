@@ -1,5 +1,6 @@
 #include <ch.h>
 #include <msgbus/messagebus.h>
+#include <msgbus/chibios/port.h>
 
 void messagebus_lock_acquire(void* p)
 {
@@ -24,3 +25,17 @@ void messagebus_condvar_wait(void* p)
     condition_variable_t* cond = (condition_variable_t*)p;
     chCondWait(cond);
 }
+
+static THD_FUNCTION(executor_thd, arg)
+{
+    chRegSetThreadName("msgbus_executor");
+    messagebus_executor_run((messagebus_executor_t*)arg);
+}
+
+thread_t* messagebus_executor_start_thread(messagebus_executor_t* executor,
+                                           void* wa,
+                                           size_t wa_size,
+                                           tprio_t prio)
+{
+    return chThdCreateStatic(wa, wa_size, prio, executor_thd, executor);
+}
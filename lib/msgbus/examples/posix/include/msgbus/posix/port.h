@@ -1,6 +1,7 @@
 #ifndef PORT_H
 #define PORT_H
 #include <pthread.h>
+#include <msgbus/messagebus.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -15,6 +16,15 @@ typedef struct {
     condvar_wrapper_t name = {PTHREAD_MUTEX_INITIALIZER, \
                               PTHREAD_COND_INITIALIZER}
 
+/** Starts count threads running the callbacks of the given executor.
+ *
+ * @parameter [out] threads Array of at least count elements, where the thread
+ * handles are stored.
+ *
+ * @returns 0 on success, otherwise the error code of pthread_create.
+ */
+int messagebus_executor_start_threads(messagebus_executor_t* executor, pthread_t* threads, size_t count);
+
 #ifdef __cplusplus
 }
 #endif
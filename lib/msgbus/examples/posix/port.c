@@ -24,3 +24,21 @@ void messagebus_condvar_wait(void* p)
     condvar_wrapper_t* wrapper = (condvar_wrapper_t*)p;
     pthread_cond_wait(&wrapper->cond, &wrapper->mutex);
 }
+
+static void* executor_thread(void* p)
+{
+    messagebus_executor_run((messagebus_executor_t*)p);
+    return NULL;
+}
+
+int messagebus_executor_start_threads(messagebus_executor_t* executor, pthread_t* threads, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        int err = pthread_create(&threads[i], NULL, executor_thread, executor);
+        if (err) {
+            return err;
+        }
+    }
+
+    return 0;
+}
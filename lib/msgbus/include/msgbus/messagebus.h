@@ -5,12 +5,23 @@ extern "C" {
 #endif
 
 #include <unistd.h>
+#include <stdint.h>
 #include <stdbool.h>
 
 #define TOPIC_NAME_MAX_LENGTH 64
 
+/** Number of slots in the per-bus topic name index. Must be a power of two.
+ * Topics advertised once the index is full are still found, but through a
+ * slower, locked scan of the topic list. */
+#ifndef MESSAGEBUS_TOPIC_INDEX_SIZE
+#define MESSAGEBUS_TOPIC_INDEX_SIZE 64
+#endif
+
 typedef struct {
     int messages;
+    /** Number of messages that were overwritten in a history topic before
+     * a cursor could read them. */
+    int overruns;
 } messagebus_topic_stats_t;
 
 typedef struct topic_s {
@@ -24,17 +35,31 @@ typedef struct topic_s {
     struct topic_s* next;
     void* metadata;
     messagebus_topic_stats_t stats;
+    bool seqlock;
+    uint32_t sequence;
+    size_t history_depth;
+    uint32_t history_head;
+    uint32_t name_hash;
+    struct messagebus_subscriber_s* subscribers;
 } messagebus_topic_t;
 
 typedef struct {
     struct {
         messagebus_topic_t* head;
+        messagebus_topic_t* index[MESSAGEBUS_TOPIC_INDEX_SIZE];
+        size_t index_count;
+        bool index_overflow;
     } topics;
     struct messagebus_new_topic_cb_s* new_topic_callback_list;
     void* lock;
     void* condvar;
 } messagebus_t;
 
+typedef struct {
+    messagebus_topic_t* topic;
+    uint32_t next;
+} messagebus_cursor_t;
+
 typedef struct messagebus_watchgroup_s {
     void* lock;
     void* condvar;
@@ -46,6 +71,24 @@ typedef struct messagebus_watcher_s {
     struct messagebus_watcher_s* next;
 } messagebus_watcher_t;
 
+typedef struct messagebus_executor_s {
+    void* lock;
+    void* condvar;
+    struct messagebus_subscriber_s* queue_head;
+    struct messagebus_subscriber_s* queue_tail;
+} messagebus_executor_t;
+
+typedef struct messagebus_subscriber_s {
+    void (*callback)(messagebus_topic_t*, void*);
+    void* callback_arg;
+    messagebus_topic_t* topic;
+    messagebus_executor_t* executor;
+    bool pending;
+    bool running;
+    struct messagebus_subscriber_s* next;
+    struct messagebus_subscriber_s* next_pending;
+} messagebus_subscriber_t;
+
 typedef struct messagebus_new_topic_cb_s {
     void (*callback)(messagebus_t*, messagebus_topic_t*, void*);
     void* callback_arg;
@@ -73,6 +116,43 @@ typedef struct messagebus_new_topic_cb_s {
  */
 void messagebus_topic_init(messagebus_topic_t* topic, void* topic_lock, void* topic_condvar, void* buffer, size_t buffer_len);
 
+/** Initializes a topic object whose reads are protected by a sequence counter
+ * instead of the topic lock.
+ *
+ * Publishers still serialize on the topic lock, but readers calling
+ * messagebus_topic_read() copy the buffer without locking and retry if a
+ * publish happened during the copy. This is meant for small, high rate topics
+ * read by many threads, where readers should never delay the publisher.
+ *
+ * @note If a reader catches a publisher in the middle of a write, it briefly
+ * takes the topic lock, so that on a single core the (possibly lower priority)
+ * publisher gets to finish its write instead of the reader spinning forever.
+ *
+ * @parameter [in] topic The topic object to create.
+ * @parameter [in] topic_lock The lock to use for this topic.
+ * @parameter [in] topic_condvar The condition variable to use for this topic.
+ * @parameter [in] buffer,buffer_len The buffer where the topic messages will
+ * be stored.
+ */
+void messagebus_topic_init_seqlock(messagebus_topic_t* topic, void* topic_lock, void* topic_condvar, void* buffer, size_t buffer_len);
+
+/** Initializes a topic object which keeps the last messages published to it.
+ *
+ * Readers can then use a cursor (see messagebus_cursor_init()) to go through
+ * every message published since their last read, instead of only seeing the
+ * latest one. Regular reads (messagebus_topic_read() and
+ * messagebus_topic_wait()) return the latest message.
+ *
+ * @parameter [in] topic The topic object to create.
+ * @parameter [in] topic_lock The lock to use for this topic.
+ * @parameter [in] topic_condvar The condition variable to use for this topic.
+ * @parameter [in] buffer Buffer large enough to store depth messages.
+ * @parameter [in] msg_len Size of a single message.
+ * @parameter [in] depth Number of messages kept in the buffer, must be a
+ * power of two.
+ */
+void messagebus_topic_init_history(messagebus_topic_t* topic, void* topic_lock, void* topic_condvar, void* buffer, size_t msg_len, size_t depth);
+
 /** Initializes a new message bus with no topics.
  *
  * @parameter [in] bus The messagebus to init.
@@ -94,6 +174,10 @@ void messagebus_init(messagebus_t* bus, void* lock, void* condvar);
 void messagebus_advertise_topic(messagebus_t* bus, messagebus_topic_t* topic, const char* name);
 
 /** Finds a topic on the bus.
+ *
+ * The lookup goes through a hash index of the topic names and does not take
+ * the bus lock, unless more than MESSAGEBUS_TOPIC_INDEX_SIZE topics were
+ * advertised and the topic is not in the index.
  *
  * @parameter [in] bus The bus to scan.
  * @parameter [in] name The name of the topic to search.
@@ -102,6 +186,17 @@ void messagebus_advertise_topic(messagebus_t* bus, messagebus_topic_t* topic, co
  */
 messagebus_topic_t* messagebus_find_topic(messagebus_t* bus, const char* name);
 
+/** Same as messagebus_find_topic, but with the name hash already computed
+ * (for example at compile time, see messagebus::TopicId).
+ *
+ * @parameter [in] hash Must be equal to messagebus_topic_name_hash(name).
+ */
+messagebus_topic_t* messagebus_find_topic_by_hash(messagebus_t* bus, uint32_t hash, const char* name);
+
+/** Hash of a topic name, as used by the topic index (32 bit FNV-1a of the
+ * first TOPIC_NAME_MAX_LENGTH characters). */
+uint32_t messagebus_topic_name_hash(const char* name);
+
 /** Waits until a topic is found on the bus.
  *
  * @parameter [in] bus The bus to scan.
@@ -140,6 +235,30 @@ bool messagebus_topic_read(messagebus_topic_t* topic, void* buf, size_t buf_len)
  */
 void messagebus_topic_wait(messagebus_topic_t* topic, void* buf, size_t buf_len);
 
+/** Initializes a cursor on a topic created by messagebus_topic_init_history().
+ *
+ * The cursor starts after the last published message, i.e. it will only
+ * return messages published after this call.
+ */
+void messagebus_cursor_init(messagebus_cursor_t* cursor, messagebus_topic_t* topic);
+
+/** Reads the oldest message of the topic not yet read through this cursor.
+ *
+ * If the cursor fell behind by more than the topic's depth, the oldest
+ * messages are skipped and counted in the topic overrun statistics.
+ *
+ * @parameter [in] cursor The cursor to read from.
+ * @parameter [out] buf Pointer where the read data will be stored.
+ * @parameter [out] buf_len Length of the buffer.
+ *
+ * @returns true if a message was read, false if the cursor is up to date.
+ */
+bool messagebus_cursor_read(messagebus_cursor_t* cursor, void* buf, size_t buf_len);
+
+/** Same as messagebus_cursor_read(), but blocks until a message is
+ * available. */
+void messagebus_cursor_wait(messagebus_cursor_t* cursor, void* buf, size_t buf_len);
+
 /** Initializes a watch group.
  *
  * Watch group are used to wait on a set of topics in parallel (similar to
@@ -161,6 +280,48 @@ void messagebus_watchgroup_watch(messagebus_watcher_t* watcher,
 
 messagebus_topic_t* messagebus_watchgroup_wait(messagebus_watchgroup_t* group);
 
+/** Initializes an executor, which runs subscriber callbacks on behalf of
+ * publishers.
+ *
+ * An executor does not own any thread: one or more threads must call
+ * messagebus_executor_run() on it (see the port specific helpers to start
+ * them). Several threads sharing an executor form a small thread pool, which
+ * can replace one dedicated waiting thread per topic.
+ *
+ * @parameter [in] lock The lock protecting the executor queue.
+ * @parameter [in] condvar The condition variable used to wake up threads.
+ */
+void messagebus_executor_init(messagebus_executor_t* executor, void* lock, void* condvar);
+
+/** Subscribes a callback to a topic.
+ *
+ * The callback receives the topic and the user provided argument, and is
+ * expected to read the topic (or drain a cursor) itself.
+ *
+ * If executor is NULL, the callback is called directly by the publishing
+ * thread, after the topic lock was released, so it must be short.
+ * Otherwise the callback is queued on the executor and called from one of its
+ * threads. If the topic is published several times before the callback runs,
+ * it is only called once. A callback never runs concurrently with itself.
+ *
+ * @warning Removing a subscriber is not supported for now.
+ */
+void messagebus_subscribe(messagebus_subscriber_t* subscriber,
+                          messagebus_topic_t* topic,
+                          messagebus_executor_t* executor,
+                          void (*callback)(messagebus_topic_t*, void*),
+                          void* arg);
+
+/** Runs the oldest pending callback of the executor, if any.
+ *
+ * @returns true if a callback was run, false if nothing was pending.
+ */
+bool messagebus_executor_dispatch(messagebus_executor_t* executor);
+
+/** Runs callbacks queued on the executor forever, blocking while there is
+ * nothing to do. This is meant to be the body of an executor thread. */
+void messagebus_executor_run(messagebus_executor_t* executor);
+
 /** Registers a callback that will trigger when a new topic is advertised on
  * the bus. */
 void messagebus_new_topic_callback_register(messagebus_t* bus,
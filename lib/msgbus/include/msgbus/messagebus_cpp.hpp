@@ -1,7 +1,38 @@
 #ifndef MESSAGEBUS_CPP_HPP
 #define MESSAGEBUS_CPP_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include "messagebus.h"
+
 namespace messagebus {
+
+/// Compile time equivalent of messagebus_topic_name_hash
+constexpr uint32_t topic_name_hash(const char* name)
+{
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < TOPIC_NAME_MAX_LENGTH && name[i] != '\0'; i++) {
+        hash = (hash ^ static_cast<uint8_t>(name[i])) * 16777619u;
+    }
+
+    return hash;
+}
+
+/// Topic name with its hash computed at compile time, when declared as
+/// constexpr. Looking a topic up by TopicId skips hashing the name, and only
+/// compares strings when the hash matches.
+struct TopicId {
+    const char* name;
+    uint32_t hash;
+
+    constexpr explicit TopicId(const char* topic_name)
+        : name(topic_name)
+        , hash(topic_name_hash(topic_name))
+    {
+    }
+};
+
 template <typename T>
 class TopicWrapper {
 public:
@@ -30,6 +61,13 @@ TopicWrapper<T> find_topic(messagebus_t& bus, const char* topic_name)
     return TopicWrapper<T>(topic);
 }
 
+template <typename T>
+TopicWrapper<T> find_topic(messagebus_t& bus, const TopicId& id)
+{
+    auto topic = messagebus_find_topic_by_hash(&bus, id.hash, id.name);
+    return TopicWrapper<T>(topic);
+}
+
 template <typename T>
 TopicWrapper<T> find_topic_blocking(messagebus_t& bus, const char* topic_name)
 {
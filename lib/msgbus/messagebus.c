@@ -1,6 +1,9 @@
 #include <msgbus/messagebus.h>
+#include <assert.h>
 #include <string.h>
 
+#define TOPIC_INDEX_MASK (MESSAGEBUS_TOPIC_INDEX_SIZE - 1)
+
 static messagebus_topic_t* topic_by_name(messagebus_t* bus, const char* name)
 {
     messagebus_topic_t* t;
@@ -13,6 +16,199 @@ static messagebus_topic_t* topic_by_name(messagebus_t* bus, const char* name)
     return NULL;
 }
 
+/* Open addressing with linear probing. Slots are only ever filled (topics
+ * cannot be deleted), and the pointer is published after the topic name, so
+ * lookups can run concurrently with insertions without locking. */
+static messagebus_topic_t* topic_by_hash(messagebus_t* bus, uint32_t hash, const char* name)
+{
+    for (size_t i = 0; i < MESSAGEBUS_TOPIC_INDEX_SIZE; i++) {
+        size_t slot = (hash + i) & TOPIC_INDEX_MASK;
+        messagebus_topic_t* t = __atomic_load_n(&bus->topics.index[slot], __ATOMIC_ACQUIRE);
+
+        if (t == NULL) {
+            return NULL;
+        }
+
+        if (t->name_hash == hash && !strcmp(name, t->name)) {
+            return t;
+        }
+    }
+
+    return NULL;
+}
+
+static void topic_index_insert(messagebus_t* bus, messagebus_topic_t* topic)
+{
+    if (bus->topics.index_count == MESSAGEBUS_TOPIC_INDEX_SIZE) {
+        __atomic_store_n(&bus->topics.index_overflow, true, __ATOMIC_RELEASE);
+        return;
+    }
+
+    size_t slot = topic->name_hash & TOPIC_INDEX_MASK;
+    while (bus->topics.index[slot] != NULL) {
+        slot = (slot + 1) & TOPIC_INDEX_MASK;
+    }
+
+    __atomic_store_n(&bus->topics.index[slot], topic, __ATOMIC_RELEASE);
+    bus->topics.index_count++;
+}
+
+/* Must be called with the bus lock held. */
+static messagebus_topic_t* topic_lookup(messagebus_t* bus, uint32_t hash, const char* name)
+{
+    messagebus_topic_t* res = topic_by_hash(bus, hash, name);
+
+    if (res == NULL && bus->topics.index_overflow) {
+        res = topic_by_name(bus, name);
+    }
+
+    return res;
+}
+
+static void seqlock_write(messagebus_topic_t* topic, const void* buf, size_t buf_len)
+{
+    uint32_t seq = __atomic_load_n(&topic->sequence, __ATOMIC_RELAXED);
+
+    /* An odd sequence number tells readers that a write is in progress. */
+    __atomic_store_n(&topic->sequence, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    memcpy(topic->buffer, buf, buf_len);
+
+    /* Zero is reserved for "never published", skip it on wrap around. */
+    seq += 2;
+    if (seq == 0) {
+        seq = 2;
+    }
+    __atomic_store_n(&topic->sequence, seq, __ATOMIC_RELEASE);
+}
+
+static bool seqlock_read(messagebus_topic_t* topic, void* buf, size_t buf_len)
+{
+    uint32_t before, after;
+
+    while (true) {
+        before = __atomic_load_n(&topic->sequence, __ATOMIC_ACQUIRE);
+
+        if (before == 0) {
+            return false;
+        }
+
+        if (before & 1) {
+            /* A publisher is in the middle of a write and holds the topic
+             * lock. Block on it rather than spinning, so that the publisher
+             * can run (and inherit our priority) if it was preempted. */
+            messagebus_lock_acquire(topic->lock);
+            messagebus_lock_release(topic->lock);
+            continue;
+        }
+
+        memcpy(buf, topic->buffer, buf_len);
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&topic->sequence, __ATOMIC_RELAXED);
+
+        if (before == after) {
+            return true;
+        }
+    }
+}
+
+static void* history_slot(messagebus_topic_t* topic, uint32_t index)
+{
+    return (uint8_t*)topic->buffer + (index % topic->history_depth) * topic->buffer_len;
+}
+
+static void* latest_message(messagebus_topic_t* topic)
+{
+    if (topic->history_depth == 0) {
+        return topic->buffer;
+    }
+
+    return history_slot(topic, topic->history_head - 1);
+}
+
+static bool cursor_pop(messagebus_cursor_t* cursor, void* buf, size_t buf_len)
+{
+    messagebus_topic_t* topic = cursor->topic;
+    uint32_t available = topic->history_head - cursor->next;
+
+    if (available == 0) {
+        return false;
+    }
+
+    if (available > topic->history_depth) {
+        topic->stats.overruns += available - topic->history_depth;
+        cursor->next = topic->history_head - topic->history_depth;
+    }
+
+    memcpy(buf, history_slot(topic, cursor->next), buf_len);
+    cursor->next++;
+
+    return true;
+}
+
+/* Must be called with the executor lock held. */
+static void executor_enqueue(messagebus_executor_t* executor, messagebus_subscriber_t* sub)
+{
+    sub->next_pending = NULL;
+
+    if (executor->queue_tail == NULL) {
+        executor->queue_head = sub;
+    } else {
+        executor->queue_tail->next_pending = sub;
+    }
+    executor->queue_tail = sub;
+
+    messagebus_condvar_broadcast(executor->condvar);
+}
+
+/* Must be called with the executor lock held. */
+static messagebus_subscriber_t* executor_dequeue(messagebus_executor_t* executor)
+{
+    messagebus_subscriber_t* sub = executor->queue_head;
+
+    if (sub != NULL) {
+        executor->queue_head = sub->next_pending;
+        if (executor->queue_head == NULL) {
+            executor->queue_tail = NULL;
+        }
+        sub->pending = false;
+        sub->running = true;
+    }
+
+    return sub;
+}
+
+static void executor_post(messagebus_subscriber_t* sub)
+{
+    messagebus_executor_t* executor = sub->executor;
+
+    messagebus_lock_acquire(executor->lock);
+
+    /* If the callback is running, it will be queued again once it is done. */
+    if (!sub->pending) {
+        sub->pending = true;
+        if (!sub->running) {
+            executor_enqueue(executor, sub);
+        }
+    }
+
+    messagebus_lock_release(executor->lock);
+}
+
+static void executor_call(messagebus_executor_t* executor, messagebus_subscriber_t* sub)
+{
+    sub->callback(sub->topic, sub->callback_arg);
+
+    messagebus_lock_acquire(executor->lock);
+    sub->running = false;
+    if (sub->pending) {
+        executor_enqueue(executor, sub);
+    }
+    messagebus_lock_release(executor->lock);
+}
+
 void messagebus_init(messagebus_t* bus, void* lock, void* condvar)
 {
     memset(bus, 0, sizeof(messagebus_t));
@@ -29,10 +225,27 @@ void messagebus_topic_init(messagebus_topic_t* topic, void* topic_lock, void* to
     topic->condvar = topic_condvar;
 }
 
+void messagebus_topic_init_seqlock(messagebus_topic_t* topic, void* topic_lock, void* topic_condvar, void* buffer, size_t buffer_len)
+{
+    messagebus_topic_init(topic, topic_lock, topic_condvar, buffer, buffer_len);
+    topic->seqlock = true;
+}
+
+void messagebus_topic_init_history(messagebus_topic_t* topic, void* topic_lock, void* topic_condvar, void* buffer, size_t msg_len, size_t depth)
+{
+    /* The slot of a message is its counter modulo depth, which only stays
+     * continuous when the counter wraps around if depth is a power of two. */
+    assert(depth > 0 && (depth & (depth - 1)) == 0);
+
+    messagebus_topic_init(topic, topic_lock, topic_condvar, buffer, msg_len);
+    topic->history_depth = depth;
+}
+
 void messagebus_advertise_topic(messagebus_t* bus, messagebus_topic_t* topic, const char* name)
 {
     memset(topic->name, 0, sizeof(topic->name));
     strncpy(topic->name, name, TOPIC_NAME_MAX_LENGTH);
+    topic->name_hash = messagebus_topic_name_hash(topic->name);
 
     messagebus_lock_acquire(bus->lock);
 
@@ -40,6 +253,7 @@ void messagebus_advertise_topic(messagebus_t* bus, messagebus_topic_t* topic, co
         topic->next = bus->topics.head;
     }
     bus->topics.head = topic;
+    topic_index_insert(bus, topic);
 
     for (messagebus_new_topic_cb_t* cb = bus->new_topic_callback_list; cb != NULL; cb = cb->next) {
         cb->callback(bus, topic, cb->callback_arg);
@@ -50,15 +264,33 @@ void messagebus_advertise_topic(messagebus_t* bus, messagebus_topic_t* topic, co
     messagebus_lock_release(bus->lock);
 }
 
+uint32_t messagebus_topic_name_hash(const char* name)
+{
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < TOPIC_NAME_MAX_LENGTH && name[i] != '\0'; i++) {
+        hash = (hash ^ (uint8_t)name[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
 messagebus_topic_t* messagebus_find_topic(messagebus_t* bus, const char* name)
 {
-    messagebus_topic_t* res;
+    return messagebus_find_topic_by_hash(bus, messagebus_topic_name_hash(name), name);
+}
 
-    messagebus_lock_acquire(bus->lock);
+messagebus_topic_t* messagebus_find_topic_by_hash(messagebus_t* bus, uint32_t hash, const char* name)
+{
+    messagebus_topic_t* res;
 
-    res = topic_by_name(bus, name);
+    res = topic_by_hash(bus, hash, name);
 
-    messagebus_lock_release(bus->lock);
+    if (res == NULL && __atomic_load_n(&bus->topics.index_overflow, __ATOMIC_ACQUIRE)) {
+        messagebus_lock_acquire(bus->lock);
+        res = topic_by_name(bus, name);
+        messagebus_lock_release(bus->lock);
+    }
 
     return res;
 }
@@ -66,11 +298,12 @@ messagebus_topic_t* messagebus_find_topic(messagebus_t* bus, const char* name)
 messagebus_topic_t* messagebus_find_topic_blocking(messagebus_t* bus, const char* name)
 {
     messagebus_topic_t* res = NULL;
+    uint32_t hash = messagebus_topic_name_hash(name);
 
     messagebus_lock_acquire(bus->lock);
 
     while (res == NULL) {
-        res = topic_by_name(bus, name);
+        res = topic_lookup(bus, hash, name);
 
         if (res == NULL) {
             messagebus_condvar_wait(bus->condvar);
@@ -90,7 +323,14 @@ bool messagebus_topic_publish(messagebus_topic_t* topic, const void* buf, size_t
 
     messagebus_lock_acquire(topic->lock);
 
-    memcpy(topic->buffer, buf, buf_len);
+    if (topic->history_depth) {
+        memcpy(history_slot(topic, topic->history_head), buf, buf_len);
+        topic->history_head++;
+    } else if (topic->seqlock) {
+        seqlock_write(topic, buf, buf_len);
+    } else {
+        memcpy(topic->buffer, buf, buf_len);
+    }
     topic->published = true;
     topic->stats.messages += 1;
     messagebus_condvar_broadcast(topic->condvar);
@@ -103,19 +343,36 @@ bool messagebus_topic_publish(messagebus_topic_t* topic, const void* buf, size_t
         messagebus_lock_release(w->group->lock);
     }
 
+    /* Subscribers can only be added to the head of the list, so it is safe to
+     * walk it without holding the lock. */
+    messagebus_subscriber_t* subscribers = topic->subscribers;
+
     messagebus_lock_release(topic->lock);
 
+    for (messagebus_subscriber_t* s = subscribers; s != NULL; s = s->next) {
+        if (s->executor != NULL) {
+            executor_post(s);
+        } else {
+            s->callback(topic, s->callback_arg);
+        }
+    }
+
     return true;
 }
 
 bool messagebus_topic_read(messagebus_topic_t* topic, void* buf, size_t buf_len)
 {
     bool success = false;
+
+    if (topic->seqlock) {
+        return seqlock_read(topic, buf, buf_len);
+    }
+
     messagebus_lock_acquire(topic->lock);
 
     if (topic->published) {
         success = true;
-        memcpy(buf, topic->buffer, buf_len);
+        memcpy(buf, latest_message(topic), buf_len);
     }
 
     messagebus_lock_release(topic->lock);
@@ -128,11 +385,41 @@ void messagebus_topic_wait(messagebus_topic_t* topic, void* buf, size_t buf_len)
     messagebus_lock_acquire(topic->lock);
     messagebus_condvar_wait(topic->condvar);
 
-    memcpy(buf, topic->buffer, buf_len);
+    memcpy(buf, latest_message(topic), buf_len);
 
     messagebus_lock_release(topic->lock);
 }
 
+void messagebus_cursor_init(messagebus_cursor_t* cursor, messagebus_topic_t* topic)
+{
+    messagebus_lock_acquire(topic->lock);
+    cursor->topic = topic;
+    cursor->next = topic->history_head;
+    messagebus_lock_release(topic->lock);
+}
+
+bool messagebus_cursor_read(messagebus_cursor_t* cursor, void* buf, size_t buf_len)
+{
+    bool success;
+
+    messagebus_lock_acquire(cursor->topic->lock);
+    success = cursor_pop(cursor, buf, buf_len);
+    messagebus_lock_release(cursor->topic->lock);
+
+    return success;
+}
+
+void messagebus_cursor_wait(messagebus_cursor_t* cursor, void* buf, size_t buf_len)
+{
+    messagebus_lock_acquire(cursor->topic->lock);
+
+    while (!cursor_pop(cursor, buf, buf_len)) {
+        messagebus_condvar_wait(cursor->topic->condvar);
+    }
+
+    messagebus_lock_release(cursor->topic->lock);
+}
+
 void messagebus_watchgroup_init(messagebus_watchgroup_t* group, void* lock, void* condvar)
 {
     group->lock = lock;
@@ -169,6 +456,62 @@ messagebus_topic_t* messagebus_watchgroup_wait(messagebus_watchgroup_t* group)
     return res;
 }
 
+void messagebus_executor_init(messagebus_executor_t* executor, void* lock, void* condvar)
+{
+    memset(executor, 0, sizeof(messagebus_executor_t));
+    executor->lock = lock;
+    executor->condvar = condvar;
+}
+
+void messagebus_subscribe(messagebus_subscriber_t* subscriber,
+                          messagebus_topic_t* topic,
+                          messagebus_executor_t* executor,
+                          void (*callback)(messagebus_topic_t*, void*),
+                          void* arg)
+{
+    memset(subscriber, 0, sizeof(messagebus_subscriber_t));
+    subscriber->callback = callback;
+    subscriber->callback_arg = arg;
+    subscriber->topic = topic;
+    subscriber->executor = executor;
+
+    messagebus_lock_acquire(topic->lock);
+    subscriber->next = topic->subscribers;
+    topic->subscribers = subscriber;
+    messagebus_lock_release(topic->lock);
+}
+
+bool messagebus_executor_dispatch(messagebus_executor_t* executor)
+{
+    messagebus_subscriber_t* sub;
+
+    messagebus_lock_acquire(executor->lock);
+    sub = executor_dequeue(executor);
+    messagebus_lock_release(executor->lock);
+
+    if (sub == NULL) {
+        return false;
+    }
+
+    executor_call(executor, sub);
+    return true;
+}
+
+void messagebus_executor_run(messagebus_executor_t* executor)
+{
+    while (true) {
+        messagebus_subscriber_t* sub;
+
+        messagebus_lock_acquire(executor->lock);
+        while ((sub = executor_dequeue(executor)) == NULL) {
+            messagebus_condvar_wait(executor->condvar);
+        }
+        messagebus_lock_release(executor->lock);
+
+        executor_call(executor, sub);
+    }
+}
+
 void messagebus_new_topic_callback_register(messagebus_t* bus,
                                             messagebus_new_topic_cb_t* cb,
                                             void (*cb_fun)(messagebus_t*,
@@ -36,20 +36,14 @@ TEST(MessageBusAtomicityTestGroup, AdvertiseIsLockedProperly)
     messagebus_advertise_topic(&bus, &topic, "topic");
 }
 
-TEST(MessageBusAtomicityTestGroup, FindNoneIsLockedProperly)
+TEST(MessageBusAtomicityTestGroup, FindNoneDoesNotLock)
 {
-    mock().expectOneCall("messagebus_lock_acquire").withPointerParameter("lock", bus.lock);
-    mock().expectOneCall("messagebus_lock_release").withPointerParameter("lock", bus.lock);
-
     lock_mocks_enable(true);
     messagebus_find_topic(&bus, "topic");
 }
 
-TEST(MessageBusAtomicityTestGroup, FindExistingTopicIsLockedProperly)
+TEST(MessageBusAtomicityTestGroup, FindExistingTopicDoesNotLock)
 {
-    mock().expectOneCall("messagebus_lock_acquire").withPointerParameter("lock", bus.lock);
-    mock().expectOneCall("messagebus_lock_release").withPointerParameter("lock", bus.lock);
-
     messagebus_advertise_topic(&bus, &topic, "topic");
     lock_mocks_enable(true);
     messagebus_find_topic(&bus, "topic");
@@ -0,0 +1,162 @@
+#include <CppUTest/TestHarness.h>
+#include <CppUTestExt/MockSupport.h>
+#include <msgbus/messagebus.h>
+#include "mocks/synchronization.hpp"
+
+TEST_GROUP (MessageBusHistoryTestGroup) {
+    messagebus_topic_t topic;
+    int buffer[4];
+    int topic_lock;
+    int topic_condvar;
+    messagebus_cursor_t cursor;
+
+    void setup() override
+    {
+        messagebus_topic_init_history(&topic, &topic_lock, &topic_condvar, buffer, sizeof(int), 4);
+        messagebus_cursor_init(&cursor, &topic);
+    }
+
+    void teardown() override
+    {
+        lock_mocks_enable(false);
+        condvar_mocks_enable(false);
+        mock().checkExpectations();
+        mock().clear();
+    }
+
+    void publish(int value)
+    {
+        messagebus_topic_publish(&topic, &value, sizeof(value));
+    }
+
+    int overruns()
+    {
+        messagebus_topic_stats_t stats;
+        messagebus_topic_stats_get(&topic, &stats);
+        return stats.overruns;
+    }
+};
+
+TEST(MessageBusHistoryTestGroup, CanCreateTopic)
+{
+    POINTERS_EQUAL(buffer, topic.buffer);
+    CHECK_EQUAL(sizeof(int), topic.buffer_len);
+    CHECK_EQUAL(4, topic.history_depth);
+}
+
+TEST(MessageBusHistoryTestGroup, CursorIsEmptyInitially)
+{
+    int value;
+    CHECK_FALSE(messagebus_cursor_read(&cursor, &value, sizeof(value)));
+}
+
+TEST(MessageBusHistoryTestGroup, CursorReadsAllMessagesInOrder)
+{
+    int value;
+    publish(1);
+    publish(2);
+    publish(3);
+
+    for (int i = 1; i <= 3; i++) {
+        CHECK_TRUE(messagebus_cursor_read(&cursor, &value, sizeof(value)));
+        CHECK_EQUAL(i, value);
+    }
+    CHECK_FALSE(messagebus_cursor_read(&cursor, &value, sizeof(value)));
+    CHECK_EQUAL(0, overruns());
+}
+
+TEST(MessageBusHistoryTestGroup, CursorStartsAfterLatestMessage)
+{
+    int value;
+    publish(1);
+
+    messagebus_cursor_t late_cursor;
+    messagebus_cursor_init(&late_cursor, &topic);
+    CHECK_FALSE(messagebus_cursor_read(&late_cursor, &value, sizeof(value)));
+
+    publish(2);
+    CHECK_TRUE(messagebus_cursor_read(&late_cursor, &value, sizeof(value)));
+    CHECK_EQUAL(2, value);
+}
+
+TEST(MessageBusHistoryTestGroup, CursorsAreIndependent)
+{
+    int value;
+    messagebus_cursor_t other_cursor;
+    messagebus_cursor_init(&other_cursor, &topic);
+
+    publish(1);
+    publish(2);
+
+    messagebus_cursor_read(&cursor, &value, sizeof(value));
+    messagebus_cursor_read(&cursor, &value, sizeof(value));
+    CHECK_EQUAL(2, value);
+
+    CHECK_TRUE(messagebus_cursor_read(&other_cursor, &value, sizeof(value)));
+    CHECK_EQUAL(1, value);
+}
+
+TEST(MessageBusHistoryTestGroup, SlowCursorSkipsOverwrittenMessages)
+{
+    int value;
+    for (int i = 1; i <= 6; i++) {
+        publish(i);
+    }
+
+    CHECK_TRUE(messagebus_cursor_read(&cursor, &value, sizeof(value)));
+    CHECK_EQUAL(3, value);
+    CHECK_EQUAL(2, overruns());
+
+    for (int i = 4; i <= 6; i++) {
+        CHECK_TRUE(messagebus_cursor_read(&cursor, &value, sizeof(value)));
+        CHECK_EQUAL(i, value);
+    }
+    CHECK_FALSE(messagebus_cursor_read(&cursor, &value, sizeof(value)));
+}
+
+TEST(MessageBusHistoryTestGroup, ReadReturnsLatestMessage)
+{
+    int value;
+    CHECK_FALSE(messagebus_topic_read(&topic, &value, sizeof(value)));
+
+    for (int i = 1; i <= 6; i++) {
+        publish(i);
+        CHECK_TRUE(messagebus_topic_read(&topic, &value, sizeof(value)));
+        CHECK_EQUAL(i, value);
+    }
+}
+
+TEST(MessageBusHistoryTestGroup, WaitReturnsLatestMessage)
+{
+    publish(1);
+    publish(2);
+
+    int value;
+    messagebus_topic_wait(&topic, &value, sizeof(value));
+    CHECK_EQUAL(2, value);
+}
+
+TEST(MessageBusHistoryTestGroup, CursorWaitDoesNotBlockIfMessageIsAvailable)
+{
+    int value;
+    publish(1);
+
+    mock().expectOneCall("messagebus_lock_acquire").withPointerParameter("lock", &topic_lock);
+    mock().expectOneCall("messagebus_lock_release").withPointerParameter("lock", &topic_lock);
+    lock_mocks_enable(true);
+    condvar_mocks_enable(true);
+
+    messagebus_cursor_wait(&cursor, &value, sizeof(value));
+    CHECK_EQUAL(1, value);
+}
+
+TEST(MessageBusHistoryTestGroup, CursorReadIsLocked)
+{
+    int value;
+
+    mock().expectOneCall("messagebus_lock_acquire").withPointerParameter("lock", &topic_lock);
+    mock().expectOneCall("messagebus_lock_release").withPointerParameter("lock", &topic_lock);
+    lock_mocks_enable(true);
+
+    messagebus_cursor_read(&cursor, &value, sizeof(value));
+}
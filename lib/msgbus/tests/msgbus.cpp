@@ -1,6 +1,8 @@
 #include <CppUTest/TestHarness.h>
 #include <CppUTestExt/MockSupport.h>
 #include <msgbus/messagebus.h>
+#include <cstdio>
+#include <cstring>
 
 TEST_GROUP (MessageBusTestGroup) {
     messagebus_t bus;
@@ -84,6 +86,53 @@ TEST(MessageBusTestGroup, CanScanBus)
     POINTERS_EQUAL(&second_topic, messagebus_find_topic(&bus, "second"));
 }
 
+TEST(MessageBusTestGroup, TopicIsIndexedOnAdvertise)
+{
+    messagebus_advertise_topic(&bus, &topic, "topic");
+
+    CHECK_EQUAL(messagebus_topic_name_hash("topic"), topic.name_hash);
+    CHECK_EQUAL(1, bus.topics.index_count);
+}
+
+TEST(MessageBusTestGroup, CanFindTopicByHash)
+{
+    messagebus_advertise_topic(&bus, &topic, "topic");
+
+    uint32_t hash = messagebus_topic_name_hash("topic");
+    POINTERS_EQUAL(&topic, messagebus_find_topic_by_hash(&bus, hash, "topic"));
+}
+
+TEST(MessageBusTestGroup, HashUsesTruncatedName)
+{
+    char long_name[TOPIC_NAME_MAX_LENGTH + 10];
+    memset(long_name, 'a', sizeof(long_name));
+    long_name[sizeof(long_name) - 1] = '\0';
+
+    messagebus_advertise_topic(&bus, &topic, long_name);
+
+    CHECK_EQUAL(messagebus_topic_name_hash(long_name), topic.name_hash);
+}
+
+TEST(MessageBusTestGroup, CanFindAllTopicsWhenIndexIsFull)
+{
+    static messagebus_topic_t topics[MESSAGEBUS_TOPIC_INDEX_SIZE + 10];
+    static char names[MESSAGEBUS_TOPIC_INDEX_SIZE + 10][16];
+    const int count = MESSAGEBUS_TOPIC_INDEX_SIZE + 10;
+
+    for (int i = 0; i < count; i++) {
+        snprintf(names[i], sizeof(names[i]), "/topic/%d", i);
+        messagebus_topic_init(&topics[i], nullptr, nullptr, nullptr, 0);
+        messagebus_advertise_topic(&bus, &topics[i], names[i]);
+    }
+
+    CHECK_TRUE(bus.topics.index_overflow);
+
+    for (int i = 0; i < count; i++) {
+        POINTERS_EQUAL(&topics[i], messagebus_find_topic(&bus, names[i]));
+    }
+    POINTERS_EQUAL(NULL, messagebus_find_topic(&bus, "/topic/unknown"));
+}
+
 TEST(MessageBusTestGroup, FindTopicBlocking)
 {
     messagebus_topic_t* res;
@@ -0,0 +1,94 @@
+#include <CppUTest/TestHarness.h>
+#include <CppUTestExt/MockSupport.h>
+#include <msgbus/messagebus.h>
+#include "mocks/synchronization.hpp"
+
+TEST_GROUP (MessageBusSeqlockTestGroup) {
+    messagebus_topic_t topic;
+    int buffer;
+    int topic_lock;
+    int topic_condvar;
+
+    void setup() override
+    {
+        mock().strictOrder();
+        messagebus_topic_init_seqlock(&topic, &topic_lock, &topic_condvar, &buffer, sizeof buffer);
+    }
+
+    void teardown() override
+    {
+        lock_mocks_enable(false);
+        mock().checkExpectations();
+        mock().clear();
+    }
+};
+
+TEST(MessageBusSeqlockTestGroup, IsEnabledOnInit)
+{
+    CHECK_TRUE(topic.seqlock);
+    CHECK_EQUAL(0, topic.sequence);
+    POINTERS_EQUAL(&buffer, topic.buffer);
+    POINTERS_EQUAL(&topic_lock, topic.lock);
+}
+
+TEST(MessageBusSeqlockTestGroup, RegularTopicDoesNotUseSeqlock)
+{
+    messagebus_topic_init(&topic, &topic_lock, &topic_condvar, &buffer, sizeof buffer);
+    CHECK_FALSE(topic.seqlock);
+}
+
+TEST(MessageBusSeqlockTestGroup, ReadUnpublished)
+{
+    int data;
+    CHECK_FALSE(messagebus_topic_read(&topic, &data, sizeof data));
+}
+
+TEST(MessageBusSeqlockTestGroup, ReadPublished)
+{
+    int data = 42;
+    messagebus_topic_publish(&topic, &data, sizeof data);
+
+    data = 0;
+    CHECK_TRUE(messagebus_topic_read(&topic, &data, sizeof data));
+    CHECK_EQUAL(42, data);
+}
+
+TEST(MessageBusSeqlockTestGroup, PublishLeavesSequenceEven)
+{
+    int data = 42;
+    messagebus_topic_publish(&topic, &data, sizeof data);
+    CHECK_EQUAL(2, topic.sequence);
+
+    messagebus_topic_publish(&topic, &data, sizeof data);
+    CHECK_EQUAL(4, topic.sequence);
+}
+
+TEST(MessageBusSeqlockTestGroup, SequenceSkipsZeroOnWrapAround)
+{
+    int data = 42;
+    topic.sequence = UINT32_MAX - 1;
+
+    messagebus_topic_publish(&topic, &data, sizeof data);
+
+    CHECK_EQUAL(2, topic.sequence);
+    CHECK_TRUE(messagebus_topic_read(&topic, &data, sizeof data));
+}
+
+TEST(MessageBusSeqlockTestGroup, PublishIsStillLocked)
+{
+    int data = 42;
+    mock().expectOneCall("messagebus_lock_acquire").withPointerParameter("lock", topic.lock);
+    mock().expectOneCall("messagebus_lock_release").withPointerParameter("lock", topic.lock);
+
+    lock_mocks_enable(true);
+    messagebus_topic_publish(&topic, &data, sizeof data);
+}
+
+TEST(MessageBusSeqlockTestGroup, ReadDoesNotLock)
+{
+    int data = 42;
+    messagebus_topic_publish(&topic, &data, sizeof data);
+
+    lock_mocks_enable(true);
+    CHECK_TRUE(messagebus_topic_read(&topic, &data, sizeof data));
+}
@@ -16,6 +16,7 @@ TEST(MessagebusStats, StatsAreZeroedOnInit)
     messagebus_topic_stats_t stats;
     messagebus_topic_stats_get(&topic, &stats);
     CHECK_EQUAL(0, stats.messages);
+    CHECK_EQUAL(0, stats.overruns);
 }
 
 TEST(MessagebusStats, MessagesAreIncrementedOnPublish)
@@ -0,0 +1,176 @@
+#include <CppUTest/TestHarness.h>
+#include <CppUTestExt/MockSupport.h>
+#include <msgbus/messagebus.h>
+#include "mocks/synchronization.hpp"
+
+static void callback(messagebus_topic_t* topic, void* arg)
+{
+    mock().actualCall("callback").withPointerParameter("topic", topic).withPointerParameter("arg", arg);
+}
+
+TEST_GROUP (MessageBusSubscriberTestGroup) {
+    messagebus_topic_t topic;
+    int buffer;
+    int topic_lock, topic_condvar;
+    messagebus_executor_t executor;
+    int executor_lock, executor_condvar;
+    messagebus_subscriber_t sub, other_sub;
+    int arg;
+
+    void setup() override
+    {
+        messagebus_topic_init(&topic, &topic_lock, &topic_condvar, &buffer, sizeof buffer);
+        messagebus_executor_init(&executor, &executor_lock, &executor_condvar);
+    }
+
+    void teardown() override
+    {
+        lock_mocks_enable(false);
+        condvar_mocks_enable(false);
+        mock().checkExpectations();
+        mock().clear();
+    }
+
+    void publish(int value)
+    {
+        messagebus_topic_publish(&topic, &value, sizeof(value));
+    }
+};
+
+TEST(MessageBusSubscriberTestGroup, CanInitExecutor)
+{
+    POINTERS_EQUAL(&executor_lock, executor.lock);
+    POINTERS_EQUAL(&executor_condvar, executor.condvar);
+    POINTERS_EQUAL(NULL, executor.queue_head);
+}
+
+TEST(MessageBusSubscriberTestGroup, SubscribeAddsToTopic)
+{
+    messagebus_subscribe(&sub, &topic, &executor, callback, &arg);
+    messagebus_subscribe(&other_sub, &topic, &executor, callback, &arg);
+
+    POINTERS_EQUAL(&other_sub, topic.subscribers);
+    POINTERS_EQUAL(&sub, topic.subscribers->next);
+}
+
+TEST(MessageBusSubscriberTestGroup, SubscribeIsLocked)
+{
+    mock().strictOrder();
+    mock().expectOneCall("messagebus_lock_acquire").withPointerParameter("lock", &topic_lock);
+    mock().expectOneCall("messagebus_lock_release").withPointerParameter("lock", &topic_lock);
+    lock_mocks_enable(true);
+
+    messagebus_subscribe(&sub, &topic, &executor, callback, &arg);
+}
+
+TEST(MessageBusSubscriberTestGroup, DirectCallbackIsCalledOnPublish)
+{
+    messagebus_subscribe(&sub, &topic, NULL, callback, &arg);
+
+    mock().expectOneCall("callback").withPointerParameter("topic", &topic).withPointerParameter("arg", &arg);
+    publish(42);
+}
+
+TEST(MessageBusSubscriberTestGroup, DirectCallbackIsCalledOutsideOfTopicLock)
+{
+    messagebus_subscribe(&sub, &topic, NULL, callback, &arg);
+
+    mock().strictOrder();
+    mock().expectOneCall("messagebus_lock_acquire").withPointerParameter("lock", &topic_lock);
+    mock().expectOneCall("messagebus_lock_release").withPointerParameter("lock", &topic_lock);
+    mock().expectOneCall("callback").withPointerParameter("topic", &topic).withPointerParameter("arg", &arg);
+    lock_mocks_enable(true);
+
+    publish(42);
+}
+
+TEST(MessageBusSubscriberTestGroup, PublishQueuesOnExecutor)
+{
+    messagebus_subscribe(&sub, &topic, &executor, callback, &arg);
+
+    mock().expectOneCall("messagebus_condvar_broadcast").withPointerParameter("var", &topic_condvar);
+    mock().expectOneCall("messagebus_condvar_broadcast").withPointerParameter("var", &executor_condvar);
+    condvar_mocks_enable(true);
+    publish(42);
+
+    POINTERS_EQUAL(&sub, executor.queue_head);
+    CHECK_TRUE(sub.pending);
+}
+
+TEST(MessageBusSubscriberTestGroup, ExecutorRunsCallback)
+{
+    messagebus_subscribe(&sub, &topic, &executor, callback, &arg);
+    publish(42);
+
+    mock().expectOneCall("callback").withPointerParameter("topic", &topic).withPointerParameter("arg", &arg);
+    CHECK_TRUE(messagebus_executor_dispatch(&executor));
+    CHECK_FALSE(messagebus_executor_dispatch(&executor));
+}
+
+TEST(MessageBusSubscriberTestGroup, NothingToDispatchWithoutPublish)
+{
+    messagebus_subscribe(&sub, &topic, &executor, callback, &arg);
+    CHECK_FALSE(messagebus_executor_dispatch(&executor));
+}
+
+TEST(MessageBusSubscriberTestGroup, SeveralPublishesAreCoalesced)
+{
+    messagebus_subscribe(&sub, &topic, &executor, callback, &arg);
+    publish(1);
+    publish(2);
+    publish(3);
+
+    mock().expectOneCall("callback").withPointerParameter("topic", &topic).withPointerParameter("arg", &arg);
+    CHECK_TRUE(messagebus_executor_dispatch(&executor));
+    CHECK_FALSE(messagebus_executor_dispatch(&executor));
+}
+
+TEST(MessageBusSubscriberTestGroup, CallbacksAreDispatchedInOrder)
+{
+    messagebus_topic_t other_topic;
+    int other_buffer;
+    messagebus_topic_init(&other_topic, nullptr, nullptr, &other_buffer, sizeof other_buffer);
+
+    messagebus_subscribe(&sub, &topic, &executor, callback, &arg);
+    messagebus_subscribe(&other_sub, &other_topic, &executor, callback, &arg);
+
+    messagebus_topic_publish(&other_topic, &other_buffer, sizeof(other_buffer));
+    publish(42);
+
+    mock().strictOrder();
+    mock().expectOneCall("callback").withPointerParameter("topic", &other_topic).withPointerParameter("arg", &arg);
+    mock().expectOneCall("callback").withPointerParameter("topic", &topic).withPointerParameter("arg", &arg);
+    CHECK_TRUE(messagebus_executor_dispatch(&executor));
+    CHECK_TRUE(messagebus_executor_dispatch(&executor));
+}
+
+static messagebus_executor_t* republish_executor;
+static int republish_count;
+
+static void republish_callback(messagebus_topic_t* topic, void* arg)
+{
+    (void)arg;
+    int value = 0;
+    republish_count++;
+
+    /* Publishing while the callback runs must not queue it a second time
+     * (this would let two executor threads run it concurrently), but it must
+     * be queued again once the callback is done. */
+    messagebus_topic_publish(topic, &value, sizeof(value));
+    CHECK_TRUE(republish_executor->queue_head == NULL);
+}
+
+TEST(MessageBusSubscriberTestGroup, PublishDuringCallbackRequeuesAfterwards)
+{
+    republish_executor = &executor;
+    republish_count = 0;
+    messagebus_subscribe(&sub, &topic, &executor, republish_callback, NULL);
+    publish(42);
+
+    CHECK_TRUE(messagebus_executor_dispatch(&executor));
+    CHECK_EQUAL(1, republish_count);
+    POINTERS_EQUAL(&sub, executor.queue_head);
+
+    CHECK_TRUE(messagebus_executor_dispatch(&executor));
+    CHECK_EQUAL(2, republish_count);
+}
@@ -63,3 +63,21 @@ TEST(MessagebusCppInterface, CanFindTopicBlocking)
     auto topic = messagebus::find_topic_blocking<int>(bus, "/foo");
     CHECK_TRUE(topic);
 }
+
+TEST(MessagebusCppInterface, TopicIdHashMatchesC)
+{
+    constexpr messagebus::TopicId id{"/foo"};
+    static_assert(id.hash == messagebus::topic_name_hash("/foo"), "hash should be computed at compile time");
+
+    CHECK_EQUAL(messagebus_topic_name_hash("/foo"), id.hash);
+}
+
+TEST(MessagebusCppInterface, CanFindTopicById)
+{
+    constexpr messagebus::TopicId id{"/foo"};
+    auto topic = messagebus::find_topic<int>(bus, id);
+    CHECK_TRUE(topic);
+
+    constexpr messagebus::TopicId unknown{"/bar"};
+    CHECK_FALSE(messagebus::find_topic<int>(bus, unknown));
+}
@@ -0,0 +1,12 @@
+#!/bin/sh
+CC=clang
+CXX=clang++
+CFLAGS="-I../include -O3"
+
+cd $(dirname $0)
+
+$CC $CFLAGS -c ../parameter.c -o parameter.o
+$CC $CFLAGS -c ../parameter_snapshot.c -o parameter_snapshot.o
+$CXX $CFLAGS -std=c++14 -o benchmark \
+    main.cpp parameter.o parameter_snapshot.o \
+    -lbenchmark -lpthread
@@ -0,0 +1,192 @@
+#include <mutex>
+#include <cstdlib>
+#include <benchmark/benchmark.h>
+#include <parameter/parameter.h>
+#include <parameter/parameter_port.h>
+#include <parameter/parameter_snapshot.h>
+
+/* Compares the ways a control loop can read its parameters on every cycle,
+ * using parameters similar to the motor board ones. */
+
+static std::mutex lock;
+
+extern "C" void parameter_port_lock(void)
+{
+    lock.lock();
+}
+
+extern "C" void parameter_port_unlock(void)
+{
+    lock.unlock();
+}
+
+extern "C" void parameter_port_assert(int condition)
+{
+    if (!condition) {
+        abort();
+    }
+}
+
+extern "C" void* parameter_port_buffer_alloc(size_t size)
+{
+    return malloc(size);
+}
+
+extern "C" void parameter_port_buffer_free(void* buffer)
+{
+    free(buffer);
+}
+
+struct pid_params {
+    parameter_namespace_t ns;
+    parameter_t kp, ki, kd, i_limit;
+};
+
+struct pid_config {
+    float kp, ki, kd, i_limit;
+};
+
+struct config {
+    pid_config pos, vel, cur;
+    float velocity_limit;
+    float torque_limit;
+    float acceleration_limit;
+    int32_t mode;
+};
+
+static parameter_namespace_t root;
+static parameter_namespace_t control_ns;
+static pid_params pos, vel, cur;
+static parameter_t velocity_limit, torque_limit, acceleration_limit, mode;
+
+static const parameter_binding_t bindings[] = {
+    PARAMETER_BINDING(&pos.kp, config, pos.kp),
+    PARAMETER_BINDING(&pos.ki, config, pos.ki),
+    PARAMETER_BINDING(&pos.kd, config, pos.kd),
+    PARAMETER_BINDING(&pos.i_limit, config, pos.i_limit),
+    PARAMETER_BINDING(&vel.kp, config, vel.kp),
+    PARAMETER_BINDING(&vel.ki, config, vel.ki),
+    PARAMETER_BINDING(&vel.kd, config, vel.kd),
+    PARAMETER_BINDING(&vel.i_limit, config, vel.i_limit),
+    PARAMETER_BINDING(&cur.kp, config, cur.kp),
+    PARAMETER_BINDING(&cur.ki, config, cur.ki),
+    PARAMETER_BINDING(&cur.kd, config, cur.kd),
+    PARAMETER_BINDING(&cur.i_limit, config, cur.i_limit),
+    PARAMETER_BINDING(&velocity_limit, config, velocity_limit),
+    PARAMETER_BINDING(&torque_limit, config, torque_limit),
+    PARAMETER_BINDING(&acceleration_limit, config, acceleration_limit),
+    PARAMETER_BINDING(&mode, config, mode),
+};
+
+static void pid_declare(pid_params* p, const char* id)
+{
+    parameter_namespace_declare(&p->ns, &control_ns, id);
+    parameter_scalar_declare_with_default(&p->kp, &p->ns, "kp", 1);
+    parameter_scalar_declare_with_default(&p->ki, &p->ns, "ki", 0);
+    parameter_scalar_declare_with_default(&p->kd, &p->ns, "kd", 0);
+    parameter_scalar_declare_with_default(&p->i_limit, &p->ns, "i_limit", 10);
+}
+
+static void declare_parameters()
+{
+    static bool declared = false;
+    if (declared) {
+        return;
+    }
+    declared = true;
+
+    parameter_namespace_declare(&root, nullptr, nullptr);
+    parameter_namespace_declare(&control_ns, &root, "control");
+    pid_declare(&pos, "position");
+    pid_declare(&vel, "velocity");
+    pid_declare(&cur, "current");
+    parameter_scalar_declare_with_default(&velocity_limit, &control_ns, "velocity_limit", 10);
+    parameter_scalar_declare_with_default(&torque_limit, &control_ns, "torque_limit", 10);
+    parameter_scalar_declare_with_default(&acceleration_limit, &control_ns, "acceleration_limit", 10);
+    parameter_integer_declare_with_default(&mode, &control_ns, "mode", 0);
+}
+
+static void pid_get(pid_params* p, pid_config* c)
+{
+    c->kp = parameter_scalar_get(&p->kp);
+    c->ki = parameter_scalar_get(&p->ki);
+    c->kd = parameter_scalar_get(&p->kd);
+    c->i_limit = parameter_scalar_get(&p->i_limit);
+}
+
+/* What the control loops do today: one get (locking several times) per
+ * parameter and per cycle. */
+static void BM_PerParameterGet(benchmark::State& state)
+{
+    declare_parameters();
+    config c;
+
+    for (auto _ : state) {
+        pid_get(&pos, &c.pos);
+        pid_get(&vel, &c.vel);
+        pid_get(&cur, &c.cur);
+        c.velocity_limit = parameter_scalar_get(&velocity_limit);
+        c.torque_limit = parameter_scalar_get(&torque_limit);
+        c.acceleration_limit = parameter_scalar_get(&acceleration_limit);
+        c.mode = parameter_integer_get(&mode);
+        benchmark::DoNotOptimize(c);
+    }
+}
+BENCHMARK(BM_PerParameterGet);
+
+/* Same, resolving the parameters by name on every cycle. */
+static void BM_PerParameterFindAndGet(benchmark::State& state)
+{
+    declare_parameters();
+    const char* scalars[] = {
+        "position/kp", "position/ki", "position/kd", "position/i_limit",
+        "velocity/kp", "velocity/ki", "velocity/kd", "velocity/i_limit",
+        "current/kp", "current/ki", "current/kd", "current/i_limit",
+        "velocity_limit", "torque_limit", "acceleration_limit"};
+    float values[15];
+
+    for (auto _ : state) {
+        for (auto i = 0; i < 15; i++) {
+            values[i] = parameter_scalar_get(parameter_find(&control_ns, scalars[i]));
+        }
+        benchmark::DoNotOptimize(values);
+        benchmark::DoNotOptimize(parameter_integer_get(parameter_find(&control_ns, "mode")));
+    }
+}
+BENCHMARK(BM_PerParameterFindAndGet);
+
+/* Snapshot when nothing changed, i.e. almost every cycle. */
+static void BM_SnapshotUnchanged(benchmark::State& state)
+{
+    declare_parameters();
+    parameter_snapshot_t snapshot;
+    parameter_snapshot_init(&snapshot, &control_ns, bindings, sizeof(bindings) / sizeof(bindings[0]));
+    config c;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(parameter_snapshot_update(&snapshot, &c));
+        benchmark::DoNotOptimize(c);
+    }
+}
+BENCHMARK(BM_SnapshotUnchanged);
+
+/* Snapshot when a parameter changes before every cycle, which is the worst
+ * case. The set itself is included in the measure. */
+static void BM_SnapshotChangedEveryCycle(benchmark::State& state)
+{
+    declare_parameters();
+    parameter_snapshot_t snapshot;
+    parameter_snapshot_init(&snapshot, &control_ns, bindings, sizeof(bindings) / sizeof(bindings[0]));
+    config c;
+    float kp = 0;
+
+    for (auto _ : state) {
+        parameter_scalar_set(&pos.kp, kp);
+        kp += 1;
+        benchmark::DoNotOptimize(parameter_snapshot_update(&snapshot, &c));
+        benchmark::DoNotOptimize(c);
+    }
+}
+BENCHMARK(BM_SnapshotChangedEveryCycle);
+
+BENCHMARK_MAIN();
@@ -15,6 +15,7 @@ struct parameter_namespace_s {
     parameter_namespace_t* subspaces;
     parameter_namespace_t* next;
     parameter_t* parameter_list;
+    uint32_t version; // incremented twice by each write in the namespace tree
 };
 
 struct _param_val_str_s {
@@ -79,6 +80,13 @@ parameter_namespace_t* _parameter_namespace_find_w_id_len(parameter_namespace_t*
 
 bool parameter_namespace_contains_changed(const parameter_namespace_t* ns);
 
+/*
+ * Get the version of the namespace, which changes every time a parameter in
+ * it or in one of its sub-namespaces is set.
+ * An odd version means that a parameter is being written.
+ */
+uint32_t parameter_namespace_version(const parameter_namespace_t* ns);
+
 /*
  * Get the parameter by id.
  * The id is relative to the namespace.
@@ -0,0 +1,80 @@
+#ifndef PARAMETER_SNAPSHOT_H
+#define PARAMETER_SNAPSHOT_H
+
+#include <stddef.h>
+#include <parameter/parameter.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Copies a set of parameters into a plain struct, for loops which use them on
+ * every cycle. Parameters are resolved once, when the bindings are created,
+ * and reading them does not take the parameter lock.
+ *
+ * Example:
+ *
+ * struct pid_config { float kp, ki, kd; } config;
+ * parameter_binding_t bindings[] = {
+ *     PARAMETER_BINDING(&param_kp, struct pid_config, kp),
+ *     PARAMETER_BINDING(&param_ki, struct pid_config, ki),
+ *     PARAMETER_BINDING(&param_kd, struct pid_config, kd),
+ * };
+ * parameter_snapshot_t snapshot;
+ * parameter_snapshot_init(&snapshot, &pid_ns, bindings, 3);
+ *
+ * // ... in the control loop:
+ * if (parameter_snapshot_update(&snapshot, &config)) {
+ *     pid_set_gains(&pid, config.kp, config.ki, config.kd);
+ * }
+ */
+
+/*
+ * Location of a parameter value in the snapshot struct. The field must have the
+ * type of the parameter: float for scalars, int32_t for integers, bool for
+ * booleans and float[dim] for vectors.
+ */
+typedef struct {
+    parameter_t* parameter;
+    size_t offset;
+} parameter_binding_t;
+
+#define PARAMETER_BINDING(param, type, field) \
+    {                                         \
+        (param), offsetof(type, field)        \
+    }
+
+typedef struct {
+    const parameter_namespace_t* ns;
+    const parameter_binding_t* bindings;
+    size_t binding_count;
+    uint32_t version; // namespace version of the last copy
+} parameter_snapshot_t;
+
+/*
+ * Initializes a snapshot of the given parameters.
+ * All the parameters must be in ns or in one of its sub-namespaces.
+ * The bindings array is not copied and must stay valid.
+ */
+void parameter_snapshot_init(parameter_snapshot_t* snapshot,
+                             const parameter_namespace_t* ns,
+                             const parameter_binding_t* bindings,
+                             size_t binding_count);
+
+/*
+ * Copies the parameter values to dst if any parameter of the namespace was set
+ * since the last update (always on the first one).
+ * Returns true if dst was updated.
+ * The values are consistent: they were all read between two writes to the
+ * namespace. Parameters which are not defined yet are not copied, so dst should
+ * contain default values.
+ * Unlike parameter_*_get(), this does not clear the changed flags.
+ */
+bool parameter_snapshot_update(parameter_snapshot_t* snapshot, void* dst);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PARAMETER_SNAPSHOT_H */
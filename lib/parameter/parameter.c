@@ -21,6 +21,11 @@
  * temporarily become negative in case the increment is interrupted by a
  * get_parameter() which decreases the counter. This poses no problem since the
  * check for the changed count correctly handles the signed integer counter)
+ *
+ * Additionally, every write to a parameter value increments the version of all
+ * the namespaces containing it, once before and once after the write. This
+ * allows reading a consistent snapshot of a namespace without taking the lock
+ * (see parameter_snapshot.c).
  */
 
 /* find the length of the next element in hierarchical id
@@ -90,6 +95,7 @@ void parameter_namespace_declare(parameter_namespace_t* ns,
 {
     ns->id = id;
     ns->changed_cnt = 0;
+    ns->version = 0;
     ns->parent = parent;
     ns->subspaces = NULL;
     ns->parameter_list = NULL;
@@ -168,6 +174,11 @@ bool parameter_namespace_contains_changed(const parameter_namespace_t* ns)
     return changed_cnt > 0;
 }
 
+uint32_t parameter_namespace_version(const parameter_namespace_t* ns)
+{
+    return __atomic_load_n(&ns->version, __ATOMIC_ACQUIRE);
+}
+
 bool parameter_changed(const parameter_t* p)
 {
     parameter_port_lock();
@@ -228,6 +239,33 @@ void _parameter_changed_clear(parameter_t* p)
     }
 }
 
+/*
+ * Start of a write to the parameter value, the lock is held until
+ * value_write_end() is called.
+ */
+static void value_write_begin(parameter_t* p)
+{
+    parameter_port_lock();
+    parameter_namespace_t* ns;
+    for (ns = p->ns; ns != NULL; ns = ns->parent) {
+        // odd version: write in progress
+        __atomic_store_n(&ns->version, ns->version + 1, __ATOMIC_RELAXED);
+    }
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void value_write_end(parameter_t* p)
+{
+    // set here so that snapshot readers never see the value without it
+    p->defined = true;
+    parameter_namespace_t* ns;
+    for (ns = p->ns; ns != NULL; ns = ns->parent) {
+        __atomic_store_n(&ns->version, ns->version + 1, __ATOMIC_RELEASE);
+    }
+    parameter_port_unlock();
+    _parameter_changed_set(p);
+}
+
 /*
  * Scalar type parameter
  */
@@ -268,10 +306,9 @@ float parameter_scalar_read(parameter_t* p)
 void parameter_scalar_set(parameter_t* p, float value)
 {
     parameter_port_assert(p->type == _PARAM_TYPE_SCALAR);
-    parameter_port_lock();
+    value_write_begin(p);
     p->value.s = value;
-    parameter_port_unlock();
-    _parameter_changed_set(p);
+    value_write_end(p);
 }
 
 /*
@@ -314,10 +351,9 @@ int32_t parameter_integer_read(parameter_t* p)
 void parameter_integer_set(parameter_t* p, int32_t value)
 {
     parameter_port_assert(p->type == _PARAM_TYPE_INTEGER);
-    parameter_port_lock();
+    value_write_begin(p);
     p->value.i = value;
-    parameter_port_unlock();
-    _parameter_changed_set(p);
+    value_write_end(p);
 }
 
 /* Boolean type parameter. */
@@ -343,10 +379,9 @@ void parameter_boolean_set(parameter_t* p, bool value)
 {
     parameter_port_assert(p->type == _PARAM_TYPE_BOOLEAN);
 
-    parameter_port_lock();
+    value_write_begin(p);
     p->value.b = value;
-    parameter_port_unlock();
-    _parameter_changed_set(p);
+    value_write_end(p);
 }
 
 bool parameter_boolean_get(parameter_t* p)
@@ -414,13 +449,12 @@ void parameter_vector_read(parameter_t* p, float* out)
 void parameter_vector_set(parameter_t* p, const float* v)
 {
     parameter_port_assert(p->type == _PARAM_TYPE_VECTOR);
-    parameter_port_lock();
+    value_write_begin(p);
     int i;
     for (i = 0; i < p->value.vect.dim; i++) {
         p->value.vect.buf[i] = v[i];
     }
-    parameter_port_unlock();
-    _parameter_changed_set(p);
+    value_write_end(p);
 }
 
 /*
@@ -481,15 +515,14 @@ uint16_t parameter_variable_vector_read(parameter_t* p, float* out)
 void parameter_variable_vector_set(parameter_t* p, const float* v, uint16_t dim)
 {
     parameter_port_assert(p->type == _PARAM_TYPE_VAR_VECTOR);
-    parameter_port_lock();
     parameter_port_assert(dim <= p->value.vect.buf_dim);
+    value_write_begin(p);
     int i;
     for (i = 0; i < dim; i++) {
         p->value.vect.buf[i] = v[i];
     }
     p->value.vect.dim = dim;
-    parameter_port_unlock();
-    _parameter_changed_set(p);
+    value_write_end(p);
 }
 
 /*
@@ -559,10 +592,9 @@ void parameter_string_set(parameter_t* p, const char* str)
 void parameter_string_set_w_len(parameter_t* p, const char* str, uint16_t len)
 {
     parameter_port_assert(p->type == _PARAM_TYPE_STRING);
-    parameter_port_lock();
     parameter_port_assert(len <= p->value.str.buf_len);
+    value_write_begin(p);
     memcpy(p->value.str.buf, str, len);
     p->value.str.len = len;
-    parameter_port_unlock();
-    _parameter_changed_set(p);
+    value_write_end(p);
 }
@@ -0,0 +1,93 @@
+#include <string.h>
+#include <parameter/parameter.h>
+#include <parameter/parameter_port.h>
+#include <parameter/parameter_snapshot.h>
+
+/* Namespace versions are even when no write is in progress, so this one never
+ * matches and forces the first update. */
+#define VERSION_NEVER_COPIED 1
+
+void parameter_snapshot_init(parameter_snapshot_t* snapshot,
+                             const parameter_namespace_t* ns,
+                             const parameter_binding_t* bindings,
+                             size_t binding_count)
+{
+    size_t i;
+    for (i = 0; i < binding_count; i++) {
+        uint8_t type = bindings[i].parameter->type;
+        parameter_port_assert(type == _PARAM_TYPE_SCALAR
+                              || type == _PARAM_TYPE_INTEGER
+                              || type == _PARAM_TYPE_BOOLEAN
+                              || type == _PARAM_TYPE_VECTOR);
+    }
+
+    snapshot->ns = ns;
+    snapshot->bindings = bindings;
+    snapshot->binding_count = binding_count;
+    snapshot->version = VERSION_NEVER_COPIED;
+}
+
+static void copy_values(const parameter_snapshot_t* snapshot, uint8_t* dst)
+{
+    size_t i;
+    for (i = 0; i < snapshot->binding_count; i++) {
+        const parameter_t* p = snapshot->bindings[i].parameter;
+        uint8_t* field = dst + snapshot->bindings[i].offset;
+
+        if (!__atomic_load_n(&p->defined, __ATOMIC_RELAXED)) {
+            continue;
+        }
+
+        switch (p->type) {
+            case _PARAM_TYPE_SCALAR:
+                memcpy(field, &p->value.s, sizeof(float));
+                break;
+
+            case _PARAM_TYPE_INTEGER:
+                memcpy(field, &p->value.i, sizeof(int32_t));
+                break;
+
+            case _PARAM_TYPE_BOOLEAN:
+                memcpy(field, &p->value.b, sizeof(bool));
+                break;
+
+            case _PARAM_TYPE_VECTOR:
+                memcpy(field, p->value.vect.buf, p->value.vect.dim * sizeof(float));
+                break;
+        }
+    }
+}
+
+bool parameter_snapshot_update(parameter_snapshot_t* snapshot, void* dst)
+{
+    uint32_t before = parameter_namespace_version(snapshot->ns);
+
+    if (before == snapshot->version) {
+        return false;
+    }
+
+    while (true) {
+        if (before & 1) {
+            /* A writer is in the middle of a write and holds the parameter
+             * lock. Block on it rather than spinning, so that the writer can
+             * run if it was preempted. */
+            parameter_port_lock();
+            parameter_port_unlock();
+            before = parameter_namespace_version(snapshot->ns);
+            continue;
+        }
+
+        copy_values(snapshot, dst);
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        uint32_t after = __atomic_load_n(&snapshot->ns->version, __ATOMIC_RELAXED);
+
+        if (before == after) {
+            break;
+        }
+        before = after;
+    }
+
+    snapshot->version = before;
+    return true;
+}
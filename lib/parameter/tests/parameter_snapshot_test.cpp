@@ -0,0 +1,166 @@
+#include "CppUTest/TestHarness.h"
+#include <cstring>
+#include <parameter/parameter.h>
+#include <parameter/parameter_snapshot.h>
+
+struct config {
+    float gain;
+    int32_t count;
+    bool enabled;
+    float offset[3];
+    float nested;
+};
+
+TEST_GROUP (ParameterSnapshot) {
+    parameter_namespace_t root;
+    parameter_namespace_t ns;
+    parameter_namespace_t sub;
+    parameter_namespace_t other;
+    parameter_t gain, count, enabled, offset, nested, unrelated;
+    float offset_buf[3] = {1, 2, 3};
+
+    parameter_binding_t bindings[5] = {
+        PARAMETER_BINDING(&gain, struct config, gain),
+        PARAMETER_BINDING(&count, struct config, count),
+        PARAMETER_BINDING(&enabled, struct config, enabled),
+        PARAMETER_BINDING(&offset, struct config, offset),
+        PARAMETER_BINDING(&nested, struct config, nested),
+    };
+
+    parameter_snapshot_t snapshot;
+    struct config config;
+
+    void setup() override
+    {
+        parameter_namespace_declare(&root, nullptr, nullptr);
+        parameter_namespace_declare(&ns, &root, "ns");
+        parameter_namespace_declare(&sub, &ns, "sub");
+        parameter_namespace_declare(&other, &root, "other");
+        parameter_scalar_declare_with_default(&gain, &ns, "gain", 1.5);
+        parameter_integer_declare_with_default(&count, &ns, "count", 12);
+        parameter_boolean_declare_with_default(&enabled, &ns, "enabled", true);
+        parameter_vector_declare_with_default(&offset, &ns, "offset", offset_buf, 3);
+        parameter_scalar_declare(&nested, &sub, "nested");
+        parameter_scalar_declare_with_default(&unrelated, &other, "unrelated", 0);
+
+        parameter_snapshot_init(&snapshot, &ns, bindings, 5);
+        memset(&config, 0, sizeof(config));
+        config.nested = 42;
+    }
+};
+
+TEST(ParameterSnapshot, FirstUpdateCopiesEverything)
+{
+    CHECK_TRUE(parameter_snapshot_update(&snapshot, &config));
+
+    CHECK_EQUAL(1.5, config.gain);
+    CHECK_EQUAL(12, config.count);
+    CHECK_TRUE(config.enabled);
+    CHECK_EQUAL(1, config.offset[0]);
+    CHECK_EQUAL(3, config.offset[2]);
+}
+
+TEST(ParameterSnapshot, UndefinedParametersAreNotCopied)
+{
+    parameter_snapshot_update(&snapshot, &config);
+
+    CHECK_EQUAL(42, config.nested);
+}
+
+TEST(ParameterSnapshot, NoUpdateIfNothingChanged)
+{
+    parameter_snapshot_update(&snapshot, &config);
+    config.gain = 0;
+
+    CHECK_FALSE(parameter_snapshot_update(&snapshot, &config));
+    CHECK_EQUAL(0, config.gain);
+}
+
+TEST(ParameterSnapshot, UpdateAfterSet)
+{
+    parameter_snapshot_update(&snapshot, &config);
+
+    parameter_scalar_set(&gain, 2.5);
+
+    CHECK_TRUE(parameter_snapshot_update(&snapshot, &config));
+    CHECK_EQUAL(2.5, config.gain);
+    CHECK_FALSE(parameter_snapshot_update(&snapshot, &config));
+}
+
+TEST(ParameterSnapshot, UpdateAfterSetInSubNamespace)
+{
+    parameter_snapshot_update(&snapshot, &config);
+
+    parameter_scalar_set(&nested, 3);
+
+    CHECK_TRUE(parameter_snapshot_update(&snapshot, &config));
+    CHECK_EQUAL(3, config.nested);
+}
+
+TEST(ParameterSnapshot, OtherNamespacesAreIgnored)
+{
+    parameter_snapshot_update(&snapshot, &config);
+
+    parameter_scalar_set(&unrelated, 3);
+
+    CHECK_FALSE(parameter_snapshot_update(&snapshot, &config));
+}
+
+TEST(ParameterSnapshot, ChangedFlagsAreNotCleared)
+{
+    parameter_scalar_set(&gain, 2.5);
+
+    parameter_snapshot_update(&snapshot, &config);
+
+    CHECK_TRUE(parameter_changed(&gain));
+}
+
+TEST_GROUP (ParameterNamespaceVersion) {
+    parameter_namespace_t root;
+    parameter_namespace_t ns;
+    parameter_t p;
+    float vect_buf[2];
+    char str_buf[10];
+
+    void setup() override
+    {
+        parameter_namespace_declare(&root, nullptr, nullptr);
+        parameter_namespace_declare(&ns, &root, "ns");
+    }
+};
+
+TEST(ParameterNamespaceVersion, InitialVersionIsZero)
+{
+    CHECK_EQUAL(0, parameter_namespace_version(&ns));
+}
+
+TEST(ParameterNamespaceVersion, SetIncrementsAllParentVersions)
+{
+    parameter_integer_declare(&p, &ns, "p");
+
+    parameter_integer_set(&p, 1);
+
+    CHECK_EQUAL(2, parameter_namespace_version(&ns));
+    CHECK_EQUAL(2, parameter_namespace_version(&root));
+}
+
+TEST(ParameterNamespaceVersion, EveryTypeIncrementsTheVersion)
+{
+    parameter_t params[6];
+    parameter_scalar_declare(&params[0], &ns, "scalar");
+    parameter_integer_declare(&params[1], &ns, "integer");
+    parameter_boolean_declare(&params[2], &ns, "boolean");
+    parameter_vector_declare(&params[3], &ns, "vector", vect_buf, 2);
+    parameter_variable_vector_declare(&params[4], &ns, "var_vector", vect_buf, 2);
+    parameter_string_declare(&params[5], &ns, "string", str_buf, sizeof(str_buf));
+
+    const float v[2] = {1, 2};
+    parameter_scalar_set(&params[0], 1);
+    parameter_integer_set(&params[1], 1);
+    parameter_boolean_set(&params[2], true);
+    parameter_vector_set(&params[3], v);
+    parameter_variable_vector_set(&params[4], v, 2);
+    parameter_string_set(&params[5], "foo");
+
+    CHECK_EQUAL(12, parameter_namespace_version(&ns));
+}
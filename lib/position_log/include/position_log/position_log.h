@@ -0,0 +1,103 @@
+#ifndef POSITION_LOG_H
+#define POSITION_LOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Binary log of the simulated robot's state.
+ *
+ * The file is a header followed by fixed-size records in host byte order, so
+ * that it can be memory-mapped and used as an array of records, without
+ * parsing. A record cut short (for example if the simulator was killed) is
+ * ignored.
+ */
+
+#define POSITION_LOG_MAGIC "CVRAPLOG"
+#define POSITION_LOG_VERSION 1
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size; /* sizeof(position_log_record_t) */
+} position_log_header_t;
+
+typedef struct {
+    uint64_t timestamp_us; /* Match time */
+    float x, y; /* m */
+    float heading; /* rad */
+    float vx, vy; /* m/s */
+    float omega; /* rad/s */
+    float left_voltage, right_voltage; /* V */
+    int32_t left_encoder, right_encoder; /* ticks */
+} position_log_record_t;
+
+/* Number of records written to disk at once */
+#define POSITION_LOG_WRITER_BUFFER_LEN 1024
+
+/** Writes records from a background thread, so that appending one is only a
+ * copy in memory. Two buffers are used: one is filled while the other is
+ * written. Appending only blocks if the disk is slower than the simulation.
+ */
+typedef struct {
+    FILE* file;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    position_log_record_t buffers[2][POSITION_LOG_WRITER_BUFFER_LEN];
+    int current; /* Buffer being filled */
+    size_t fill;
+
+    /* Buffer handed to the thread and not written yet */
+    bool pending;
+    size_t pending_len;
+
+    bool closing;
+    bool failed;
+} position_log_writer_t;
+
+/** Creates (or truncates) the log file and starts the writer thread.
+ *
+ * @returns false if the file could not be opened.
+ */
+bool position_log_writer_open(position_log_writer_t* writer, const char* path);
+
+/** Adds a record to the log. Must always be called from the same thread. */
+void position_log_writer_append(position_log_writer_t* writer, const position_log_record_t* record);
+
+/** Writes the remaining records, stops the thread and closes the file.
+ *
+ * @returns false if any record could not be written.
+ */
+bool position_log_writer_close(position_log_writer_t* writer);
+
+/** A log file mapped in memory. */
+typedef struct {
+    const position_log_record_t* records;
+    size_t count;
+
+    void* map;
+    size_t map_len;
+} position_log_t;
+
+/** Maps a log file in memory.
+ *
+ * @returns false if the file could not be mapped, or is not a log in the
+ * format of this version.
+ */
+bool position_log_map(position_log_t* log, const char* path);
+
+void position_log_unmap(position_log_t* log);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POSITION_LOG_H */
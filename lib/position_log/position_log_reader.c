@@ -0,0 +1,48 @@
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "position_log/position_log.h"
+
+bool position_log_map(position_log_t* log, const char* path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(position_log_header_t)) {
+        close(fd);
+        return false;
+    }
+
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+
+    const position_log_header_t* header = (const position_log_header_t*)map;
+    if (memcmp(header->magic, POSITION_LOG_MAGIC, sizeof(header->magic)) != 0
+        || header->version != POSITION_LOG_VERSION
+        || header->record_size != sizeof(position_log_record_t)) {
+        munmap(map, st.st_size);
+        return false;
+    }
+
+    log->map = map;
+    log->map_len = st.st_size;
+    log->records = (const position_log_record_t*)((const char*)map + sizeof(position_log_header_t));
+    log->count = (st.st_size - sizeof(position_log_header_t)) / sizeof(position_log_record_t);
+
+    return true;
+}
+
+void position_log_unmap(position_log_t* log)
+{
+    munmap(log->map, log->map_len);
+    log->records = NULL;
+    log->count = 0;
+}
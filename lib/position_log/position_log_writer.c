@@ -0,0 +1,111 @@
+#include <string.h>
+#include "position_log/position_log.h"
+
+static void* writer_thread(void* p)
+{
+    position_log_writer_t* writer = (position_log_writer_t*)p;
+
+    pthread_mutex_lock(&writer->lock);
+    while (true) {
+        while (!writer->pending && !writer->closing) {
+            pthread_cond_wait(&writer->cond, &writer->lock);
+        }
+        if (!writer->pending) {
+            break;
+        }
+
+        /* The buffer not being filled is ours until pending is cleared */
+        const position_log_record_t* buffer = writer->buffers[!writer->current];
+        size_t len = writer->pending_len;
+        pthread_mutex_unlock(&writer->lock);
+
+        bool ok = fwrite(buffer, sizeof(position_log_record_t), len, writer->file) == len;
+
+        pthread_mutex_lock(&writer->lock);
+        writer->failed |= !ok;
+        writer->pending = false;
+        pthread_cond_broadcast(&writer->cond);
+    }
+    pthread_mutex_unlock(&writer->lock);
+
+    return NULL;
+}
+
+/* Hands the current buffer to the thread and starts filling the other one */
+static void writer_submit(position_log_writer_t* writer)
+{
+    pthread_mutex_lock(&writer->lock);
+    while (writer->pending) {
+        pthread_cond_wait(&writer->cond, &writer->lock);
+    }
+    writer->pending = true;
+    writer->pending_len = writer->fill;
+    writer->current = !writer->current;
+    writer->fill = 0;
+    pthread_cond_broadcast(&writer->cond);
+    pthread_mutex_unlock(&writer->lock);
+}
+
+bool position_log_writer_open(position_log_writer_t* writer, const char* path)
+{
+    writer->file = fopen(path, "wb");
+    if (writer->file == NULL) {
+        return false;
+    }
+
+    position_log_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, POSITION_LOG_MAGIC, sizeof(header.magic));
+    header.version = POSITION_LOG_VERSION;
+    header.record_size = sizeof(position_log_record_t);
+
+    if (fwrite(&header, sizeof(header), 1, writer->file) != 1) {
+        fclose(writer->file);
+        return false;
+    }
+
+    writer->current = 0;
+    writer->fill = 0;
+    writer->pending = false;
+    writer->pending_len = 0;
+    writer->closing = false;
+    writer->failed = false;
+
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->cond, NULL);
+    pthread_create(&writer->thread, NULL, writer_thread, writer);
+
+    return true;
+}
+
+void position_log_writer_append(position_log_writer_t* writer, const position_log_record_t* record)
+{
+    writer->buffers[writer->current][writer->fill] = *record;
+    writer->fill++;
+
+    if (writer->fill == POSITION_LOG_WRITER_BUFFER_LEN) {
+        writer_submit(writer);
+    }
+}
+
+bool position_log_writer_close(position_log_writer_t* writer)
+{
+    if (writer->fill > 0) {
+        writer_submit(writer);
+    }
+
+    pthread_mutex_lock(&writer->lock);
+    writer->closing = true;
+    pthread_cond_broadcast(&writer->cond);
+    pthread_mutex_unlock(&writer->lock);
+
+    pthread_join(writer->thread, NULL);
+    pthread_cond_destroy(&writer->cond);
+    pthread_mutex_destroy(&writer->lock);
+
+    bool ok = !writer->failed;
+    if (fclose(writer->file) != 0) {
+        ok = false;
+    }
+    return ok;
+}
@@ -0,0 +1,109 @@
+#include <CppUTest/TestHarness.h>
+#include <cstdio>
+#include <memory>
+#include <unistd.h>
+#include <position_log/position_log.h>
+
+static position_log_record_t make_record(int i)
+{
+    position_log_record_t record = {};
+    record.timestamp_us = 10000 * i;
+    record.x = 0.1f * i;
+    record.heading = -0.5f;
+    record.right_voltage = 12.f;
+    record.left_encoder = -i;
+    return record;
+}
+
+TEST_GROUP (PositionLogTestGroup) {
+    char path[64] = "/tmp/position_log_test_XXXXXX";
+
+    /* Too large for the stack */
+    std::unique_ptr<position_log_writer_t> writer{new position_log_writer_t};
+    position_log_t log;
+
+    void setup() override
+    {
+        close(mkstemp(path));
+    }
+
+    void teardown() override
+    {
+        unlink(path);
+    }
+
+    void write_records(int count)
+    {
+        CHECK_TRUE(position_log_writer_open(writer.get(), path));
+        for (int i = 0; i < count; i++) {
+            auto record = make_record(i);
+            position_log_writer_append(writer.get(), &record);
+        }
+        CHECK_TRUE(position_log_writer_close(writer.get()));
+    }
+};
+
+TEST(PositionLogTestGroup, EmptyLog)
+{
+    write_records(0);
+
+    CHECK_TRUE(position_log_map(&log, path));
+    CHECK_EQUAL(0, log.count);
+    position_log_unmap(&log);
+}
+
+TEST(PositionLogTestGroup, ReadsBackRecords)
+{
+    write_records(3);
+
+    CHECK_TRUE(position_log_map(&log, path));
+    CHECK_EQUAL(3, log.count);
+    CHECK_EQUAL(20000, log.records[2].timestamp_us);
+    DOUBLES_EQUAL(0.2, log.records[2].x, 1e-6);
+    DOUBLES_EQUAL(-0.5, log.records[2].heading, 1e-6);
+    DOUBLES_EQUAL(12., log.records[2].right_voltage, 1e-6);
+    CHECK_EQUAL(-2, log.records[2].left_encoder);
+    position_log_unmap(&log);
+}
+
+TEST(PositionLogTestGroup, RecordsSpanningSeveralBuffersAreInOrder)
+{
+    const int count = 3 * POSITION_LOG_WRITER_BUFFER_LEN + 17;
+    write_records(count);
+
+    CHECK_TRUE(position_log_map(&log, path));
+    CHECK_EQUAL(count, log.count);
+    for (int i = 0; i < count; i++) {
+        CHECK_EQUAL(-i, log.records[i].left_encoder);
+    }
+    position_log_unmap(&log);
+}
+
+TEST(PositionLogTestGroup, IgnoresTruncatedRecord)
+{
+    write_records(2);
+    CHECK_EQUAL(0, truncate(path, sizeof(position_log_header_t) + sizeof(position_log_record_t) + 5));
+
+    CHECK_TRUE(position_log_map(&log, path));
+    CHECK_EQUAL(1, log.count);
+    position_log_unmap(&log);
+}
+
+TEST(PositionLogTestGroup, RejectsOtherFiles)
+{
+    FILE* f = fopen(path, "w");
+    fputs("0.2,1.0,0.0,0.0\n0.2,1.0,0.0,0.0\n", f);
+    fclose(f);
+
+    CHECK_FALSE(position_log_map(&log, path));
+}
+
+TEST(PositionLogTestGroup, RejectsMissingFile)
+{
+    CHECK_FALSE(position_log_map(&log, "/nonexistent/position_log"));
+}
+
+TEST(PositionLogTestGroup, OpenFailsInMissingDirectory)
+{
+    CHECK_FALSE(position_log_writer_open(writer.get(), "/nonexistent/position_log"));
+}
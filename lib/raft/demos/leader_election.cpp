@@ -19,10 +19,22 @@ struct EmptyStateMachine {
 
     };
 
+    struct Snapshot {
+    };
+
     void apply(Operation op)
     {
         (void)op;
     }
+
+    Snapshot snapshot() const
+    {
+        return {};
+    }
+
+    void restore(const Snapshot&)
+    {
+    }
 };
 
 using Peer = UDPPeer<EmptyStateMachine>;
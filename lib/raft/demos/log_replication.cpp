@@ -11,10 +11,22 @@ using namespace std::literals::chrono_literals;
 
 struct EmptyStateMachine {
     using Operation = int;
+    struct Snapshot {
+    };
+
     void apply(Operation op)
     {
         std::cout << "commited " << op << std::endl;
     }
+
+    Snapshot snapshot() const
+    {
+        return {};
+    }
+
+    void restore(const Snapshot&)
+    {
+    }
 };
 
 using Peer = UDPPeer<EmptyStateMachine>;
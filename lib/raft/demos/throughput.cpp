@@ -0,0 +1,165 @@
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include <cstdio>
+#include <cstdlib>
+#include <error/error.h>
+#include "../raft.hpp"
+#include "udp_transport.hpp"
+#include <error_handlers.h>
+
+/* Measures how many operations per second a cluster running on localhost can
+ * commit. Every node runs in its own thread and talks to the others over UDP.
+ * The leader replicates operations as fast as its log accepts them. */
+
+using namespace std::chrono;
+
+struct CounterStateMachine {
+    using Operation = int;
+
+    struct Snapshot {
+        int count;
+        int sum;
+    };
+
+    int count = 0;
+    int sum = 0;
+
+    void apply(Operation op)
+    {
+        count++;
+        sum += op;
+    }
+
+    Snapshot snapshot() const
+    {
+        return {count, sum};
+    }
+
+    void restore(const Snapshot& snapshot)
+    {
+        count = snapshot.count;
+        sum = snapshot.sum;
+    }
+};
+
+using Peer = UDPPeer<CounterStateMachine>;
+using Message = raft::Message<CounterStateMachine>;
+
+struct NodeStats {
+    std::atomic<int> committed{0};
+    std::atomic<bool> leader{false};
+};
+
+static std::atomic<bool> running{true};
+static std::atomic<bool> measuring{false};
+
+static void run_node(int my_port, const std::vector<int>& ports, NodeStats& stats)
+{
+    std::vector<std::unique_ptr<Peer>> peers;
+    std::vector<raft::Peer<CounterStateMachine>*> peers_ptrs;
+    for (auto port : ports) {
+        if (port != my_port) {
+            peers.emplace_back(new Peer(port));
+            peers_ptrs.push_back(peers.back().get());
+        }
+    }
+
+    auto my_socket = make_receive_socket(my_port);
+    CounterStateMachine fsm;
+    raft::State<CounterStateMachine> state(fsm, my_port, peers_ptrs.data(), peers_ptrs.size());
+
+    // Ticks at 1 kHz, and processes messages in between
+    const auto tick_period = milliseconds(1);
+    auto next_tick = steady_clock::now();
+    auto next_operation = 1;
+
+    while (running) {
+        Message msg;
+        if (read_from_socket(my_socket, msg)) {
+            Message reply;
+            if (state.process(msg, reply)) {
+                for (auto p : peers_ptrs) {
+                    if (p->id == msg.from_id) {
+                        p->send(reply);
+                    }
+                }
+            }
+        }
+
+        if (steady_clock::now() < next_tick) {
+            continue;
+        }
+        next_tick += tick_period;
+
+        if (state.node_state == raft::NodeState::Leader && measuring) {
+            while (state.replicate(next_operation)) {
+                next_operation++;
+            }
+        }
+
+        state.tick();
+
+        stats.leader = state.node_state == raft::NodeState::Leader;
+        stats.committed = fsm.count;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    register_error_handlers();
+
+    if (argc < 3) {
+        ERROR("Usage: %s duration_seconds port1 [...] portN", argv[0]);
+        exit(1);
+    }
+
+    const auto duration = seconds(atoi(argv[1]));
+    std::vector<int> ports;
+    for (auto i = 2; i < argc; i++) {
+        ports.push_back(atoi(argv[i]));
+    }
+
+    std::vector<NodeStats> stats(ports.size());
+    std::vector<std::thread> threads;
+    for (auto i = 0u; i < ports.size(); i++) {
+        threads.emplace_back(run_node, ports[i], std::cref(ports), std::ref(stats[i]));
+    }
+
+    // Wait for the election to complete
+    auto leader = -1;
+    while (leader < 0) {
+        std::this_thread::sleep_for(milliseconds(10));
+        for (auto i = 0u; i < stats.size(); i++) {
+            if (stats[i].leader) {
+                leader = i;
+            }
+        }
+    }
+    NOTICE("%d is leader", ports[leader]);
+
+    auto start_count = stats[leader].committed.load();
+    auto start = steady_clock::now();
+    measuring = true;
+    std::this_thread::sleep_for(duration);
+    auto end_count = stats[leader].committed.load();
+    auto elapsed = duration_cast<microseconds>(steady_clock::now() - start).count();
+
+    running = false;
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    auto committed = end_count - start_count;
+    printf("committed %d operations in %.3f s: %.0f op/s\n",
+           committed, elapsed * 1e-6, committed * 1e6 / elapsed);
+
+    for (auto i = 0u; i < ports.size(); i++) {
+        printf("node %d: %d operations applied%s\n", ports[i], stats[i].committed.load(),
+               static_cast<int>(i) == leader ? " (leader)" : "");
+    }
+
+    return 0;
+}
@@ -35,7 +35,7 @@ template <typename StateMachine>
 bool read_from_socket(int socket, raft::Message<StateMachine>& msg)
 {
     struct sockaddr_in si_other;
-    socklen_t slen;
+    socklen_t slen = sizeof(si_other);
 
     auto recv_len = recvfrom(socket, &msg, sizeof(msg), 0,
                              (struct sockaddr*)&si_other, &slen);
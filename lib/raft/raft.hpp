@@ -2,6 +2,7 @@
 
 #include <error/error.h>
 #include <cstdlib>
+#include <cstring>
 #include <algorithm>
 
 namespace raft {
@@ -10,8 +11,15 @@ const auto HEARTBEAT_PERIOD = 10;
 const auto ELECTION_TIMEOUT_MAX = 500;
 const auto ELECTION_TIMEOUT_MIN = 100;
 
-// TODO: How many entries ?
-const auto LOG_SIZE = 10u;
+// Number of entries kept in the log of each node. Committed entries are
+// discarded when the log is full, the state machine acting as a snapshot.
+const auto LOG_SIZE = 64u;
+
+// Maximum number of entries sent in a single AppendEntries message
+const auto MAX_ENTRIES_PER_MESSAGE = 16u;
+
+// Maximum number of entries sent to a peer but not acknowledged yet
+const auto MAX_IN_FLIGHT_ENTRIES = 3 * MAX_ENTRIES_PER_MESSAGE;
 
 using NodeId = int;
 using Term = int;
@@ -30,26 +38,35 @@ struct LogEntry {
     Index index;
 };
 
+/** Replicated log, stored as a ring buffer.
+ *
+ * Entries must have consecutive indices, which allows finding an entry from
+ * its index in constant time. The entries preceding the first one were
+ * compacted, only the index and term of the last compacted entry are kept.
+ */
 template <typename Operation, int N>
 class Log {
     int m_size;
+    int m_start;
+    Index m_snapshot_index;
+    Term m_snapshot_term;
     LogEntry<Operation> entries[N];
 
-    void remove_conflicting_entries(const LogEntry<Operation>* new_entries, int entry_count)
+    const LogEntry<Operation>& at(int i) const
     {
-        for (auto i = 0; i < size(); i++) {
-            for (auto j = 0; j < entry_count; j++) {
-                if (new_entries[j].index == entries[i].index && entries[i].term < new_entries[j].term) {
-                    keep_until(i);
-                    return;
-                }
-            }
+        auto pos = m_start + i;
+        if (pos >= N) {
+            pos -= N;
         }
+        return entries[pos];
     }
 
 public:
     Log()
         : m_size(0)
+        , m_start(0)
+        , m_snapshot_index(0)
+        , m_snapshot_term(0)
     {
     }
 
@@ -58,11 +75,16 @@ public:
         return m_size;
     }
 
+    bool full() const
+    {
+        return m_size == N;
+    }
+
     void append(LogEntry<Operation> entry)
     {
         if (m_size < N) {
-            entries[m_size] = entry;
             m_size++;
+            (*this)[m_size - 1] = entry;
         } else {
             // This should not happen if log compaction is ran often enough
             // Note: This error does not threaten the consistency of the log,
@@ -73,46 +95,112 @@ public:
 
     LogEntry<Operation>& operator[](int i)
     {
-        return entries[i];
+        return const_cast<LogEntry<Operation>&>(at(i));
     }
 
     Index last_index() const
     {
         if (m_size > 0) {
-            return entries[m_size - 1].index;
+            return at(m_size - 1).index;
         }
 
-        return 0;
+        return m_snapshot_index;
     }
 
     Term last_term() const
     {
         if (m_size > 0) {
-            return entries[m_size - 1].term;
+            return at(m_size - 1).term;
+        }
+
+        return m_snapshot_term;
+    }
+
+    /** Index and term of the last compacted entry, or zero if none. */
+    Index snapshot_index() const
+    {
+        return m_snapshot_index;
+    }
+
+    Term snapshot_term() const
+    {
+        return m_snapshot_term;
+    }
+
+    /** Returns the position of the entry with the given index, or -1 if it
+     * is not in the log. */
+    int position(Index index) const
+    {
+        if (m_size == 0) {
+            return -1;
         }
 
-        return 0;
+        auto pos = index - at(0).index;
+        if (pos < 0 || pos >= m_size) {
+            return -1;
+        }
+        return pos;
     }
 
     LogEntry<Operation>* find_entry(Term term, Index index)
     {
-        for (auto i = 0; i < size(); i++) {
-            if (entries[i].index == index && entries[i].term == term) {
-                return &entries[i];
-            }
+        auto pos = position(index);
+        if (pos < 0 || (*this)[pos].term != term) {
+            return nullptr;
         }
 
-        return nullptr;
+        return &(*this)[pos];
     }
 
-    void merge(const LogEntry<Operation>* entries, int entry_count)
+    /** Returns true if the log contains the entry, or compacted it. */
+    bool matches(Index index, Term term) const
+    {
+        if (index == m_snapshot_index && term == m_snapshot_term) {
+            return true;
+        }
+
+        auto pos = position(index);
+        return pos >= 0 && at(pos).term == term;
+    }
+
+    /** Returns the term of the entry with the given index, or -1 if it is
+     * neither in the log nor the last compacted entry. */
+    Term term_at(Index index) const
     {
-        remove_conflicting_entries(entries, entry_count);
+        if (index == m_snapshot_index) {
+            return m_snapshot_term;
+        }
+
+        auto pos = position(index);
+        return pos >= 0 ? at(pos).term : -1;
+    }
 
+    void merge(const LogEntry<Operation>* entries, int entry_count)
+    {
         for (auto i = 0; i < entry_count; i++) {
-            if (entries[i].index > last_index()) {
-                append(entries[i]);
+            const auto& entry = entries[i];
+
+            // Entries which conflict with a new one (same index, different
+            // term) are removed, along with all the ones following them
+            auto pos = position(entry.index);
+            if (pos >= 0) {
+                if ((*this)[pos].term == entry.term) {
+                    continue;
+                }
+                keep_until(pos);
+            }
+
+            // Compacted entries were committed, so they cannot conflict
+            if (entry.index <= m_snapshot_index) {
+                continue;
+            }
+
+            // Do not leave holes in the log
+            if ((m_size > 0 || m_snapshot_index > 0) && entry.index != last_index() + 1) {
+                break;
             }
+
+            append(entry);
         }
     }
 
@@ -121,8 +209,37 @@ public:
     {
         m_size = n;
     }
+
+    /** Discards all entries up to the given index (included). */
+    void compact(Index index)
+    {
+        auto pos = position(index);
+        if (pos < 0) {
+            return;
+        }
+
+        m_snapshot_index = index;
+        m_snapshot_term = at(pos).term;
+        m_start = (m_start + pos + 1) % N;
+        m_size -= pos + 1;
+    }
+
+    /** Discards the whole log, which now starts after the given entry. */
+    void reset(Index index, Term term)
+    {
+        m_size = 0;
+        m_start = 0;
+        m_snapshot_index = index;
+        m_snapshot_term = term;
+    }
 };
 
+/** Messages exchanged by the nodes.
+ *
+ * The state machine must provide an Operation type, and a Snapshot type
+ * holding its whole state, which is sent to the peers lagging behind the
+ * compacted part of the log. Both must be trivially copyable.
+ */
 template <typename StateMachine>
 struct Message {
     enum class Type {
@@ -130,6 +247,7 @@ struct Message {
         VoteReply,
         AppendEntriesRequest,
         AppendEntriesReply,
+        InstallSnapshotRequest,
     };
 
     Type type;
@@ -151,13 +269,20 @@ struct Message {
             Index leader_commit;
             Term previous_entry_term;
             Index previous_entry_index;
-            LogEntry<typename StateMachine::Operation> entries[LOG_SIZE];
+            LogEntry<typename StateMachine::Operation> entries[MAX_ENTRIES_PER_MESSAGE];
         } append_entries_request;
 
         struct {
             bool success;
             Index last_index;
         } append_entries_reply;
+
+        // Answered with an AppendEntriesReply
+        struct {
+            Index last_included_index;
+            Term last_included_term;
+            typename StateMachine::Snapshot snapshot;
+        } install_snapshot_request;
     };
 
     Message()
@@ -183,8 +308,16 @@ public:
     // versions of the log to each peer
     Index match_index;
     Index next_index;
+
+    // True if the peer replied to a request since the last heartbeat
+    bool replied;
 };
 
+/** Raft node.
+ *
+ * The state machine must provide apply(Operation), as well as snapshot() and
+ * restore(Snapshot) to save and load its whole state (see Message).
+ */
 template <typename StateMachine>
 class State {
 public:
@@ -219,6 +352,8 @@ public:
     {
         for (auto i = 0; i < peer_count; i++) {
             peers[i]->match_index = 0;
+            peers[i]->next_index = 0;
+            peers[i]->replied = false;
         }
     }
 
@@ -284,6 +419,10 @@ public:
 
                 reply.type = Message::Type::AppendEntriesReply;
 
+                // The last index is a hint for the leader, in case the
+                // request is rejected because it does not match our log
+                reply.append_entries_reply.last_index = log.last_index();
+
                 // If the request comes from an older term, discard itj
                 if (msg.term < term) {
                     // TODO: add my own term
@@ -296,15 +435,22 @@ public:
                 auto prev_index = msg.append_entries_request.previous_entry_index;
                 auto prev_term = msg.append_entries_request.previous_entry_term;
                 if (prev_index > 0 && prev_term > 0) {
-                    if (!log.find_entry(prev_term, prev_index)) {
+                    if (!log.matches(prev_index, prev_term)) {
                         reply.append_entries_reply.success = false;
                         return true;
                     }
                 }
 
-                // Append the new entries to the log
-                log.merge(msg.append_entries_request.entries,
-                          msg.append_entries_request.count);
+                // Make room for the new entries if needed
+                auto count = msg.append_entries_request.count;
+                if (log.size() + count > static_cast<int>(LOG_SIZE)) {
+                    compact_log();
+                }
+
+                // Append the new entries to the log. Entries conflicting with
+                // the new ones (same index, but not the same term) are
+                // replaced.
+                log.merge(msg.append_entries_request.entries, count);
 
                 // Update the commit value
                 auto leader_commit = msg.append_entries_request.leader_commit;
@@ -314,37 +460,74 @@ public:
                     commit_index = new_index;
                 }
 
-                // Checks for conflicting entries, meaning entries that have
-                // the same index as one in the log, but not with the same
-                // term, then solves this conflict.
-
+                // Only the entries up to the last new one are known to match
+                // the leader's log
                 reply.append_entries_reply.success = true;
-                reply.append_entries_reply.last_index = log.last_index();
+                reply.append_entries_reply.last_index = std::min(prev_index + count, log.last_index());
 
                 return true;
             }
 
             case Message::Type::AppendEntriesReply: {
+                auto peer = find_peer(msg.from_id);
+                if (peer == nullptr) {
+                    break;
+                }
+
+                auto last_index = msg.append_entries_reply.last_index;
+                peer->replied = true;
+
                 if (msg.append_entries_reply.success) {
-                    auto last_index = msg.append_entries_reply.last_index;
-                    for (auto i = 0; i < peer_count; i++) {
-                        if (peers[i]->id == msg.from_id) {
-                            peers[i]->match_index = last_index;
-                            peers[i]->next_index = last_index + 1;
-                        }
-                    }
+                    // Replies can arrive out of order when several requests
+                    // are in flight, so indices never go back here.
+                    peer->match_index = std::max(peer->match_index, last_index);
+                    peer->next_index = std::max(peer->next_index, last_index + 1);
+
                     auto new_index = find_safe_index();
                     commit_log_entries(commit_index, new_index);
                     commit_index = new_index;
                 } else {
-                    for (auto i = 0; i < peer_count; i++) {
-                        if (peers[i]->id == msg.from_id) {
-                            peers[i]->next_index--;
-                        }
-                    }
+                    // Go back at most to the end of the peer's log instead of
+                    // probing entries one by one
+                    peer->next_index = std::min(peer->next_index - 1, last_index + 1);
+                    peer->next_index = std::max(peer->next_index, 1);
                 }
                 break;
             }
+
+            case Message::Type::InstallSnapshotRequest: {
+                reset_election_timer();
+
+                if (msg.term > term) {
+                    node_state = NodeState::Follower;
+                    term = msg.term;
+                }
+
+                reply.type = Message::Type::AppendEntriesReply;
+
+                if (msg.term < term) {
+                    reply.append_entries_reply.success = false;
+                    reply.append_entries_reply.last_index = log.last_index();
+                    return true;
+                }
+
+                const auto& req = msg.install_snapshot_request;
+                if (req.last_included_index > commit_index) {
+                    // Keep the entries following the snapshot if our log
+                    // agrees with it, otherwise start over from the snapshot
+                    if (log.matches(req.last_included_index, req.last_included_term)) {
+                        log.compact(req.last_included_index);
+                    } else {
+                        log.reset(req.last_included_index, req.last_included_term);
+                    }
+                    state_machine.restore(req.snapshot);
+                    commit_index = req.last_included_index;
+                }
+
+                reply.append_entries_reply.success = true;
+                reply.append_entries_reply.last_index = commit_index;
+                return true;
+            }
         }
 
         return false;
@@ -375,6 +558,13 @@ public:
         }
     }
 
+    /** Advances the timers.
+     *
+     * The leader sends the entries replicated since the previous tick, in as
+     * few messages as possible, to the peers which do not have too many
+     * unacknowledged entries already. Every HEARTBEAT_PERIOD ticks, it sends
+     * a message to every peer, even empty.
+     */
     void tick()
     {
         if (node_state == NodeState::Leader) {
@@ -384,14 +574,27 @@ public:
         }
     }
 
-    void replicate(typename StateMachine::Operation operation)
+    /** Appends an operation to the log.
+     *
+     * @returns false if the log is full of entries which cannot be compacted
+     * because they are not committed yet.
+     */
+    bool replicate(typename StateMachine::Operation operation)
     {
         // TODO: If we are not a leader we should forward this to the leader
+        if (log.full()) {
+            compact_log();
+            if (log.full()) {
+                return false;
+            }
+        }
+
         LogEntry<typename StateMachine::Operation> entry;
         entry.operation = operation;
         entry.term = term;
         entry.index = log.last_index() + 1;
         log.append(entry);
+        return true;
     }
 
     void become_leader()
@@ -400,46 +603,114 @@ public:
         for (auto i = 0; i < peer_count; i++) {
             peers[i]->next_index = log.last_index();
             peers[i]->match_index = 0;
+            peers[i]->replied = true;
         }
     }
 
 private:
+    Peer* find_peer(NodeId peer_id)
+    {
+        for (auto i = 0; i < peer_count; i++) {
+            if (peers[i]->id == peer_id) {
+                return peers[i];
+            }
+        }
+        return nullptr;
+    }
+
     void tick_heartbeat()
     {
-        if (heartbeat_timer > 0) {
-            heartbeat_timer--;
-        } else {
+        auto heartbeat = heartbeat_timer == 0;
+        if (heartbeat) {
             DEBUG("Sending heartbeat");
-            for (auto i = 0; i < peer_count; i++) {
-                Message msg;
-                msg.type = Message::Type::AppendEntriesRequest;
-                msg.from_id = id;
-                msg.term = term;
-                msg.append_entries_request.count = 0;
-                msg.append_entries_request.leader_commit = commit_index;
-
-                auto peer = peers[i];
-                auto next_index = peer->next_index;
-
-                // Copy all the log with a greater index than the last one for
-                // this peer
-                for (auto j = 0; j < log.size(); j++) {
-                    if (log[j].index >= next_index) {
-                        for (auto k = 0; k + j < log.size(); k++) {
-                            msg.append_entries_request.entries[k] = log[k + j];
-                            msg.append_entries_request.count++;
-                        }
-                        break;
-                    }
-                    msg.append_entries_request.previous_entry_term = log[j].term;
-                    msg.append_entries_request.previous_entry_index = log[j].index;
+            // Rearm timer
+            heartbeat_timer = HEARTBEAT_PERIOD - 1;
+        } else {
+            heartbeat_timer--;
+        }
+
+        for (auto i = 0; i < peer_count; i++) {
+            auto peer = peers[i];
+
+            if (heartbeat) {
+                // If the peer did not reply during a whole period, the
+                // requests or their replies were probably lost: send the
+                // unacknowledged entries again.
+                if (!peer->replied) {
+                    peer->next_index = std::min(peer->next_index, peer->match_index + 1);
                 }
+                peer->replied = false;
+            }
+
+            send_entries(peer, heartbeat);
+        }
+    }
 
-                peer->send(msg);
+    /** Sends the entries starting at the peer's next_index, if any and if the
+     * flow control allows it, or always if force is true. */
+    void send_entries(Peer* peer, bool force)
+    {
+        // The entries the peer needs were compacted
+        if (log.snapshot_index() > 0 && peer->next_index <= log.snapshot_index()) {
+            if (force) {
+                send_snapshot(peer);
             }
+            return;
+        }
 
-            // Rearm timer
-            heartbeat_timer = HEARTBEAT_PERIOD - 1;
+        auto first = std::max(peer->next_index, log.snapshot_index() + 1);
+        first = std::min(first, log.last_index() + 1);
+        auto in_flight = std::max(first - 1 - peer->match_index, 0);
+        auto count = log.last_index() - first + 1;
+        count = std::min(count, static_cast<int>(MAX_ENTRIES_PER_MESSAGE));
+        count = std::min(count, static_cast<int>(MAX_IN_FLIGHT_ENTRIES) - in_flight);
+        count = std::max(count, 0);
+
+        if (count == 0 && !force) {
+            return;
+        }
+
+        Message msg;
+        msg.type = Message::Type::AppendEntriesRequest;
+        msg.from_id = id;
+        msg.term = term;
+        msg.append_entries_request.count = count;
+        msg.append_entries_request.leader_commit = commit_index;
+        msg.append_entries_request.previous_entry_index = first - 1;
+        msg.append_entries_request.previous_entry_term = std::max(log.term_at(first - 1), 0);
+
+        auto pos = log.position(first);
+        for (auto i = 0; i < count; i++) {
+            msg.append_entries_request.entries[i] = log[pos + i];
+        }
+
+        peer->send(msg);
+
+        // Send the following entries without waiting for the reply
+        peer->next_index = first + count;
+    }
+
+    void send_snapshot(Peer* peer)
+    {
+        // The state machine has applied every committed entry, so its state
+        // is the snapshot of the log up to the commit index
+        Message msg;
+        msg.type = Message::Type::InstallSnapshotRequest;
+        msg.from_id = id;
+        msg.term = term;
+        msg.install_snapshot_request.last_included_index = commit_index;
+        msg.install_snapshot_request.last_included_term = log.term_at(commit_index);
+        msg.install_snapshot_request.snapshot = state_machine.snapshot();
+
+        peer->send(msg);
+    }
+
+    /** Discards the committed entries from the log. */
+    void compact_log()
+    {
+        if (commit_index > log.snapshot_index()) {
+            DEBUG("Compacting log up to %d", commit_index);
+            log.compact(commit_index);
         }
     }
 
@@ -463,35 +734,39 @@ private:
 
     Index find_safe_index()
     {
-        // Finds an index N such that a majority of match_index >= N and log[N]
-        // == currentTerm
+        // Finds the greatest index N such that a majority of match_index >= N
+        // and log[N] == currentTerm
         // See sections 5.3 and 5.4 of the raft paper for why those properties
         // are important
 
-        // Step 1 sort the peers according to their match index.
-        // This allows us to take N as the median value of the match index,
-        // ensuring that a majority of nodes have a match_index of at least N
-        std::qsort(peers, peer_count, sizeof(peers[0]), [](const void* a, const void* b) {
-            Peer* pa = (Peer*)a;
-            Peer* pb = (Peer*)b;
-            if (pa->match_index < pb->match_index) {
-                return 1;
-            } else if (pa->match_index > pb->match_index) {
-                return -1;
+        // Step 1: find the greatest N replicated on a majority of the nodes,
+        // counting ourselves. There are only a few peers, so trying every
+        // match index is cheaper than sorting them.
+        auto N = commit_index;
+        for (auto i = 0; i < peer_count; i++) {
+            auto candidate = peers[i]->match_index;
+            if (candidate <= N) {
+                continue;
+            }
+
+            auto replicas = 1;
+            for (auto j = 0; j < peer_count; j++) {
+                if (peers[j]->match_index >= candidate) {
+                    replicas++;
+                }
             }
-            return 0;
-        });
 
-        const auto median_peer = std::max(peer_count / 2 - 1, 0);
-        auto N = peers[median_peer]->match_index;
+            if (2 * replicas > peer_count + 1) {
+                N = candidate;
+            }
+        }
 
         // Then check that the entry with index N is from the current term.
         // This is important to ensure consistency when the leader changed
-        // recently
-        for (auto i = 0; i < log.size(); i++) {
-            if (log[i].index == N && log[i].term == term) {
-                return N;
-            }
+        // recently. Terms never decrease along the log, so if it is not the
+        // case, no smaller N can be committed either.
+        if (N > commit_index && log.term_at(N) == term) {
+            return N;
         }
 
         // If we are not able to find a safe N to commit, then return the
@@ -501,15 +776,18 @@ private:
 
     void commit_log_entries(Index old_index, Index new_index)
     {
-        auto i = 0;
+        if (new_index <= old_index) {
+            return;
+        }
 
-        // First find all non commited entries
-        auto commit_index = old_index;
-        for (; i < log.size() && log[i].index <= commit_index; i++) {
+        // Entries are applied as soon as they are committed, so the first
+        // entry to apply is right after the old commit index
+        auto i = log.position(old_index + 1);
+        if (i < 0) {
+            return;
         }
 
-        // Then commit all new entries
-        for (; commit_index < new_index; commit_index++, i++) {
+        for (auto index = old_index; index < new_index; index++, i++) {
             state_machine.apply(log[i].operation);
         }
     }
@@ -39,6 +39,12 @@ bool RaftMessageComparator::isEqual(const void* object1, const void* object2)
                                 &m2->append_entries_reply,
                                 sizeof(m1->append_entries_reply));
             break;
+
+        case MessageType::InstallSnapshotRequest:
+            return !std::memcmp(&m1->install_snapshot_request,
+                                &m2->install_snapshot_request,
+                                sizeof(m1->install_snapshot_request));
+            break;
     }
 
     return true;
@@ -87,6 +93,15 @@ SimpleString RaftMessageComparator::valueToString(const void* object)
                          msg->term,
                          msg->append_entries_reply.success);
             break;
+
+        case MessageType::InstallSnapshotRequest:
+            std::sprintf(buffer,
+                         "InstallSnapshotRequest(from=%d, term=%d, lastIndex=%d, lastTerm=%d)",
+                         msg->from_id,
+                         msg->term,
+                         msg->install_snapshot_request.last_included_index,
+                         msg->install_snapshot_request.last_included_term);
+            break;
     }
     return buffer;
 }
@@ -167,6 +182,9 @@ SimpleString StringFrom(TestMessage::Type type)
 
         case Type::AppendEntriesReply:
             return "AppendEntriesReply";
+
+        case Type::InstallSnapshotRequest:
+            return "InstallSnapshotRequest";
     }
 
     return "<unknown>";
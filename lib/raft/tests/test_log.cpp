@@ -128,7 +128,7 @@ TEST(LogOperations, MergeWhenSomeOfTheNewEntriesAreAlreadyInTheLog)
 TEST(LogOperations, MergeConflictingEntries)
 {
     // Conflicting entries are defined as entries with the same index.
-    // In that case, the entry with the higher term is kept
+    // In that case, the new entry (coming from the leader) is kept
     log.append(make_entry(TestStateMachine::Operation::BAR, 1, 1));
     LogEntry new_entries[1];
     new_entries[0] = make_entry(TestStateMachine::Operation::FOO, 2, 1);
@@ -147,3 +147,119 @@ TEST(LogOperations, EraseAfterEntry)
     log.keep_until(2);
     CHECK_EQUAL(2, log.size());
 }
+
+TEST(LogOperations, MergeRemovesEntriesFollowingAConflict)
+{
+    for (auto i = 1; i <= 4; i++) {
+        log.append(make_entry(TestStateMachine::Operation::BAR, 1, i));
+    }
+
+    LogEntry new_entries[1];
+    new_entries[0] = make_entry(TestStateMachine::Operation::FOO, 2, 2);
+    log.merge(new_entries, 1);
+
+    CHECK_EQUAL(2, log.size());
+    CHECK_EQUAL(2, log.last_index());
+    CHECK_EQUAL(2, log.last_term());
+}
+
+TEST(LogOperations, MergeDoesNotLeaveHoles)
+{
+    log.append(make_entry(TestStateMachine::Operation::BAR, 1, 1));
+    LogEntry new_entries[1];
+    new_entries[0] = make_entry(TestStateMachine::Operation::FOO, 1, 3);
+
+    log.merge(new_entries, 1);
+
+    CHECK_EQUAL(1, log.size());
+}
+
+TEST(LogOperations, CompactDiscardsEntries)
+{
+    for (auto i = 1; i <= 4; i++) {
+        log.append(make_entry(TestStateMachine::Operation::BAR, i, i));
+    }
+
+    log.compact(3);
+
+    CHECK_EQUAL(1, log.size());
+    CHECK_EQUAL(4, log[0].index);
+    CHECK_EQUAL(3, log.snapshot_index());
+    CHECK_EQUAL(3, log.snapshot_term());
+    POINTERS_EQUAL(nullptr, log.find_entry(2, 2));
+}
+
+TEST(LogOperations, LastIndexOfACompactedLogIsTheSnapshotOne)
+{
+    for (auto i = 1; i <= 4; i++) {
+        log.append(make_entry(TestStateMachine::Operation::BAR, 2, i));
+    }
+
+    log.compact(4);
+
+    CHECK_EQUAL(0, log.size());
+    CHECK_EQUAL(4, log.last_index());
+    CHECK_EQUAL(2, log.last_term());
+}
+
+TEST(LogOperations, CompactedEntryStillMatches)
+{
+    for (auto i = 1; i <= 4; i++) {
+        log.append(make_entry(TestStateMachine::Operation::BAR, 1, i));
+    }
+    log.compact(2);
+
+    CHECK_TRUE(log.matches(2, 1));
+    CHECK_TRUE(log.matches(3, 1));
+    CHECK_FALSE(log.matches(1, 1));
+    CHECK_FALSE(log.matches(3, 2));
+    CHECK_EQUAL(1, log.term_at(2));
+    CHECK_EQUAL(-1, log.term_at(1));
+}
+
+TEST(LogOperations, LogWrapsAroundAfterCompaction)
+{
+    raft::Index index = 1;
+    for (auto round = 0; round < 5; round++) {
+        while (log.size() < 10) {
+            log.append(make_entry(TestStateMachine::Operation::BAR, round, index));
+            index++;
+        }
+        log.compact(index - 4);
+    }
+
+    CHECK_EQUAL(3, log.size());
+    for (auto i = 0; i < log.size(); i++) {
+        CHECK_EQUAL(index - 3 + i, log[i].index);
+        CHECK_EQUAL(&log[i], log.find_entry(4, index - 3 + i));
+    }
+}
+
+TEST(LogOperations, MergeAfterCompaction)
+{
+    for (auto i = 1; i <= 10; i++) {
+        log.append(make_entry(TestStateMachine::Operation::BAR, 1, i));
+    }
+    log.compact(8);
+
+    LogEntry new_entries[4];
+    for (auto i = 0; i < 4; i++) {
+        new_entries[i] = make_entry(TestStateMachine::Operation::FOO, 1, 8 + i);
+    }
+    log.merge(new_entries, 4);
+
+    CHECK_EQUAL(11, log.last_index());
+    CHECK_EQUAL(3, log.size());
+    CHECK_TRUE(log[2].operation == TestStateMachine::Operation::FOO);
+}
+
+TEST(LogOperations, ResetDiscardsEverything)
+{
+    log.append(make_entry(TestStateMachine::Operation::BAR, 1, 1));
+
+    log.reset(12, 3);
+
+    CHECK_EQUAL(0, log.size());
+    CHECK_EQUAL(12, log.last_index());
+    CHECK_EQUAL(3, log.last_term());
+}
@@ -0,0 +1,333 @@
+#include <CppUTest/TestHarness.h>
+#include <vector>
+
+#include "test_state_machine.hpp"
+
+class RecordingPeer : public TestPeer {
+public:
+    std::vector<TestMessage> sent;
+
+    RecordingPeer(raft::NodeId id)
+        : TestPeer(id)
+    {
+    }
+
+    virtual void send(const TestMessage& msg)
+    {
+        sent.push_back(msg);
+    }
+};
+
+TEST_GROUP (LogCompactionTestGroup) {
+    RecordingPeer peer{1}, other_peer{2};
+    TestPeer* peers[2] = {&peer, &other_peer};
+    TestStateMachine fsm;
+    TestRaftState leader{fsm, 42, peers, 2};
+
+    void setup()
+    {
+        leader.term = 1;
+        leader.become_leader();
+    }
+
+    void acknowledge(RecordingPeer& p, raft::Index last_index, bool success = true)
+    {
+        TestMessage msg, reply;
+        msg.type = TestMessage::Type::AppendEntriesReply;
+        msg.from_id = p.id;
+        msg.term = leader.term;
+        msg.append_entries_reply.success = success;
+        msg.append_entries_reply.last_index = last_index;
+        leader.process(msg, reply);
+    }
+
+    void replicate_and_commit(int count)
+    {
+        for (auto i = 0; i < count; i++) {
+            CHECK_TRUE(leader.replicate(TestStateMachine::Operation::FOO));
+        }
+        acknowledge(peer, leader.log.last_index());
+        acknowledge(other_peer, leader.log.last_index());
+    }
+
+    void tick_until_heartbeat()
+    {
+        while (leader.heartbeat_timer > 0) {
+            leader.tick();
+        }
+        leader.tick();
+    }
+};
+
+TEST(LogCompactionTestGroup, NewEntriesAreBatchedInASingleMessage)
+{
+    for (auto i = 0; i < 5; i++) {
+        leader.replicate(TestStateMachine::Operation::FOO);
+    }
+
+    leader.tick();
+
+    CHECK_EQUAL(1, peer.sent.size());
+    auto& req = peer.sent[0].append_entries_request;
+    CHECK_EQUAL(5, req.count);
+    CHECK_EQUAL(0, req.previous_entry_index);
+    CHECK_EQUAL(5, req.entries[4].index);
+}
+
+TEST(LogCompactionTestGroup, EntriesAreSentWithoutWaitingForTheHeartbeat)
+{
+    leader.tick();
+    peer.sent.clear();
+
+    leader.replicate(TestStateMachine::Operation::FOO);
+    leader.tick();
+
+    CHECK_EQUAL(1, peer.sent.size());
+    CHECK_EQUAL(1, peer.sent[0].append_entries_request.count);
+}
+
+TEST(LogCompactionTestGroup, FollowingEntriesAreSentBeforeTheReply)
+{
+    leader.replicate(TestStateMachine::Operation::FOO);
+    leader.tick();
+    leader.replicate(TestStateMachine::Operation::BAR);
+    leader.tick();
+
+    CHECK_EQUAL(2, peer.sent.size());
+    auto& req = peer.sent[1].append_entries_request;
+    CHECK_EQUAL(1, req.count);
+    CHECK_EQUAL(1, req.previous_entry_index);
+    CHECK_EQUAL(1, req.previous_entry_term);
+    CHECK_EQUAL(2, req.entries[0].index);
+}
+
+TEST(LogCompactionTestGroup, MessagesAreLimitedInSize)
+{
+    for (auto i = 0u; i < raft::MAX_ENTRIES_PER_MESSAGE + 1; i++) {
+        leader.replicate(TestStateMachine::Operation::FOO);
+    }
+
+    leader.tick();
+    leader.tick();
+
+    CHECK_EQUAL(2, peer.sent.size());
+    CHECK_EQUAL(raft::MAX_ENTRIES_PER_MESSAGE, peer.sent[0].append_entries_request.count);
+    CHECK_EQUAL(1, peer.sent[1].append_entries_request.count);
+}
+
+TEST(LogCompactionTestGroup, UnacknowledgedEntriesAreLimited)
+{
+    for (auto i = 0u; i < raft::LOG_SIZE; i++) {
+        leader.replicate(TestStateMachine::Operation::FOO);
+    }
+
+    for (auto i = 1; i < raft::HEARTBEAT_PERIOD; i++) {
+        leader.tick();
+    }
+
+    auto sent = 0u;
+    for (auto& msg : peer.sent) {
+        sent += msg.append_entries_request.count;
+    }
+    CHECK_EQUAL(raft::MAX_IN_FLIGHT_ENTRIES, sent);
+
+    // Once entries are acknowledged, the following ones are sent
+    acknowledge(peer, raft::MAX_ENTRIES_PER_MESSAGE);
+    peer.sent.clear();
+    leader.tick();
+    CHECK_EQUAL(1, peer.sent.size());
+    CHECK_EQUAL(raft::MAX_IN_FLIGHT_ENTRIES + 1, peer.sent[0].append_entries_request.entries[0].index);
+}
+
+TEST(LogCompactionTestGroup, EntriesAreSentAgainIfThePeerDoesNotReply)
+{
+    leader.tick(); // heartbeat
+    leader.replicate(TestStateMachine::Operation::FOO);
+    leader.tick();
+    acknowledge(other_peer, 1);
+
+    peer.sent.clear();
+    tick_until_heartbeat();
+
+    // The peer did not reply since the previous heartbeat
+    CHECK_EQUAL(1, peer.sent.size());
+    CHECK_EQUAL(1, peer.sent[0].append_entries_request.count);
+    CHECK_EQUAL(1, peer.sent[0].append_entries_request.entries[0].index);
+
+    // The other one did, so it only gets a heartbeat
+    CHECK_EQUAL(0, other_peer.sent.back().append_entries_request.count);
+}
+
+TEST(LogCompactionTestGroup, RejectedRequestsRestartAfterThePeerLog)
+{
+    for (auto i = 0; i < 10; i++) {
+        leader.replicate(TestStateMachine::Operation::FOO);
+    }
+    leader.tick();
+
+    acknowledge(peer, 3, false);
+
+    CHECK_EQUAL(4, peer.next_index);
+}
+
+TEST(LogCompactionTestGroup, OutOfOrderRepliesDoNotMoveIndicesBack)
+{
+    for (auto i = 0; i < 10; i++) {
+        leader.replicate(TestStateMachine::Operation::FOO);
+    }
+    leader.tick();
+
+    acknowledge(peer, 8);
+    acknowledge(peer, 4);
+
+    CHECK_EQUAL(8, peer.match_index);
+    CHECK_EQUAL(11, peer.next_index);
+}
+
+TEST(LogCompactionTestGroup, CommitIndexNeedsAMajority)
+{
+    // With a third peer, two peers out of three are needed
+    RecordingPeer third_peer{3};
+    TestPeer* more_peers[3] = {&peer, &other_peer, &third_peer};
+    TestStateMachine fsm;
+    TestRaftState state{fsm, 42, more_peers, 3};
+    state.term = 1;
+    state.become_leader();
+    state.replicate(TestStateMachine::Operation::FOO);
+    state.replicate(TestStateMachine::Operation::FOO);
+
+    TestMessage msg, reply;
+    msg.type = TestMessage::Type::AppendEntriesReply;
+    msg.append_entries_reply.success = true;
+
+    msg.from_id = peer.id;
+    msg.append_entries_reply.last_index = 2;
+    state.process(msg, reply);
+    CHECK_EQUAL(0, state.commit_index);
+
+    msg.from_id = third_peer.id;
+    msg.append_entries_reply.last_index = 1;
+    state.process(msg, reply);
+    CHECK_EQUAL(1, state.commit_index);
+}
+
+TEST(LogCompactionTestGroup, CommittedEntriesAreCompactedWhenTheLogIsFull)
+{
+    replicate_and_commit(raft::LOG_SIZE);
+    CHECK_EQUAL(static_cast<int>(raft::LOG_SIZE), leader.commit_index);
+    CHECK_EQUAL(static_cast<int>(raft::LOG_SIZE), fsm.applied_count);
+
+    CHECK_TRUE(leader.replicate(TestStateMachine::Operation::BAR));
+
+    CHECK_EQUAL(1, leader.log.size());
+    CHECK_EQUAL(static_cast<int>(raft::LOG_SIZE), leader.log.snapshot_index());
+    CHECK_EQUAL(static_cast<int>(raft::LOG_SIZE) + 1, leader.log.last_index());
+}
+
+TEST(LogCompactionTestGroup, CannotReplicateIfTheLogIsFullOfUncommittedEntries)
+{
+    for (auto i = 0u; i < raft::LOG_SIZE; i++) {
+        CHECK_TRUE(leader.replicate(TestStateMachine::Operation::FOO));
+    }
+
+    CHECK_FALSE(leader.replicate(TestStateMachine::Operation::FOO));
+}
+
+TEST(LogCompactionTestGroup, SnapshotIsSentIfEntriesWereCompacted)
+{
+    tick_until_heartbeat();
+    replicate_and_commit(raft::LOG_SIZE);
+    leader.replicate(TestStateMachine::Operation::BAR);
+
+    // The peer lost its log and rejects the next request
+    acknowledge(peer, 0, false);
+
+    peer.sent.clear();
+    tick_until_heartbeat();
+
+    CHECK_EQUAL(1, peer.sent.size());
+    auto& msg = peer.sent[0];
+    CHECK_TRUE(msg.type == TestMessage::Type::InstallSnapshotRequest);
+    CHECK_EQUAL(static_cast<int>(raft::LOG_SIZE), msg.install_snapshot_request.last_included_index);
+    CHECK_EQUAL(1, msg.install_snapshot_request.last_included_term);
+    CHECK_EQUAL(static_cast<int>(raft::LOG_SIZE), msg.install_snapshot_request.snapshot.applied_count);
+}
+
+TEST_GROUP (InstallSnapshotTestGroup) {
+    TestStateMachine fsm;
+    TestRaftState state{fsm, 42, nullptr, 0};
+
+    bool install_snapshot(raft::Term term, raft::Index index, raft::Term last_term, int applied_count)
+    {
+        TestMessage msg, reply;
+        msg.type = TestMessage::Type::InstallSnapshotRequest;
+        msg.term = term;
+        msg.install_snapshot_request.last_included_index = index;
+        msg.install_snapshot_request.last_included_term = last_term;
+        msg.install_snapshot_request.snapshot.applied_count = applied_count;
+
+        CHECK_TRUE(state.process(msg, reply));
+        CHECK_TRUE(reply.type == TestMessage::Type::AppendEntriesReply);
+        return reply.append_entries_reply.success;
+    }
+
+    void append(raft::Term term, raft::Index index)
+    {
+        raft::LogEntry<TestStateMachine::Operation> entry;
+        entry.term = term;
+        entry.index = index;
+        entry.operation = TestStateMachine::Operation::FOO;
+        state.log.append(entry);
+    }
+};
+
+TEST(InstallSnapshotTestGroup, SnapshotReplacesTheLog)
+{
+    append(1, 1);
+
+    CHECK_TRUE(install_snapshot(2, 20, 2, 20));
+
+    CHECK_EQUAL(20, fsm.applied_count);
+    CHECK_EQUAL(20, state.commit_index);
+    CHECK_EQUAL(0, state.log.size());
+    CHECK_EQUAL(20, state.log.last_index());
+    CHECK_EQUAL(2, state.log.last_term());
+}
+
+TEST(InstallSnapshotTestGroup, FollowingEntriesAreKept)
+{
+    for (auto i = 1; i <= 5; i++) {
+        append(1, i);
+    }
+
+    CHECK_TRUE(install_snapshot(1, 3, 1, 3));
+
+    CHECK_EQUAL(2, state.log.size());
+    CHECK_EQUAL(5, state.log.last_index());
+    CHECK_EQUAL(3, state.commit_index);
+}
+
+TEST(InstallSnapshotTestGroup, OldSnapshotsAreIgnored)
+{
+    state.term = 3;
+    CHECK_FALSE(install_snapshot(2, 20, 2, 20));
+    CHECK_EQUAL(0, fsm.applied_count);
+}
+
+TEST(InstallSnapshotTestGroup, AppendEntriesMatchTheSnapshot)
+{
+    install_snapshot(2, 20, 2, 20);
+
+    TestMessage msg, reply;
+    msg.type = TestMessage::Type::AppendEntriesRequest;
+    msg.term = 2;
+    msg.append_entries_request.previous_entry_index = 20;
+    msg.append_entries_request.previous_entry_term = 2;
+    msg.append_entries_request.count = 1;
+    msg.append_entries_request.entries[0].index = 21;
+    msg.append_entries_request.entries[0].term = 2;
+    state.process(msg, reply);
+
+    CHECK_TRUE(reply.append_entries_reply.success);
+    CHECK_EQUAL(21, reply.append_entries_reply.last_index);
+}
@@ -9,9 +9,26 @@ public:
         BAR = 0xfe,
     };
 
+    struct Snapshot {
+        int applied_count;
+    };
+
+    int applied_count = 0;
+
     void apply(Operation op)
     {
         (void)op;
+        applied_count++;
+    }
+
+    Snapshot snapshot() const
+    {
+        return {applied_count};
+    }
+
+    void restore(const Snapshot& snapshot)
+    {
+        applied_count = snapshot.applied_count;
     }
 };
 
@@ -10,11 +10,23 @@ public:
         ONE,
     };
 
+    struct Snapshot {
+    };
+
     void apply(Operation op)
     {
         auto o = static_cast<int>(op);
         mock().actualCall("commit").withParameter("operation", o);
     }
+
+    Snapshot snapshot() const
+    {
+        return {};
+    }
+
+    void restore(const Snapshot&)
+    {
+    }
 };
 
 using TestMessage = raft::Message<MockCommitMachine>;
@@ -34,8 +46,8 @@ TEST_GROUP (StateMachineCommitTestGroup) {
 
         msg.type = TestMessage::Type::AppendEntriesRequest;
         msg.append_entries_request.leader_commit = commit;
-        msg.append_entries_request.previous_entry_term = state.log.last_index();
-        msg.append_entries_request.previous_entry_index = state.log.last_term();
+        msg.append_entries_request.previous_entry_term = state.log.last_term();
+        msg.append_entries_request.previous_entry_index = state.log.last_index();
         msg.append_entries_request.entries[0] = entry;
         msg.append_entries_request.count = 1;
 
@@ -0,0 +1,18 @@
+#ifndef TIMESTAMP_POSIX_H
+#define TIMESTAMP_POSIX_H
+
+#include "timestamp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Replaces the time source used by timestamp_get() and ltimestamp_get(), for
+ * example to run on simulated time. NULL goes back to CLOCK_MONOTONIC. */
+void timestamp_posix_set_source(ltimestamp_t (*source)(void));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIMESTAMP_POSIX_H */
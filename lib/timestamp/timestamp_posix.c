@@ -0,0 +1,28 @@
+#include <stddef.h>
+#include <time.h>
+#include <timestamp/timestamp.h>
+#include <timestamp/timestamp_posix.h>
+
+static ltimestamp_t monotonic_us(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (ltimestamp_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+static ltimestamp_t (*volatile time_source)(void) = monotonic_us;
+
+void timestamp_posix_set_source(ltimestamp_t (*source)(void))
+{
+    time_source = source != NULL ? source : monotonic_us;
+}
+
+timestamp_t timestamp_get(void)
+{
+    return (timestamp_t)time_source();
+}
+
+ltimestamp_t ltimestamp_get(void)
+{
+    return time_source();
+}
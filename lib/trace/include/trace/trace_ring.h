@@ -0,0 +1,129 @@
+#ifndef TRACE_RING_H
+#define TRACE_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/** Number of events kept by each ring, must be a power of two. */
+#ifndef TRACE_RING_SIZE
+#define TRACE_RING_SIZE 256
+#endif
+
+/** Maximum number of rings which can be registered. */
+#ifndef TRACE_RING_MAX_COUNT
+#define TRACE_RING_MAX_COUNT 16
+#endif
+
+/* Types specific to rings, in addition to the TRACE_TYPE_* ones */
+enum {
+    TRACE_TYPE_BEGIN = 4,
+    TRACE_TYPE_END,
+};
+
+struct trace_ring_event {
+    /* 2n + 1 while event n is being written, 2n + 2 once it is complete */
+    uint32_t sequence;
+    uint32_t timestamp_us;
+    uint8_t event_id;
+    uint8_t type;
+    union {
+        void* address;
+        const char* string;
+        int32_t integer;
+        float scalar;
+    } data;
+};
+
+/** Trace buffer owned by a single writer (thread, core or interrupt level).
+ *
+ * Writing to it does not take any lock, and it can be read while the writer
+ * keeps going: the oldest events are then overwritten.
+ */
+struct trace_ring {
+    const char* name;
+    uint8_t id;
+    uint32_t head; /**< Number of events written since init */
+    struct trace_ring* next;
+    struct trace_ring_event events[TRACE_RING_SIZE];
+};
+
+/** Position of a reader in each of the rings. */
+struct trace_ring_reader {
+    uint32_t cursor[TRACE_RING_MAX_COUNT];
+};
+
+/** Output function used to dump the rings, for example writing to a shell or
+ * a socket. */
+typedef void (*trace_write_fn_t)(void* arg, const void* data, size_t len);
+
+/* Tags of the records making up a binary dump. All integers are little
+ * endian. The dump starts with the magic "CVTR" and the format version. */
+enum {
+    TRACE_RECORD_NAME = 1, /**< event_id, len, name[len] */
+    TRACE_RECORD_RING, /**< ring_id, len, name[len] */
+    TRACE_RECORD_EVENT, /**< ring_id, event_id, type, timestamp_us (u32), data (u32) */
+    TRACE_RECORD_STRING, /**< ring_id, event_id, timestamp_us (u32), len, string[len] */
+    TRACE_RECORD_LOST, /**< ring_id, count (u32) */
+    TRACE_RECORD_END, /**< Nothing, marks the end of a streamed dump */
+};
+
+#define TRACE_DUMP_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Initializes a ring and registers it so that it is included in dumps.
+ *
+ * @returns false if too many rings were registered already.
+ */
+bool trace_ring_init(struct trace_ring* ring, const char* name);
+
+/** Forgets all registered rings, for example to register them again. */
+void trace_ring_unregister_all(void);
+
+/* Trace functions, only to be called by the ring's writer */
+void trace_ring_point(struct trace_ring* ring, uint8_t event_id);
+void trace_ring_address(struct trace_ring* ring, uint8_t event_id, void* p);
+void trace_ring_string(struct trace_ring* ring, uint8_t event_id, const char* str);
+void trace_ring_scalar(struct trace_ring* ring, uint8_t event_id, float f);
+void trace_ring_integer(struct trace_ring* ring, uint8_t event_id, int32_t i);
+
+/** Marks the start and end of a span of time, such as a control loop
+ * iteration. */
+void trace_ring_begin(struct trace_ring* ring, uint8_t event_id);
+void trace_ring_end(struct trace_ring* ring, uint8_t event_id);
+
+/** Reads an event by its index in the ring (counting since init).
+ *
+ * @returns false if the event was overwritten or is not written yet.
+ */
+bool trace_ring_read(struct trace_ring* ring, uint32_t index, struct trace_ring_event* event);
+
+/** Starts reading all registered rings from their oldest event. */
+void trace_ring_reader_init(struct trace_ring_reader* reader);
+
+/** Writes the dump header: magic, event names and ring names. */
+void trace_ring_dump_header(trace_write_fn_t write, void* arg, const char** names, size_t name_count);
+
+/** Writes all events written since the last call, without stopping tracing.
+ *
+ * Events which were overwritten before being dumped are reported as lost.
+ *
+ * @returns The number of events written.
+ */
+size_t trace_ring_dump(struct trace_ring_reader* reader, trace_write_fn_t write, void* arg);
+
+/** Ends a dump, so that a reader knows where it stops when it is streamed
+ * over a link which carries other data afterwards, such as a shell. */
+void trace_ring_dump_end(trace_write_fn_t write, void* arg);
+
+/* Porting function (platform specific, not provided by this library) */
+extern uint32_t trace_timestamp_us_get(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACE_RING_H */
@@ -1,6 +1,7 @@
 #include <stdint.h>
 
 #include "trace/trace.h"
+#include "trace/trace_ring.h"
 
 int32_t trace_timestamp_ms_get(void)
 {
@@ -15,3 +16,8 @@ int32_t trace_lock(void)
 void trace_unlock(int32_t status)
 {
 }
+
+uint32_t trace_timestamp_us_get(void)
+{
+    return 1234567;
+}
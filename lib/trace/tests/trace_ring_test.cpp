@@ -0,0 +1,254 @@
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <CppUTest/TestHarness.h>
+#include <trace/trace.h>
+#include <trace/trace_ring.h>
+#include "trace_points.h"
+
+extern "C" const char* trace_point_names[];
+
+static void write_to_vector(void* arg, const void* data, size_t len)
+{
+    auto out = static_cast<std::vector<uint8_t>*>(arg);
+    auto bytes = static_cast<const uint8_t*>(data);
+    out->insert(out->end(), bytes, bytes + len);
+}
+
+static uint32_t read_u32(const std::vector<uint8_t>& v, size_t pos)
+{
+    return v[pos] | (v[pos + 1] << 8) | (v[pos + 2] << 16) | ((uint32_t)v[pos + 3] << 24);
+}
+
+TEST_GROUP (TraceRingTestGroup) {
+    struct trace_ring ring;
+    struct trace_ring_reader reader;
+    std::vector<uint8_t> out;
+
+    void setup() override
+    {
+        trace_init();
+        trace_enable();
+        trace_ring_unregister_all();
+        trace_ring_init(&ring, "control");
+        trace_ring_reader_init(&reader);
+    }
+};
+
+TEST(TraceRingTestGroup, RingsGetDifferentIds)
+{
+    struct trace_ring other;
+    CHECK_TRUE(trace_ring_init(&other, "other"));
+    CHECK_EQUAL(0, ring.id);
+    CHECK_EQUAL(1, other.id);
+}
+
+TEST(TraceRingTestGroup, CannotRegisterTooManyRings)
+{
+    static struct trace_ring rings[TRACE_RING_MAX_COUNT];
+
+    for (auto i = 1; i < TRACE_RING_MAX_COUNT; i++) {
+        CHECK_TRUE(trace_ring_init(&rings[i], "ring"));
+    }
+    CHECK_FALSE(trace_ring_init(&rings[0], "ring"));
+}
+
+TEST(TraceRingTestGroup, CanTraceEvent)
+{
+    struct trace_ring_event e;
+
+    trace_ring_integer(&ring, TRACE_POINT_1, 42);
+
+    CHECK_EQUAL(1, ring.head);
+    CHECK_TRUE(trace_ring_read(&ring, 0, &e));
+    CHECK_EQUAL(TRACE_POINT_1, e.event_id);
+    CHECK_EQUAL(TRACE_TYPE_INTEGER, e.type);
+    CHECK_EQUAL(1234567, e.timestamp_us);
+    CHECK_EQUAL(42, e.data.integer);
+}
+
+TEST(TraceRingTestGroup, DisabledTracingIsNotRecorded)
+{
+    trace_disable();
+    trace_ring_point(&ring, TRACE_POINT_1);
+    CHECK_EQUAL(0, ring.head);
+}
+
+TEST(TraceRingTestGroup, CannotReadEventNotWrittenYet)
+{
+    struct trace_ring_event e;
+    CHECK_FALSE(trace_ring_read(&ring, 0, &e));
+}
+
+TEST(TraceRingTestGroup, CannotReadOverwrittenEvent)
+{
+    struct trace_ring_event e;
+
+    for (auto i = 0; i < TRACE_RING_SIZE + 1; i++) {
+        trace_ring_integer(&ring, TRACE_POINT_0, i);
+    }
+
+    CHECK_FALSE(trace_ring_read(&ring, 0, &e));
+    CHECK_TRUE(trace_ring_read(&ring, TRACE_RING_SIZE, &e));
+    CHECK_EQUAL(TRACE_RING_SIZE, e.data.integer);
+}
+
+TEST(TraceRingTestGroup, DumpHeader)
+{
+    trace_ring_dump_header(write_to_vector, &out, trace_point_names, 2);
+
+    std::vector<uint8_t> expected = {'C', 'V', 'T', 'R', TRACE_DUMP_VERSION};
+    const char* names[] = {"TRACE_POINT_0", "TRACE_POINT_1"};
+    for (auto i = 0; i < 2; i++) {
+        expected.push_back(TRACE_RECORD_NAME);
+        expected.push_back(i);
+        expected.push_back(strlen(names[i]));
+        expected.insert(expected.end(), names[i], names[i] + strlen(names[i]));
+    }
+    expected.push_back(TRACE_RECORD_RING);
+    expected.push_back(0);
+    expected.push_back(7);
+    expected.insert(expected.end(), {'c', 'o', 'n', 't', 'r', 'o', 'l'});
+
+    CHECK_TRUE(expected == out);
+}
+
+TEST(TraceRingTestGroup, DumpEvent)
+{
+    trace_ring_integer(&ring, TRACE_POINT_2, -2);
+
+    CHECK_EQUAL(1, trace_ring_dump(&reader, write_to_vector, &out));
+
+    std::vector<uint8_t> expected = {
+        TRACE_RECORD_EVENT, 0, TRACE_POINT_2, TRACE_TYPE_INTEGER,
+        0x87, 0xd6, 0x12, 0x00, // 1234567
+        0xfe, 0xff, 0xff, 0xff};
+    CHECK_TRUE(expected == out);
+}
+
+TEST(TraceRingTestGroup, DumpEnd)
+{
+    trace_ring_dump_end(write_to_vector, &out);
+
+    std::vector<uint8_t> expected = {TRACE_RECORD_END};
+    CHECK_TRUE(expected == out);
+}
+
+TEST(TraceRingTestGroup, DumpScalarAsRawFloat)
+{
+    float f = 1.5;
+    uint32_t raw;
+    memcpy(&raw, &f, sizeof(raw));
+
+    trace_ring_scalar(&ring, TRACE_POINT_0, f);
+    trace_ring_dump(&reader, write_to_vector, &out);
+
+    CHECK_EQUAL(TRACE_TYPE_SCALAR, out[3]);
+    CHECK_EQUAL(raw, read_u32(out, 8));
+}
+
+TEST(TraceRingTestGroup, DumpStringContent)
+{
+    trace_ring_string(&ring, TRACE_POINT_1, "hello");
+    trace_ring_dump(&reader, write_to_vector, &out);
+
+    std::vector<uint8_t> expected = {
+        TRACE_RECORD_STRING, 0, TRACE_POINT_1,
+        0x87, 0xd6, 0x12, 0x00,
+        5, 'h', 'e', 'l', 'l', 'o'};
+    CHECK_TRUE(expected == out);
+}
+
+TEST(TraceRingTestGroup, DumpSpans)
+{
+    trace_ring_begin(&ring, TRACE_POINT_0);
+    trace_ring_end(&ring, TRACE_POINT_0);
+    trace_ring_dump(&reader, write_to_vector, &out);
+
+    CHECK_EQUAL(24, out.size());
+    CHECK_EQUAL(TRACE_TYPE_BEGIN, out[3]);
+    CHECK_EQUAL(TRACE_TYPE_END, out[12 + 3]);
+}
+
+TEST(TraceRingTestGroup, DumpOnlyWritesNewEvents)
+{
+    trace_ring_point(&ring, TRACE_POINT_0);
+    CHECK_EQUAL(1, trace_ring_dump(&reader, write_to_vector, &out));
+    CHECK_EQUAL(0, trace_ring_dump(&reader, write_to_vector, &out));
+
+    trace_ring_point(&ring, TRACE_POINT_0);
+    CHECK_EQUAL(1, trace_ring_dump(&reader, write_to_vector, &out));
+}
+
+TEST(TraceRingTestGroup, DumpDoesNotStopTracing)
+{
+    trace_ring_dump(&reader, write_to_vector, &out);
+    trace_ring_point(&ring, TRACE_POINT_0);
+    CHECK_EQUAL(1, ring.head);
+}
+
+TEST(TraceRingTestGroup, DumpReportsLostEvents)
+{
+    for (auto i = 0; i < TRACE_RING_SIZE + 10; i++) {
+        trace_ring_integer(&ring, TRACE_POINT_0, i);
+    }
+
+    CHECK_EQUAL(TRACE_RING_SIZE, trace_ring_dump(&reader, write_to_vector, &out));
+
+    // The first dumped event is the oldest one still in the ring
+    CHECK_EQUAL(10, read_u32(out, 8));
+
+    auto lost = out.size() - 6;
+    CHECK_EQUAL(TRACE_RECORD_LOST, out[lost]);
+    CHECK_EQUAL(0, out[lost + 1]);
+    CHECK_EQUAL(10, read_u32(out, lost + 2));
+}
+
+TEST(TraceRingTestGroup, DumpAllRings)
+{
+    struct trace_ring other;
+    trace_ring_init(&other, "other");
+
+    trace_ring_point(&ring, TRACE_POINT_0);
+    trace_ring_point(&other, TRACE_POINT_1);
+
+    CHECK_EQUAL(2, trace_ring_dump(&reader, write_to_vector, &out));
+}
+
+TEST(TraceRingTestGroup, CanDumpWhileWriterIsRunning)
+{
+    const int count = 100000;
+    std::thread writer([&]() {
+        for (auto i = 0; i < count; i++) {
+            trace_ring_integer(&ring, TRACE_POINT_0, i);
+        }
+    });
+
+    size_t written = 0;
+    while (__atomic_load_n(&ring.head, __ATOMIC_ACQUIRE) < (uint32_t)count) {
+        written += trace_ring_dump(&reader, write_to_vector, &out);
+    }
+    writer.join();
+    written += trace_ring_dump(&reader, write_to_vector, &out);
+
+    // Events must come out in order, and each one is either dumped or
+    // reported as lost.
+    size_t lost = 0, events = 0;
+    int32_t previous = -1;
+    for (size_t pos = 0; pos < out.size();) {
+        if (out[pos] == TRACE_RECORD_LOST) {
+            lost += read_u32(out, pos + 2);
+            pos += 6;
+        } else {
+            CHECK_EQUAL(TRACE_RECORD_EVENT, out[pos]);
+            int32_t value = read_u32(out, pos + 8);
+            CHECK_TRUE(value > previous);
+            previous = value;
+            events++;
+            pos += 12;
+        }
+    }
+
+    CHECK_EQUAL(written, events);
+    CHECK_EQUAL(count, lost + events);
+}
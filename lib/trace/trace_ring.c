@@ -0,0 +1,256 @@
+#include <trace/trace.h>
+#include <trace/trace_ring.h>
+#include <string.h>
+
+#define TRACE_RING_MASK (TRACE_RING_SIZE - 1)
+
+#if (TRACE_RING_SIZE & TRACE_RING_MASK) != 0
+#error "TRACE_RING_SIZE must be a power of two"
+#endif
+
+extern volatile struct trace_buffer_struct trace_buffer;
+
+static struct trace_ring* registered_rings;
+static uint8_t ring_count;
+
+void trace_ring_unregister_all(void)
+{
+    __atomic_store_n(&registered_rings, NULL, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring_count, 0, __ATOMIC_RELEASE);
+}
+
+bool trace_ring_init(struct trace_ring* ring, const char* name)
+{
+    memset(ring, 0, sizeof(*ring));
+    ring->name = name;
+
+    uint8_t id = __atomic_fetch_add(&ring_count, 1, __ATOMIC_RELAXED);
+    if (id >= TRACE_RING_MAX_COUNT) {
+        __atomic_fetch_sub(&ring_count, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    ring->id = id;
+
+    /* Lock-free push at the head of the list of rings */
+    ring->next = __atomic_load_n(&registered_rings, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&registered_rings, &ring->next, ring, true,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+
+    return true;
+}
+
+static void trace_ring_push(struct trace_ring* ring, uint8_t event_id, uint8_t type, struct trace_ring_event* e)
+{
+    if (!trace_buffer.active) {
+        return;
+    }
+
+    /* Only the writer modifies head, so no atomic increment is needed */
+    uint32_t n = ring->head;
+    struct trace_ring_event* slot = &ring->events[n & TRACE_RING_MASK];
+
+    __atomic_store_n(&slot->sequence, 2 * n + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    /* Relaxed atomic accesses, as a reader might copy the slot concurrently */
+    __atomic_store_n(&slot->timestamp_us, trace_timestamp_us_get(), __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->event_id, event_id, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->type, type, __ATOMIC_RELAXED);
+    __atomic_store(&slot->data, &e->data, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&slot->sequence, 2 * n + 2, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->head, n + 1, __ATOMIC_RELEASE);
+}
+
+void trace_ring_point(struct trace_ring* ring, uint8_t event_id)
+{
+    struct trace_ring_event e;
+    e.data.string = "";
+    trace_ring_push(ring, event_id, TRACE_TYPE_STRING, &e);
+}
+
+void trace_ring_address(struct trace_ring* ring, uint8_t event_id, void* p)
+{
+    struct trace_ring_event e;
+    e.data.address = p;
+    trace_ring_push(ring, event_id, TRACE_TYPE_ADDRESS, &e);
+}
+
+void trace_ring_string(struct trace_ring* ring, uint8_t event_id, const char* str)
+{
+    struct trace_ring_event e;
+    e.data.string = str;
+    trace_ring_push(ring, event_id, TRACE_TYPE_STRING, &e);
+}
+
+void trace_ring_scalar(struct trace_ring* ring, uint8_t event_id, float f)
+{
+    struct trace_ring_event e;
+    e.data.scalar = f;
+    trace_ring_push(ring, event_id, TRACE_TYPE_SCALAR, &e);
+}
+
+void trace_ring_integer(struct trace_ring* ring, uint8_t event_id, int32_t i)
+{
+    struct trace_ring_event e;
+    e.data.integer = i;
+    trace_ring_push(ring, event_id, TRACE_TYPE_INTEGER, &e);
+}
+
+void trace_ring_begin(struct trace_ring* ring, uint8_t event_id)
+{
+    struct trace_ring_event e;
+    e.data.integer = 0;
+    trace_ring_push(ring, event_id, TRACE_TYPE_BEGIN, &e);
+}
+
+void trace_ring_end(struct trace_ring* ring, uint8_t event_id)
+{
+    struct trace_ring_event e;
+    e.data.integer = 0;
+    trace_ring_push(ring, event_id, TRACE_TYPE_END, &e);
+}
+
+bool trace_ring_read(struct trace_ring* ring, uint32_t index, struct trace_ring_event* event)
+{
+    struct trace_ring_event* slot = &ring->events[index & TRACE_RING_MASK];
+    uint32_t expected = 2 * index + 2;
+
+    if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != expected) {
+        return false;
+    }
+
+    event->timestamp_us = __atomic_load_n(&slot->timestamp_us, __ATOMIC_RELAXED);
+    event->event_id = __atomic_load_n(&slot->event_id, __ATOMIC_RELAXED);
+    event->type = __atomic_load_n(&slot->type, __ATOMIC_RELAXED);
+    __atomic_load(&slot->data, &event->data, __ATOMIC_RELAXED);
+    event->sequence = expected;
+
+    /* If the writer wrapped around meanwhile, the copy might be torn */
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) == expected;
+}
+
+void trace_ring_reader_init(struct trace_ring_reader* reader)
+{
+    memset(reader, 0, sizeof(*reader));
+}
+
+static void write_u8(trace_write_fn_t write, void* arg, uint8_t val)
+{
+    write(arg, &val, 1);
+}
+
+static void write_u32(trace_write_fn_t write, void* arg, uint32_t val)
+{
+    uint8_t buf[4];
+    for (int i = 0; i < 4; i++) {
+        buf[i] = (uint8_t)(val >> (8 * i));
+    }
+    write(arg, buf, sizeof(buf));
+}
+
+static void write_string(trace_write_fn_t write, void* arg, const char* str)
+{
+    size_t len = str ? strlen(str) : 0;
+    if (len > 255) {
+        len = 255;
+    }
+    write_u8(write, arg, len);
+    write(arg, str, len);
+}
+
+void trace_ring_dump_header(trace_write_fn_t write, void* arg, const char** names, size_t name_count)
+{
+    write(arg, "CVTR", 4);
+    write_u8(write, arg, TRACE_DUMP_VERSION);
+
+    for (size_t i = 0; i < name_count && i < 256; i++) {
+        write_u8(write, arg, TRACE_RECORD_NAME);
+        write_u8(write, arg, i);
+        write_string(write, arg, names[i]);
+    }
+
+    struct trace_ring* ring = __atomic_load_n(&registered_rings, __ATOMIC_ACQUIRE);
+    for (; ring != NULL; ring = ring->next) {
+        write_u8(write, arg, TRACE_RECORD_RING);
+        write_u8(write, arg, ring->id);
+        write_string(write, arg, ring->name);
+    }
+}
+
+static void write_event(trace_write_fn_t write, void* arg, uint8_t ring_id, struct trace_ring_event* e)
+{
+    if (e->type == TRACE_TYPE_STRING) {
+        write_u8(write, arg, TRACE_RECORD_STRING);
+        write_u8(write, arg, ring_id);
+        write_u8(write, arg, e->event_id);
+        write_u32(write, arg, e->timestamp_us);
+        write_string(write, arg, e->data.string);
+        return;
+    }
+
+    uint32_t data;
+    if (e->type == TRACE_TYPE_ADDRESS) {
+        data = (uint32_t)(uintptr_t)e->data.address;
+    } else if (e->type == TRACE_TYPE_SCALAR) {
+        memcpy(&data, &e->data.scalar, sizeof(data));
+    } else {
+        data = (uint32_t)e->data.integer;
+    }
+
+    write_u8(write, arg, TRACE_RECORD_EVENT);
+    write_u8(write, arg, ring_id);
+    write_u8(write, arg, e->event_id);
+    write_u8(write, arg, e->type);
+    write_u32(write, arg, e->timestamp_us);
+    write_u32(write, arg, data);
+}
+
+static void write_lost(trace_write_fn_t write, void* arg, uint8_t ring_id, uint32_t count)
+{
+    write_u8(write, arg, TRACE_RECORD_LOST);
+    write_u8(write, arg, ring_id);
+    write_u32(write, arg, count);
+}
+
+size_t trace_ring_dump(struct trace_ring_reader* reader, trace_write_fn_t write, void* arg)
+{
+    size_t written = 0;
+    struct trace_ring* ring = __atomic_load_n(&registered_rings, __ATOMIC_ACQUIRE);
+
+    for (; ring != NULL; ring = ring->next) {
+        uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        uint32_t cursor = reader->cursor[ring->id];
+        uint32_t lost = 0;
+
+        if (head - cursor > TRACE_RING_SIZE) {
+            lost = head - cursor - TRACE_RING_SIZE;
+            cursor = head - TRACE_RING_SIZE;
+        }
+
+        for (; cursor != head; cursor++) {
+            struct trace_ring_event e;
+            if (!trace_ring_read(ring, cursor, &e)) {
+                lost++;
+                continue;
+            }
+            write_event(write, arg, ring->id, &e);
+            written++;
+        }
+
+        if (lost > 0) {
+            write_lost(write, arg, ring->id, lost);
+        }
+
+        reader->cursor[ring->id] = head;
+    }
+
+    return written;
+}
+
+void trace_ring_dump_end(trace_write_fn_t write, void* arg)
+{
+    write_u8(write, arg, TRACE_RECORD_END);
+}
@@ -0,0 +1,48 @@
+#ifndef VIRTUAL_CLOCK_UAVCAN_CLOCK_HPP
+#define VIRTUAL_CLOCK_UAVCAN_CLOCK_HPP
+
+#include <uavcan_linux/uavcan_linux.hpp>
+#include "virtual_clock.h"
+
+/** UAVCAN clock following a virtual clock once one is set, and the system
+ * clock before.
+ *
+ * It derives from the Linux clock so that it can be given to the SocketCAN
+ * driver, which then timestamps the received frames in simulated time.
+ */
+class VirtualUavcanClock : public uavcan_linux::SystemClock {
+    virtual_clock_t* clock = nullptr;
+
+public:
+    /** Must be called before the node using the clock is started. */
+    void use_virtual_clock(virtual_clock_t* virtual_clock)
+    {
+        clock = virtual_clock;
+    }
+
+    uavcan::MonotonicTime getMonotonic() const override
+    {
+        if (clock == nullptr) {
+            return uavcan_linux::SystemClock::getMonotonic();
+        }
+        return uavcan::MonotonicTime::fromUSec(virtual_clock_now(clock));
+    }
+
+    uavcan::UtcTime getUtc() const override
+    {
+        if (clock == nullptr) {
+            return uavcan_linux::SystemClock::getUtc();
+        }
+        return uavcan::UtcTime::fromUSec(virtual_clock_now(clock));
+    }
+
+    void adjustUtc(uavcan::UtcDuration adjustment) override
+    {
+        /* Simulated time is the same for everybody, there is nothing to sync */
+        if (clock == nullptr) {
+            uavcan_linux::SystemClock::adjustUtc(adjustment);
+        }
+    }
+};
+
+#endif /* VIRTUAL_CLOCK_UAVCAN_CLOCK_HPP */
@@ -0,0 +1,113 @@
+#ifndef VIRTUAL_CLOCK_H
+#define VIRTUAL_CLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VIRTUAL_CLOCK_MAX_PARTICIPANTS 32
+
+/* Value of running when nobody holds the token */
+#define VIRTUAL_CLOCK_IDLE (-1)
+
+/* Value of running once the clock was stopped */
+#define VIRTUAL_CLOCK_STOPPED (-2)
+
+/** Simulated time shared by several threads or processes running in lockstep.
+ *
+ * Each participant is a loop which does some work then sleeps until a point
+ * in simulated time. Only one participant runs at a time: when it goes to
+ * sleep, the clock jumps to the earliest wakeup time and hands over to the
+ * participant which asked for it. Ties are broken by participant id, so that
+ * given the same inputs the participants always run in the same order.
+ *
+ * Time only advances when all the participants are sleeping, so the
+ * simulation runs as fast as the CPU allows, and a participant is never late.
+ *
+ * The clock can live in shared memory (see virtual_clock_create_shared()) to
+ * synchronize several processes. A participant which blocks on something else
+ * than the clock while holding it blocks the whole simulation.
+ */
+typedef struct {
+    uint32_t magic;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    /* Simulated time in microseconds */
+    uint64_t now_us;
+
+    /* Time does not start before that many participants joined */
+    uint32_t expected_participants;
+    uint32_t participant_count;
+    bool started;
+
+    /* Id of the participant holding the clock, or one of the special values */
+    int32_t running;
+
+    bool joined[VIRTUAL_CLOCK_MAX_PARTICIPANTS];
+    uint64_t wakeup_us[VIRTUAL_CLOCK_MAX_PARTICIPANTS];
+} virtual_clock_t;
+
+/** Initializes a clock at time zero.
+ *
+ * @param [in] expected_participants The clock stays at zero and nobody runs
+ * until that many participants joined.
+ * @param [in] shared Must be true if the clock is shared between processes.
+ */
+void virtual_clock_init(virtual_clock_t* clock, uint32_t expected_participants, bool shared);
+
+/** Creates a clock in the POSIX shared memory object of the given name (for
+ * example "/hitl_clock"), replacing any existing one.
+ *
+ * @returns The clock, or NULL if the shared memory could not be created.
+ */
+virtual_clock_t* virtual_clock_create_shared(const char* name, uint32_t expected_participants);
+
+/** Opens a clock created by another process with virtual_clock_create_shared().
+ *
+ * @returns The clock, or NULL if it does not exist (yet).
+ */
+virtual_clock_t* virtual_clock_open_shared(const char* name);
+
+/** Removes the name of a shared clock, processes which opened it keep using it. */
+void virtual_clock_unlink_shared(const char* name);
+
+/** Returns the simulated time in microseconds. Can be called from any thread. */
+uint64_t virtual_clock_now(virtual_clock_t* clock);
+
+/** Registers the calling thread as the participant with the given id, then
+ * blocks until it is its turn to run.
+ *
+ * Ids must be unique and below VIRTUAL_CLOCK_MAX_PARTICIPANTS. Participants
+ * joining after the time started enter at the current time.
+ */
+void virtual_clock_join(virtual_clock_t* clock, int id);
+
+/** Gives the clock back and unregisters the participant. */
+void virtual_clock_leave(virtual_clock_t* clock, int id);
+
+/** Gives the clock back and blocks until the simulated time reaches the given
+ * time and it is the participant's turn to run again.
+ *
+ * A wakeup time in the past runs the participant again at the current time,
+ * after participants with a lower id waiting for the same time.
+ */
+void virtual_clock_sleep_until(virtual_clock_t* clock, int id, uint64_t time_us);
+
+/** Stops the clock: participants calling virtual_clock_sleep_until() never
+ * wake up again and virtual_clock_wait_stopped() returns. Must be called by
+ * the participant holding the clock. */
+void virtual_clock_stop(virtual_clock_t* clock);
+
+/** Blocks until the clock is stopped. */
+void virtual_clock_wait_stopped(virtual_clock_t* clock);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VIRTUAL_CLOCK_H */
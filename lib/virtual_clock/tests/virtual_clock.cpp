@@ -0,0 +1,139 @@
+#include <CppUTest/TestHarness.h>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <virtual_clock/virtual_clock.h>
+
+TEST_GROUP (VirtualClockTestGroup) {
+    virtual_clock_t clock;
+
+    /* Times and ids of the participants' ticks, in the order they ran */
+    std::vector<std::pair<uint64_t, int>> ticks;
+
+    void participant(int id, uint64_t period_us, uint64_t end_us)
+    {
+        virtual_clock_join(&clock, id);
+        while (virtual_clock_now(&clock) < end_us) {
+            ticks.push_back({virtual_clock_now(&clock), id});
+            virtual_clock_sleep_until(&clock, id, virtual_clock_now(&clock) + period_us);
+        }
+        virtual_clock_leave(&clock, id);
+    }
+};
+
+TEST(VirtualClockTestGroup, StartsAtZero)
+{
+    virtual_clock_init(&clock, 1, false);
+
+    CHECK_EQUAL(0, virtual_clock_now(&clock));
+}
+
+TEST(VirtualClockTestGroup, JumpsStraightToTheWakeupTime)
+{
+    virtual_clock_init(&clock, 1, false);
+    virtual_clock_join(&clock, 0);
+
+    virtual_clock_sleep_until(&clock, 0, 3600000000);
+
+    CHECK_EQUAL(3600000000, virtual_clock_now(&clock));
+}
+
+TEST(VirtualClockTestGroup, SleepingInThePastDoesNotGoBackInTime)
+{
+    virtual_clock_init(&clock, 1, false);
+    virtual_clock_join(&clock, 0);
+    virtual_clock_sleep_until(&clock, 0, 1000);
+
+    virtual_clock_sleep_until(&clock, 0, 10);
+
+    CHECK_EQUAL(1000, virtual_clock_now(&clock));
+}
+
+TEST(VirtualClockTestGroup, RunsParticipantsInWakeupOrder)
+{
+    virtual_clock_init(&clock, 2, false);
+
+    std::thread a([&]() { participant(3, 300, 1000); });
+    std::thread b([&]() { participant(1, 500, 1000); });
+    a.join();
+    b.join();
+
+    /* Ties at the same time are broken by id */
+    std::vector<std::pair<uint64_t, int>> expected = {
+        {0, 1}, {0, 3}, {300, 3}, {500, 1}, {600, 3}, {900, 3}};
+    CHECK_TRUE(ticks == expected);
+}
+
+TEST(VirtualClockTestGroup, WaitsForAllParticipantsBeforeStarting)
+{
+    virtual_clock_init(&clock, 2, false);
+
+    std::thread a([&]() { participant(0, 100, 300); });
+
+    /* Nobody runs until the second participant joins */
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    CHECK_TRUE(ticks.empty());
+
+    virtual_clock_join(&clock, 5);
+    virtual_clock_sleep_until(&clock, 5, 1000);
+    a.join();
+
+    CHECK_EQUAL(3, ticks.size());
+    CHECK_EQUAL(1000, virtual_clock_now(&clock));
+}
+
+TEST(VirtualClockTestGroup, LeavingHandsOverToTheNextParticipant)
+{
+    virtual_clock_init(&clock, 1, false);
+    virtual_clock_join(&clock, 0);
+
+    std::thread a([&]() { participant(1, 100, 500); });
+
+    virtual_clock_sleep_until(&clock, 0, 200);
+    virtual_clock_leave(&clock, 0);
+    a.join();
+
+    CHECK_EQUAL(500, virtual_clock_now(&clock));
+}
+
+TEST(VirtualClockTestGroup, StopWakesUpWaiters)
+{
+    virtual_clock_init(&clock, 1, false);
+    virtual_clock_join(&clock, 0);
+
+    std::thread waiter([&]() { virtual_clock_wait_stopped(&clock); });
+    virtual_clock_stop(&clock);
+    waiter.join();
+
+    CHECK_EQUAL(VIRTUAL_CLOCK_STOPPED, clock.running);
+}
+
+TEST_GROUP (VirtualClockSharedTestGroup) {
+    const char* name = "/virtual_clock_test";
+
+    void teardown() override
+    {
+        virtual_clock_unlink_shared(name);
+    }
+};
+
+TEST(VirtualClockSharedTestGroup, OpeningAMissingClockFails)
+{
+    virtual_clock_unlink_shared(name);
+
+    POINTERS_EQUAL(NULL, virtual_clock_open_shared(name));
+}
+
+TEST(VirtualClockSharedTestGroup, OpenedClockSharesTheTime)
+{
+    virtual_clock_t* created = virtual_clock_create_shared(name, 1);
+    CHECK_TRUE(created != NULL);
+
+    virtual_clock_t* opened = virtual_clock_open_shared(name);
+    CHECK_TRUE(opened != NULL);
+
+    virtual_clock_join(created, 0);
+    virtual_clock_sleep_until(created, 0, 1234);
+
+    CHECK_EQUAL(1234, virtual_clock_now(opened));
+}
@@ -0,0 +1,208 @@
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "virtual_clock/virtual_clock.h"
+
+#define VIRTUAL_CLOCK_MAGIC 0x56434c4b
+
+static void set_now(virtual_clock_t* clock, uint64_t now_us)
+{
+    __atomic_store_n(&clock->now_us, now_us, __ATOMIC_RELEASE);
+}
+
+/* Hands the clock over to the next participant. Must be called with the lock
+ * held, by the participant giving the clock back. */
+static void schedule(virtual_clock_t* clock)
+{
+    if (clock->running == VIRTUAL_CLOCK_STOPPED) {
+        return;
+    }
+
+    clock->running = VIRTUAL_CLOCK_IDLE;
+
+    if (!clock->started) {
+        if (clock->participant_count < clock->expected_participants) {
+            return;
+        }
+        clock->started = true;
+    }
+
+    int next = -1;
+    for (int i = 0; i < VIRTUAL_CLOCK_MAX_PARTICIPANTS; i++) {
+        if (!clock->joined[i]) {
+            continue;
+        }
+        /* Strict comparison so that the lowest id wins ties */
+        if (next < 0 || clock->wakeup_us[i] < clock->wakeup_us[next]) {
+            next = i;
+        }
+    }
+
+    if (next < 0) {
+        return;
+    }
+
+    if (clock->wakeup_us[next] > clock->now_us) {
+        set_now(clock, clock->wakeup_us[next]);
+    }
+    clock->running = next;
+    pthread_cond_broadcast(&clock->cond);
+}
+
+static void wait_for_turn(virtual_clock_t* clock, int id)
+{
+    while (clock->running != id) {
+        pthread_cond_wait(&clock->cond, &clock->lock);
+    }
+}
+
+void virtual_clock_init(virtual_clock_t* clock, uint32_t expected_participants, bool shared)
+{
+    memset(clock, 0, sizeof(virtual_clock_t));
+
+    pthread_mutexattr_t mutex_attr;
+    pthread_mutexattr_init(&mutex_attr);
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+
+    if (shared) {
+        pthread_mutexattr_setpshared(&mutex_attr, PTHREAD_PROCESS_SHARED);
+        pthread_condattr_setpshared(&cond_attr, PTHREAD_PROCESS_SHARED);
+    }
+
+    pthread_mutex_init(&clock->lock, &mutex_attr);
+    pthread_cond_init(&clock->cond, &cond_attr);
+
+    pthread_mutexattr_destroy(&mutex_attr);
+    pthread_condattr_destroy(&cond_attr);
+
+    clock->expected_participants = expected_participants;
+    clock->running = VIRTUAL_CLOCK_IDLE;
+
+    /* Written last so that other processes only open fully initialized clocks */
+    __atomic_store_n(&clock->magic, VIRTUAL_CLOCK_MAGIC, __ATOMIC_RELEASE);
+}
+
+virtual_clock_t* virtual_clock_create_shared(const char* name, uint32_t expected_participants)
+{
+    int fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0600);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    if (ftruncate(fd, sizeof(virtual_clock_t)) < 0) {
+        close(fd);
+        return NULL;
+    }
+
+    void* mem = mmap(NULL, sizeof(virtual_clock_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        return NULL;
+    }
+
+    virtual_clock_t* clock = (virtual_clock_t*)mem;
+    virtual_clock_init(clock, expected_participants, true);
+    return clock;
+}
+
+virtual_clock_t* virtual_clock_open_shared(const char* name)
+{
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(virtual_clock_t)) {
+        close(fd);
+        return NULL;
+    }
+
+    void* mem = mmap(NULL, sizeof(virtual_clock_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        return NULL;
+    }
+
+    virtual_clock_t* clock = (virtual_clock_t*)mem;
+    if (__atomic_load_n(&clock->magic, __ATOMIC_ACQUIRE) != VIRTUAL_CLOCK_MAGIC) {
+        munmap(mem, sizeof(virtual_clock_t));
+        return NULL;
+    }
+
+    return clock;
+}
+
+void virtual_clock_unlink_shared(const char* name)
+{
+    shm_unlink(name);
+}
+
+uint64_t virtual_clock_now(virtual_clock_t* clock)
+{
+    return __atomic_load_n(&clock->now_us, __ATOMIC_ACQUIRE);
+}
+
+void virtual_clock_join(virtual_clock_t* clock, int id)
+{
+    pthread_mutex_lock(&clock->lock);
+
+    clock->joined[id] = true;
+    clock->wakeup_us[id] = clock->now_us;
+    clock->participant_count++;
+
+    if (clock->running == VIRTUAL_CLOCK_IDLE) {
+        schedule(clock);
+    }
+
+    wait_for_turn(clock, id);
+    pthread_mutex_unlock(&clock->lock);
+}
+
+void virtual_clock_leave(virtual_clock_t* clock, int id)
+{
+    pthread_mutex_lock(&clock->lock);
+
+    clock->joined[id] = false;
+    clock->participant_count--;
+
+    if (clock->running == id) {
+        schedule(clock);
+    }
+
+    pthread_mutex_unlock(&clock->lock);
+}
+
+void virtual_clock_sleep_until(virtual_clock_t* clock, int id, uint64_t time_us)
+{
+    pthread_mutex_lock(&clock->lock);
+
+    clock->wakeup_us[id] = time_us;
+    if (clock->running == id) {
+        schedule(clock);
+    }
+
+    wait_for_turn(clock, id);
+    pthread_mutex_unlock(&clock->lock);
+}
+
+void virtual_clock_stop(virtual_clock_t* clock)
+{
+    pthread_mutex_lock(&clock->lock);
+    clock->running = VIRTUAL_CLOCK_STOPPED;
+    pthread_cond_broadcast(&clock->cond);
+    pthread_mutex_unlock(&clock->lock);
+}
+
+void virtual_clock_wait_stopped(virtual_clock_t* clock)
+{
+    pthread_mutex_lock(&clock->lock);
+    while (clock->running != VIRTUAL_CLOCK_STOPPED) {
+        pthread_cond_wait(&clock->cond, &clock->lock);
+    }
+    pthread_mutex_unlock(&clock->lock);
+}
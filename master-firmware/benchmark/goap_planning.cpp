@@ -0,0 +1,192 @@
+#include <benchmark/benchmark.h>
+
+#include "strategy/actions.h"
+#include "strategy/goals.h"
+#include "strategy/state.h"
+#include "strategy/travel_time.h"
+
+/* Measures the time needed to plan each of the goals of the strategy, using
+ * the same actions and planner size as the robot.
+ *
+ * The plans of all the goals at once also report their quality, as the match
+ * time they are expected to take (estimated_s), with and without taking the
+ * travel times into account. */
+
+using namespace actions;
+
+/* The robot side of the actions is not needed for planning. */
+bool EnableLighthouse::execute(StrategyState& state)
+{
+    plan_effects(state);
+    return true;
+}
+
+bool RaiseWindsock::execute(StrategyState& state)
+{
+    plan_effects(state);
+    return true;
+}
+
+bool BackwardReefPickup::execute(StrategyState& state)
+{
+    plan_effects(state);
+    return true;
+}
+
+static EnableLighthouse enable_lighthouse;
+static RaiseWindsock windsocks[2] = {{0}, {1}};
+static BackwardReefPickup backward_reef_pickup;
+
+static goap::Action<StrategyState>* all_actions[] = {
+    &enable_lighthouse,
+    &windsocks[0],
+    &windsocks[1],
+    &backward_reef_pickup,
+};
+
+static void plan_goal(benchmark::State& bench, goap::Goal<StrategyState>& goal)
+{
+    static goap::Planner<StrategyState, StrategyStateHash, GOAP_SPACE_SIZE> planner;
+    goap::Action<StrategyState>* path[10];
+    StrategyState state = initial_state();
+
+    for (auto _ : bench) {
+        auto len = planner.plan(state, goal, all_actions, 4, path, 10);
+        benchmark::DoNotOptimize(len);
+    }
+}
+
+static void BM_PlanLighthouseEnabled(benchmark::State& bench)
+{
+    goals::LighthouseEnabled goal;
+    plan_goal(bench, goal);
+}
+
+static void BM_PlanWindsocksUp(benchmark::State& bench)
+{
+    goals::WindsocksUp goal;
+    plan_goal(bench, goal);
+}
+
+/* All the goals of the match at once */
+struct AllGoals : goap::Goal<StrategyState> {
+    goals::LighthouseEnabled lighthouse;
+    goals::WindsocksUp windsocks;
+
+    int distance_to(const StrategyState& state) const override
+    {
+        return lighthouse.distance_to(state) + windsocks.distance_to(state);
+    }
+};
+
+/* Hides the cost of an action, as the planner did before it used them */
+struct UnitCost : goap::Action<StrategyState> {
+    goap::Action<StrategyState>* action;
+
+    UnitCost(goap::Action<StrategyState>* action)
+        : action(action)
+    {
+    }
+
+    bool can_run(const StrategyState& state) override
+    {
+        return action->can_run(state);
+    }
+
+    void plan_effects(StrategyState& state) override
+    {
+        action->plan_effects(state);
+    }
+
+    bool execute(StrategyState& state) override
+    {
+        return action->execute(state);
+    }
+};
+
+static UnitCost unit_cost_actions[] = {
+    &enable_lighthouse,
+    &windsocks[0],
+    &windsocks[1],
+    &backward_reef_pickup,
+};
+
+static goap::Action<StrategyState>* all_unit_cost_actions[] = {
+    &unit_cost_actions[0],
+    &unit_cost_actions[1],
+    &unit_cost_actions[2],
+    &unit_cost_actions[3],
+};
+
+/* Table with an opponent in the middle, and the robot in its starting area */
+static StrategyState match_start(void)
+{
+    static struct obstacle_avoidance oa;
+    polygon_set_boundingbox(0, 0, 3000, 2000);
+    oa_init(&oa);
+
+    auto opponent = oa_new_poly(&oa, 4);
+    oa_poly_set_point(&oa, opponent, 1700, 800, 0);
+    oa_poly_set_point(&oa, opponent, 1700, 1200, 1);
+    oa_poly_set_point(&oa, opponent, 1300, 1200, 2);
+    oa_poly_set_point(&oa, opponent, 1300, 800, 3);
+    travel_time_oracle().set_obstacles(&oa);
+
+    StrategyState state = initial_state();
+    set_robot_position(state, {250, 450});
+    return state;
+}
+
+static void plan_all_goals(benchmark::State& bench, goap::Action<StrategyState>** actions, bool cold_oracle)
+{
+    static goap::Planner<StrategyState, StrategyStateHash, GOAP_SPACE_SIZE> planner;
+    goap::Action<StrategyState>* path[10];
+    StrategyState state = match_start();
+    AllGoals goal;
+    auto& oracle = travel_time_oracle();
+    auto limits = travel_limits_default();
+    int len = 0;
+
+    for (auto _ : bench) {
+        if (cold_oracle) {
+            /* Changing the limits forgets the travel times */
+            bench.PauseTiming();
+            limits.distance_speed += 1;
+            oracle.set_limits(limits);
+            bench.ResumeTiming();
+        }
+        len = planner.plan(state, goal, actions, 4, path, 10);
+        benchmark::DoNotOptimize(len);
+    }
+    oracle.set_limits(travel_limits_default());
+
+    /* The plan is rated with the real costs in both cases */
+    int cost_ms = 0;
+    for (int i = 0; i < len; i++) {
+        auto action = path[i];
+        if (actions == all_unit_cost_actions) {
+            action = static_cast<UnitCost*>(action)->action;
+        }
+        cost_ms += action->cost(state);
+        action->plan_effects(state);
+    }
+
+    bench.counters["plan_length"] = len;
+    bench.counters["estimated_s"] = cost_ms / 1000.;
+}
+
+static void BM_PlanAllGoals(benchmark::State& bench)
+{
+    plan_all_goals(bench, all_actions, bench.range(0));
+}
+
+static void BM_PlanAllGoalsUnitCost(benchmark::State& bench)
+{
+    plan_all_goals(bench, all_unit_cost_actions, false);
+}
+
+BENCHMARK(BM_PlanLighthouseEnabled);
+BENCHMARK(BM_PlanWindsocksUp);
+BENCHMARK(BM_PlanAllGoals)->ArgName("cold_oracle")->Arg(0)->Arg(1);
+BENCHMARK(BM_PlanAllGoalsUnitCost);
+BENCHMARK_MAIN();
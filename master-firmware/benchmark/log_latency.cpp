@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+
+#include <benchmark/benchmark.h>
+#include <error/error.h>
+
+#include "debug/log.h"
+
+using namespace std::chrono_literals;
+
+/* Measures how long a log call blocks a hot thread, such as the control loop
+ * logging its position, while other threads log too.
+ *
+ * - Synchronous: formats and writes each message under a global mutex, as
+ *   log.c used to do.
+ * - Asynchronous: the current logger, with its thread writing to the same
+ *   output.
+ *
+ * The output is /dev/null, so this is a lower bound for the synchronous case:
+ * a terminal or a slow disk only make the writes and the lock waits longer.
+ * The hot thread logs every 100us and the other threads every 20us. */
+
+static pthread_mutex_t synchronous_lock = PTHREAD_MUTEX_INITIALIZER;
+static FILE* synchronous_output;
+
+static void synchronous_log(struct error* e, ...)
+{
+    pthread_mutex_lock(&synchronous_lock);
+    va_list va;
+
+    fprintf(synchronous_output, "%7s ", error_severity_get_name(e->severity));
+    fprintf(synchronous_output, "%s:%d\t", e->file, e->line);
+
+    va_start(va, e);
+    vfprintf(synchronous_output, e->text, va);
+    va_end(va);
+
+    fprintf(synchronous_output, "\n");
+    fflush(synchronous_output);
+    pthread_mutex_unlock(&synchronous_lock);
+}
+
+template <bool asynchronous>
+static void BM_LogCallLatency(benchmark::State& state)
+{
+    uint32_t dropped = log_dropped_count();
+
+    if (asynchronous) {
+        log_config_t config;
+        log_config_default(&config);
+        config.console = false;
+        config.file = "/dev/null";
+        log_init(&config);
+    } else {
+        synchronous_output = fopen("/dev/null", "w");
+        error_register_notice(synchronous_log);
+    }
+
+    std::atomic<bool> running{true};
+    std::vector<std::thread> others;
+    for (int i = 0; i < state.range(0); i++) {
+        others.emplace_back([&running, i]() {
+            while (running) {
+                NOTICE("thread %d at %.3f %.3f", i, 1.234, 5.678);
+                std::this_thread::sleep_for(20us);
+            }
+        });
+    }
+
+    std::vector<double> latencies;
+    latencies.reserve(state.max_iterations);
+
+    // The first message of a thread allocates its ring
+    NOTICE("start");
+
+    for (auto _ : state) {
+        auto start = std::chrono::steady_clock::now();
+        NOTICE("pos: %d %d %d", 1200, 1000, 90);
+        auto end = std::chrono::steady_clock::now();
+
+        auto elapsed = std::chrono::duration<double>(end - start).count();
+        state.SetIterationTime(elapsed);
+        latencies.push_back(elapsed);
+
+        std::this_thread::sleep_for(100us);
+    }
+
+    running = false;
+    for (auto& t : others) {
+        t.join();
+    }
+
+    if (asynchronous) {
+        log_shutdown();
+    } else {
+        error_register_notice(nullptr);
+        fclose(synchronous_output);
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    state.counters["p99_us"] = 1e6 * latencies[latencies.size() * 99 / 100];
+    state.counters["max_us"] = 1e6 * latencies.back();
+    state.counters["dropped"] = log_dropped_count() - dropped;
+}
+
+BENCHMARK_TEMPLATE(BM_LogCallLatency, false)
+    ->ArgName("other_threads")
+    ->Arg(0)
+    ->Arg(3)
+    ->Iterations(10000)
+    ->UseManualTime();
+BENCHMARK_TEMPLATE(BM_LogCallLatency, true)
+    ->ArgName("other_threads")
+    ->Arg(0)
+    ->Arg(3)
+    ->Iterations(10000)
+    ->UseManualTime();
+
+BENCHMARK_MAIN();
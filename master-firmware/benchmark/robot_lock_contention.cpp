@@ -0,0 +1,151 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdio>
+
+#include <benchmark/benchmark.h>
+#include <absl/synchronization/mutex.h>
+
+#include <aversive/position_manager/position_manager.h>
+#include <aversive/robot_system/robot_system.h>
+#include <msgbus/messagebus.h>
+#include <msgbus/posix/port.h>
+
+/* Measures how long the control loop waits on mutexes while other threads
+ * read the robot pose, which is what the GUI, strategy, map and shell do.
+ *
+ * - GlobalLock: every access goes through a single lock for the whole robot
+ *   state, as base_controller.cpp used to do with robot.lock.
+ * - SplitState: the control loop only takes the lock of the control systems,
+ *   and readers get the pose from a seqlock topic (see robot_pose_get()).
+ *
+ * The wait time comes from absl's mutex contention profiler, counting only the
+ * waits of the control loop thread. */
+
+static std::atomic<int64_t> control_wait_cycles{0};
+static thread_local bool is_control_thread = false;
+
+static void mutex_profiler(int64_t wait_cycles)
+{
+    if (is_control_thread) {
+        control_wait_cycles.fetch_add(wait_cycles, std::memory_order_relaxed);
+    }
+}
+
+static int32_t encoder_value = 0;
+
+static int32_t fake_encoder(void*)
+{
+    return encoder_value;
+}
+
+struct Pose {
+    float x, y, a;
+};
+
+struct FakeRobot {
+    struct robot_system rs;
+    struct robot_position pos;
+    absl::Mutex lock;
+
+    messagebus_topic_t pose_topic;
+    condvar_wrapper_t pose_sync = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER};
+    Pose pose_buffer;
+
+    FakeRobot()
+    {
+        rs_init(&rs);
+        rs_set_flags(&rs, RS_USE_EXT);
+        rs_set_left_ext_encoder(&rs, fake_encoder, nullptr, 1.);
+        rs_set_right_ext_encoder(&rs, fake_encoder, nullptr, 1.);
+        position_init(&pos);
+        position_set_related_robot_system(&pos, &rs);
+        position_set_physical_params(&pos, 200., 100.);
+        messagebus_topic_init_seqlock(&pose_topic, &pose_sync, &pose_sync,
+                                      &pose_buffer, sizeof(pose_buffer));
+    }
+
+    Pose read_pose_from_position_manager()
+    {
+        return {position_get_x_float(&pos), position_get_y_float(&pos), position_get_a_rad_float(&pos)};
+    }
+};
+
+/* Some work standing for the control systems update */
+static void control_work()
+{
+    volatile float x = 0;
+    for (int i = 0; i < 500; i++) {
+        x = x + 0.5f * i;
+    }
+}
+
+template <bool split>
+static void BM_ControlLoopWithPoseReaders(benchmark::State& state)
+{
+    FakeRobot robot;
+    std::atomic<bool> running{true};
+    std::atomic<int64_t> reads{0};
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < state.range(0); i++) {
+        readers.emplace_back([&]() {
+            while (running) {
+                Pose pose;
+                if (split) {
+                    messagebus_topic_read(&robot.pose_topic, &pose, sizeof(pose));
+                } else {
+                    absl::MutexLock _(&robot.lock);
+                    pose = robot.read_pose_from_position_manager();
+                }
+                benchmark::DoNotOptimize(pose);
+                reads++;
+            }
+        });
+    }
+
+    absl::RegisterMutexProfiler(mutex_profiler);
+    is_control_thread = true;
+    control_wait_cycles = 0;
+
+    for (auto _ : state) {
+        encoder_value += 10;
+        if (split) {
+            position_manage(&robot.pos);
+            Pose pose = robot.read_pose_from_position_manager();
+            messagebus_topic_publish(&robot.pose_topic, &pose, sizeof(pose));
+
+            absl::MutexLock _(&robot.lock);
+            rs_update(&robot.rs);
+            control_work();
+        } else {
+            absl::MutexLock _(&robot.lock);
+            position_manage(&robot.pos);
+            rs_update(&robot.rs);
+            control_work();
+        }
+    }
+
+    is_control_thread = false;
+    running = false;
+    for (auto& t : readers) {
+        t.join();
+    }
+
+    state.counters["wait_cycles_per_tick"] = benchmark::Counter(control_wait_cycles.load() / double(state.iterations()));
+    state.counters["reads"] = benchmark::Counter(reads.load(), benchmark::Counter::kIsRate);
+}
+
+static void BM_GlobalLock(benchmark::State& state)
+{
+    BM_ControlLoopWithPoseReaders<false>(state);
+}
+BENCHMARK(BM_GlobalLock)->Arg(1)->Arg(4)->UseRealTime();
+
+static void BM_SplitState(benchmark::State& state)
+{
+    BM_ControlLoopWithPoseReaders<true>(state);
+}
+BENCHMARK(BM_SplitState)->Arg(1)->Arg(4)->UseRealTime();
+
+BENCHMARK_MAIN();
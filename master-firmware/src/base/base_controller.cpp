@@ -1,30 +1,37 @@
-#include <thread>
 #include <math.h>
 
 #include <error/error.h>
+#include <timestamp/timestamp.h>
 
 #include <aversive/trajectory_manager/trajectory_manager.h>
 #include <aversive/trajectory_manager/trajectory_manager_utils.h>
 #include <aversive/trajectory_manager/trajectory_manager_core.h>
 
+#include <parameter/parameter_snapshot.h>
+
 #include "main.h"
 #include "config.h"
 
 #include "rs_port.h"
 #include "base_controller.h"
+#include "pose_history.h"
+#include "periodic_executor.h"
+#include "can/motor_driver_uavcan.hpp"
 #include "protobuf/position.pb.h"
 
-#define BASE_CONTROLLER_STACKSIZE 1024
-#define POSITION_MANAGER_STACKSIZE 1024
-#define TRAJECTORY_MANAGER_STACKSIZE 2048
-
-using namespace std::chrono_literals;
+static_assert(ODOM_FREQUENCY == ASSERV_FREQUENCY,
+              "Odometry and control run in the same periodic pipeline");
 
 struct _robot robot;
 
+static TOPIC_DECL_SEQLOCK(pose_topic, RobotPosition);
+
+/* Published by the odometry task, see pose_history.h */
+static pose_history_t pose_history;
+
 void robot_init()
 {
-    absl::MutexLock _(&robot.lock);
+    absl::MutexLock _(&robot.control_lock);
 
     robot.mode = BOARD_MODE_ANGLE_DISTANCE;
     robot.base_speed = BASE_SPEED_FAST;
@@ -117,145 +124,232 @@ void robot_init()
     bd_set_thresholds(&robot.angle_bd, 15000, 1);
 }
 
-static void base_ctrl_thd()
-{
-    parameter_namespace_t* control_params = parameter_namespace_find(&master_config, "aversive/control");
-    parameter_namespace_t* odometry_params = parameter_namespace_find(&master_config, "odometry");
+struct pid_config {
+    float kp, ki, kd, i_limit;
+};
 
-    while (true) {
-        robot.lock.Lock();
-        rs_update(&robot.rs);
-
-        /* Control system manage */
-        if (robot.mode != BOARD_MODE_SET_PWM) {
-            if (robot.mode == BOARD_MODE_ANGLE_DISTANCE || robot.mode == BOARD_MODE_ANGLE_ONLY) {
-                cs_manage(&robot.angle_cs);
-            } else {
-                rs_set_angle(&robot.rs, 0); // Sets angle PWM to zero
-            }
-
-            if (robot.mode == BOARD_MODE_ANGLE_DISTANCE || robot.mode == BOARD_MODE_DISTANCE_ONLY) {
-                cs_manage(&robot.distance_cs);
-            } else {
-                rs_set_distance(&robot.rs, 0); // Sets distance PWM to zero
-            }
-        }
+struct speed_config {
+    float distance_speed, angle_speed;
+    float distance_acc, angle_acc;
+};
 
-        /* Blocking detection manage */
-        bd_manage(&robot.angle_bd, abs(cs_get_error(&robot.angle_cs)));
-        bd_manage(&robot.distance_bd, abs(cs_get_error(&robot.distance_cs)));
-
-        if (parameter_namespace_contains_changed(control_params)) {
-            float kp, ki, kd, ilim;
-            pid_get_gains(&robot.angle_pid.pid, &kp, &ki, &kd);
-            kp = parameter_scalar_get(parameter_find(control_params, "angle/kp"));
-            ki = parameter_scalar_get(parameter_find(control_params, "angle/ki"));
-            kd = parameter_scalar_get(parameter_find(control_params, "angle/kd"));
-            ilim = parameter_scalar_get(parameter_find(control_params, "angle/i_limit"));
-            pid_set_gains(&robot.angle_pid.pid, kp, ki, kd);
-            pid_set_integral_limit(&robot.angle_pid.pid, ilim);
-
-            pid_get_gains(&robot.distance_pid.pid, &kp, &ki, &kd);
-            kp = parameter_scalar_get(parameter_find(control_params, "distance/kp"));
-            ki = parameter_scalar_get(parameter_find(control_params, "distance/ki"));
-            kd = parameter_scalar_get(parameter_find(control_params, "distance/kd"));
-            ilim = parameter_scalar_get(parameter_find(control_params, "distance/i_limit"));
-            pid_set_gains(&robot.distance_pid.pid, kp, ki, kd);
-            pid_set_integral_limit(&robot.distance_pid.pid, ilim);
-        }
-        if (parameter_namespace_contains_changed(odometry_params)) {
-            rs_set_left_ext_encoder(&robot.rs, rs_encoder_get_left_ext, nullptr,
-                                    config_get_scalar("master/odometry/left_wheel_correction_factor"));
-            rs_set_right_ext_encoder(&robot.rs, rs_encoder_get_right_ext, nullptr,
-                                     config_get_scalar("master/odometry/right_wheel_correction_factor"));
-
-            position_set_physical_params(&robot.pos,
-                                         config_get_scalar("master/odometry/external_track_mm"),
-                                         config_get_scalar("master/odometry/external_encoder_ticks_per_mm"));
-        }
+/* Copies of the parameters used by the control loop, updated only when they
+ * change. */
+struct base_control_config {
+    pid_config angle, distance;
+};
 
-        switch (robot.base_speed) {
-            case BASE_SPEED_INIT:
-                trajectory_set_speed(&robot.traj,
-                                     1000 * speed_mm2imp(&robot.traj, config_get_scalar("master/aversive/trajectories/distance/speed/init")),
-                                     speed_rd2imp(&robot.traj, config_get_scalar("master/aversive/trajectories/angle/speed/init")));
-
-                trajectory_set_acc(&robot.traj,
-                                   1000 * acc_mm2imp(&robot.traj, config_get_scalar("master/aversive/trajectories/distance/acceleration/init")),
-                                   acc_rd2imp(&robot.traj, config_get_scalar("master/aversive/trajectories/angle/acceleration/init")));
-                break;
-
-            case BASE_SPEED_SLOW:
-                trajectory_set_speed(&robot.traj,
-                                     1000 * speed_mm2imp(&robot.traj, config_get_scalar("master/aversive/trajectories/distance/speed/slow")),
-                                     speed_rd2imp(&robot.traj, config_get_scalar("master/aversive/trajectories/angle/speed/slow")));
-
-                trajectory_set_acc(&robot.traj,
-                                   1000 * acc_mm2imp(&robot.traj, config_get_scalar("master/aversive/trajectories/distance/acceleration/slow")),
-                                   acc_rd2imp(&robot.traj, config_get_scalar("master/aversive/trajectories/angle/acceleration/slow")));
-                break;
-
-            case BASE_SPEED_FAST:
-                trajectory_set_speed(&robot.traj,
-                                     1000 * speed_mm2imp(&robot.traj, config_get_scalar("master/aversive/trajectories/distance/speed/fast")),
-                                     speed_rd2imp(&robot.traj, config_get_scalar("master/aversive/trajectories/angle/speed/fast")));
-                trajectory_set_acc(&robot.traj,
-                                   1000 * acc_mm2imp(&robot.traj, config_get_scalar("master/aversive/trajectories/distance/acceleration/fast")),
-                                   acc_rd2imp(&robot.traj, config_get_scalar("master/aversive/trajectories/angle/acceleration/fast")));
-                break;
-            default:
-                WARNING("Unknown speed type, going back to safe!");
-                robot.base_speed = BASE_SPEED_SLOW;
-                break;
-        }
+struct trajectory_config {
+    speed_config init, slow, fast;
+};
 
-        robot.lock.Unlock();
+struct odometry_config {
+    float left_wheel_correction_factor, right_wheel_correction_factor;
+    float external_track_mm, external_encoder_ticks_per_mm;
+};
 
-        /* Wait until next regulation loop */
-        std::this_thread::sleep_for(1000ms / ASSERV_FREQUENCY);
+static parameter_t* find_parameter(parameter_namespace_t* ns, const char* id)
+{
+    parameter_t* p = parameter_find(ns, id);
+    if (p == nullptr) {
+        ERROR("Unknown parameter \"%s\"", id);
     }
+    return p;
 }
 
-void base_controller_start()
+static void set_trajectory_speed(const speed_config& config)
 {
-    std::thread ctrl_thd(base_ctrl_thd);
-    ctrl_thd.detach();
+    trajectory_set_speed(&robot.traj,
+                         1000 * speed_mm2imp(&robot.traj, config.distance_speed),
+                         speed_rd2imp(&robot.traj, config.angle_speed));
+    trajectory_set_acc(&robot.traj,
+                       1000 * acc_mm2imp(&robot.traj, config.distance_acc),
+                       acc_rd2imp(&robot.traj, config.angle_acc));
 }
 
-static void position_manager_thd()
+static parameter_snapshot_t control_snapshot, trajectory_snapshot, odometry_snapshot;
+
+static struct {
+    base_control_config control;
+    trajectory_config trajectory;
+    odometry_config odometry;
+} loop_config;
+
+static void parameter_snapshots_init()
 {
-    while (true) {
-        {
-            absl::MutexLock _(&robot.lock);
-            position_manage(&robot.pos);
-            DEBUG_EVERY_N(ODOM_FREQUENCY, "pos: %d %d %d",
-                          position_get_x_s16(&robot.pos),
-                          position_get_y_s16(&robot.pos),
-                          position_get_a_deg_s16(&robot.pos));
-        }
-        std::this_thread::sleep_for(1000ms / ODOM_FREQUENCY);
+    parameter_namespace_t* control_params = parameter_namespace_find(&master_config, "aversive/control");
+    parameter_namespace_t* trajectory_params = parameter_namespace_find(&master_config, "aversive/trajectories");
+    parameter_namespace_t* odometry_params = parameter_namespace_find(&master_config, "odometry");
+
+    auto control = [control_params](const char* id) { return find_parameter(control_params, id); };
+    static const parameter_binding_t control_bindings[] = {
+        PARAMETER_BINDING(control("angle/kp"), base_control_config, angle.kp),
+        PARAMETER_BINDING(control("angle/ki"), base_control_config, angle.ki),
+        PARAMETER_BINDING(control("angle/kd"), base_control_config, angle.kd),
+        PARAMETER_BINDING(control("angle/i_limit"), base_control_config, angle.i_limit),
+        PARAMETER_BINDING(control("distance/kp"), base_control_config, distance.kp),
+        PARAMETER_BINDING(control("distance/ki"), base_control_config, distance.ki),
+        PARAMETER_BINDING(control("distance/kd"), base_control_config, distance.kd),
+        PARAMETER_BINDING(control("distance/i_limit"), base_control_config, distance.i_limit),
+    };
+
+    auto trajectory = [trajectory_params](const char* id) { return find_parameter(trajectory_params, id); };
+    static const parameter_binding_t trajectory_bindings[] = {
+        PARAMETER_BINDING(trajectory("distance/speed/init"), trajectory_config, init.distance_speed),
+        PARAMETER_BINDING(trajectory("angle/speed/init"), trajectory_config, init.angle_speed),
+        PARAMETER_BINDING(trajectory("distance/acceleration/init"), trajectory_config, init.distance_acc),
+        PARAMETER_BINDING(trajectory("angle/acceleration/init"), trajectory_config, init.angle_acc),
+        PARAMETER_BINDING(trajectory("distance/speed/slow"), trajectory_config, slow.distance_speed),
+        PARAMETER_BINDING(trajectory("angle/speed/slow"), trajectory_config, slow.angle_speed),
+        PARAMETER_BINDING(trajectory("distance/acceleration/slow"), trajectory_config, slow.distance_acc),
+        PARAMETER_BINDING(trajectory("angle/acceleration/slow"), trajectory_config, slow.angle_acc),
+        PARAMETER_BINDING(trajectory("distance/speed/fast"), trajectory_config, fast.distance_speed),
+        PARAMETER_BINDING(trajectory("angle/speed/fast"), trajectory_config, fast.angle_speed),
+        PARAMETER_BINDING(trajectory("distance/acceleration/fast"), trajectory_config, fast.distance_acc),
+        PARAMETER_BINDING(trajectory("angle/acceleration/fast"), trajectory_config, fast.angle_acc),
+    };
+
+    auto odometry = [odometry_params](const char* id) { return find_parameter(odometry_params, id); };
+    static const parameter_binding_t odometry_bindings[] = {
+        PARAMETER_BINDING(odometry("left_wheel_correction_factor"), odometry_config, left_wheel_correction_factor),
+        PARAMETER_BINDING(odometry("right_wheel_correction_factor"), odometry_config, right_wheel_correction_factor),
+        PARAMETER_BINDING(odometry("external_track_mm"), odometry_config, external_track_mm),
+        PARAMETER_BINDING(odometry("external_encoder_ticks_per_mm"), odometry_config, external_encoder_ticks_per_mm),
+    };
+
+    parameter_snapshot_init(&control_snapshot, control_params, control_bindings, sizeof(control_bindings) / sizeof(control_bindings[0]));
+    parameter_snapshot_init(&trajectory_snapshot, trajectory_params, trajectory_bindings, sizeof(trajectory_bindings) / sizeof(trajectory_bindings[0]));
+    parameter_snapshot_init(&odometry_snapshot, odometry_params, odometry_bindings, sizeof(odometry_bindings) / sizeof(odometry_bindings[0]));
+}
+
+static void pose_publish()
+{
+    RobotPosition pose;
+    {
+        absl::ReaderMutexLock _(&robot.pos.lock_);
+        pose.x = position_get_x_double_unsafe(&robot.pos);
+        pose.y = position_get_y_double_unsafe(&robot.pos);
+        pose.a = position_get_a_rad_double_unsafe(&robot.pos);
     }
+    messagebus_topic_publish(&pose_topic.topic, &pose, sizeof(pose));
+    pose_history_push(&pose_history, timestamp_get(), pose.x, pose.y, pose.a);
 }
 
-void position_manager_start()
+RobotPosition robot_pose_get()
 {
-    std::thread pos_thd(position_manager_thd);
-    pos_thd.detach();
+    RobotPosition pose = RobotPosition_init_default;
+    messagebus_topic_read(&pose_topic.topic, &pose, sizeof(pose));
+    return pose;
 }
 
-void trajectory_manager_thd()
+/* The position manager has its own lock. The robot system it reads is only
+ * updated by the control task, which runs in the same pipeline. */
+static void position_manager_tick()
 {
-    while (true) {
-        {
-            absl::MutexLock _(&robot.lock);
-            trajectory_manager_manage(&robot.traj);
+    position_manage(&robot.pos);
+    pose_publish();
+
+    DEBUG_EVERY_N(ODOM_FREQUENCY, "pos: %d %d %d",
+                  position_get_x_s16(&robot.pos),
+                  position_get_y_s16(&robot.pos),
+                  position_get_a_deg_s16(&robot.pos));
+}
+
+static void base_control_tick()
+{
+    absl::MutexLock _(&robot.control_lock);
+    rs_update(&robot.rs);
+
+    /* Control system manage */
+    if (robot.mode != BOARD_MODE_SET_PWM) {
+        if (robot.mode == BOARD_MODE_ANGLE_DISTANCE || robot.mode == BOARD_MODE_ANGLE_ONLY) {
+            cs_manage(&robot.angle_cs);
+        } else {
+            rs_set_angle(&robot.rs, 0); // Sets angle PWM to zero
+        }
+
+        if (robot.mode == BOARD_MODE_ANGLE_DISTANCE || robot.mode == BOARD_MODE_DISTANCE_ONLY) {
+            cs_manage(&robot.distance_cs);
+        } else {
+            rs_set_distance(&robot.rs, 0); // Sets distance PWM to zero
         }
-        std::this_thread::sleep_for(1000ms / ODOM_FREQUENCY);
     }
+
+    /* Blocking detection manage */
+    bd_manage(&robot.angle_bd, abs(cs_get_error(&robot.angle_cs)));
+    bd_manage(&robot.distance_bd, abs(cs_get_error(&robot.distance_cs)));
+
+    if (parameter_snapshot_update(&control_snapshot, &loop_config.control)) {
+        const auto& angle = loop_config.control.angle;
+        pid_set_gains(&robot.angle_pid.pid, angle.kp, angle.ki, angle.kd);
+        pid_set_integral_limit(&robot.angle_pid.pid, angle.i_limit);
+
+        const auto& distance = loop_config.control.distance;
+        pid_set_gains(&robot.distance_pid.pid, distance.kp, distance.ki, distance.kd);
+        pid_set_integral_limit(&robot.distance_pid.pid, distance.i_limit);
+    }
+    if (parameter_snapshot_update(&odometry_snapshot, &loop_config.odometry)) {
+        rs_set_left_ext_encoder(&robot.rs, rs_encoder_get_left_ext, nullptr,
+                                loop_config.odometry.left_wheel_correction_factor);
+        rs_set_right_ext_encoder(&robot.rs, rs_encoder_get_right_ext, nullptr,
+                                 loop_config.odometry.right_wheel_correction_factor);
+
+        position_set_physical_params(&robot.pos,
+                                     loop_config.odometry.external_track_mm,
+                                     loop_config.odometry.external_encoder_ticks_per_mm);
+    }
+
+    parameter_snapshot_update(&trajectory_snapshot, &loop_config.trajectory);
+    switch (robot.base_speed) {
+        case BASE_SPEED_INIT:
+            set_trajectory_speed(loop_config.trajectory.init);
+            break;
+
+        case BASE_SPEED_SLOW:
+            set_trajectory_speed(loop_config.trajectory.slow);
+            break;
+
+        case BASE_SPEED_FAST:
+            set_trajectory_speed(loop_config.trajectory.fast);
+            break;
+        default:
+            WARNING("Unknown speed type, going back to safe!");
+            robot.base_speed = BASE_SPEED_SLOW;
+            break;
+    }
+
+    motor_driver_uavcan_setpoints_ready();
+}
+
+/* The trajectory manager has its own lock, but it writes the consigns of the
+ * control systems. */
+static void trajectory_manager_tick()
+{
+    absl::MutexLock _(&robot.control_lock);
+    trajectory_manager_manage(&robot.traj);
 }
 
-void trajectory_manager_start()
+void base_controller_start(int realtime_priority, int cpu, virtual_clock_t* virtual_clock)
 {
-    std::thread traj_thd(trajectory_manager_thd);
-    traj_thd.detach();
+    static PeriodicExecutor executor("base", std::chrono::microseconds(1000000 / ASSERV_FREQUENCY));
+
+    parameter_snapshots_init();
+
+    pose_history_init(&pose_history);
+    pose_publish();
+    messagebus_advertise_topic(&bus, &pose_topic.topic, "/position");
+    messagebus_advertise_topic(&bus, &pose_history.topic, "/position/history");
+
+    executor.set_realtime_priority(realtime_priority);
+    executor.set_cpu(cpu);
+    if (virtual_clock) {
+        executor.use_virtual_clock(virtual_clock, VIRTUAL_CLOCK_ID_CONTROL);
+    }
+
+    /* Runs as a single pipeline so that control always uses the position
+     * computed in the same tick, and the trajectory the latest control state. */
+    executor.add_task("odometry", position_manager_tick);
+    executor.add_task("control", base_control_tick);
+    executor.add_task("trajectory", trajectory_manager_tick);
+    executor.start();
 }
@@ -2,6 +2,7 @@
 #define BASE_CONTROLLER_H
 
 #include <absl/synchronization/mutex.h>
+#include <virtual_clock/virtual_clock.h>
 
 #include <quadramp/quadramp.h>
 
@@ -12,6 +13,7 @@
 #include <aversive/trajectory_manager/trajectory_manager.h>
 
 #include "cs_port.h"
+#include "protobuf/position.pb.h"
 
 /** Frequency of the regulation loop and odometry loop (in Hz) */
 #define ASSERV_FREQUENCY 100
@@ -53,6 +55,11 @@ enum base_speed_t {
 
  This structure contains all vars that should be global. This is a clean way to
  group all vars in one place. It also serve as a namespace.
+
+ The position and trajectory managers have their own locks. The control
+ systems (robot system, control system managers, PIDs, quadramps and blocking
+ detection) are protected by control_lock. Threads which only need the robot
+ pose should use robot_pose_get() rather than taking any of those locks.
  */
 struct _robot {
     struct robot_system rs; // Robot system (angle & distance)
@@ -78,19 +85,30 @@ struct _robot {
     int opponent_size;
 
     uint32_t start_time; // Time since the beginning of the match, in microseconds
-    absl::Mutex lock;
+    absl::Mutex control_lock;
 };
 
 extern struct _robot robot;
 
 void robot_init(void);
-void robot_trajectory_windows_set_coarse(void);
-void robot_trajectory_windows_set_fine(void);
 
-void base_controller_start(void);
+/** Returns the last pose computed by the odometry (mm and rad).
+ *
+ * It is published at each control tick and can be read from any thread
+ * without waiting for the control loop, nor delaying it.
+ */
+RobotPosition robot_pose_get(void);
 
-void position_manager_start(void);
+void robot_trajectory_windows_set_coarse(void);
+void robot_trajectory_windows_set_fine(void);
 
-void trajectory_manager_start(void);
+/** Starts the odometry, control and trajectory pipeline.
+ *
+ * @param realtime_priority SCHED_FIFO priority of the thread, 0 for the
+ * default scheduler.
+ * @param cpu CPU to pin the thread to, -1 for any.
+ * @param virtual_clock Simulated time to run on, NULL for real time.
+ */
+void base_controller_start(int realtime_priority, int cpu, virtual_clock_t* virtual_clock);
 
 #endif /* BASE_CONTROLLER_H */
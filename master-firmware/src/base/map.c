@@ -42,6 +42,7 @@ void map_init(struct _map* map, int robot_size, bool enable_wall)
     if (enable_wall) {
         map->the_wall = oa_new_poly(&map->oa, 4);
         map_set_rectangular_obstacle(map->the_wall, 1500, 1450, 40, 200, robot_size);
+        oa_poly_set_static(&map->oa, map->the_wall);
     }
 
     /* Add the distributors ahead of the ramp */
@@ -49,10 +50,13 @@ void map_init(struct _map* map, int robot_size, bool enable_wall)
     map->distributor_obstacle[1] = oa_new_poly(&map->oa, 4);
     map_set_rectangular_obstacle_from_corners(map->distributor_obstacle[0], 450, 1543, 1050, 1578, robot_size);
     map_set_rectangular_obstacle_from_corners(map->distributor_obstacle[1], 1950, 1543, 2550, 1578, robot_size);
+    oa_poly_set_static(&map->oa, map->distributor_obstacle[0]);
+    oa_poly_set_static(&map->oa, map->distributor_obstacle[1]);
 
     /* Add ramp as obstacle */
     map->ramp_obstacle = oa_new_poly(&map->oa, 4);
     map_set_rectangular_obstacle_from_corners(map->ramp_obstacle, 450, 1578, 2550, 2000, robot_size);
+    oa_poly_set_static(&map->oa, map->ramp_obstacle);
 
     map->enable_opponent = true;
 }
@@ -11,7 +11,7 @@
 #include "base/base_controller.h"
 #include "base/map.h"
 #include "base/map_server.h"
-#include "robot_helpers/beacon_helpers.h"
+#include "base/opponent_tracking.h"
 #include "robot_helpers/trajectory_helpers.h"
 #include "strategy/state.h"
 
@@ -20,6 +20,9 @@
 
 #define MAP_SERVER_STACKSIZE 1024
 
+static_assert(OPPONENT_TRACKER_MAX_TRACKS == MAP_NUM_OPPONENT,
+              "Each tracked opponent needs an obstacle in the map");
+
 static struct {
     struct _map map;
     MUTEX_DECL(map_lock);
@@ -36,7 +39,9 @@ static THD_FUNCTION(map_server_thd, arg)
     bool enable_wall = config_get_boolean("master/is_main_robot");
     map_init(&map_data.map, robot_size, enable_wall);
 
-    BeaconSignal beacon_signal;
+    opponent_estimate_t opponents[OPPONENT_TRACKER_MAX_TRACKS];
+
+    /* Only watched to update the map, the beacon handler feeds the tracker */
     messagebus_topic_t* proximity_beacon_topic = messagebus_find_topic_blocking(&bus, "/proximity_beacon");
 
     AllyPosition ally_position;
@@ -68,17 +73,14 @@ static THD_FUNCTION(map_server_thd, arg)
         robot_size = config_get_integer("master/robot_size_x_mm");
         opponent_size = config_get_integer("master/opponent_size_x_mm_default");
 
-        /* Create obstacle at opponent position, only consider recent beacon signal */
-        if (messagebus_topic_read(proximity_beacon_topic, &beacon_signal, sizeof(beacon_signal))) {
-            if (timestamp_duration_s(beacon_signal.timestamp.us, timestamp_get()) < TRAJ_MAX_TIME_DELAY_OPPONENT_DETECTION) {
-                float x_opp, y_opp;
-                beacon_cartesian_convert(&robot.pos,
-                                         1000 * beacon_signal.range.range.distance,
-                                         beacon_signal.range.angle,
-                                         &x_opp, &y_opp);
-                map_update_opponent_obstacle(map, x_opp, y_opp, opponent_size * 1.25, robot_size);
+        /* Create obstacles where the opponents are now, tracks without recent
+         * beacon signal are dropped */
+        opponent_tracking_get(timestamp_get(), opponents);
+        for (int i = 0; i < OPPONENT_TRACKER_MAX_TRACKS; i++) {
+            if (opponents[i].valid) {
+                map_set_opponent_obstacle(map, i, opponents[i].x, opponents[i].y, opponent_size * 1.25, robot_size);
             } else {
-                map_update_opponent_obstacle(map, 0, 0, 0, 0); // reset opponent position
+                map_set_opponent_obstacle(map, i, 0, 0, 0, 0); // reset opponent position
             }
         }
 
@@ -0,0 +1,239 @@
+#include <math.h>
+#include <string.h>
+
+#include "opponent_tracker.h"
+
+/* Initial uncertainty on the speed of a new track [mm/s] */
+#define INITIAL_SPEED_STDDEV 1000.f
+
+void opponent_tracker_init(opponent_tracker_t* tracker)
+{
+    memset(tracker, 0, sizeof(opponent_tracker_t));
+
+    tracker->params.range_stddev = 100.f;
+    tracker->params.angle_stddev = 0.03f;
+    tracker->params.process_noise = 1e5f;
+    tracker->params.gate = 13.8f; /* 99.9% for 2 degrees of freedom */
+    tracker->params.confirmation_hits = 2;
+    tracker->params.timeout = 1.f;
+}
+
+/* Moves the state of a track forward in time, with a constant velocity
+ * model. Does nothing for times before the track state. */
+static void predict(const opponent_tracker_params_t* params, opponent_track_t* track, timestamp_t time)
+{
+    float dt = timestamp_duration_s(track->time, time);
+    if (dt <= 0) {
+        return;
+    }
+
+    float(*P)[4] = track->covariance;
+    float q = params->process_noise;
+
+    track->state[0] += dt * track->state[2];
+    track->state[1] += dt * track->state[3];
+
+    /* P = F P F' + Q, done by hand for F = [I dt*I; 0 I] */
+    for (int axis = 0; axis < 2; axis++) {
+        int p = axis, v = axis + 2;
+        for (int j = 0; j < 4; j++) {
+            P[p][j] += dt * P[v][j];
+        }
+        for (int i = 0; i < 4; i++) {
+            P[i][p] += dt * P[i][v];
+        }
+
+        P[p][p] += q * dt * dt * dt / 3;
+        P[p][v] += q * dt * dt / 2;
+        P[v][p] += q * dt * dt / 2;
+        P[v][v] += q * dt;
+    }
+
+    track->time = time;
+}
+
+static bool timed_out(const opponent_tracker_params_t* params, const opponent_track_t* track, timestamp_t now)
+{
+    return timestamp_duration_s(track->last_update, now) > params->timeout;
+}
+
+/* Position measurement and its covariance, from a range and bearing */
+static void measurement_position(const opponent_tracker_params_t* params,
+                                 float robot_x, float robot_y, float robot_a,
+                                 float distance, float angle,
+                                 float z[2], float R[2][2])
+{
+    float heading = robot_a + angle;
+    float c = cosf(heading), s = sinf(heading);
+    float var_r = params->range_stddev * params->range_stddev;
+    float var_t = distance * distance * params->angle_stddev * params->angle_stddev;
+
+    z[0] = robot_x + distance * c;
+    z[1] = robot_y + distance * s;
+
+    /* J diag(var_r, var_a) J', J being the jacobian of the conversion */
+    R[0][0] = c * c * var_r + s * s * var_t;
+    R[1][1] = s * s * var_r + c * c * var_t;
+    R[0][1] = R[1][0] = c * s * (var_r - var_t);
+}
+
+/* Innovation of a measurement and the inverse of its covariance */
+static float mahalanobis(const opponent_track_t* track, const float z[2], float R[2][2], float y[2], float S_inv[2][2])
+{
+    const float(*P)[4] = track->covariance;
+
+    y[0] = z[0] - track->state[0];
+    y[1] = z[1] - track->state[1];
+
+    float S[2][2] = {
+        {P[0][0] + R[0][0], P[0][1] + R[0][1]},
+        {P[1][0] + R[1][0], P[1][1] + R[1][1]},
+    };
+    float det = S[0][0] * S[1][1] - S[0][1] * S[1][0];
+
+    S_inv[0][0] = S[1][1] / det;
+    S_inv[1][1] = S[0][0] / det;
+    S_inv[0][1] = -S[0][1] / det;
+    S_inv[1][0] = -S[1][0] / det;
+
+    return y[0] * (S_inv[0][0] * y[0] + S_inv[0][1] * y[1])
+        + y[1] * (S_inv[1][0] * y[0] + S_inv[1][1] * y[1]);
+}
+
+static void update(opponent_track_t* track, const float y[2], float S_inv[2][2])
+{
+    float(*P)[4] = track->covariance;
+    float K[4][2];
+
+    /* K = P H' S^-1, H selecting the position */
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 2; j++) {
+            K[i][j] = P[i][0] * S_inv[0][j] + P[i][1] * S_inv[1][j];
+        }
+    }
+
+    for (int i = 0; i < 4; i++) {
+        track->state[i] += K[i][0] * y[0] + K[i][1] * y[1];
+    }
+
+    /* P = (I - K H) P */
+    float HP[2][4];
+    memcpy(HP[0], P[0], sizeof(HP[0]));
+    memcpy(HP[1], P[1], sizeof(HP[1]));
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            P[i][j] -= K[i][0] * HP[0][j] + K[i][1] * HP[1][j];
+        }
+    }
+
+    /* Keeps it symmetric despite rounding errors */
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < i; j++) {
+            P[i][j] = P[j][i] = (P[i][j] + P[j][i]) / 2;
+        }
+    }
+}
+
+static void start_track(opponent_track_t* track, timestamp_t timestamp, const float z[2], float R[2][2])
+{
+    memset(track, 0, sizeof(opponent_track_t));
+
+    track->active = true;
+    track->time = timestamp;
+    track->last_update = timestamp;
+    track->hits = 1;
+
+    track->state[0] = z[0];
+    track->state[1] = z[1];
+
+    track->covariance[0][0] = R[0][0];
+    track->covariance[0][1] = R[0][1];
+    track->covariance[1][0] = R[1][0];
+    track->covariance[1][1] = R[1][1];
+    track->covariance[2][2] = INITIAL_SPEED_STDDEV * INITIAL_SPEED_STDDEV;
+    track->covariance[3][3] = INITIAL_SPEED_STDDEV * INITIAL_SPEED_STDDEV;
+}
+
+int opponent_tracker_add_measurement(opponent_tracker_t* tracker,
+                                     timestamp_t timestamp,
+                                     float robot_x,
+                                     float robot_y,
+                                     float robot_a,
+                                     float distance,
+                                     float angle)
+{
+    const opponent_tracker_params_t* params = &tracker->params;
+    float z[2], R[2][2];
+    float y[2], S_inv[2][2];
+
+    measurement_position(params, robot_x, robot_y, robot_a, distance, angle, z, R);
+
+    int best = -1;
+    float best_distance = params->gate;
+
+    for (int i = 0; i < OPPONENT_TRACKER_MAX_TRACKS; i++) {
+        opponent_track_t* track = &tracker->tracks[i];
+
+        if (track->active && timed_out(params, track, timestamp)) {
+            track->active = false;
+        }
+        if (!track->active) {
+            continue;
+        }
+
+        predict(params, track, timestamp);
+
+        float d = mahalanobis(track, z, R, y, S_inv);
+        if (d < best_distance) {
+            best_distance = d;
+            best = i;
+        }
+    }
+
+    if (best >= 0) {
+        opponent_track_t* track = &tracker->tracks[best];
+        mahalanobis(track, z, R, y, S_inv);
+        update(track, y, S_inv);
+        track->last_update = timestamp;
+        track->hits++;
+        return best;
+    }
+
+    /* Something new, or an outlier which will time out */
+    for (int i = 0; i < OPPONENT_TRACKER_MAX_TRACKS; i++) {
+        if (!tracker->tracks[i].active) {
+            start_track(&tracker->tracks[i], timestamp, z, R);
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void opponent_tracker_get(opponent_tracker_t* tracker,
+                          timestamp_t now,
+                          opponent_estimate_t estimates[OPPONENT_TRACKER_MAX_TRACKS])
+{
+    const opponent_tracker_params_t* params = &tracker->params;
+
+    for (int i = 0; i < OPPONENT_TRACKER_MAX_TRACKS; i++) {
+        /* The tracks keep the time of their last measurement */
+        opponent_track_t track = tracker->tracks[i];
+        opponent_estimate_t* estimate = &estimates[i];
+
+        memset(estimate, 0, sizeof(opponent_estimate_t));
+
+        if (!track.active || track.hits < params->confirmation_hits || timed_out(params, &track, now)) {
+            continue;
+        }
+
+        predict(params, &track, now);
+
+        estimate->valid = true;
+        estimate->x = track.state[0];
+        estimate->y = track.state[1];
+        estimate->vx = track.state[2];
+        estimate->vy = track.state[3];
+        estimate->position_stddev = sqrtf((track.covariance[0][0] + track.covariance[1][1]) / 2);
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef OPPONENT_TRACKER_H
+#define OPPONENT_TRACKER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <timestamp/timestamp.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Number of opponents tracked, same as MAP_NUM_OPPONENT */
+#define OPPONENT_TRACKER_MAX_TRACKS 2
+
+typedef struct {
+    float range_stddev; // [mm]
+    float angle_stddev; // [rad]
+
+    /** Spectral density of the opponent acceleration [mm^2/s^3] */
+    float process_noise;
+
+    /** Squared Mahalanobis distance under which a measurement belongs to a
+     * track */
+    float gate;
+
+    /** Measurements needed before a track is reported */
+    int confirmation_hits;
+
+    /** Tracks without measurements for that long are dropped [s] */
+    float timeout;
+} opponent_tracker_params_t;
+
+typedef struct {
+    bool active;
+    timestamp_t time; // of the state
+    timestamp_t last_update;
+    int hits;
+
+    /* x, y [mm], vx, vy [mm/s] and their covariance */
+    float state[4];
+    float covariance[4][4];
+} opponent_track_t;
+
+typedef struct {
+    opponent_tracker_params_t params;
+    opponent_track_t tracks[OPPONENT_TRACKER_MAX_TRACKS];
+} opponent_tracker_t;
+
+typedef struct {
+    bool valid;
+    float x, y; // [mm]
+    float vx, vy; // [mm/s]
+    float position_stddev; // [mm]
+} opponent_estimate_t;
+
+/** Tracks the opponents seen by the beacon, with a constant velocity Kalman
+ * filter per opponent.
+ *
+ * Each measurement goes to the closest track (in Mahalanobis distance) if it
+ * is within the gate, or starts a new track in a free slot otherwise.
+ *
+ * Initializes the tracker with default parameters, which can then be changed
+ * in tracker->params.
+ */
+void opponent_tracker_init(opponent_tracker_t* tracker);
+
+/** Adds a beacon measurement, taken at the given time from the given robot
+ * pose (mm and rad).
+ *
+ * @param [in] distance Distance to the opponent [mm].
+ * @param [in] angle Angle of the opponent relative to the robot heading [rad].
+ *
+ * @returns The index of the track it was associated with, or -1 if it was
+ * dropped.
+ */
+int opponent_tracker_add_measurement(opponent_tracker_t* tracker,
+                                     timestamp_t timestamp,
+                                     float robot_x,
+                                     float robot_y,
+                                     float robot_a,
+                                     float distance,
+                                     float angle);
+
+/** Predicts where the confirmed opponents are at the given time.
+ *
+ * @param [out] estimates One per track, valid if the track is confirmed and
+ * did not time out.
+ */
+void opponent_tracker_get(opponent_tracker_t* tracker,
+                          timestamp_t now,
+                          opponent_estimate_t estimates[OPPONENT_TRACKER_MAX_TRACKS]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OPPONENT_TRACKER_H */
@@ -0,0 +1,30 @@
+#include <mutex>
+
+#include "opponent_tracking.h"
+
+static std::mutex lock;
+static opponent_tracker_t tracker;
+
+void opponent_tracking_init(float timeout)
+{
+    std::lock_guard<std::mutex> l(lock);
+    opponent_tracker_init(&tracker);
+    tracker.params.timeout = timeout;
+}
+
+void opponent_tracking_add_measurement(timestamp_t timestamp,
+                                       float robot_x,
+                                       float robot_y,
+                                       float robot_a,
+                                       float distance,
+                                       float angle)
+{
+    std::lock_guard<std::mutex> l(lock);
+    opponent_tracker_add_measurement(&tracker, timestamp, robot_x, robot_y, robot_a, distance, angle);
+}
+
+void opponent_tracking_get(timestamp_t now, opponent_estimate_t estimates[OPPONENT_TRACKER_MAX_TRACKS])
+{
+    std::lock_guard<std::mutex> l(lock);
+    opponent_tracker_get(&tracker, now, estimates);
+}
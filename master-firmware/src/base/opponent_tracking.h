@@ -0,0 +1,39 @@
+#ifndef OPPONENT_TRACKING_H
+#define OPPONENT_TRACKING_H
+
+#include "base/opponent_tracker.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Opponent tracker shared by the beacon handler, which feeds it, and its
+ * users (trajectory checks, map server). All functions are thread-safe.
+ *
+ * Measurements are added from the thread receiving them rather than from a
+ * dedicated thread, so that in lockstep simulation (see --virtual_clock) they
+ * are processed at a deterministic point in time.
+ */
+
+/** Forgets all tracks and sets the default parameters, except for the time
+ * after which tracks without measurements are dropped [s]. */
+void opponent_tracking_init(float timeout);
+
+/** Adds a beacon measurement taken at the given time, from the robot pose
+ * (mm and rad) at that time, see opponent_tracker_add_measurement(). */
+void opponent_tracking_add_measurement(timestamp_t timestamp,
+                                       float robot_x,
+                                       float robot_y,
+                                       float robot_a,
+                                       float distance,
+                                       float angle);
+
+/** Predicts where the opponents are at the given time, see
+ * opponent_tracker_get(). */
+void opponent_tracking_get(timestamp_t now, opponent_estimate_t estimates[OPPONENT_TRACKER_MAX_TRACKS]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OPPONENT_TRACKING_H */
@@ -0,0 +1,88 @@
+#include <math.h>
+#include <string.h>
+
+#include "pose_history.h"
+
+void pose_history_init(pose_history_t* history)
+{
+    memset(history, 0, sizeof(pose_history_t));
+    pthread_mutex_init(&history->sync.mutex, NULL);
+    pthread_cond_init(&history->sync.cond, NULL);
+    messagebus_topic_init_history(&history->topic, &history->sync, &history->sync,
+                                  history->entries, sizeof(pose_history_entry_t),
+                                  POSE_HISTORY_SIZE);
+}
+
+void pose_history_push(pose_history_t* history, timestamp_t timestamp, float x, float y, float a)
+{
+    pose_history_entry_t pose = {timestamp, x, y, a};
+    messagebus_topic_publish(&history->topic, &pose, sizeof(pose));
+}
+
+void pose_history_reader_init(pose_history_reader_t* reader, messagebus_topic_t* topic)
+{
+    messagebus_cursor_init(&reader->cursor, topic);
+    reader->count = 0;
+}
+
+static const pose_history_entry_t* reader_pose(pose_history_reader_t* reader, uint32_t index)
+{
+    return &reader->entries[index % POSE_HISTORY_SIZE];
+}
+
+static void interpolate(const pose_history_entry_t* older,
+                        const pose_history_entry_t* newer,
+                        timestamp_t timestamp,
+                        pose_history_entry_t* pose)
+{
+    int32_t span = timestamp_duration_us(older->timestamp, newer->timestamp);
+    float f = 0.f;
+    if (span > 0) {
+        f = timestamp_duration_us(older->timestamp, timestamp) / (float)span;
+    }
+
+    /* Turn by the shortest way */
+    float da = remainderf(newer->a - older->a, 2 * M_PI);
+
+    pose->timestamp = timestamp;
+    pose->x = older->x + f * (newer->x - older->x);
+    pose->y = older->y + f * (newer->y - older->y);
+    pose->a = remainderf(older->a + f * da, 2 * M_PI);
+}
+
+bool pose_history_get(pose_history_reader_t* reader, timestamp_t timestamp, pose_history_entry_t* pose)
+{
+    /* Copies the poses published since the last call. If the reader fell
+     * behind, the cursor skips those which were overwritten, and so does the
+     * local copy, which has the same size. */
+    pose_history_entry_t* slot = &reader->entries[reader->count % POSE_HISTORY_SIZE];
+    while (messagebus_cursor_read(&reader->cursor, slot, sizeof(pose_history_entry_t))) {
+        reader->count++;
+        slot = &reader->entries[reader->count % POSE_HISTORY_SIZE];
+    }
+
+    uint32_t count = reader->count;
+    if (count == 0) {
+        return false;
+    }
+
+    const pose_history_entry_t* newer = reader_pose(reader, count - 1);
+    if (timestamp_duration_us(newer->timestamp, timestamp) >= 0) {
+        *pose = *newer;
+        return true;
+    }
+
+    /* Goes back in time until the pose before the requested time */
+    for (uint32_t n = 2; n <= count && n <= POSE_HISTORY_SIZE; n++) {
+        const pose_history_entry_t* older = reader_pose(reader, count - n);
+
+        if (timestamp_duration_us(older->timestamp, timestamp) >= 0) {
+            interpolate(older, newer, timestamp, pose);
+            return true;
+        }
+
+        newer = older;
+    }
+
+    return false;
+}
@@ -0,0 +1,68 @@
+#ifndef POSE_HISTORY_H
+#define POSE_HISTORY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <timestamp/timestamp.h>
+#include <msgbus/messagebus.h>
+#include <msgbus/posix/port.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Number of poses kept, 1.28s at the odometry frequency */
+#define POSE_HISTORY_SIZE 128
+
+typedef struct {
+    timestamp_t timestamp;
+    float x, y; // [mm]
+    float a; // [rad]
+} pose_history_entry_t;
+
+/** History topic of the last poses computed by the odometry, to know where
+ * the robot was when a sensor took a measurement.
+ *
+ * See messagebus_topic_init_history(): the odometry publishes each pose, and
+ * readers go through them with a cursor.
+ */
+typedef struct {
+    messagebus_topic_t topic;
+    condvar_wrapper_t sync;
+    pose_history_entry_t entries[POSE_HISTORY_SIZE];
+} pose_history_t;
+
+/** Poses read from a pose history by one reader, which keeps its own copy so
+ * that it can search them without holding the topic lock.
+ *
+ * A reader must only be used by a single thread.
+ */
+typedef struct {
+    messagebus_cursor_t cursor;
+    pose_history_entry_t entries[POSE_HISTORY_SIZE];
+
+    /* Number of poses read so far */
+    uint32_t count;
+} pose_history_reader_t;
+
+void pose_history_init(pose_history_t* history);
+
+/** Adds the latest pose. Timestamps must be increasing. */
+void pose_history_push(pose_history_t* history, timestamp_t timestamp, float x, float y, float a);
+
+/** Starts reading the given topic, created by pose_history_init(). Only the
+ * poses published from now on will be known to the reader. */
+void pose_history_reader_init(pose_history_reader_t* reader, messagebus_topic_t* topic);
+
+/** Gets the pose of the robot at the given time, interpolated between the two
+ * closest poses. A time after the latest pose gives the latest pose.
+ *
+ * @returns false if the history is empty or does not go back that far.
+ */
+bool pose_history_get(pose_history_reader_t* reader, timestamp_t timestamp, pose_history_entry_t* pose);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POSE_HISTORY_H */
@@ -6,6 +6,9 @@
 
 #define MAX_MOTOR_VOLTAGE_SCALE 1000.f
 
+/* Read twice per control tick, so its hash is computed at compile time */
+static constexpr messagebus::TopicId encoders_topic_id{"/encoders"};
+
 uint32_t left_encoder_prev, right_encoder_prev;
 int32_t left_encoder_value, right_encoder_value;
 
@@ -39,14 +42,14 @@ void rs_right_wheel_set_voltage(void* motor, int32_t voltage)
 static WheelEncodersPulse read_encoders_topic(void)
 {
     WheelEncodersPulse msg = WheelEncodersPulse_init_zero;
-    messagebus_topic_t* topic = messagebus_find_topic(&bus, "/encoders");
+    auto topic = messagebus::find_topic<WheelEncodersPulse>(bus, encoders_topic_id);
 
-    if (topic == NULL) {
+    if (!topic) {
         WARNING_EVERY_N(1000, "Could not find encoders topic");
         return msg;
     }
 
-    if (!messagebus_topic_read(topic, &msg, sizeof(msg))) {
+    if (!topic.read(msg)) {
         WARNING_EVERY_N(1000, "no encoders message received");
     }
 
@@ -1,8 +1,9 @@
 #pragma once
 
+#include <algorithm>
+#include <iterator>
 #include <memory>
 #include <absl/strings/string_view.h>
-#include <absl/types/optional.h>
 #include <unordered_map>
 #include <can/bus_enumerator.h>
 #include <msgbus/messagebus.h>
@@ -20,17 +21,22 @@
 // It is templated over the types of the messages (both on the UAVCAN side, as
 // well as on the messagebus side), as well as some metadata required for
 // protobuf.
+//
+// Topics are resolved once per source node and cached in a table indexed by
+// node ID, so forwarding a message does not allocate nor look up strings. The
+// table is flushed whenever the bus enumerator mapping changes, as a node ID
+// can be reassigned to another board.
 template <
     typename UavcanMessage,
     typename TopicMessage,
     const pb_field_t TopicFields[],
     uint32_t TopicMsgId>
 class UavcanToMessagebusProxy {
+    // UAVCAN node IDs are 7 bits
+    static constexpr int MAX_NODE_ID = 128;
+
     struct TopicData {
-        // we store a pointer to data, as TopicData itself might be moved as we
-        // add more topics, but we do not want to move the data buffer, as it
-        // is also referenced in other places
-        std::unique_ptr<TopicMessage> data;
+        TopicMessage data;
         condvar_wrapper_t var;
         messagebus_topic_t topic;
     };
@@ -41,7 +47,20 @@ class UavcanToMessagebusProxy {
     topic_metadata_t metadata;
 
     std::unique_ptr<uavcan::Subscriber<UavcanMessage>> subscriber;
-    std::unordered_map<std::string, TopicData> topic_map;
+    // Owns the topics. Several nodes might map to the same topic name, and
+    // the topic must not move once it is advertised, hence the unique_ptr.
+    std::unordered_map<std::string, std::unique_ptr<TopicData>> topic_map;
+
+    // Topic of each source node, nullptr until the first message of a known
+    // board is received.
+    messagebus_topic_t* topic_by_node[MAX_NODE_ID] = {};
+
+    // Generation of the bus enumerator that topic_by_node was resolved with
+    uint32_t enumerator_generation = 0;
+
+    // Translated message, published from there. It cannot be written in the
+    // topic buffer directly, as readers might be copying it at the same time.
+    TopicMessage translated;
 
 public:
     // Constructor. Takes a bus enumerator that will be used to gather the
@@ -62,10 +81,11 @@ public:
     // This must be implemented by users of this class.
     virtual std::string topic_name(absl::string_view board_name) = 0;
 
-    // Returns the message translated to messagebus format, or empty if the
-    // message should not be forwarded to the bus.
-    // This must be implemented by users of this class.
-    virtual absl::optional<TopicMessage> translate(const UavcanMessage& in) = 0;
+    // Writes the message translated to messagebus format in out. Returns false
+    // if the message should not be forwarded to the bus.
+    // This must be implemented by users of this class, and must not allocate
+    // as it runs for every received message.
+    virtual bool translate(const UavcanMessage& in, TopicMessage& out) = 0;
 
     // Starts a listener for the provided UAVCAN type on the node, and starts
     // forwarding messages.
@@ -84,22 +104,34 @@ public:
 protected:
     void process(const UavcanMessage& msg, uint8_t src_id)
     {
-        // Finds out the name of the sender from the bus enumerator and abors
-        // if that sender is not known yet.
-        const char* board_name = bus_enumerator_get_str_id(bus_enumerator, src_id);
-
-        if (!board_name) {
-            // TODO(antoinealb): Maybe we want to log that failure
+        if (src_id >= MAX_NODE_ID) {
             return;
         }
 
-        messagebus_topic_t* topic = find_or_create_topic(topic_name(board_name));
+        if (bus_enumerator->generation != enumerator_generation) {
+            std::fill(std::begin(topic_by_node), std::end(topic_by_node), nullptr);
+            enumerator_generation = bus_enumerator->generation;
+        }
+
+        messagebus_topic_t* topic = topic_by_node[src_id];
+
+        if (!topic) {
+            // Finds out the name of the sender from the bus enumerator and
+            // aborts if that sender is not known yet.
+            const char* board_name = bus_enumerator_get_str_id(bus_enumerator, src_id);
+
+            if (!board_name) {
+                // TODO(antoinealb): Maybe we want to log that failure
+                return;
+            }
+
+            topic = find_or_create_topic(topic_name(board_name));
+            topic_by_node[src_id] = topic;
+        }
 
         // Sends the message to messagebus if the user was able to translate it
-        auto topic_msg_opt = translate(msg);
-        if (topic_msg_opt) {
-            messagebus_topic_publish(topic, &(*topic_msg_opt),
-                                     sizeof(TopicMessage));
+        if (translate(msg, translated)) {
+            messagebus_topic_publish(topic, &translated, sizeof(TopicMessage));
         }
     }
 
@@ -107,20 +139,18 @@ protected:
     {
         auto elem = topic_map.find(topic_name);
         if (elem != topic_map.end()) {
-            return &elem->second.topic;
+            return &elem->second->topic;
         }
 
         // Otherwise create it from scratch and store it in the map
-        topic_map.insert({topic_name, TopicData()});
-        topic_map[topic_name].data = std::make_unique<TopicMessage>();
+        auto& topic = topic_map[topic_name];
+        topic = std::make_unique<TopicData>();
 
-        messagebus_topic_init(&topic_map[topic_name].topic,
-                              &topic_map[topic_name].var,
-                              &topic_map[topic_name].var,
-                              topic_map[topic_name].data.get(), sizeof(TopicMessage));
-        topic_map[topic_name].topic.metadata = &metadata;
-        messagebus_advertise_topic(msgbus, &topic_map[topic_name].topic, topic_name.c_str());
+        messagebus_topic_init(&topic->topic, &topic->var, &topic->var,
+                              &topic->data, sizeof(TopicMessage));
+        topic->topic.metadata = &metadata;
+        messagebus_advertise_topic(msgbus, &topic->topic, topic_name.c_str());
 
-        return &topic_map[topic_name].topic;
+        return &topic->topic;
     }
 };
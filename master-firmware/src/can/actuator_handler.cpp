@@ -28,15 +28,13 @@ struct ActuatorFeedbackProxy : public ProxyBase {
         return absl::StrReplaceAll(board_name, {{"actuator-", "/actuator/"}});
     }
 
-    absl::optional<ActuatorFeedback> translate(const Feedback& msg) override
+    bool translate(const Feedback& msg, ActuatorFeedback& feedback) override
     {
-        ActuatorFeedback feedback;
-
         feedback.pressure[0] = msg.pressure[0];
         feedback.pressure[1] = msg.pressure[1];
         feedback.digital_input = msg.digital_input;
 
-        return feedback;
+        return true;
     }
 };
 
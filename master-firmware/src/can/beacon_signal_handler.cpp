@@ -5,10 +5,43 @@
 
 #include "main.h"
 #include "config.h"
+#include "base/base_controller.h"
+#include "base/opponent_tracking.h"
+#include "base/pose_history.h"
 #include "robot_helpers/beacon_helpers.h"
 #include "protobuf/beacons.pb.h"
 
-static TOPIC_DECL(proximity_beacon_topic, BeaconSignal);
+static TOPIC_DECL_SEQLOCK(proximity_beacon_topic, BeaconSignal);
+
+static constexpr messagebus::TopicId pose_history_topic_id{"/position/history"};
+
+/** Gets the pose the robot had when the beacon took a measurement, from the
+ * poses published by the odometry since the first call. */
+static bool robot_pose_at(timestamp_t timestamp, RobotPosition* pose)
+{
+    static pose_history_reader_t history;
+    static bool history_found = false;
+
+    if (!history_found) {
+        messagebus_topic_t* topic = messagebus_find_topic_by_hash(&bus, pose_history_topic_id.hash,
+                                                                  pose_history_topic_id.name);
+        if (topic == NULL) {
+            return false;
+        }
+        pose_history_reader_init(&history, topic);
+        history_found = true;
+    }
+
+    pose_history_entry_t entry;
+    if (!pose_history_get(&history, timestamp, &entry)) {
+        return false;
+    }
+
+    pose->x = entry.x;
+    pose->y = entry.y;
+    pose->a = entry.a;
+    return true;
+}
 
 static void beacon_cb(const uavcan::ReceivedDataStructure<cvra::proximity_beacon::Signal>& msg)
 {
@@ -29,14 +62,21 @@ static void beacon_cb(const uavcan::ReceivedDataStructure<cvra::proximity_beacon
 
     BeaconSignal data;
 
-    // TODO: replace this once the timestamp module is ported
-    data.timestamp.us = 0;
+    data.timestamp.us = timestamp_get();
     data.range.range.distance = reflector_radius / tanf(msg.length / 2.);
     data.range.range.type = Range_RangeType_OTHER;
     data.range.angle = beacon_get_angle(msg.start_angle + angular_offset, msg.length);
 
     messagebus_topic_publish(&proximity_beacon_topic.topic, &data, sizeof(data));
 
+    /* Track the opponent, using where the robot was when the beacon saw it */
+    RobotPosition pose;
+    if (!robot_pose_at(data.timestamp.us, &pose)) {
+        pose = robot_pose_get();
+    }
+    opponent_tracking_add_measurement(data.timestamp.us, pose.x, pose.y, pose.a,
+                                      1000 * data.range.range.distance, data.range.angle);
+
     DEBUG("Opponent detected at: %.3fm, %.3frad \traw signal: %.3f, %.3f",
           data.range.range.distance,
           data.range.angle, msg.start_angle, msg.length);
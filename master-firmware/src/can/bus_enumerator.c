@@ -58,6 +58,7 @@ void bus_enumerator_init(bus_enumerator_t* en,
     en->buffer_len = buffer_len;
     en->nb_entries_str_to_can = 0;
     en->nb_entries_can_to_str = 0;
+    en->generation = 0;
 }
 
 void bus_enumerator_add_node(bus_enumerator_t* en, const char* str_id, void* driver)
@@ -119,6 +120,29 @@ void bus_enumerator_update_node_info(bus_enumerator_t* en, const char* str_id, u
                sizeof(bus_enumerator_entry_t));
 
         en->nb_entries_can_to_str++;
+        en->generation++;
+    }
+}
+
+void bus_enumerator_remove_can_id(bus_enumerator_t* en, uint8_t can_id)
+{
+    uint16_t index;
+
+    index = index_by_can_id(en, can_id);
+
+    if (index != BUS_ENUMERATOR_INDEX_NOT_FOUND) {
+        // the string ID is not known anymore on this CAN ID
+        uint16_t str_index = index_by_str_id(en, en->can_to_str[index].str_id);
+        if (str_index != BUS_ENUMERATOR_INDEX_NOT_FOUND) {
+            en->str_to_can[str_index].can_id = BUS_ENUMERATOR_CAN_ID_NOT_SET;
+        }
+
+        memmove(&en->can_to_str[index],
+                &en->can_to_str[index + 1],
+                (en->nb_entries_can_to_str - index - 1) * sizeof(bus_enumerator_entry_t));
+
+        en->nb_entries_can_to_str--;
+        en->generation++;
     }
 }
 
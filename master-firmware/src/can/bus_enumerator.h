@@ -44,6 +44,9 @@ typedef struct {
     uint16_t buffer_len;
     uint16_t nb_entries_str_to_can;
     uint16_t nb_entries_can_to_str;
+    // incremented every time the CAN ID <-> string ID mapping changes, so
+    // that users caching it know when to look it up again
+    uint32_t generation;
 } bus_enumerator_t;
 
 void bus_enumerator_init(bus_enumerator_t* en,
@@ -56,6 +59,14 @@ void bus_enumerator_add_node(bus_enumerator_t* en, const char* str_id, void* dri
 // called by the CAN driver
 void bus_enumerator_update_node_info(bus_enumerator_t* en, const char* str_id, uint8_t can_id);
 
+/** Forgets the node using the given CAN ID.
+ *
+ * This is used when a CAN ID is reassigned to another board, for example by
+ * dynamic node ID allocation. The string ID stays known, and can be given a
+ * new CAN ID with bus_enumerator_update_node_info().
+ */
+void bus_enumerator_remove_can_id(bus_enumerator_t* en, uint8_t can_id);
+
 /** Returns the total number of nodes.
  *
  * This function returns the total number of nodes, i.e. the number of time
@@ -29,6 +29,9 @@ void motor_driver_init(motor_driver_t* d,
     d->can_id = CAN_ID_NOT_SET;
 
     d->control_mode = MOTOR_CONTROL_MODE_DISABLED;
+    d->trajectory.head = 0;
+    d->trajectory.count = 0;
+    d->trajectory.has_last = false;
 
     d->can_driver = NULL;
 
@@ -108,6 +111,81 @@ void motor_driver_disable(motor_driver_t* d)
     motor_driver_unlock(d);
 }
 
+bool motor_driver_push_trajectory_segment(motor_driver_t* d,
+                                          const motor_trajectory_segment_t* segment)
+{
+    bool success = false;
+    motor_driver_lock(d);
+    if (d->control_mode != MOTOR_CONTROL_MODE_TRAJECTORY) {
+        d->control_mode = MOTOR_CONTROL_MODE_TRAJECTORY;
+        d->trajectory.head = 0;
+        d->trajectory.count = 0;
+        d->trajectory.has_last = false;
+    }
+
+    if (d->trajectory.count < MOTOR_TRAJECTORY_QUEUE_LEN) {
+        unsigned int index = (d->trajectory.head + d->trajectory.count) % MOTOR_TRAJECTORY_QUEUE_LEN;
+        d->trajectory.segments[index] = *segment;
+        d->trajectory.count++;
+        success = true;
+    }
+    motor_driver_unlock(d);
+
+    return success;
+}
+
+bool motor_driver_pop_trajectory_segment(motor_driver_t* d,
+                                         motor_trajectory_segment_t* segment)
+{
+    if (d->control_mode != MOTOR_CONTROL_MODE_TRAJECTORY || d->trajectory.count == 0) {
+        return false;
+    }
+
+    *segment = d->trajectory.segments[d->trajectory.head];
+    d->trajectory.head = (d->trajectory.head + 1) % MOTOR_TRAJECTORY_QUEUE_LEN;
+    d->trajectory.count--;
+    d->trajectory.last = *segment;
+    d->trajectory.has_last = true;
+    return true;
+}
+
+bool motor_driver_get_last_trajectory_segment(motor_driver_t* d,
+                                              uint32_t now,
+                                              motor_trajectory_segment_t* segment)
+{
+    if (d->control_mode != MOTOR_CONTROL_MODE_TRAJECTORY || !d->trajectory.has_last) {
+        return false;
+    }
+
+    // difference modulo 2^32, so that it works across timestamp overflows
+    int32_t elapsed = (int32_t)(now - d->trajectory.last.start);
+    if (elapsed > (int32_t)d->trajectory.last.duration) {
+        return false;
+    }
+
+    *segment = d->trajectory.last;
+    return true;
+}
+
+void motor_trajectory_segment_hermite(motor_trajectory_segment_t* segment,
+                                      uint32_t start,
+                                      uint32_t duration,
+                                      float p0,
+                                      float v0,
+                                      float p1,
+                                      float v1)
+{
+    float T = duration / 1e6f;
+
+    segment->start = start;
+    segment->duration = duration;
+    segment->coeffs[0] = p0;
+    segment->coeffs[1] = v0;
+    segment->coeffs[2] = (3 * (p1 - p0) - (2 * v0 + v1) * T) / (T * T);
+    segment->coeffs[3] = (2 * (p0 - p1) + (v0 + v1) * T) / (T * T * T);
+    segment->torque = 0;
+}
+
 void motor_driver_set_can_id(motor_driver_t* d, int can_id)
 {
     d->can_id = can_id;
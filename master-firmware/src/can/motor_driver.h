@@ -3,6 +3,8 @@
 
 #include <parameter/parameter.h>
 #include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
 
 #define MOTOR_ID_MAX_LEN 24
 #define MOTOR_ID_MAX_LEN_WITH_NUL (MOTOR_ID_MAX_LEN + 1) // terminated C string buffer
@@ -12,6 +14,9 @@
 #define MOTOR_CONTROL_MODE_VELOCITY 2
 #define MOTOR_CONTROL_MODE_TORQUE 3
 #define MOTOR_CONTROL_MODE_VOLTAGE 4
+#define MOTOR_CONTROL_MODE_TRAJECTORY 5
+
+#define MOTOR_TRAJECTORY_QUEUE_LEN 8
 
 #define MOTOR_STREAMS_NB_VALUES 10
 #define MOTOR_STREAM_CURRENT 0
@@ -33,6 +38,16 @@ struct pid_parameter_s {
     parameter_t ilimit;
 };
 
+/* Segment of a trajectory streamed to the motor board. The position is the
+ * cubic polynomial coeffs[0] + coeffs[1] t + coeffs[2] t^2 + coeffs[3] t^3,
+ * with t the time since start in seconds. */
+typedef struct {
+    uint32_t start; // [us] in the timestamp_get() clock
+    uint32_t duration; // [us]
+    float coeffs[4];
+    float torque; // feedforward torque
+} motor_trajectory_segment_t;
+
 typedef struct {
     char id[MOTOR_ID_MAX_LEN + 1];
     int can_id;
@@ -49,6 +64,15 @@ typedef struct {
         float voltage;
     } setpt;
 
+    // segments waiting to be sent to the board, in trajectory mode
+    struct {
+        motor_trajectory_segment_t segments[MOTOR_TRAJECTORY_QUEUE_LEN];
+        unsigned int head;
+        unsigned int count;
+        motor_trajectory_segment_t last; // last segment taken out of the queue
+        bool has_last;
+    } trajectory;
+
     struct {
         parameter_namespace_t root;
         parameter_namespace_t control;
@@ -111,6 +135,36 @@ void motor_driver_set_torque(motor_driver_t* d, float torque);
 void motor_driver_set_voltage(motor_driver_t* d, float voltage);
 void motor_driver_disable(motor_driver_t* d);
 
+// Queues a trajectory segment to be sent to the board, and switches to
+// trajectory mode. Segments should be pushed ahead of their start time, by
+// more than the worst case CAN latency.
+// Returns false if the queue is full.
+bool motor_driver_push_trajectory_segment(motor_driver_t* d,
+                                          const motor_trajectory_segment_t* segment);
+
+// Takes the oldest segment out of the queue, returns false if it is empty.
+// Must be called in a motor_driver_lock/unlock critical section.
+bool motor_driver_pop_trajectory_segment(motor_driver_t* d,
+                                         motor_trajectory_segment_t* segment);
+
+// Gets the last segment taken out of the queue, which is sent again to keep
+// the board enabled while it executes. Returns false if there is none or if
+// it has ended at time now, so that the board times out once the trajectory
+// is over. Must be called in a motor_driver_lock/unlock critical section.
+bool motor_driver_get_last_trajectory_segment(motor_driver_t* d,
+                                              uint32_t now,
+                                              motor_trajectory_segment_t* segment);
+
+// Fills a segment going from position p0 at velocity v0 to position p1 at
+// velocity v1 (cubic Hermite spline).
+void motor_trajectory_segment_hermite(motor_trajectory_segment_t* segment,
+                                      uint32_t start,
+                                      uint32_t duration,
+                                      float p0,
+                                      float v0,
+                                      float p1,
+                                      float v1);
+
 #define CAN_ID_NOT_SET 0xFFFF
 int motor_driver_get_can_id(motor_driver_t* d);
 void motor_driver_set_can_id(motor_driver_t* d, int can_id);
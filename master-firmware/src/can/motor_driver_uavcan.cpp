@@ -1,10 +1,10 @@
 #include <uavcan/uavcan.hpp>
 #include <uavcan/protocol/NodeStatus.hpp>
 #include <uavcan/protocol/param/GetSet.hpp>
-#include <cvra/motor/control/Velocity.hpp>
-#include <cvra/motor/control/Position.hpp>
-#include <cvra/motor/control/Torque.hpp>
-#include <cvra/motor/control/Voltage.hpp>
+#include <cvra/motor/control/SetpointBatch.hpp>
+#include <cvra/motor/control/TrajectorySegment.hpp>
+#include <atomic>
+#include <chrono>
 
 #include <error/error.h>
 #include <timestamp/timestamp.h>
@@ -18,27 +18,41 @@
 using namespace uavcan;
 using namespace cvra::motor;
 
-/*** Sends a setpoint to the motor board, picking the message type according to
- * the current value. */
-static void motor_driver_uavcan_send_setpoint(motor_driver_t* d);
+/** Sends the setpoints of all motor boards in a single SetpointBatch
+ * transfer (or a few if there are many boards). Keepalive also repeats the
+ * current trajectory segment of boards with nothing new to send. */
+static void motor_driver_uavcan_send_setpoints(bool keepalive);
 
 /** Send new parameters from the global tree to the motor board. */
 static int motor_driver_uavcan_update_config(motor_driver_t* d);
 
-static LazyConstructor<Publisher<control::Velocity>> velocity_pub;
-static LazyConstructor<Publisher<control::Position>> position_pub;
-static LazyConstructor<Publisher<control::Torque>> torque_pub;
-static LazyConstructor<Publisher<control::Voltage>> voltage_pub;
+/** Sends the queued trajectory segments of a motor board. */
+static void motor_driver_uavcan_send_trajectory(motor_driver_t* d, bool keepalive);
+
+static LazyConstructor<Publisher<control::SetpointBatch>> setpoint_batch_pub;
+static LazyConstructor<Publisher<control::TrajectorySegment>> trajectory_segment_pub;
+
+static std::atomic<bool> setpoints_pending{false};
+static std::atomic<int64_t> setpoints_ready_time_us{0};
+static std::atomic<timestamp_t> setpoints_timestamp{0};
+static DurationHistogram setpoint_latency;
+static std::atomic<uint32_t> setpoint_transfer_count{0};
+
+static int64_t now_us()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
 
 int motor_driver_uavcan_init(INode& node)
 {
-    velocity_pub.construct<INode&>(node);
-    position_pub.construct<INode&>(node);
-    torque_pub.construct<INode&>(node);
-    voltage_pub.construct<INode&>(node);
+    setpoint_batch_pub.construct<INode&>(node);
+    trajectory_segment_pub.construct<INode&>(node);
 
     /* Setup a timer that will send the config & setpoints to the motor boards
-     * periodically.
+     * periodically. Setpoints are also sent as soon as the control loop
+     * produces them, see motor_driver_uavcan_setpoints_ready(); this timer
+     * keeps the boards enabled if the control loop stops.
      *
      * This timer will be called from the UAVCAN main event loop.
      * */
@@ -59,9 +73,7 @@ int motor_driver_uavcan_init(INode& node)
                 }
             }
 
-            for (int i = 0; i < drv_list_len; i++) {
-                motor_driver_uavcan_send_setpoint(&drv_list[i]);
-            }
+            motor_driver_uavcan_send_setpoints(true);
         });
 
     /* Starts the periodic timer. Its rate must be at least every 300 ms,
@@ -72,6 +84,33 @@ int motor_driver_uavcan_init(INode& node)
     return 0;
 }
 
+void motor_driver_uavcan_setpoints_ready()
+{
+    setpoints_ready_time_us.store(now_us(), std::memory_order_relaxed);
+    setpoints_timestamp.store(timestamp_get(), std::memory_order_relaxed);
+    setpoints_pending.store(true, std::memory_order_release);
+}
+
+void motor_driver_uavcan_send_pending_setpoints()
+{
+    if (!setpoints_pending.exchange(false, std::memory_order_acquire)) {
+        return;
+    }
+
+    motor_driver_uavcan_send_setpoints(false);
+    setpoint_latency.add(now_us() - setpoints_ready_time_us.load(std::memory_order_relaxed));
+}
+
+const DurationHistogram& motor_driver_uavcan_setpoint_latency()
+{
+    return setpoint_latency;
+}
+
+uint32_t motor_driver_uavcan_setpoint_transfer_count()
+{
+    return setpoint_transfer_count.load(std::memory_order_relaxed);
+}
+
 static void update_motor_can_id(motor_driver_t* d)
 {
     int node_id = motor_driver_get_can_id(d);
@@ -95,52 +134,132 @@ static int motor_driver_uavcan_update_config(motor_driver_t* d)
     return 1;
 }
 
-static void motor_driver_uavcan_send_setpoint(motor_driver_t* d)
+/** Appends the setpoint of a motor board to the batch.
+ *
+ * @returns false if the board does not need a setpoint.
+ */
+static bool motor_driver_uavcan_get_setpoint(motor_driver_t* d, control::Setpoint& setpoint)
 {
-    control::Position position_setpoint;
-    control::Velocity velocity_setpoint;
-    control::Torque torque_setpoint;
-    control::Voltage voltage_setpoint;
-
     update_motor_can_id(d);
     int node_id = motor_driver_get_can_id(d);
     if (node_id == CAN_ID_NOT_SET) {
-        return;
+        return false;
     }
 
+    setpoint.node_id = node_id;
+
+    bool valid = true;
     motor_driver_lock(d);
     switch (d->control_mode) {
-        case MOTOR_CONTROL_MODE_VELOCITY: {
-            velocity_setpoint.velocity = motor_driver_get_velocity_setpt(d);
-            velocity_setpoint.node_id = node_id;
-            velocity_pub->broadcast(velocity_setpoint);
-        } break;
-
-        case MOTOR_CONTROL_MODE_POSITION: {
-            position_setpoint.position = motor_driver_get_position_setpt(d);
-            position_setpoint.node_id = node_id;
-            position_pub->broadcast(position_setpoint);
-        } break;
-
-        case MOTOR_CONTROL_MODE_TORQUE: {
-            torque_setpoint.torque = motor_driver_get_torque_setpt(d);
-            torque_setpoint.node_id = node_id;
-            torque_pub->broadcast(torque_setpoint);
-        } break;
-
-        case MOTOR_CONTROL_MODE_VOLTAGE: {
-            voltage_setpoint.voltage = motor_driver_get_voltage_setpt(d);
-            voltage_setpoint.node_id = node_id;
-            voltage_pub->broadcast(voltage_setpoint);
-        } break;
+        case MOTOR_CONTROL_MODE_VELOCITY:
+            setpoint.mode = control::Setpoint::MODE_VELOCITY;
+            setpoint.value = motor_driver_get_velocity_setpt(d);
+            break;
+
+        case MOTOR_CONTROL_MODE_POSITION:
+            setpoint.mode = control::Setpoint::MODE_POSITION;
+            setpoint.value = motor_driver_get_position_setpt(d);
+            break;
+
+        case MOTOR_CONTROL_MODE_TORQUE:
+            setpoint.mode = control::Setpoint::MODE_TORQUE;
+            setpoint.value = motor_driver_get_torque_setpt(d);
+            break;
+
+        case MOTOR_CONTROL_MODE_VOLTAGE:
+            setpoint.mode = control::Setpoint::MODE_VOLTAGE;
+            setpoint.value = motor_driver_get_voltage_setpt(d);
+            break;
+
+        /* Segments are sent on their own, see motor_driver_uavcan_send_trajectory() */
+        case MOTOR_CONTROL_MODE_TRAJECTORY:
+            valid = false;
+            break;
 
         /* Nothing to do, not sending any setpoint will disable the board. */
         case MOTOR_CONTROL_MODE_DISABLED:
+            valid = false;
             break;
 
         default:
             ERROR("Unknown control mode %d for board %d", d->control_mode, node_id);
+            valid = false;
             break;
     }
     motor_driver_unlock(d);
+
+    return valid;
+}
+
+static void motor_driver_uavcan_send_setpoints(bool keepalive)
+{
+    motor_driver_t* drv_list;
+    uint16_t drv_list_len;
+    motor_manager_get_list(&motor_manager, &drv_list, &drv_list_len);
+
+    control::SetpointBatch batch;
+    /* Lets receivers measure the latency from the control loop, see the
+     * hitl motor emulator. Keepalives are stamped when they are sent. */
+    batch.timestamp = keepalive ? timestamp_get() : setpoints_timestamp.load(std::memory_order_relaxed);
+    for (int i = 0; i < drv_list_len; i++) {
+        motor_driver_uavcan_send_trajectory(&drv_list[i], keepalive);
+
+        control::Setpoint setpoint;
+        if (!motor_driver_uavcan_get_setpoint(&drv_list[i], setpoint)) {
+            continue;
+        }
+
+        batch.setpoints.push_back(setpoint);
+        if (batch.setpoints.size() == batch.setpoints.capacity()) {
+            setpoint_batch_pub->broadcast(batch);
+            setpoint_transfer_count.fetch_add(1, std::memory_order_relaxed);
+            batch.setpoints.clear();
+        }
+    }
+
+    if (batch.setpoints.size() > 0) {
+        setpoint_batch_pub->broadcast(batch);
+        setpoint_transfer_count.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+static void motor_driver_uavcan_send_segment(int node_id, const motor_trajectory_segment_t& segment)
+{
+    control::TrajectorySegment msg;
+    msg.node_id = node_id;
+    msg.timestamp = timestamp_get();
+    msg.start_time = segment.start;
+    msg.duration = segment.duration;
+    for (int i = 0; i < 4; i++) {
+        msg.coefficients[i] = segment.coeffs[i];
+    }
+    msg.torque = segment.torque;
+    trajectory_segment_pub->broadcast(msg);
+}
+
+static void motor_driver_uavcan_send_trajectory(motor_driver_t* d, bool keepalive)
+{
+    update_motor_can_id(d);
+    int node_id = motor_driver_get_can_id(d);
+    if (node_id == CAN_ID_NOT_SET) {
+        return;
+    }
+
+    motor_trajectory_segment_t segment;
+    bool sent = false;
+
+    motor_driver_lock(d);
+    while (motor_driver_pop_trajectory_segment(d, &segment)) {
+        motor_driver_uavcan_send_segment(node_id, segment);
+        sent = true;
+    }
+
+    /* The board replaces a segment it already has by the new copy, so this
+     * only refreshes its timeout, and recovers if the last one was lost.
+     * Finished segments are not repeated, the board holds the end position
+     * until it times out. */
+    if (keepalive && !sent && motor_driver_get_last_trajectory_segment(d, timestamp_get(), &segment)) {
+        motor_driver_uavcan_send_segment(node_id, segment);
+    }
+    motor_driver_unlock(d);
 }
@@ -2,7 +2,23 @@
 #define MOTOR_DRIVER_UAVCAN_HPP
 
 #include <uavcan/uavcan.hpp>
+#include "periodic_executor.h"
 
 int motor_driver_uavcan_init(uavcan::INode& node);
 
+/** Signals that the control loop produced new setpoints for the motor
+ * boards. Can be called from any thread. */
+void motor_driver_uavcan_setpoints_ready();
+
+/** Sends the setpoints if new ones are ready. Must be called from the UAVCAN
+ * thread after each spin. */
+void motor_driver_uavcan_send_pending_setpoints();
+
+/** Delay between motor_driver_uavcan_setpoints_ready() and the setpoints
+ * being sent. */
+const DurationHistogram& motor_driver_uavcan_setpoint_latency();
+
+/** Number of SetpointBatch transfers sent. */
+uint32_t motor_driver_uavcan_setpoint_transfer_count();
+
 #endif /* MOTOR_DRIVER_UAVCAN_HPP */
@@ -26,13 +26,12 @@ struct Proxy : public ProxyBase {
         return absl::StrCat("/distance/", board_name);
     }
 
-    absl::optional<Range> translate(const cvra::sensor::DistanceVL6180X& msg) override
+    bool translate(const cvra::sensor::DistanceVL6180X& msg, Range& dist) override
     {
-        Range dist;
         dist.distance = msg.distance_mm / 1000.f;
         dist.type = Range_RangeType_LASER;
 
-        return dist;
+        return true;
     }
 };
 
@@ -1,6 +1,9 @@
+#include <cstring>
 #include <string>
 #include <thread>
 #include <uavcan_linux/uavcan_linux.hpp>
+#include <virtual_clock/uavcan_clock.hpp>
+#include <can_bus_shm/can_driver.hpp>
 #include <uavcan/protocol/node_info_retriever.hpp>
 #include "emergency_stop_handler.hpp"
 #include "motor_feedback_streams_handler.hpp"
@@ -14,6 +17,7 @@
 #include "actuator_handler.h"
 #include <can/uavcan_node.h>
 #include "control_panel.h"
+#include "main.h"
 
 #include <error/error.h>
 
@@ -39,6 +43,15 @@ class BusEnumeratorNodeInfoAdapter final : public uavcan::INodeInfoListener {
     {
         uint8_t can_id = node_id.get();
         NOTICE("Discovered node \"%s\" -> %d", node_info.name.c_str(), node_id.get());
+
+        /* The ID used to belong to another board, for example if it was
+         * reassigned by dynamic node ID allocation. */
+        const char* known_name = bus_enumerator_get_str_id(&bus_enumerator, can_id);
+        if (known_name != nullptr && strcmp(known_name, node_info.name.c_str()) != 0) {
+            WARNING("Node %d changed from \"%s\" to \"%s\"", can_id, known_name, node_info.name.c_str());
+            bus_enumerator_remove_can_id(&bus_enumerator, can_id);
+        }
+
         if (bus_enumerator_get_str_id(&bus_enumerator, can_id) == nullptr) {
             bus_enumerator_update_node_info(&bus_enumerator, node_info.name.c_str(), can_id);
 
@@ -57,28 +70,49 @@ class BusEnumeratorNodeInfoAdapter final : public uavcan::INodeInfoListener {
     }
 };
 
-uavcan::ISystemClock& getSystemClock()
+VirtualUavcanClock& getSystemClock()
 {
-    static uavcan_linux::SystemClock clock;
+    static VirtualUavcanClock clock;
     return clock;
 }
 
 uavcan::ICanDriver& getCanDriver(std::string iface)
 {
-    static uavcan_linux::SocketCanDriver driver(dynamic_cast<const uavcan_linux::SystemClock&>(getSystemClock()));
-    if (driver.getNumIfaces() == 0) // Will be executed once
+    static std::unique_ptr<uavcan::ICanDriver> driver;
+    if (!driver) // Will be executed once
     {
-        if (driver.addIface(iface) < 0) {
+        driver = can_driver_open(iface, getSystemClock());
+        if (!driver) {
             ERROR("Failed to add iface '%s'", iface.c_str());
         }
     }
-    return driver;
+    return *driver;
 }
 
-static void main(std::string can_iface, uint8_t id)
+/** Polls the bus at the spin frequency of simulated time. Never blocks on the
+ * bus while holding the clock, which would stop the simulation. */
+static void spin_on_virtual_clock(uavcan::Node<UAVCAN_MEMORY_POOL_SIZE>& node, virtual_clock_t* virtual_clock)
+{
+    const uint64_t period_us = 1000000 / UAVCAN_SPIN_FREQ;
+
+    virtual_clock_join(virtual_clock, VIRTUAL_CLOCK_ID_UAVCAN);
+    while (true) {
+        int res = node.spinOnce();
+        if (res < 0) {
+            WARNING("UAVCAN spin warning %d", res);
+        }
+        motor_driver_uavcan_send_pending_setpoints();
+        virtual_clock_sleep_until(virtual_clock, VIRTUAL_CLOCK_ID_UAVCAN,
+                                  virtual_clock_now(virtual_clock) + period_us);
+    }
+}
+
+static void main(std::string can_iface, uint8_t id, virtual_clock_t* virtual_clock)
 {
     int res;
 
+    getSystemClock().use_virtual_clock(virtual_clock);
+
     uavcan::Node<UAVCAN_MEMORY_POOL_SIZE> node(getCanDriver(can_iface),
                                                getSystemClock());
 
@@ -163,11 +197,16 @@ static void main(std::string can_iface, uint8_t id)
     node.getNodeStatusProvider().setModeOperational();
     node.getNodeStatusProvider().setHealthOk();
 
+    if (virtual_clock) {
+        spin_on_virtual_clock(node, virtual_clock);
+    }
+
     while (true) {
         res = node.spin(uavcan::MonotonicDuration::fromMSec(1000 / UAVCAN_SPIN_FREQ));
         if (res < 0) {
             WARNING("UAVCAN spin warning %d", res);
         }
+        motor_driver_uavcan_send_pending_setpoints();
     }
 }
 
@@ -181,8 +220,8 @@ static void node_status_cb(const uavcan::ReceivedDataStructure<uavcan::protocol:
 
 } // namespace uavcan_node
 
-void uavcan_node_start(std::string can_iface, uint8_t id)
+void uavcan_node_start(std::string can_iface, uint8_t id, virtual_clock_t* virtual_clock)
 {
-    std::thread uavcan_thread(uavcan_node::main, can_iface, id);
+    std::thread uavcan_thread(uavcan_node::main, can_iface, id, virtual_clock);
     uavcan_thread.detach();
 }
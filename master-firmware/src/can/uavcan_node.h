@@ -3,8 +3,11 @@
 
 #ifdef __cplusplus
 #include <string>
+#include <virtual_clock/virtual_clock.h>
 
-void uavcan_node_start(std::string can_iface, uint8_t id);
+/** Starts the UAVCAN node thread. If virtual_clock is not NULL, the node
+ * runs on simulated time. */
+void uavcan_node_start(std::string can_iface, uint8_t id, virtual_clock_t* virtual_clock);
 
 extern "C" {
 #endif
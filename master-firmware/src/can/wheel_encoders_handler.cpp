@@ -26,7 +26,7 @@ static void WheelEncoder_handler(
 
 int wheel_encoder_handler_init(uavcan::INode& node)
 {
-    messagebus_topic_init(&encoders_topic, &wrapper, &wrapper, &msg_content, sizeof(msg_content));
+    messagebus_topic_init_seqlock(&encoders_topic, &wrapper, &wrapper, &msg_content, sizeof(msg_content));
     messagebus_advertise_topic(&bus, &encoders_topic, "/encoders");
 
     static Subscriber sub(node);
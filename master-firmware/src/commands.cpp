@@ -47,6 +47,8 @@ extern "C" {
 #include "protobuf/encoders.pb.h"
 #include "usbconf.h"
 #include "shell_commands.h"
+#include "periodic_executor.h"
+#include "can/motor_driver_uavcan.hpp"
 
 SHELL_COMMAND_END();
 
@@ -106,6 +108,56 @@ SHELL_COMMAND(threads, chp, argc, argv)
     } while (tp != NULL);
 }
 
+static void print_histogram(BaseSequentialStream* chp, const char* name, const DurationHistogram& histogram)
+{
+    chprintf(chp, "  %-12s max %6ld us |", name, (long)histogram.max());
+    for (int i = 0; i < DurationHistogram::BUCKET_COUNT; i++) {
+        chprintf(chp, " %lu", (unsigned long)histogram.count(i));
+    }
+    chprintf(chp, "\r\n");
+}
+
+SHELL_COMMAND(sched, chp, argc, argv)
+{
+    bool reset = argc == 1 && !strcmp(argv[0], "reset");
+    if (argc > 0 && !reset) {
+        chprintf(chp, "Usage: sched [reset]\r\n");
+        return;
+    }
+
+    for (auto* e = PeriodicExecutor::first(); e != nullptr; e = e->next()) {
+        if (reset) {
+            e->reset_stats();
+            continue;
+        }
+
+        chprintf(chp, "%s: period %ld us, %lu ticks, %lu overruns, %lu missed ticks\r\n",
+                 e->name(), (long)e->period().count(), (unsigned long)e->tick_count(),
+                 (unsigned long)e->overrun_count(), (unsigned long)e->missed_tick_count());
+
+        chprintf(chp, "  histogram buckets (us):");
+        for (int i = 0; i < DurationHistogram::BUCKET_COUNT; i++) {
+            chprintf(chp, " %ld", (long)DurationHistogram::bucket_min(i));
+        }
+        chprintf(chp, "\r\n");
+
+        print_histogram(chp, "jitter", e->jitter());
+        for (int i = 0; i < e->task_count(); i++) {
+            print_histogram(chp, e->task(i).name, e->task(i).execution_time);
+        }
+    }
+}
+
+SHELL_COMMAND(setpoints, chp, argc, argv)
+{
+    (void)argc;
+    (void)argv;
+
+    chprintf(chp, "%lu setpoint transfers sent\r\n",
+             (unsigned long)motor_driver_uavcan_setpoint_transfer_count());
+    print_histogram(chp, "latency", motor_driver_uavcan_setpoint_latency());
+}
+
 SHELL_COMMAND(stack, chp, argc, argv)
 {
 #if (CH_DBG_FILL_THREADS != TRUE) || (CH_CFG_USE_REGISTRY != TRUE) || (CH_DBG_ENABLE_STACK_CHECK != TRUE)
@@ -398,13 +450,9 @@ SHELL_COMMAND(pos, chp, argc, argv)
     (void)argc;
     (void)argv;
 
-    float x, y, a;
-
-    x = position_get_x_float(&robot.pos);
-    y = position_get_y_float(&robot.pos);
-    a = position_get_a_rad_float(&robot.pos);
+    auto pose = robot_pose_get();
 
-    chprintf(chp, "x: %f [mm]\r\ny: %f [mm]\r\na: %f [rad]\r\n", x, y, a);
+    chprintf(chp, "x: %f [mm]\r\ny: %f [mm]\r\na: %f [rad]\r\n", pose.x, pose.y, pose.a);
 }
 
 /* position_reset */
@@ -838,6 +886,65 @@ SHELL_COMMAND(motor_voltage, chp, argc, argv)
     motor_manager_set_voltage(&motor_manager, argv[0], voltage);
 }
 
+SHELL_COMMAND(motor_traj, chp, argc, argv)
+{
+    if (argc < 4) {
+        chprintf(chp, "Usage: motor_traj motor_name start end duration\r\n");
+        return;
+    }
+    float start = atof(argv[1]);
+    float end = atof(argv[2]);
+    float duration = atof(argv[3]);
+
+    motor_driver_t* motor = (motor_driver_t*)bus_enumerator_get_driver(motor_manager.bus_enumerator, argv[0]);
+    if (motor == NULL) {
+        chprintf(chp, "Motor %s doesn't exist\r\n", argv[0]);
+        return;
+    }
+    if (duration <= 0) {
+        chprintf(chp, "Duration must be positive\r\n");
+        return;
+    }
+
+    /* Streams a smooth move as 10 ms segments, each one pushed 30 ms before
+     * it starts. */
+    const uint32_t segment_us = 10000;
+    const uint32_t lead_us = 30000;
+    const int segment_count = duration * 1e6f / segment_us + 1;
+    const float T = segment_count * segment_us / 1e6f;
+
+    auto position = [&](float t) {
+        float s = t / T;
+        return start + (end - start) * s * s * (3 - 2 * s);
+    };
+    auto velocity = [&](float t) {
+        float s = t / T;
+        return (end - start) * 6 * s * (1 - s) / T;
+    };
+
+    chprintf(chp, "Streaming %d segments to %s\r\n", segment_count, argv[0]);
+
+    uint32_t t0 = timestamp_get() + lead_us;
+    for (int i = 0; i < segment_count; i++) {
+        float t = i * segment_us / 1e6f;
+        float next_t = (i + 1) * segment_us / 1e6f;
+
+        motor_trajectory_segment_t segment;
+        motor_trajectory_segment_hermite(&segment, t0 + i * segment_us, segment_us,
+                                         position(t), velocity(t),
+                                         position(next_t), velocity(next_t));
+
+        while (timestamp_duration_us(timestamp_get(), segment.start) > (int32_t)lead_us) {
+            chThdSleepMilliseconds(1);
+        }
+        if (!motor_driver_push_trajectory_segment(motor, &segment)) {
+            chprintf(chp, "Trajectory queue full\r\n");
+            return;
+        }
+        motor_driver_uavcan_setpoints_ready();
+    }
+}
+
 SHELL_COMMAND(motor_index_sym, chp, argc, argv)
 {
     if (argc < 3) {
@@ -1,46 +1,842 @@
+#define _GNU_SOURCE
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <error/error.h>
+#include <timestamp/timestamp.h>
 #include <signal.h>
 #include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
 
 #include "log.h"
 
-static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+/* Space for the arguments of a message in its record */
+#define LOG_ARGS_SIZE 160
+
+#define LOG_MAX_OUTPUTS 4
+#define LOG_DRAIN_PERIOD_US 10000
+
+struct log_record {
+    const char* file;
+    const char* text;
+    timestamp_t timestamp;
+    uint16_t line;
+    uint8_t severity;
+    /* The arguments could not be packed, args holds the formatted text */
+    bool formatted;
+    uint8_t args[LOG_ARGS_SIZE];
+};
+
+/* Single producer, single consumer queue of the messages of a thread. When a
+ * thread exits, its ring is reused by the next thread which logs. */
+struct log_ring {
+    struct log_ring* next;
+    bool owned;
+    char thread_name[16];
+
+    /* Written by the producer */
+    uint32_t head __attribute__((aligned(64)));
+    uint32_t dropped;
+
+    /* Written by the log thread */
+    uint32_t tail __attribute__((aligned(64)));
+    uint32_t dropped_reported;
+
+    struct log_record records[LOG_RING_SIZE];
+};
+
+struct log_output {
+    void (*write)(void* arg, const char* line, size_t len);
+    void (*flush)(void* arg);
+    void* arg;
+};
+
+static struct log_ring* rings;
+static __thread struct log_ring* thread_ring;
+static pthread_key_t ring_key;
+static pthread_once_t ring_key_once = PTHREAD_ONCE_INIT;
+
+static pthread_mutex_t outputs_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct log_output outputs[LOG_MAX_OUTPUTS];
+static int outputs_count;
+
+static pthread_t log_thread;
+static bool running;
+static uint32_t drain_generation;
+
+static struct {
+    FILE* file;
+    char path[256];
+    size_t size;
+    size_t max_size;
+    int count;
+} file_output;
+
+static int udp_socket = -1;
+
+/*
+ * Arguments packing
+ *
+ * The log thread formats the messages, so the calling thread only copies the
+ * arguments in the record. Both walk the format string the same way to know
+ * the type of each argument.
+ */
+
+enum arg_type {
+    ARG_NONE, /* %% */
+    ARG_SIGNED,
+    ARG_UNSIGNED,
+    ARG_CHAR,
+    ARG_DOUBLE,
+    ARG_STRING,
+    ARG_POINTER,
+};
+
+struct conversion {
+    const char* start; /* the '%' */
+    const char* end; /* after the conversion character */
+    enum arg_type type;
+    char length[3];
+    char conversion;
+    bool width_star;
+    bool precision_star;
+};
+
+/* Parses the conversion starting at the given '%'. Returns false for the ones
+ * which are not supported, such as %n or long double. */
+static bool parse_conversion(const char* p, struct conversion* c)
+{
+    memset(c, 0, sizeof(struct conversion));
+    c->start = p++;
+
+    while (*p && strchr("-+ #0'", *p)) {
+        p++;
+    }
+    if (*p == '*') {
+        c->width_star = true;
+        p++;
+    }
+    while (*p >= '0' && *p <= '9') {
+        p++;
+    }
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            c->precision_star = true;
+            p++;
+        }
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+    }
+    for (int i = 0; i < 2 && *p && strchr("hljztq", *p); i++) {
+        c->length[i] = *p++;
+    }
+
+    c->conversion = *p;
+    c->end = p + 1;
+
+    switch (c->conversion) {
+        case '%':
+            c->type = ARG_NONE;
+            break;
+        case 'd':
+        case 'i':
+            c->type = ARG_SIGNED;
+            break;
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X':
+            c->type = ARG_UNSIGNED;
+            break;
+        case 'c':
+            c->type = ARG_CHAR;
+            return c->length[0] == '\0';
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'F':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            c->type = ARG_DOUBLE;
+            break;
+        case 's':
+            c->type = ARG_STRING;
+            return c->length[0] == '\0';
+        case 'p':
+            c->type = ARG_POINTER;
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+static int64_t signed_arg(const struct conversion* c, va_list* va)
+{
+    if (!strcmp(c->length, "l")) {
+        return va_arg(*va, long);
+    } else if (!strcmp(c->length, "ll") || !strcmp(c->length, "q")) {
+        return va_arg(*va, long long);
+    } else if (!strcmp(c->length, "j")) {
+        return va_arg(*va, intmax_t);
+    } else if (!strcmp(c->length, "z")) {
+        return va_arg(*va, ssize_t);
+    } else if (!strcmp(c->length, "t")) {
+        return va_arg(*va, ptrdiff_t);
+    }
+    /* char and short are promoted to int */
+    int value = va_arg(*va, int);
+    if (!strcmp(c->length, "hh")) {
+        return (signed char)value;
+    } else if (!strcmp(c->length, "h")) {
+        return (short)value;
+    }
+    return value;
+}
+
+static uint64_t unsigned_arg(const struct conversion* c, va_list* va)
+{
+    if (!strcmp(c->length, "l")) {
+        return va_arg(*va, unsigned long);
+    } else if (!strcmp(c->length, "ll") || !strcmp(c->length, "q")) {
+        return va_arg(*va, unsigned long long);
+    } else if (!strcmp(c->length, "j")) {
+        return va_arg(*va, uintmax_t);
+    } else if (!strcmp(c->length, "z")) {
+        return va_arg(*va, size_t);
+    } else if (!strcmp(c->length, "t")) {
+        return va_arg(*va, ptrdiff_t);
+    }
+    unsigned int value = va_arg(*va, unsigned int);
+    if (!strcmp(c->length, "hh")) {
+        return (unsigned char)value;
+    } else if (!strcmp(c->length, "h")) {
+        return (unsigned short)value;
+    }
+    return value;
+}
+
+/* Returns false if the arguments do not fit in the record */
+static bool pack_args(const char* text, va_list* va, uint8_t* args)
+{
+    size_t pos = 0;
+    struct conversion c;
+
+#define PACK(value)                                 \
+    do {                                            \
+        __typeof__(value) _v = (value);             \
+        if (pos + sizeof(_v) > LOG_ARGS_SIZE) {     \
+            return false;                           \
+        }                                           \
+        memcpy(&args[pos], &_v, sizeof(_v));        \
+        pos += sizeof(_v);                          \
+    } while (0)
+
+    for (const char* p = strchr(text, '%'); p != NULL; p = strchr(c.end, '%')) {
+        if (!parse_conversion(p, &c)) {
+            return false;
+        }
+        if (c.width_star) {
+            PACK(va_arg(*va, int));
+        }
+        if (c.precision_star) {
+            PACK(va_arg(*va, int));
+        }
+
+        switch (c.type) {
+            case ARG_NONE:
+                break;
+            case ARG_SIGNED:
+                PACK(signed_arg(&c, va));
+                break;
+            case ARG_UNSIGNED:
+                PACK(unsigned_arg(&c, va));
+                break;
+            case ARG_CHAR:
+                PACK(va_arg(*va, int));
+                break;
+            case ARG_DOUBLE:
+                PACK(va_arg(*va, double));
+                break;
+            case ARG_POINTER:
+                PACK(va_arg(*va, void*));
+                break;
+            case ARG_STRING: {
+                const char* s = va_arg(*va, const char*);
+                if (s == NULL) {
+                    s = "(null)";
+                }
+                size_t len = strlen(s) + 1;
+                if (pos + len > LOG_ARGS_SIZE) {
+                    return false;
+                }
+                memcpy(&args[pos], s, len);
+                pos += len;
+            } break;
+        }
+    }
+#undef PACK
+
+    return true;
+}
+
+/* Formats the message of a record, in the same way as vsnprintf would have */
+static void format_args(const struct log_record* record, char* out, size_t size)
+{
+    const char* text = record->text;
+    const uint8_t* args = record->args;
+    size_t len = 0;
+    struct conversion c;
+
+#define UNPACK(type)                       \
+    ({                                     \
+        type _v;                           \
+        memcpy(&_v, args, sizeof(_v));     \
+        args += sizeof(_v);                \
+        _v;                                \
+    })
+
+#define APPEND(...)                                                     \
+    do {                                                                \
+        if (len < size) {                                               \
+            int _n = snprintf(&out[len], size - len, __VA_ARGS__);      \
+            len += _n > 0 ? (size_t)_n : 0;                             \
+        }                                                               \
+    } while (0)
+
+    for (const char* p = text; *p != '\0'; p = c.end) {
+        const char* percent = strchr(p, '%');
+        if (percent == NULL) {
+            APPEND("%s", p);
+            break;
+        }
+        APPEND("%.*s", (int)(percent - p), p);
+        parse_conversion(percent, &c);
+
+        /* Rebuilds the conversion with the stars replaced by their value,
+         * and the integers as long long */
+        char spec[32];
+        const char* flags_end = percent + 1 + strspn(percent + 1, "-+ #0'");
+        int n = snprintf(spec, sizeof(spec), "%.*s", (int)(flags_end - percent), percent);
+        const char* q = flags_end;
+        if (c.width_star) {
+            n += snprintf(&spec[n], sizeof(spec) - n, "%d", UNPACK(int));
+            q++;
+        } else {
+            size_t digits = strspn(q, "0123456789");
+            n += snprintf(&spec[n], sizeof(spec) - n, "%.*s", (int)digits, q);
+            q += digits;
+        }
+        if (*q == '.') {
+            n += snprintf(&spec[n], sizeof(spec) - n, ".");
+            q++;
+            if (c.precision_star) {
+                n += snprintf(&spec[n], sizeof(spec) - n, "%d", UNPACK(int));
+                q++;
+            }
+            size_t digits = strspn(q, "0123456789");
+            n += snprintf(&spec[n], sizeof(spec) - n, "%.*s", (int)digits, q);
+        }
+        if (c.type == ARG_SIGNED || c.type == ARG_UNSIGNED) {
+            n += snprintf(&spec[n], sizeof(spec) - n, "ll");
+        }
+        snprintf(&spec[n], sizeof(spec) - n, "%c", c.conversion);
+
+        switch (c.type) {
+            case ARG_NONE:
+                APPEND("%%");
+                break;
+            case ARG_SIGNED:
+                APPEND(spec, (long long)UNPACK(int64_t));
+                break;
+            case ARG_UNSIGNED:
+                APPEND(spec, (unsigned long long)UNPACK(uint64_t));
+                break;
+            case ARG_CHAR:
+                APPEND(spec, UNPACK(int));
+                break;
+            case ARG_DOUBLE:
+                APPEND(spec, UNPACK(double));
+                break;
+            case ARG_POINTER:
+                APPEND(spec, UNPACK(void*));
+                break;
+            case ARG_STRING:
+                APPEND(spec, (const char*)args);
+                args += strlen((const char*)args) + 1;
+                break;
+        }
+    }
+#undef UNPACK
+#undef APPEND
+}
+
+/*
+ * Per thread rings
+ */
+
+static void ring_release(void* ring)
+{
+    __atomic_store_n(&((struct log_ring*)ring)->owned, false, __ATOMIC_RELEASE);
+}
+
+static void ring_key_create(void)
+{
+    pthread_key_create(&ring_key, ring_release);
+}
+
+static struct log_ring* ring_get(void)
+{
+    if (thread_ring != NULL) {
+        return thread_ring;
+    }
+
+    struct log_ring* ring;
+
+    /* Reuses the ring of an exited thread, once the log thread emptied it */
+    for (ring = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->next) {
+        bool owned = false;
+        if (__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)
+            && __atomic_compare_exchange_n(&ring->owned, &owned, true, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+
+    if (ring == NULL) {
+        ring = calloc(1, sizeof(struct log_ring));
+        if (ring == NULL) {
+            return NULL;
+        }
+        ring->owned = true;
+        ring->next = __atomic_load_n(&rings, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&rings, &ring->next, ring, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        }
+    }
+
+    if (pthread_getname_np(pthread_self(), ring->thread_name, sizeof(ring->thread_name)) != 0) {
+        strcpy(ring->thread_name, "?");
+    }
+
+    pthread_once(&ring_key_once, ring_key_create);
+    pthread_setspecific(ring_key, ring);
+    thread_ring = ring;
+    return ring;
+}
+
+static bool ring_full(const struct log_ring* ring)
+{
+    return ring->head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= LOG_RING_SIZE;
+}
+
+static void record_fill(struct log_record* record, struct error* e, va_list* va)
+{
+    va_list va_fallback;
+
+    record->file = e->file;
+    record->text = e->text;
+    record->line = e->line;
+    record->severity = e->severity;
+    record->timestamp = timestamp_get();
+
+    va_copy(va_fallback, *va);
+    record->formatted = !pack_args(e->text, va, record->args);
+    if (record->formatted) {
+        vsnprintf((char*)record->args, LOG_ARGS_SIZE, e->text, va_fallback);
+    }
+    va_end(va_fallback);
+}
+
+static void write_record(const char* thread_name, const struct log_record* record);
+static void flush_outputs(void);
 
 static void log_message(struct error* e, ...)
 {
-    pthread_mutex_lock(&log_lock);
+    struct log_ring* ring = ring_get();
     va_list va;
 
-    printf("%7s ", error_severity_get_name(e->severity));
-    printf("%s:%d\t", strrchr(e->file, '/') + 1, e->line);
+    /* Errors are never dropped: wait for the log thread to make room */
+    if (ring != NULL && e->severity >= ERROR_SEVERITY_ERROR) {
+        while (ring_full(ring) && __atomic_load_n(&running, __ATOMIC_ACQUIRE)
+               && !pthread_equal(pthread_self(), log_thread)) {
+            usleep(1000);
+        }
+    }
 
     va_start(va, e);
-    vprintf(e->text, va);
-    va_end(va);
+    if (ring != NULL && !ring_full(ring)) {
+        uint32_t head = ring->head;
+        record_fill(&ring->records[head % LOG_RING_SIZE], e, &va);
+        __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    } else if (e->severity >= ERROR_SEVERITY_ERROR) {
+        /* No log thread to make room, write it from here */
+        struct log_record record;
+        record_fill(&record, e, &va);
 
-    printf("\n");
-
-    fflush(stdout);
+        pthread_mutex_lock(&outputs_lock);
+        write_record(ring != NULL ? ring->thread_name : "?", &record);
+        flush_outputs();
+        pthread_mutex_unlock(&outputs_lock);
+    } else if (ring != NULL) {
+        __atomic_store_n(&ring->dropped, ring->dropped + 1, __ATOMIC_RELAXED);
+    }
+    va_end(va);
 
     if (e->severity >= ERROR_SEVERITY_ERROR) {
+        log_flush();
+
         /* break if run under a debugger */
         raise(SIGINT);
         exit(1);
     }
-    pthread_mutex_unlock(&log_lock);
 }
 
-void log_init(int enable_verbose)
+/*
+ * Log thread
+ */
+
+static void write_line(const char* line, size_t len)
+{
+    for (int i = 0; i < outputs_count; i++) {
+        outputs[i].write(outputs[i].arg, line, len);
+    }
+}
+
+static void write_record(const char* thread_name, const struct log_record* record)
+{
+    char line[LOG_LINE_SIZE];
+    const char* file = strrchr(record->file, '/');
+    file = file ? file + 1 : record->file;
+
+    int n = snprintf(line, sizeof(line), "%4u.%06u %-15s %7s %s:%d\t",
+                     record->timestamp / 1000000, record->timestamp % 1000000,
+                     thread_name, error_severity_get_name(record->severity), file, record->line);
+
+    /* Keeps room for the newline */
+    if (record->formatted) {
+        snprintf(&line[n], sizeof(line) - n - 1, "%s", (const char*)record->args);
+    } else {
+        format_args(record, &line[n], sizeof(line) - n - 1);
+    }
+
+    size_t len = strlen(line);
+    line[len++] = '\n';
+    write_line(line, len);
+}
+
+static void report_drops(struct log_ring* ring)
+{
+    uint32_t dropped = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+
+    if (dropped != ring->dropped_reported) {
+        char line[LOG_LINE_SIZE];
+        timestamp_t now = timestamp_get();
+        int n = snprintf(line, sizeof(line), "%4u.%06u %-15s %7s log.c\t%u messages dropped from %s\n",
+                         now / 1000000, now % 1000000, "log",
+                         error_severity_get_name(ERROR_SEVERITY_WARNING),
+                         dropped - ring->dropped_reported, ring->thread_name);
+        write_line(line, n);
+        ring->dropped_reported = dropped;
+    }
+}
+
+static void flush_outputs(void)
+{
+    for (int i = 0; i < outputs_count; i++) {
+        if (outputs[i].flush) {
+            outputs[i].flush(outputs[i].arg);
+        }
+    }
+}
+
+/* Writes the pending records of all threads, oldest first. Returns false if
+ * there were none. */
+static bool drain(void)
+{
+    bool written = false;
+
+    pthread_mutex_lock(&outputs_lock);
+    while (true) {
+        struct log_ring* oldest = NULL;
+        timestamp_t oldest_timestamp = 0;
+
+        for (struct log_ring* ring = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->next) {
+            uint32_t tail = ring->tail;
+            if (tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) {
+                continue;
+            }
+            timestamp_t timestamp = ring->records[tail % LOG_RING_SIZE].timestamp;
+            if (oldest == NULL || timestamp_duration_us(timestamp, oldest_timestamp) > 0) {
+                oldest = ring;
+                oldest_timestamp = timestamp;
+            }
+        }
+
+        if (oldest == NULL) {
+            break;
+        }
+
+        write_record(oldest->thread_name, &oldest->records[oldest->tail % LOG_RING_SIZE]);
+        __atomic_store_n(&oldest->tail, oldest->tail + 1, __ATOMIC_RELEASE);
+        written = true;
+    }
+
+    for (struct log_ring* ring = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->next) {
+        report_drops(ring);
+    }
+
+    flush_outputs();
+    pthread_mutex_unlock(&outputs_lock);
+
+    return written;
+}
+
+static void* log_thread_main(void* arg)
+{
+    (void)arg;
+    pthread_setname_np(pthread_self(), "log");
+
+    while (__atomic_load_n(&running, __ATOMIC_ACQUIRE)) {
+        if (!drain()) {
+            usleep(LOG_DRAIN_PERIOD_US);
+        }
+        __atomic_add_fetch(&drain_generation, 1, __ATOMIC_RELEASE);
+    }
+
+    drain();
+    return NULL;
+}
+
+void log_flush(void)
+{
+    if (!__atomic_load_n(&running, __ATOMIC_ACQUIRE) || pthread_equal(pthread_self(), log_thread)) {
+        return;
+    }
+
+    for (struct log_ring* ring = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->next) {
+        uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        while ((int32_t)(head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)) > 0) {
+            usleep(1000);
+        }
+    }
+
+    /* The pass which wrote the last record might not have flushed yet */
+    uint32_t generation = __atomic_load_n(&drain_generation, __ATOMIC_ACQUIRE);
+    while (__atomic_load_n(&drain_generation, __ATOMIC_ACQUIRE) == generation) {
+        usleep(1000);
+    }
+}
+
+uint32_t log_dropped_count(void)
+{
+    uint32_t dropped = 0;
+    for (struct log_ring* ring = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->next) {
+        dropped += __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+    }
+    return dropped;
+}
+
+/*
+ * Outputs
+ */
+
+void log_add_output(void (*write)(void* arg, const char* line, size_t len), void* arg)
+{
+    pthread_mutex_lock(&outputs_lock);
+    if (outputs_count < LOG_MAX_OUTPUTS) {
+        outputs[outputs_count].write = write;
+        outputs[outputs_count].flush = NULL;
+        outputs[outputs_count].arg = arg;
+        outputs_count++;
+    }
+    pthread_mutex_unlock(&outputs_lock);
+}
+
+static void console_write(void* arg, const char* line, size_t len)
+{
+    (void)arg;
+    fwrite(line, 1, len, stdout);
+}
+
+static void console_flush(void* arg)
+{
+    (void)arg;
+    fflush(stdout);
+}
+
+static void file_rotate(void)
+{
+    char from[sizeof(file_output.path) + 16], to[sizeof(file_output.path) + 16];
+
+    fclose(file_output.file);
+
+    for (int i = file_output.count - 1; i > 0; i--) {
+        snprintf(from, sizeof(from), "%s.%d", file_output.path, i);
+        snprintf(to, sizeof(to), "%s.%d", file_output.path, i + 1);
+        rename(from, to);
+    }
+    if (file_output.count > 0) {
+        snprintf(to, sizeof(to), "%s.1", file_output.path);
+        rename(file_output.path, to);
+    }
+
+    file_output.file = fopen(file_output.path, "w");
+    file_output.size = 0;
+}
+
+static void file_write(void* arg, const char* line, size_t len)
+{
+    (void)arg;
+    if (file_output.size + len > file_output.max_size) {
+        file_rotate();
+    }
+    if (file_output.file != NULL) {
+        file_output.size += fwrite(line, 1, len, file_output.file);
+    }
+}
+
+static void file_flush(void* arg)
+{
+    (void)arg;
+    if (file_output.file != NULL) {
+        fflush(file_output.file);
+    }
+}
+
+static bool file_open(const log_config_t* config)
+{
+    snprintf(file_output.path, sizeof(file_output.path), "%s", config->file);
+    file_output.max_size = config->file_size;
+    file_output.count = config->file_count;
+    file_output.file = fopen(file_output.path, "a");
+    if (file_output.file == NULL) {
+        return false;
+    }
+    fseek(file_output.file, 0, SEEK_END);
+    file_output.size = ftell(file_output.file);
+    return true;
+}
+
+static void udp_write(void* arg, const char* line, size_t len)
+{
+    (void)arg;
+    /* Messages are lost rather than waiting on the network */
+    send(udp_socket, line, len, MSG_DONTWAIT);
+}
+
+static bool udp_open(const log_config_t* config)
+{
+    struct addrinfo hints, *addresses;
+    char port[8];
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    snprintf(port, sizeof(port), "%d", config->udp_port);
+
+    if (getaddrinfo(config->udp_host, port, &hints, &addresses) != 0) {
+        return false;
+    }
+
+    for (struct addrinfo* a = addresses; a != NULL; a = a->ai_next) {
+        udp_socket = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (udp_socket < 0) {
+            continue;
+        }
+        if (connect(udp_socket, a->ai_addr, a->ai_addrlen) == 0) {
+            break;
+        }
+        close(udp_socket);
+        udp_socket = -1;
+    }
+
+    freeaddrinfo(addresses);
+    return udp_socket >= 0;
+}
+
+static void add_output(void (*write)(void*, const char*, size_t), void (*flush)(void*))
+{
+    log_add_output(write, NULL);
+    pthread_mutex_lock(&outputs_lock);
+    outputs[outputs_count - 1].flush = flush;
+    pthread_mutex_unlock(&outputs_lock);
+}
+
+void log_config_default(log_config_t* config)
 {
+    memset(config, 0, sizeof(log_config_t));
+    config->console = true;
+    config->file_size = 10 * 1024 * 1024;
+    config->file_count = 5;
+}
+
+void log_init(const log_config_t* config)
+{
+    bool file_failed = false, udp_failed = false;
+
+    if (config->console) {
+        add_output(console_write, console_flush);
+    }
+    if (config->file != NULL) {
+        if (file_open(config)) {
+            add_output(file_write, file_flush);
+        } else {
+            file_failed = true;
+        }
+    }
+    if (config->udp_host != NULL) {
+        if (udp_open(config)) {
+            add_output(udp_write, NULL);
+        } else {
+            udp_failed = true;
+        }
+    }
+
+    __atomic_store_n(&running, true, __ATOMIC_RELEASE);
+    pthread_create(&log_thread, NULL, log_thread_main, NULL);
+
     error_register_error(log_message);
     error_register_warning(log_message);
     error_register_notice(log_message);
 
-    if (enable_verbose) {
+    if (config->verbose) {
         error_register_debug(log_message);
     }
+
+    if (file_failed) {
+        WARNING("Could not open log file %s", config->file);
+    }
+    if (udp_failed) {
+        WARNING("Could not reach log host %s:%d", config->udp_host, config->udp_port);
+    }
+}
+
+void log_shutdown(void)
+{
+    error_register_error(NULL);
+    error_register_warning(NULL);
+    error_register_notice(NULL);
+    error_register_debug(NULL);
+
+    __atomic_store_n(&running, false, __ATOMIC_RELEASE);
+    pthread_join(log_thread, NULL);
+
+    pthread_mutex_lock(&outputs_lock);
+    outputs_count = 0;
+    if (file_output.file != NULL) {
+        fclose(file_output.file);
+        file_output.file = NULL;
+    }
+    if (udp_socket >= 0) {
+        close(udp_socket);
+        udp_socket = -1;
+    }
+    pthread_mutex_unlock(&outputs_lock);
 }
@@ -1,11 +1,67 @@
 #ifndef LOG_H
 #define LOG_H
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-void log_init(int enable_verbose);
+/** Messages each thread can have waiting before new ones are dropped */
+#define LOG_RING_SIZE 128
+
+/** Longest line written to the outputs, longer messages are truncated */
+#define LOG_LINE_SIZE 256
+
+typedef struct {
+    bool verbose; /**< Also log DEBUG messages */
+    bool console; /**< Write the messages to stdout */
+
+    /** File to write the messages to, NULL for none. When it grows over
+     * file_size bytes, it is renamed to file.1, file.1 to file.2 and so on,
+     * keeping file_count old files. */
+    const char* file;
+    size_t file_size;
+    int file_count;
+
+    /** Host to send each message to as an UDP datagram, NULL for none */
+    const char* udp_host;
+    int udp_port;
+} log_config_t;
+
+/** Fills the config with the defaults: console output only. */
+void log_config_default(log_config_t* config);
+
+/** Registers the log handlers and starts the thread writing the messages.
+ *
+ * Logging never blocks the calling thread, except for ERROR, which waits for
+ * the messages to be written before exiting. Each thread puts fixed size
+ * records (severity, file, line, timestamp and the raw arguments) into its own
+ * lock-free ring, and formatting and I/O are done by the log thread.
+ * When a ring is full, messages are dropped and the drop is reported later,
+ * except for ERROR, which waits for room (or is written by the calling thread
+ * if there is no log thread).
+ *
+ * The message text is kept by pointer, so it must be a string literal, which
+ * is what the error macros are used with.
+ */
+void log_init(const log_config_t* config);
+
+/** Unregisters the log handlers, then writes the pending messages and stops
+ * the log thread. */
+void log_shutdown(void);
+
+/** Adds an output, called from the log thread with each formatted line
+ * (newline included). */
+void log_add_output(void (*write)(void* arg, const char* line, size_t len), void* arg);
+
+/** Waits until all the messages logged so far are written. */
+void log_flush(void);
+
+/** Returns how many messages were dropped because a ring was full. */
+uint32_t log_dropped_count(void);
 
 #ifdef __cplusplus
 }
@@ -8,6 +8,7 @@
 #include "absl/strings/str_cat.h"
 
 #include "base/base_controller.h"
+#include "robot_helpers/math_helpers.h"
 
 class PositionPage : public Page {
     GHandle page_title;
@@ -42,14 +43,10 @@ public:
 
     void on_timer() override
     {
-        auto x = 0, y = 0, a = 0;
-
-        {
-            absl::MutexLock l(&robot.lock);
-            x = position_get_x_s16(&robot.pos);
-            y = position_get_y_s16(&robot.pos);
-            a = position_get_a_deg_s16(&robot.pos);
-        }
+        auto pose = robot_pose_get();
+        auto x = static_cast<int>(pose.x);
+        auto y = static_cast<int>(pose.y);
+        auto a = static_cast<int>(DEGREES(pose.a));
 
         std::string msg = absl::StrCat("x: ", x, " y: ", y, " a: ", a, " deg");
 
@@ -3,6 +3,7 @@
 #include <math.h>
 
 #include <thread>
+#include <vector>
 #include <absl/flags/flag.h>
 #include <absl/flags/parse.h>
 #include <absl/flags/usage.h>
@@ -22,10 +23,15 @@
 #include "can/motor_manager.h"
 //#include "lwipthread.h"
 #include <error/error.h>
+#include <timestamp/timestamp_posix.h>
+#include <virtual_clock/virtual_clock.h>
 //#include "base/encoder.h"
 #include "base/base_controller.h"
+#include "base/opponent_tracking.h"
 #include "robot_helpers/trajectory_helpers.h"
+#include "robot_helpers/sleep_helpers.h"
 #include "strategy.h"
+#include "match_report.h"
 #include "gui.h"
 //#include "udp_topic_broadcaster.h"
 //#include "ally_position_service.h"
@@ -44,10 +50,22 @@ motor_manager_t motor_manager;
 messagebus_t bus;
 static MESSAGEBUS_POSIX_SYNC_DECL(bus_sync);
 
-ABSL_FLAG(std::string, can_iface, "vcan0", "SocketCAN interface to use. If empty, disable UAVCAN.");
+ABSL_FLAG(std::string, can_iface, "vcan0", "SocketCAN interface to use, or shm:/name for a shared memory bus. If empty, disable UAVCAN.");
 ABSL_FLAG(bool, verbose, false, "Enable verbose output");
+ABSL_FLAG(std::string, log_file, "", "Also write the log to this file, rotated every 10MB.");
+ABSL_FLAG(std::string, log_udp, "", "Also send the log to this host:port over UDP, one datagram per message.");
 ABSL_FLAG(bool, enable_gui, true, "Enable on-robot GUI");
 ABSL_FLAG(std::string, robot_config, "simulation", "Which config to load, can be order, chaos or simulation.");
+ABSL_FLAG(int, control_priority, 0, "SCHED_FIFO priority of the control loop, 0 for the default scheduler.");
+ABSL_FLAG(int, control_cpu, -1, "CPU the control loop is pinned to, -1 for any.");
+ABSL_FLAG(std::string, virtual_clock, "", "Name of the simulator's virtual clock (see hitl --lockstep). If set, "
+                                          "the control loop and UAVCAN run on simulated time.");
+ABSL_FLAG(std::string, config_override, "", "MessagePack file of parameters to apply on top of robot_config.");
+ABSL_FLAG(bool, play_game, false, "Start the strategy right after boot.");
+ABSL_FLAG(std::string, match_report, "", "JSON file in which to write the match statistics when the "
+                                         "virtual clock stops.");
+
+static virtual_clock_t* virtual_clock = nullptr;
 
 void config_load_err_cb(void* arg, const char* id, const char* err)
 {
@@ -86,6 +104,30 @@ void config_load_from_flash()
     }
 }
 
+/** Applies the parameters of a MessagePack file, which only needs to contain
+ * the ones to change. */
+static void config_load_override(const std::string& path)
+{
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f == NULL) {
+        ERROR("Could not open config override %s", path.c_str());
+    }
+
+    std::vector<char> buffer;
+    char chunk[4096];
+    size_t len;
+    while ((len = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        buffer.insert(buffer.end(), chunk, chunk + len);
+    }
+    fclose(f);
+
+    NOTICE("Loading config override %s", path.c_str());
+    int ret = parameter_msgpack_read(&global_config, buffer.data(), buffer.size(), config_load_err_cb, nullptr);
+    if (ret != 0) {
+        ERROR("Could not load config override %s", path.c_str());
+    }
+}
+
 static void blink_start()
 {
     std::thread blink([]() {
@@ -97,6 +139,23 @@ static void blink_start()
     blink.detach();
 }
 
+static ltimestamp_t virtual_clock_timestamp()
+{
+    return virtual_clock_now(virtual_clock);
+}
+
+/* The control loop, the UAVCAN thread and the strategy run in lockstep with
+ * the simulator. Other threads (GUI, shell) read simulated time but still
+ * sleep in real time. */
+static void virtual_clock_connect(const std::string& name)
+{
+    NOTICE("waiting for virtual clock %s", name.c_str());
+    while ((virtual_clock = virtual_clock_open_shared(name.c_str())) == nullptr) {
+        std::this_thread::sleep_for(100ms);
+    }
+    timestamp_posix_set_source(virtual_clock_timestamp);
+}
+
 static void enable_deadlock_detection()
 {
     absl::SetMutexDeadlockDetectionMode(absl::OnDeadlockCycle::kReport);
@@ -116,10 +175,31 @@ int main(int argc, char** argv)
 
     blink_start();
 
-    log_init(absl::GetFlag(FLAGS_verbose));
+    log_config_t log_config;
+    log_config_default(&log_config);
+    log_config.verbose = absl::GetFlag(FLAGS_verbose);
+
+    std::string log_file = absl::GetFlag(FLAGS_log_file);
+    if (!log_file.empty()) {
+        log_config.file = log_file.c_str();
+    }
+
+    std::string log_udp = absl::GetFlag(FLAGS_log_udp);
+    auto log_udp_colon = log_udp.rfind(':');
+    std::string log_udp_host = log_udp.substr(0, log_udp_colon);
+    if (log_udp_colon != std::string::npos) {
+        log_config.udp_host = log_udp_host.c_str();
+        log_config.udp_port = atoi(log_udp.c_str() + log_udp_colon + 1);
+    }
+
+    log_init(&log_config);
 
     NOTICE("boot");
 
+    if (!absl::GetFlag(FLAGS_virtual_clock).empty()) {
+        virtual_clock_connect(absl::GetFlag(FLAGS_virtual_clock));
+    }
+
     /* Initialize the interthread communication bus. */
     messagebus_init(&bus, &bus_sync, &bus_sync);
 
@@ -145,9 +225,12 @@ int main(int argc, char** argv)
 
     /* Initiaze UAVCAN communication */
 
+    /* Fed by the beacon handler of the UAVCAN node */
+    opponent_tracking_init(TRAJ_MAX_TIME_DELAY_OPPONENT_DETECTION);
+
     if (!absl::GetFlag(FLAGS_can_iface).empty()) {
         NOTICE("starting UAVCAN on %s", absl::GetFlag(FLAGS_can_iface).c_str());
-        uavcan_node_start(absl::GetFlag(FLAGS_can_iface), 10);
+        uavcan_node_start(absl::GetFlag(FLAGS_can_iface), 10, virtual_clock);
     }
 
     /* Those service communicate over IP so must be started afterward */
@@ -156,6 +239,9 @@ int main(int argc, char** argv)
 
     /* Load stored robot config */
     config_load_from_flash();
+    if (!absl::GetFlag(FLAGS_config_override).empty()) {
+        config_load_override(absl::GetFlag(FLAGS_config_override));
+    }
 
     control_panel_init();
     if (absl::GetFlag(FLAGS_enable_gui)) {
@@ -164,11 +250,26 @@ int main(int argc, char** argv)
 
     /* Base init */
     robot_init();
-    base_controller_start();
-    position_manager_start();
-    trajectory_manager_start();
+    base_controller_start(absl::GetFlag(FLAGS_control_priority), absl::GetFlag(FLAGS_control_cpu),
+                          virtual_clock);
+
+    if (absl::GetFlag(FLAGS_play_game)) {
+        std::thread strategy([]() {
+            robot_sleep_join_virtual_clock(virtual_clock, VIRTUAL_CLOCK_ID_STRATEGY);
+            strategy_play_game();
+        });
+        strategy.detach();
+    }
 
-    //strategy_play_game();
+    if (virtual_clock) {
+        /* The simulator decides when the match ends */
+        virtual_clock_wait_stopped(virtual_clock);
+        NOTICE("virtual clock stopped, exiting");
+        if (!absl::GetFlag(FLAGS_match_report).empty()) {
+            match_report_write(absl::GetFlag(FLAGS_match_report).c_str());
+        }
+        return 0;
+    }
 
     while (true) {
         std::this_thread::sleep_for(1s);
@@ -13,6 +13,13 @@ extern "C" {
 #define MAX_NB_MOTOR_DRIVERS 20
 #define MAX_NB_BUS_ENUMERATOR_ENTRIES 21
 
+/* Ids of the threads running on the virtual clock of the simulator (see
+ * --virtual_clock). The simulator uses lower ids, so that it runs first when
+ * several threads wake up at the same time. */
+#define VIRTUAL_CLOCK_ID_CONTROL 16
+#define VIRTUAL_CLOCK_ID_UAVCAN 17
+#define VIRTUAL_CLOCK_ID_STRATEGY 18
+
 /** Robot wide interthread bus. */
 extern messagebus_t bus;
 
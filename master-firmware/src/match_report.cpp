@@ -0,0 +1,52 @@
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include <absl/strings/str_format.h>
+#include <absl/strings/str_join.h>
+#include <error/error.h>
+
+#include "main.h"
+#include "match_report.h"
+#include "periodic_executor.h"
+#include "strategy.h"
+#include "strategy/score.h"
+
+void match_report_write(const char* path)
+{
+    std::vector<std::string> fields;
+
+    int score = 0;
+    StrategyState state;
+    messagebus_topic_t* state_topic = messagebus_find_topic(&bus, "/state");
+    if (state_topic && messagebus_topic_read(state_topic, &state, sizeof(state))) {
+        score = compute_score(state, true);
+    }
+    fields.push_back(absl::StrFormat("\"score\": %d", score));
+
+    auto planning = strategy_planning_stats_get();
+    fields.push_back(absl::StrFormat("\"planning_count\": %u", planning.plans));
+    fields.push_back(absl::StrFormat("\"planning_ready\": %u", planning.ready));
+    fields.push_back(absl::StrFormat("\"planning_searches\": %u", planning.searches));
+    fields.push_back(absl::StrFormat("\"planning_total_us\": %d", planning.search_total_us));
+    fields.push_back(absl::StrFormat("\"planning_max_us\": %d", planning.search_max_us));
+    fields.push_back(absl::StrFormat("\"planning_idle_us\": %d", planning.wait_total_us));
+
+    for (auto* executor = PeriodicExecutor::first(); executor; executor = executor->next()) {
+        fields.push_back(absl::StrFormat("\"%s_ticks\": %u", executor->name(), executor->tick_count()));
+        fields.push_back(absl::StrFormat("\"%s_overruns\": %u", executor->name(), executor->overrun_count()));
+        for (int i = 0; i < executor->task_count(); i++) {
+            const auto& task = executor->task(i);
+            fields.push_back(absl::StrFormat("\"%s_%s_max_us\": %d", executor->name(), task.name,
+                                             task.execution_time.max()));
+        }
+    }
+
+    FILE* f = fopen(path, "w");
+    if (f == NULL) {
+        WARNING("Could not write match report to %s", path);
+        return;
+    }
+    fprintf(f, "{\n  %s\n}\n", absl::StrJoin(fields, ",\n  ").c_str());
+    fclose(f);
+}
@@ -0,0 +1,11 @@
+#ifndef MATCH_REPORT_H
+#define MATCH_REPORT_H
+
+/** Writes statistics about the match to the given file, as a flat JSON object:
+ * the score, the time spent planning and the execution time of the periodic
+ * tasks (odometry, control, trajectory). Used by the batch simulation runner
+ * to compare strategies.
+ */
+void match_report_write(const char* path);
+
+#endif /* MATCH_REPORT_H */
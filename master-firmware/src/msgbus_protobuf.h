@@ -20,7 +20,13 @@ typedef struct {
     messagebus_watcher_t udp_watcher;
 } topic_metadata_t;
 
-#define TOPIC_DECL(name, type)                                 \
+#define TOPIC_DECL(name, type) _TOPIC_DECL(name, type, false)
+
+/* Same as TOPIC_DECL, but readers do not take the topic lock, see
+ * messagebus_topic_init_seqlock(). */
+#define TOPIC_DECL_SEQLOCK(name, type) _TOPIC_DECL(name, type, true)
+
+#define _TOPIC_DECL(name, type, seqlock)                       \
     struct {                                                   \
         messagebus_topic_t topic;                              \
         condvar_wrapper_t var;                                 \
@@ -32,7 +38,8 @@ typedef struct {
                                name.var,                       \
                                &name.value,                    \
                                sizeof(type),                   \
-                               name.metadata),                 \
+                               name.metadata,                  \
+                               seqlock),                       \
         {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER}, \
         type##_init_default,                                   \
         {                                                      \
@@ -42,9 +49,9 @@ typedef struct {
         },                                                     \
     }
 
-#define _MESSAGEBUS_TOPIC_DATA(topic, lock, condvar, buffer, buffer_size, metadata) \
-    {                                                                               \
-        buffer, buffer_size, &lock, &condvar, "", 0, NULL, NULL, &metadata, {0},    \
+#define _MESSAGEBUS_TOPIC_DATA(topic, lock, condvar, buffer, buffer_size, metadata, seqlock)                \
+    {                                                                                                       \
+        buffer, buffer_size, &lock, &condvar, "", 0, NULL, NULL, &metadata, {0}, seqlock, 0, 0, 0, 0, NULL, \
     }
 
 /* Wraps the topic information in a header (in protobuf format) to be sent over
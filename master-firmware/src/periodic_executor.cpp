@@ -0,0 +1,219 @@
+#include <thread>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <errno.h>
+
+#include <error/error.h>
+
+#include "periodic_executor.h"
+
+static const int64_t NSEC_PER_SEC = 1000000000;
+
+static std::atomic<PeriodicExecutor*> executors{nullptr};
+
+static int64_t timespec_diff_ns(const struct timespec* a, const struct timespec* b)
+{
+    return (a->tv_sec - b->tv_sec) * NSEC_PER_SEC + (a->tv_nsec - b->tv_nsec);
+}
+
+static void timespec_add_ns(struct timespec* t, int64_t ns)
+{
+    ns += t->tv_nsec;
+    t->tv_sec += ns / NSEC_PER_SEC;
+    t->tv_nsec = ns % NSEC_PER_SEC;
+}
+
+uint32_t periodic_deadline_advance(struct timespec* deadline, int64_t period_ns, const struct timespec* now)
+{
+    timespec_add_ns(deadline, period_ns);
+
+    int64_t late_ns = timespec_diff_ns(now, deadline);
+    if (late_ns < 0) {
+        return 0;
+    }
+
+    /* Skip to the first deadline after now, keeping the original phase */
+    uint32_t skipped = late_ns / period_ns + 1;
+    timespec_add_ns(deadline, skipped * period_ns);
+    return skipped;
+}
+
+void DurationHistogram::add(int64_t duration_us)
+{
+    int bucket = 0;
+    while (bucket < BUCKET_COUNT - 1 && duration_us >= bucket_min(bucket + 1)) {
+        bucket++;
+    }
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    if (duration_us > max_us.load(std::memory_order_relaxed)) {
+        max_us.store(duration_us, std::memory_order_relaxed);
+    }
+}
+
+void DurationHistogram::reset()
+{
+    for (auto& b : buckets) {
+        b.store(0, std::memory_order_relaxed);
+    }
+    max_us.store(0, std::memory_order_relaxed);
+}
+
+PeriodicExecutor::PeriodicExecutor(const char* name, std::chrono::microseconds period)
+    : name_(name)
+    , period_(period)
+{
+}
+
+void PeriodicExecutor::set_realtime_priority(int prio)
+{
+    priority = prio;
+}
+
+void PeriodicExecutor::set_cpu(int c)
+{
+    cpu = c;
+}
+
+void PeriodicExecutor::use_virtual_clock(virtual_clock_t* clock, int participant_id)
+{
+    virtual_clock = clock;
+    virtual_clock_id = participant_id;
+}
+
+bool PeriodicExecutor::add_task(const char* name, std::function<void()> function)
+{
+    if (task_count_ >= MAX_TASKS) {
+        return false;
+    }
+
+    tasks[task_count_].name = name;
+    tasks[task_count_].function = function;
+    task_count_++;
+    return true;
+}
+
+PeriodicExecutor* PeriodicExecutor::first()
+{
+    return executors.load(std::memory_order_acquire);
+}
+
+void PeriodicExecutor::start()
+{
+    next_ = executors.load(std::memory_order_relaxed);
+    while (!executors.compare_exchange_weak(next_, this, std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+    }
+
+    std::thread thd([this]() {
+        configure_thread();
+        while (true) {
+            run_ticks(1);
+        }
+    });
+    thd.detach();
+}
+
+void PeriodicExecutor::configure_thread()
+{
+    if (priority > 0) {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = priority;
+        int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (err != 0) {
+            WARNING("%s: cannot use SCHED_FIFO priority %d: %s", name_, priority, strerror(err));
+        }
+    }
+
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (err != 0) {
+            WARNING("%s: cannot pin to CPU %d: %s", name_, cpu, strerror(err));
+        }
+    }
+}
+
+void PeriodicExecutor::now(struct timespec* t)
+{
+    if (virtual_clock == nullptr) {
+        clock_gettime(CLOCK_MONOTONIC, t);
+        return;
+    }
+
+    uint64_t now_us = virtual_clock_now(virtual_clock);
+    t->tv_sec = now_us / 1000000;
+    t->tv_nsec = (now_us % 1000000) * 1000;
+}
+
+void PeriodicExecutor::wait_for_deadline()
+{
+    if (!deadline_initialized) {
+        if (virtual_clock) {
+            virtual_clock_join(virtual_clock, virtual_clock_id);
+        }
+        now(&deadline);
+        deadline_initialized = true;
+        return;
+    }
+
+    if (virtual_clock) {
+        uint64_t deadline_us = deadline.tv_sec * 1000000ULL + deadline.tv_nsec / 1000;
+        virtual_clock_sleep_until(virtual_clock, virtual_clock_id, deadline_us);
+        return;
+    }
+
+    int err;
+    do {
+        err = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr);
+    } while (err == EINTR);
+}
+
+void PeriodicExecutor::run_tick()
+{
+    struct timespec start, end;
+    now(&start);
+    jitter_.add(timespec_diff_ns(&start, &deadline) / 1000);
+
+    struct timespec task_start = start;
+    for (int i = 0; i < task_count_; i++) {
+        tasks[i].function();
+
+        struct timespec task_end;
+        now(&task_end);
+        tasks[i].execution_time.add(timespec_diff_ns(&task_end, &task_start) / 1000);
+        task_start = task_end;
+    }
+    end = task_start;
+
+    ticks.fetch_add(1, std::memory_order_relaxed);
+
+    uint32_t skipped = periodic_deadline_advance(&deadline, period_.count() * 1000, &end);
+    if (skipped > 0) {
+        overruns.fetch_add(1, std::memory_order_relaxed);
+        missed_ticks.fetch_add(skipped, std::memory_order_relaxed);
+    }
+}
+
+void PeriodicExecutor::run_ticks(int count)
+{
+    for (int i = 0; i < count; i++) {
+        wait_for_deadline();
+        run_tick();
+    }
+}
+
+void PeriodicExecutor::reset_stats()
+{
+    ticks.store(0, std::memory_order_relaxed);
+    overruns.store(0, std::memory_order_relaxed);
+    missed_ticks.store(0, std::memory_order_relaxed);
+    jitter_.reset();
+    for (int i = 0; i < task_count_; i++) {
+        tasks[i].execution_time.reset();
+    }
+}
@@ -0,0 +1,177 @@
+#ifndef PERIODIC_EXECUTOR_H
+#define PERIODIC_EXECUTOR_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <time.h>
+#include <virtual_clock/virtual_clock.h>
+
+/** Histogram of durations in microseconds, with power of two buckets.
+ *
+ * Bucket 0 counts durations below 1 us, bucket i counts durations in
+ * [2^(i-1), 2^i) us and the last bucket everything above. It can be read by
+ * another thread while it is being updated.
+ */
+class DurationHistogram {
+public:
+    static constexpr int BUCKET_COUNT = 16;
+
+    void add(int64_t duration_us);
+    void reset();
+
+    uint32_t count(int bucket) const
+    {
+        return buckets[bucket].load(std::memory_order_relaxed);
+    }
+
+    int64_t max() const
+    {
+        return max_us.load(std::memory_order_relaxed);
+    }
+
+    /** Lower bound of a bucket, in microseconds. */
+    static int64_t bucket_min(int bucket)
+    {
+        return bucket == 0 ? 0 : int64_t(1) << (bucket - 1);
+    }
+
+private:
+    std::atomic<uint32_t> buckets[BUCKET_COUNT] = {};
+    std::atomic<int64_t> max_us{0};
+};
+
+struct PeriodicTask {
+    const char* name;
+    std::function<void()> function;
+    DurationHistogram execution_time;
+};
+
+/** Runs a list of tasks in order on a dedicated thread, once per period.
+ *
+ * Each tick is scheduled at an absolute deadline (start + n * period), so the
+ * loop duration does not make the period drift. Tasks added to the same
+ * executor form a pipeline: they never run concurrently and always run in the
+ * order they were added.
+ *
+ * When a tick takes longer than the period, it is counted as an overrun and the
+ * missed deadlines are skipped instead of running several ticks in a burst.
+ */
+class PeriodicExecutor {
+public:
+    static constexpr int MAX_TASKS = 8;
+
+    PeriodicExecutor(const char* name, std::chrono::microseconds period);
+
+    /** Runs the thread with the SCHED_FIFO policy at the given priority, 0
+     * keeps the default scheduler. Must be called before start(). */
+    void set_realtime_priority(int priority);
+
+    /** Pins the thread to the given CPU, -1 lets it run on any. Must be
+     * called before start(). */
+    void set_cpu(int cpu);
+
+    /** Runs the ticks on simulated time instead of CLOCK_MONOTONIC, as the
+     * participant with the given id. The first tick joins the clock. Must be
+     * called before start(). */
+    void use_virtual_clock(virtual_clock_t* clock, int participant_id);
+
+    /** Adds a task at the end of the pipeline. Must be called before start().
+     *
+     * @returns false if there are too many tasks already.
+     */
+    bool add_task(const char* name, std::function<void()> function);
+
+    /** Starts the executor thread. */
+    void start();
+
+    /** Runs the given number of ticks in the calling thread. */
+    void run_ticks(int count);
+
+    /** Resets the statistics of the executor and its tasks. */
+    void reset_stats();
+
+    const char* name() const
+    {
+        return name_;
+    }
+
+    std::chrono::microseconds period() const
+    {
+        return period_;
+    }
+
+    int task_count() const
+    {
+        return task_count_;
+    }
+
+    const PeriodicTask& task(int i) const
+    {
+        return tasks[i];
+    }
+
+    uint32_t tick_count() const
+    {
+        return ticks.load(std::memory_order_relaxed);
+    }
+
+    uint32_t overrun_count() const
+    {
+        return overruns.load(std::memory_order_relaxed);
+    }
+
+    uint32_t missed_tick_count() const
+    {
+        return missed_ticks.load(std::memory_order_relaxed);
+    }
+
+    /** Delay between the deadline and the time the tick actually started. */
+    const DurationHistogram& jitter() const
+    {
+        return jitter_;
+    }
+
+    /** Executors which were started, to list them in the shell. */
+    static PeriodicExecutor* first();
+    PeriodicExecutor* next() const
+    {
+        return next_;
+    }
+
+private:
+    void configure_thread();
+    void run_tick();
+    void wait_for_deadline();
+    void now(struct timespec* t);
+
+    const char* name_;
+    std::chrono::microseconds period_;
+    int priority = 0;
+    int cpu = -1;
+    virtual_clock_t* virtual_clock = nullptr;
+    int virtual_clock_id;
+
+    PeriodicTask tasks[MAX_TASKS];
+    int task_count_ = 0;
+
+    struct timespec deadline;
+    bool deadline_initialized = false;
+
+    std::atomic<uint32_t> ticks{0};
+    std::atomic<uint32_t> overruns{0};
+    std::atomic<uint32_t> missed_ticks{0};
+    DurationHistogram jitter_;
+
+    PeriodicExecutor* next_ = nullptr;
+};
+
+/** Advances deadline by period until it is after now.
+ *
+ * @returns The number of deadlines which were skipped, 0 if the next one is
+ * still ahead.
+ */
+uint32_t periodic_deadline_advance(struct timespec* deadline, int64_t period_ns, const struct timespec* now);
+
+#endif /* PERIODIC_EXECUTOR_H */
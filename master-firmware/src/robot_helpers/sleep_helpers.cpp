@@ -0,0 +1,29 @@
+#include <thread>
+
+#include "sleep_helpers.h"
+
+/* Other threads (shell commands for example) can call the same helpers, and
+ * must keep sleeping in real time. */
+static thread_local virtual_clock_t* thread_clock = nullptr;
+static thread_local int thread_clock_id;
+
+void robot_sleep_join_virtual_clock(virtual_clock_t* clock, int id)
+{
+    if (clock == nullptr) {
+        return;
+    }
+
+    thread_clock = clock;
+    thread_clock_id = id;
+    virtual_clock_join(clock, id);
+}
+
+void robot_sleep(std::chrono::microseconds duration)
+{
+    if (thread_clock) {
+        virtual_clock_sleep_until(thread_clock, thread_clock_id,
+                                  virtual_clock_now(thread_clock) + duration.count());
+    } else {
+        std::this_thread::sleep_for(duration);
+    }
+}
@@ -0,0 +1,16 @@
+#ifndef SLEEP_HELPERS_H
+#define SLEEP_HELPERS_H
+
+#include <chrono>
+#include <virtual_clock/virtual_clock.h>
+
+/** Makes the calling thread the participant id of the simulator's virtual
+ * clock (see --virtual_clock), so that its calls to robot_sleep() wait in
+ * simulated time. Does nothing if clock is NULL. */
+void robot_sleep_join_virtual_clock(virtual_clock_t* clock, int id);
+
+/** Sleeps for the given duration, in simulated time if the calling thread
+ * joined the virtual clock, in real time otherwise. */
+void robot_sleep(std::chrono::microseconds duration);
+
+#endif /* SLEEP_HELPERS_H */
@@ -1,11 +1,11 @@
 // TODO: Define this once map is converted to Linux, then delete all USE_MAP
 // ifdefs
+#include <cmath>
 #include <unordered_map>
 #define USE_MAP 0
 #include <absl/time/time.h>
 #include <absl/synchronization/mutex.h>
 #include <absl/types/optional.h>
-#include <thread>
 
 #include <error/error.h>
 
@@ -16,8 +16,10 @@
 #include "base/map.h"
 #endif
 
+#include "base/opponent_tracking.h"
 #include "math_helpers.h"
 #include "beacon_helpers.h"
+#include "sleep_helpers.h"
 
 #include "protobuf/beacons.pb.h"
 #include "protobuf/ally_position.pb.h"
@@ -39,23 +41,22 @@ static const std::unordered_map<int, std::string> trajectory_reasons = {
 
 int trajectory_wait_for_end(int watched_end_reasons)
 {
-    std::this_thread::sleep_for(100ms);
+    robot_sleep(100ms);
     int traj_end_reason = 0;
     while (traj_end_reason == 0) {
         traj_end_reason = trajectory_has_ended(watched_end_reasons);
-        std::this_thread::sleep_for(1ms);
+        robot_sleep(1ms);
     }
 
     auto reason = trajectory_reasons.find(traj_end_reason);
+    auto pose = robot_pose_get();
 
     if (reason == trajectory_reasons.end()) {
         NOTICE("End of trajectory, UNKNOWN reason %d at %d %d %d",
-               traj_end_reason, position_get_x_s16(&robot.pos), position_get_y_s16(&robot.pos),
-               position_get_a_deg_s16(&robot.pos));
+               traj_end_reason, (int)pose.x, (int)pose.y, (int)DEGREES(pose.a));
     } else {
         NOTICE("End of trajectory: %s at %d %d %d",
-               reason->second.c_str(), position_get_x_s16(&robot.pos), position_get_y_s16(&robot.pos),
-               position_get_a_deg_s16(&robot.pos));
+               reason->second.c_str(), (int)pose.x, (int)pose.y, (int)DEGREES(pose.a));
     }
 
     return traj_end_reason;
@@ -63,7 +64,7 @@ int trajectory_wait_for_end(int watched_end_reasons)
 
 int trajectory_has_ended(int watched_end_reasons)
 {
-    absl::MutexLock _(&robot.lock);
+    absl::MutexLock _(&robot.control_lock);
     if ((watched_end_reasons & TRAJ_END_GOAL_REACHED) && trajectory_finished(&robot.traj)) {
         return TRAJ_END_GOAL_REACHED;
     }
@@ -85,19 +86,15 @@ int trajectory_has_ended(int watched_end_reasons)
 
 #if USE_MAP
     if (watched_end_reasons & TRAJ_END_OPPONENT_NEAR) {
-        BeaconSignal beacon_signal;
-        messagebus_topic_t* proximity_beacon_topic = messagebus_find_topic_blocking(&bus, "/proximity_beacon");
-
-        // only consider recent beacon signal
-        if (messagebus_topic_read(proximity_beacon_topic, &beacon_signal, sizeof(beacon_signal)) && timestamp_duration_s(beacon_signal.timestamp.us, timestamp_get()) < TRAJ_MAX_TIME_DELAY_OPPONENT_DETECTION && beacon_signal.range.range.distance < TRAJ_MIN_DISTANCE_TO_OPPONENT) {
-            float x_opp, y_opp;
-            beacon_cartesian_convert(&robot.pos,
-                                     1000 * beacon_signal.range.range.distance,
-                                     beacon_signal.range.angle,
-                                     &x_opp,
-                                     &y_opp);
-
-            if (trajectory_is_on_collision_path(&robot, x_opp, y_opp)) {
+        // Tracks without recent beacon signal are dropped by the tracker
+        opponent_estimate_t opponents[OPPONENT_TRACKER_MAX_TRACKS];
+        opponent_tracking_get(timestamp_get(), opponents);
+        auto pose = robot_pose_get();
+
+        for (const auto& opponent : opponents) {
+            float distance = std::hypot(opponent.x - pose.x, opponent.y - pose.y);
+            if (opponent.valid && distance < 1000 * TRAJ_MIN_DISTANCE_TO_OPPONENT
+                && trajectory_is_on_collision_path(&robot, opponent.x, opponent.y)) {
                 return TRAJ_END_OPPONENT_NEAR;
             }
         }
@@ -206,22 +203,22 @@ bool trajectory_crosses_obstacle(struct _robot* robot, poly_t* opponent, point_t
     return path_crosses_obstacle == 1 || current_pos_inside_obstacle;
 }
 
-#if USE_MAP
 bool trajectory_is_on_collision_path(struct _robot* robot, int x, int y)
 {
-    point_t points[4];
+    // Same square as the opponent obstacle of the map, see
+    // map_set_rectangular_obstacle()
+    const float half_size = (robot->opponent_size * 1.25f + robot->robot_size) / 2;
+    point_t points[4] = {
+        {x + half_size, y - half_size},
+        {x + half_size, y + half_size},
+        {x - half_size, y + half_size},
+        {x - half_size, y - half_size},
+    };
     poly_t opponent = {.pts = points, .l = 4};
-    map_set_rectangular_obstacle(&opponent,
-                                 x,
-                                 y,
-                                 robot->opponent_size * 1.25,
-                                 robot->opponent_size * 1.25,
-                                 robot->robot_size);
 
     point_t intersection;
     return trajectory_crosses_obstacle(robot, &opponent, &intersection);
 }
-#endif
 
 void trajectory_set_mode_aligning(
     enum board_mode_t* robot_mode,
@@ -2,19 +2,23 @@
 #define USE_MAP 0
 
 #include <array>
-#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cmath>
 
 #include <aversive/blocking_detection_manager/blocking_detection_manager.h>
 #include <aversive/obstacle_avoidance/obstacle_avoidance.h>
 #include <aversive/trajectory_manager/trajectory_manager_utils.h>
 #include <error/error.h>
 #include <goap/goap.hpp>
+#include <goap/background_planner.hpp>
 #include <timestamp/timestamp.h>
 
 #include "robot_helpers/math_helpers.h"
 #include "robot_helpers/trajectory_helpers.h"
 #include "robot_helpers/strategy_helpers.h"
 #include "robot_helpers/motor_helpers.h"
+#include "robot_helpers/sleep_helpers.h"
 #include "base/base_controller.h"
 
 #if USE_MAP
@@ -31,13 +35,23 @@
 #include "strategy/actions.h"
 #include "strategy/goals.h"
 #include "strategy/state.h"
+#include "strategy/travel_time.h"
 
 using namespace std::chrono_literals;
 
 // TODO(antoinealb): Move GOAP defines to something shared with unit tests
 const int MAX_GOAP_PATH_LEN = 10;
 
-static goap::Planner<StrategyState, GOAP_SPACE_SIZE> planner;
+/* Plans are searched in the background while the robot moves, for the states
+ * the strategy may be in once the current action is done. The cache holds
+ * those speculations (two outcomes for each goal) as well as the
+ * continuations of the current plans. */
+using StrategyPlanner = goap::BackgroundPlanner<StrategyState, StrategyStateHash, GOAP_SPACE_SIZE, 32, MAX_GOAP_PATH_LEN>;
+
+/* Resolution of the robot position recorded after a failed action [mm] */
+const int FAILURE_POSITION_GRID_MM = 100;
+
+static std::atomic<bool> planner_started{false};
 
 static enum strat_color_t wait_for_color_selection();
 static void wait_for_autoposition_signal();
@@ -51,10 +65,10 @@ static enum strat_color_t wait_for_color_selection()
     while (!control_panel_button_is_pressed(BUTTON_YELLOW) && !control_panel_button_is_pressed(BUTTON_GREEN)) {
         control_panel_set(LED_YELLOW);
         control_panel_set(LED_GREEN);
-        std::this_thread::sleep_for(100ms);
+        robot_sleep(100ms);
         control_panel_clear(LED_YELLOW);
         control_panel_clear(LED_GREEN);
-        std::this_thread::sleep_for(100ms);
+        robot_sleep(100ms);
     }
 
     if (control_panel_button_is_pressed(BUTTON_GREEN)) {
@@ -84,10 +98,10 @@ static void wait_for_starter()
 
         /* Wait for a rising edge */
         while (control_panel_read(STARTER)) {
-            std::this_thread::sleep_for(10ms);
+            robot_sleep(10ms);
         }
         while (!control_panel_read(STARTER)) {
-            std::this_thread::sleep_for(10ms);
+            robot_sleep(10ms);
             starter_armed_time_ms += 10;
 
             /* indicate that starter is armed */
@@ -114,6 +128,27 @@ actions::BackwardReefPickup backward_reef_pickup;
 
 actions::RaiseWindsock windsocks[2] = {{0}, {1}};
 
+/* Created on first use, as it starts the planning thread */
+static StrategyPlanner& strategy_planner()
+{
+    static std::vector<goap::Action<StrategyState>*> action_ptrs = []() {
+        auto actions = strategy_get_actions();
+        return std::vector<goap::Action<StrategyState>*>(actions.begin(), actions.end());
+    }();
+    static StrategyPlanner planner(action_ptrs.data(), action_ptrs.size());
+
+    planner_started = true;
+    return planner;
+}
+
+StrategyPlanningStats strategy_planning_stats_get()
+{
+    if (!planner_started) {
+        return {};
+    }
+    return strategy_planner().get_stats();
+}
+
 std::vector<actions::NamedAction<StrategyState>*> strategy_get_actions()
 {
     // Put all the actions the robot should consider in here.
@@ -125,6 +160,18 @@ std::vector<actions::NamedAction<StrategyState>*> strategy_get_actions()
     }};
 }
 
+/* Measured robot position, rounded to the failure grid. A failed action
+ * leaves the robot wherever it stopped, so its state only matches a speculated
+ * one once rounded, typically when it failed before getting far. */
+static actions::TablePoint measured_position(void)
+{
+    auto pose = robot_pose_get();
+    auto round = [](float mm) {
+        return (int)std::lround(mm / FAILURE_POSITION_GRID_MM) * FAILURE_POSITION_GRID_MM;
+    };
+    return {round(pose.x), round(pose.y)};
+}
+
 void strategy_order_play_game(StrategyState& state, enum strat_color_t color)
 {
     messagebus_topic_t* state_topic = messagebus_find_topic_blocking(&bus, "/state");
@@ -146,34 +193,57 @@ void strategy_order_play_game(StrategyState& state, enum strat_color_t color)
 #endif
 
     robot.base_speed = BASE_SPEED_FAST;
+    auto pose = robot_pose_get();
     NOTICE("Robot positioned at x: %d[mm], y: %d[mm], a: %d[deg]",
-           position_get_x_s16(&robot.pos), position_get_y_s16(&robot.pos), position_get_a_deg_s16(&robot.pos));
+           (int)pose.x, (int)pose.y, (int)DEGREES(pose.a));
+    actions::set_robot_position(state, {(int)pose.x, (int)pose.y});
 
     /* Wait for starter to begin */
 #if 0
     wait_for_starter();
 #else
-    std::this_thread::sleep_for(2s);
+    robot_sleep(2s);
 #endif
 
     trajectory_game_timer_reset();
 
     NOTICE("Starting game...");
 
-    auto actions = strategy_get_actions();
-    std::vector<goap::Action<StrategyState>*> action_ptrs;
-    std::transform(actions.begin(), actions.end(), std::back_inserter(action_ptrs),
-                   [](actions::NamedAction<StrategyState>* p) { return p; });
+    auto& planner = strategy_planner();
+    auto& oracle = travel_time_oracle();
 
     // Always find a non complete goal, find actions to fulfill it, then apply
     // those actions.
     while (!trajectory_game_has_ended()) {
         for (auto* goal : goals) {
-            int len = planner.plan(state, *goal,
-                                   action_ptrs.data(),
-                                   action_ptrs.size(), path, MAX_GOAP_PATH_LEN);
+            int len = planner.plan(state, *goal, path, MAX_GOAP_PATH_LEN);
             for (int i = 0; i < len; i++) {
+                // While the action runs, plan from where it should leave us,
+                // and from where we are in case it fails.
+                std::array<StrategyState, 2> outcomes = {state, state};
+                path[i]->plan_effects(outcomes[0]);
+                actions::set_robot_position(outcomes[1], measured_position());
+
+                // Costs are the travel times with the current speed and
+                // obstacles, plans found with other costs are outdated.
+                bool costs_changed = oracle.set_limits(travel_limits_from_trajectory(&robot.traj));
+                // Obstacles come from the map server, which is not ported
+                // yet: until then the oracle assumes straight lines.
+#if USE_MAP
+                auto map = map_server_map_lock_and_get();
+                costs_changed |= oracle.set_obstacles(&map->oa);
+                map_server_map_release(map);
+#endif
+                if (costs_changed) {
+                    planner.invalidate();
+                }
+                planner.speculate(outcomes.data(), outcomes.size(), goals.data(), goals.size());
+
                 bool success = path[i]->execute(state);
+                if (!success) {
+                    // Plan again from wherever the action left us
+                    actions::set_robot_position(state, measured_position());
+                }
                 messagebus_topic_publish(state_topic, &state, sizeof(state));
                 if (!success) {
                     break; // Break on failure
@@ -1,11 +1,19 @@
 #ifndef STRATEGY_H
 #define STRATEGY_H
 
+#include <cstdint>
 #include <vector>
+#include <goap/background_planner.hpp>
 #include "strategy/actions.h"
 
 void strategy_play_game();
 
+/** Time spent by the strategy in the GOAP planner, in real time, and time
+ * it waited for plans (idle). */
+using StrategyPlanningStats = goap::BackgroundPlannerStats;
+
+StrategyPlanningStats strategy_planning_stats_get();
+
 std::vector<actions::NamedAction<StrategyState>*> strategy_get_actions();
 
 #endif /* STRATEGY_H */
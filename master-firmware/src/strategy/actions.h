@@ -12,6 +12,19 @@
 
 namespace actions {
 
+/** Position on the table, in mm. */
+struct TablePoint {
+    int x, y;
+};
+
+/** Cost of an action in milliseconds: the time needed to reach its start
+ * point from where the state expects the robot to be, plus the time spent
+ * there. */
+int motion_cost(const StrategyState& state, TablePoint start, int work_ms);
+
+/** Records where the robot is expected to be after an action. */
+void set_robot_position(StrategyState& state, TablePoint point);
+
 template <class T>
 class NamedAction : public goap::Action<T> {
 public:
@@ -22,9 +35,13 @@ public:
  * lighthouse. */
 class EnableLighthouse : public NamedAction<StrategyState> {
 public:
+    static constexpr TablePoint start = {525, 300};
+    static constexpr TablePoint end = {225, 300};
+
     bool can_run(const StrategyState& state) override;
     void plan_effects(StrategyState& state) override;
     bool execute(StrategyState& state) override;
+    int cost(const StrategyState& state) override;
     std::string get_name() override
     {
         return "lighthouse";
@@ -42,6 +59,11 @@ public:
     bool can_run(const StrategyState& state) override;
     void plan_effects(StrategyState& state) override;
     bool execute(StrategyState& state) override;
+    int cost(const StrategyState& state) override;
+
+    int windsock_x() const;
+    TablePoint start() const;
+    TablePoint end() const;
 
     std::string get_name() override
     {
@@ -51,9 +73,13 @@ public:
 
 class BackwardReefPickup : public NamedAction<StrategyState> {
 public:
+    static constexpr TablePoint start = {500, 1525};
+    static constexpr TablePoint end = {300, 1525};
+
     bool can_run(const StrategyState& state) override;
     void plan_effects(StrategyState& state) override;
     bool execute(StrategyState& state) override;
+    int cost(const StrategyState& state) override;
 
     std::string get_name() override
     {
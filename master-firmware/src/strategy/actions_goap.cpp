@@ -4,10 +4,38 @@
  * should go to actions_impl.cpp
  */
 
+#include <algorithm>
+#include <cmath>
 #include "actions.h"
+#include "travel_time.h"
 
 using namespace actions;
 
+constexpr TablePoint EnableLighthouse::start;
+constexpr TablePoint EnableLighthouse::end;
+constexpr TablePoint BackwardReefPickup::start;
+constexpr TablePoint BackwardReefPickup::end;
+
+int actions::motion_cost(const StrategyState& state, TablePoint start, int work_ms)
+{
+    int travel_ms = 0;
+
+    /* Without a known position, only the work itself is accounted for */
+    if (state.robot.has_x && state.robot.has_y) {
+        travel_ms = travel_time_oracle().time_ms(state.robot.x, state.robot.y, start.x, start.y);
+    }
+
+    return std::max(1, travel_ms + work_ms);
+}
+
+void actions::set_robot_position(StrategyState& state, TablePoint point)
+{
+    state.robot.has_x = true;
+    state.robot.x = point.x;
+    state.robot.has_y = true;
+    state.robot.y = point.y;
+}
+
 bool EnableLighthouse::can_run(const StrategyState& state)
 {
     (void)state;
@@ -17,6 +45,20 @@ bool EnableLighthouse::can_run(const StrategyState& state)
 void EnableLighthouse::plan_effects(StrategyState& state)
 {
     state.lighthouse_is_on = true;
+    set_robot_position(state, end);
+}
+
+int EnableLighthouse::cost(const StrategyState& state)
+{
+    auto& oracle = travel_time_oracle();
+
+    /* Backs up next to the lighthouse, turns, pushes the button and leaves */
+    int work_ms = oracle.straight_ms(std::hypot(start.x - 225, start.y - 400))
+        + oracle.turn_ms(M_PI / 2)
+        + oracle.straight_ms(300)
+        + oracle.straight_ms(200);
+
+    return motion_cost(state, start, work_ms);
 }
 
 RaiseWindsock::RaiseWindsock(int windsock_index)
@@ -33,6 +75,34 @@ bool RaiseWindsock::can_run(const StrategyState& state)
 void RaiseWindsock::plan_effects(StrategyState& state)
 {
     state.windsocks_are_up[windsock_index] = true;
+    set_robot_position(state, end());
+}
+
+int RaiseWindsock::windsock_x() const
+{
+    return windsock_index == 0 ? 2770 : 2365;
+}
+
+TablePoint RaiseWindsock::start() const
+{
+    return {windsock_x() - 100, 1500};
+}
+
+TablePoint RaiseWindsock::end() const
+{
+    return {windsock_x() + 100, 2000 - 150};
+}
+
+int RaiseWindsock::cost(const StrategyState& state)
+{
+    auto& oracle = travel_time_oracle();
+
+    /* Goes to the border, turns and pushes the windsock along it */
+    int work_ms = oracle.straight_ms(end().y - start().y)
+        + oracle.turn_ms(M_PI / 2)
+        + oracle.straight_ms(end().x - start().x);
+
+    return motion_cost(state, start(), work_ms);
 }
 
 bool BackwardReefPickup::can_run(const StrategyState& state)
@@ -64,4 +134,21 @@ void BackwardReefPickup::plan_effects(StrategyState& state)
     state.our_dispenser.glasses[0] = GlassColor_UNKNOWN;
     state.our_dispenser.glasses[1] = GlassColor_UNKNOWN;
     state.our_dispenser.glasses[2] = GlassColor_UNKNOWN;
+
+    set_robot_position(state, end);
+}
+
+int BackwardReefPickup::cost(const StrategyState& state)
+{
+    auto& oracle = travel_time_oracle();
+
+    /* Turns, backs into the reef and leaves, waiting for the arms and the
+     * glasses in between */
+    int work_ms = oracle.turn_ms(M_PI / 2)
+        + 500
+        + oracle.straight_ms(300)
+        + 400
+        + oracle.straight_ms(100);
+
+    return motion_cost(state, start, work_ms);
 }
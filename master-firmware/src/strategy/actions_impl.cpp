@@ -1,7 +1,7 @@
-#include <thread>
 #include <error/error.h>
 #include "actions.h"
 #include "robot_helpers/trajectory_helpers.h"
+#include "robot_helpers/sleep_helpers.h"
 
 using namespace std::chrono_literals;
 
@@ -14,7 +14,7 @@ bool actions::EnableLighthouse::execute(StrategyState& state)
 
     // Go in front of lighthouse
     NOTICE("Going to the lighthouse");
-    trajectory_goto_forward_xy_abs(&robot.traj, 525, 300);
+    trajectory_goto_forward_xy_abs(&robot.traj, start.x, start.y);
     res = trajectory_wait_for_end(TRAJ_FLAGS_ALL);
     if (res != TRAJ_END_GOAL_REACHED) {
         WARNING("Could not go to lighthouse: %d", res);
@@ -41,7 +41,7 @@ bool actions::EnableLighthouse::execute(StrategyState& state)
     trajectory_d_rel(&robot.traj, 300);
     trajectory_wait_for_end(TRAJ_FLAGS_SHORT_DISTANCE);
 
-    if (position_get_y_double(&robot.pos) > 150) {
+    if (robot_pose_get().y > 150) {
         WARNING("Could not get close enough to trigger lighthouse...");
         return false;
     }
@@ -51,6 +51,7 @@ bool actions::EnableLighthouse::execute(StrategyState& state)
 
     trajectory_d_rel(&robot.traj, -200);
     trajectory_wait_for_end(TRAJ_FLAGS_SHORT_DISTANCE);
+    set_robot_position(state, end);
 
     return true;
 }
@@ -60,24 +61,17 @@ bool actions::RaiseWindsock::execute(StrategyState& state)
     (void)state;
     NOTICE("Raising windsock #%d", windsock_index);
 
-    int windsock_x;
     int res;
 
-    if (windsock_index == 0) {
-        windsock_x = 2770;
-    } else {
-        windsock_x = 2365;
-    }
-
     // TODO: Use proper obstacle avoidance instead
-    trajectory_goto_xy_abs(&robot.traj, windsock_x - 100, 1500);
+    trajectory_goto_xy_abs(&robot.traj, start().x, start().y);
     res = trajectory_wait_for_end(TRAJ_FLAGS_ALL);
     if (res != TRAJ_END_GOAL_REACHED) {
         WARNING("Could not go to windsock!");
         return false;
     }
 
-    trajectory_goto_xy_abs(&robot.traj, windsock_x - 100, 2000 - 150);
+    trajectory_goto_xy_abs(&robot.traj, start().x, end().y);
     res = trajectory_wait_for_end(TRAJ_FLAGS_ALL);
     if (res != TRAJ_END_GOAL_REACHED) {
         WARNING("Could not go to windsock!");
@@ -99,6 +93,7 @@ bool actions::RaiseWindsock::execute(StrategyState& state)
     }
 
     state.windsocks_are_up[windsock_index] = true;
+    set_robot_position(state, end());
 
     return true;
 }
@@ -106,7 +101,7 @@ bool actions::RaiseWindsock::execute(StrategyState& state)
 bool actions::BackwardReefPickup::execute(StrategyState& state)
 {
     WARNING("picking up glasses at our dispenser");
-    trajectory_goto_xy_abs(&robot.traj, 500, 1525);
+    trajectory_goto_xy_abs(&robot.traj, start.x, start.y);
 
     auto res = trajectory_wait_for_end(TRAJ_FLAGS_ALL);
     if (res != TRAJ_END_GOAL_REACHED) {
@@ -124,7 +119,7 @@ bool actions::BackwardReefPickup::execute(StrategyState& state)
     }
 
     // Give the robot some time to converge
-    std::this_thread::sleep_for(500ms);
+    robot_sleep(500ms);
 
     // TODO: Check that this distance is enough
     trajectory_d_rel(&robot.traj, -300);
@@ -134,7 +129,7 @@ bool actions::BackwardReefPickup::execute(StrategyState& state)
     }
 
     // give time to catch the glasses
-    std::this_thread::sleep_for(400ms);
+    robot_sleep(400ms);
 
     state.robot.back_left_glass = state.our_dispenser.glasses[0];
     state.robot.back_center_glass = state.our_dispenser.glasses[1];
@@ -149,5 +144,7 @@ bool actions::BackwardReefPickup::execute(StrategyState& state)
         return false;
     }
 
+    set_robot_position(state, end);
+
     return true;
 }
@@ -2,6 +2,7 @@
 #define STRATEGY_STATE_H
 
 #include <stdint.h>
+#include <goap/goap.hpp>
 
 #include "table.h"
 
@@ -12,4 +13,8 @@
 StrategyState initial_state(void);
 bool operator==(const StrategyState& lhs, const StrategyState& rhs);
 
+/** Hash for the planners. StrategyState is a packed struct, compared with
+ * memcmp, so its bytes can be hashed directly. */
+using StrategyStateHash = goap::BytewiseHash<StrategyState>;
+
 #endif /* STRATEGY_STATE_H */
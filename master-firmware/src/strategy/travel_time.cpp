@@ -0,0 +1,205 @@
+#include <cmath>
+#include <cstring>
+#include <aversive/trajectory_manager/trajectory_manager_utils.h>
+
+#include "travel_time.h"
+
+TravelLimits travel_limits_default(void)
+{
+    return {600.f, 3000.f, 6.f, 30.f};
+}
+
+TravelLimits travel_limits_from_trajectory(struct trajectory* traj)
+{
+    TravelLimits limits;
+
+    limits.distance_speed = speed_imp2mm(traj, traj->d_speed);
+    limits.distance_acc = acc_imp2mm(traj, traj->d_acc);
+    limits.angle_speed = speed_imp2rd(traj, traj->a_speed);
+    limits.angle_acc = acc_imp2rd(traj, traj->a_acc);
+
+    return limits;
+}
+
+float travel_time_trapezoidal(float distance, float speed, float acc)
+{
+    distance = std::fabs(distance);
+
+    /* Distance needed to reach full speed and stop again */
+    if (distance < speed * speed / acc) {
+        /* Triangular profile, full speed is never reached */
+        return 2 * std::sqrt(distance / acc);
+    }
+
+    return distance / speed + speed / acc;
+}
+
+static int16_t grid_index(int mm)
+{
+    return std::lround(mm / (float)TravelTimeOracle::GRID_MM);
+}
+
+static int to_ms(float seconds)
+{
+    return std::lround(seconds * 1000);
+}
+
+const int TravelTimeOracle::UNREACHABLE_MS;
+const int TravelTimeOracle::GRID_MM;
+const size_t TravelTimeOracle::CACHE_SIZE;
+
+TravelTimeOracle::TravelTimeOracle()
+    : limits(travel_limits_default())
+    , oa(new struct obstacle_avoidance)
+{
+    oa_init(oa.get());
+}
+
+bool TravelTimeOracle::set_limits(const TravelLimits& new_limits)
+{
+    std::lock_guard<std::mutex> l(lock);
+    if (!memcmp(&limits, &new_limits, sizeof(limits))) {
+        return false;
+    }
+    limits = new_limits;
+    cache.clear();
+    return true;
+}
+
+/* Polygon 0 only holds the start and end points of the last search */
+static bool same_obstacles(const struct obstacle_avoidance* a, const struct obstacle_avoidance* b)
+{
+    if (a->cur_poly_idx != b->cur_poly_idx) {
+        return false;
+    }
+
+    for (int i = 1; i < a->cur_poly_idx; i++) {
+        if (a->polys[i].l != b->polys[i].l) {
+            return false;
+        }
+        for (int j = 0; j < a->polys[i].l; j++) {
+            if (a->polys[i].pts[j].x != b->polys[i].pts[j].x || a->polys[i].pts[j].y != b->polys[i].pts[j].y) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool TravelTimeOracle::set_obstacles(const struct obstacle_avoidance* new_oa)
+{
+    std::lock_guard<std::mutex> l(lock);
+    if (has_obstacles && same_obstacles(oa.get(), new_oa)) {
+        return false;
+    }
+    oa_copy(oa.get(), new_oa);
+    has_obstacles = true;
+    cache.clear();
+    return true;
+}
+
+int TravelTimeOracle::time_ms(int from_x, int from_y, int to_x, int to_y)
+{
+    const int16_t grid[4] = {grid_index(from_x), grid_index(from_y), grid_index(to_x), grid_index(to_y)};
+
+    uint64_t key = 0;
+    for (auto index : grid) {
+        key = (key << 16) | (uint16_t)index;
+    }
+
+    std::lock_guard<std::mutex> l(lock);
+
+    auto cached = cache.find(key);
+    if (cached != cache.end()) {
+        hits++;
+        return cached->second;
+    }
+    misses++;
+
+    /* Computed from the grid points, so that the cached value does not
+     * depend on which query came first */
+    float seconds = path_time(grid[0] * GRID_MM, grid[1] * GRID_MM, grid[2] * GRID_MM, grid[3] * GRID_MM);
+    int ms = seconds < 0 ? UNREACHABLE_MS : to_ms(seconds);
+
+    if (cache.size() >= CACHE_SIZE) {
+        cache.clear();
+    }
+    cache[key] = ms;
+
+    return ms;
+}
+
+/* Must be called with the lock held. Returns a negative time if there is no
+ * path. */
+float TravelTimeOracle::path_time(int from_x, int from_y, int to_x, int to_y)
+{
+    point_t direct = {(float)to_x, (float)to_y};
+    point_t* points = &direct;
+    int len = 1;
+
+    if (has_obstacles) {
+        oa_start_end_points(oa.get(), from_x, from_y, to_x, to_y);
+        if (oa_process(oa.get()) <= 0) {
+            return -1;
+        }
+        len = oa_get_path(oa.get(), &points);
+    }
+
+    float seconds = 0;
+    float x = from_x, y = from_y;
+    float heading = NAN;
+
+    for (int i = 0; i < len; i++) {
+        float dx = points[i].x - x;
+        float dy = points[i].y - y;
+        float distance = std::sqrt(dx * dx + dy * dy);
+        if (distance == 0) {
+            continue;
+        }
+
+        /* The robot stops and turns at each corner of the path */
+        float segment_heading = std::atan2(dy, dx);
+        if (!std::isnan(heading)) {
+            float turn = std::remainder(segment_heading - heading, 2 * M_PI);
+            seconds += travel_time_trapezoidal(turn, limits.angle_speed, limits.angle_acc);
+        }
+        seconds += travel_time_trapezoidal(distance, limits.distance_speed, limits.distance_acc);
+
+        heading = segment_heading;
+        x = points[i].x;
+        y = points[i].y;
+    }
+
+    return seconds;
+}
+
+int TravelTimeOracle::straight_ms(float distance)
+{
+    std::lock_guard<std::mutex> l(lock);
+    return to_ms(travel_time_trapezoidal(distance, limits.distance_speed, limits.distance_acc));
+}
+
+int TravelTimeOracle::turn_ms(float angle)
+{
+    std::lock_guard<std::mutex> l(lock);
+    return to_ms(travel_time_trapezoidal(angle, limits.angle_speed, limits.angle_acc));
+}
+
+unsigned TravelTimeOracle::cache_hits()
+{
+    std::lock_guard<std::mutex> l(lock);
+    return hits;
+}
+
+unsigned TravelTimeOracle::cache_misses()
+{
+    std::lock_guard<std::mutex> l(lock);
+    return misses;
+}
+
+TravelTimeOracle& travel_time_oracle(void)
+{
+    static TravelTimeOracle oracle;
+    return oracle;
+}
@@ -0,0 +1,98 @@
+#ifndef STRATEGY_TRAVEL_TIME_H
+#define STRATEGY_TRAVEL_TIME_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <aversive/obstacle_avoidance/obstacle_avoidance.h>
+#include <aversive/trajectory_manager/trajectory_manager.h>
+
+/** Speed and acceleration limits of the robot. */
+struct TravelLimits {
+    float distance_speed; /**< mm/s */
+    float distance_acc; /**< mm/s^2 */
+    float angle_speed; /**< rad/s */
+    float angle_acc; /**< rad/s^2 */
+};
+
+/** Limits set by the base controller at startup. */
+TravelLimits travel_limits_default(void);
+
+/** Reads the current limits of a trajectory manager. */
+TravelLimits travel_limits_from_trajectory(struct trajectory* traj);
+
+/** Time needed to cover a distance (or an angle) from standstill to
+ * standstill, with the trapezoidal speed profile of the trajectory manager,
+ * in seconds. */
+float travel_time_trapezoidal(float distance, float speed, float acc);
+
+/** Estimates how long the robot needs to go from one point of the table to
+ * another, following the path found by the obstacle avoidance and turning at
+ * each of its corners.
+ *
+ * Results are cached on a GRID_MM grid until the obstacles or the limits
+ * change. It is thread-safe, so that actions can use it to compute their cost
+ * on the background planning thread.
+ */
+class TravelTimeOracle {
+public:
+    /** Returned when no path exists, longer than a match. */
+    static const int UNREACHABLE_MS = 1000000;
+
+    /** Resolution of the cache, in mm. */
+    static const int GRID_MM = 10;
+
+    /** Bound on the number of cached paths. */
+    static const size_t CACHE_SIZE = 1024;
+
+    TravelTimeOracle();
+
+    TravelTimeOracle(const TravelTimeOracle&) = delete;
+    TravelTimeOracle& operator=(const TravelTimeOracle&) = delete;
+
+    /** Sets the limits, clearing the cache if they changed.
+     *
+     * @returns true if they changed, in which case plans using the travel
+     * times must be invalidated. */
+    bool set_limits(const TravelLimits& limits);
+
+    /** Copies the obstacles to avoid. Until this is called, the robot is
+     * assumed to move in straight lines.
+     *
+     * @returns true if they changed, see set_limits(). */
+    bool set_obstacles(const struct obstacle_avoidance* oa);
+
+    /** Travel time between two points in mm, in milliseconds, or
+     * UNREACHABLE_MS. The initial heading of the robot is not taken into
+     * account. */
+    int time_ms(int from_x, int from_y, int to_x, int to_y);
+
+    /** Time needed to go straight over a distance in mm, in milliseconds. */
+    int straight_ms(float distance);
+
+    /** Time needed to turn by an angle in radians, in milliseconds. */
+    int turn_ms(float angle);
+
+    unsigned cache_hits();
+    unsigned cache_misses();
+
+private:
+    float path_time(int from_x, int from_y, int to_x, int to_y);
+
+    std::mutex lock;
+    TravelLimits limits;
+
+    /* Too large for the stack of the planning thread */
+    std::unique_ptr<struct obstacle_avoidance> oa;
+    bool has_obstacles = false;
+
+    std::unordered_map<uint64_t, int> cache;
+    unsigned hits = 0, misses = 0;
+};
+
+/** Oracle used by the strategy actions. */
+TravelTimeOracle& travel_time_oracle(void);
+
+#endif /* STRATEGY_TRAVEL_TIME_H */
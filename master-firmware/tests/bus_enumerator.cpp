@@ -143,6 +143,53 @@ TEST(BusEnumeratorTestGroup, UpdateNodeInfoWorksOnlyOnce)
     CHECK_EQUAL(LARGE_CAN_ID, en.can_to_str[0].can_id);
 }
 
+TEST(BusEnumeratorTestGroup, RemoveCanId)
+{
+    bus_enumerator_add_node(&en, SMALL_STR_ID, DRIVER_POINTER);
+    bus_enumerator_add_node(&en, LARGE_STR_ID, DRIVER_POINTER);
+    bus_enumerator_update_node_info(&en, SMALL_STR_ID, SMALL_CAN_ID);
+    bus_enumerator_update_node_info(&en, LARGE_STR_ID, LARGE_CAN_ID);
+
+    bus_enumerator_remove_can_id(&en, SMALL_CAN_ID);
+
+    CHECK_EQUAL(2, bus_enumerator_total_nodes_count(&en));
+    CHECK_EQUAL(1, bus_enumerator_discovered_nodes_count(&en));
+    POINTERS_EQUAL(NULL, bus_enumerator_get_str_id(&en, SMALL_CAN_ID));
+    CHECK_EQUAL(BUS_ENUMERATOR_CAN_ID_NOT_SET, bus_enumerator_get_can_id(&en, SMALL_STR_ID));
+    STRCMP_EQUAL(LARGE_STR_ID, bus_enumerator_get_str_id(&en, LARGE_CAN_ID));
+}
+
+TEST(BusEnumeratorTestGroup, CanIdCanBeReassignedAfterRemoval)
+{
+    bus_enumerator_add_node(&en, SMALL_STR_ID, DRIVER_POINTER);
+    bus_enumerator_add_node(&en, LARGE_STR_ID, DRIVER_POINTER);
+    bus_enumerator_update_node_info(&en, SMALL_STR_ID, SMALL_CAN_ID);
+
+    bus_enumerator_remove_can_id(&en, SMALL_CAN_ID);
+    bus_enumerator_update_node_info(&en, LARGE_STR_ID, SMALL_CAN_ID);
+
+    STRCMP_EQUAL(LARGE_STR_ID, bus_enumerator_get_str_id(&en, SMALL_CAN_ID));
+    CHECK_EQUAL(1, en.nb_entries_can_to_str);
+}
+
+TEST(BusEnumeratorTestGroup, GenerationChangesWithTheMapping)
+{
+    bus_enumerator_add_node(&en, SMALL_STR_ID, DRIVER_POINTER);
+    uint32_t generation = en.generation;
+
+    bus_enumerator_update_node_info(&en, SMALL_STR_ID, SMALL_CAN_ID);
+    CHECK(generation != en.generation);
+    generation = en.generation;
+
+    /* Nothing changes */
+    bus_enumerator_update_node_info(&en, SMALL_STR_ID, SMALL_CAN_ID);
+    bus_enumerator_remove_can_id(&en, LARGE_CAN_ID);
+    CHECK_EQUAL(generation, en.generation);
+
+    bus_enumerator_remove_can_id(&en, SMALL_CAN_ID);
+    CHECK(generation != en.generation);
+}
+
 TEST(BusEnumeratorTestGroup, GetNumberOfEntries)
 {
     bus_enumerator_add_node(&en, LARGE_STR_ID, DRIVER_POINTER);
@@ -0,0 +1,116 @@
+#include <CppUTest/TestHarness.h>
+#include "can/motor_driver.h"
+#include <parameter/parameter.h>
+
+TEST_GROUP (MotorDriverTrajectoryTestGroup) {
+    motor_driver_t drv;
+    parameter_namespace_t ns;
+    motor_trajectory_segment_t segment;
+
+    void setup() override
+    {
+        parameter_namespace_declare(&ns, nullptr, nullptr);
+        motor_driver_init(&drv, "left-wheel", &ns);
+        motor_trajectory_segment_hermite(&segment, 1000, 10000, 0, 0, 1, 0);
+    }
+
+    bool pop(motor_trajectory_segment_t* s)
+    {
+        motor_driver_lock(&drv);
+        bool res = motor_driver_pop_trajectory_segment(&drv, s);
+        motor_driver_unlock(&drv);
+        return res;
+    }
+};
+
+TEST(MotorDriverTrajectoryTestGroup, PushingSwitchesToTrajectoryMode)
+{
+    CHECK_TRUE(motor_driver_push_trajectory_segment(&drv, &segment));
+
+    CHECK_EQUAL(MOTOR_CONTROL_MODE_TRAJECTORY, motor_driver_get_control_mode(&drv));
+}
+
+TEST(MotorDriverTrajectoryTestGroup, SegmentsArePoppedInOrder)
+{
+    motor_trajectory_segment_t res;
+    motor_driver_push_trajectory_segment(&drv, &segment);
+    segment.start = 11000;
+    motor_driver_push_trajectory_segment(&drv, &segment);
+
+    CHECK_TRUE(pop(&res));
+    CHECK_EQUAL(1000, res.start);
+    CHECK_TRUE(pop(&res));
+    CHECK_EQUAL(11000, res.start);
+    CHECK_FALSE(pop(&res));
+}
+
+TEST(MotorDriverTrajectoryTestGroup, RefusesSegmentsWhenQueueIsFull)
+{
+    for (int i = 0; i < MOTOR_TRAJECTORY_QUEUE_LEN; i++) {
+        CHECK_TRUE(motor_driver_push_trajectory_segment(&drv, &segment));
+    }
+
+    CHECK_FALSE(motor_driver_push_trajectory_segment(&drv, &segment));
+}
+
+TEST(MotorDriverTrajectoryTestGroup, ChangingModeClearsTheQueue)
+{
+    motor_trajectory_segment_t res;
+    motor_driver_push_trajectory_segment(&drv, &segment);
+
+    motor_driver_set_velocity(&drv, 1);
+
+    CHECK_FALSE(pop(&res));
+    motor_driver_push_trajectory_segment(&drv, &segment);
+    CHECK_TRUE(pop(&res));
+    CHECK_FALSE(pop(&res));
+}
+
+TEST(MotorDriverTrajectoryTestGroup, RemembersLastSegmentSent)
+{
+    motor_trajectory_segment_t res;
+    motor_driver_lock(&drv);
+    CHECK_FALSE(motor_driver_get_last_trajectory_segment(&drv, 0, &res));
+    motor_driver_unlock(&drv);
+
+    motor_driver_push_trajectory_segment(&drv, &segment);
+    pop(&res);
+
+    motor_driver_lock(&drv);
+    CHECK_TRUE(motor_driver_get_last_trajectory_segment(&drv, 5000, &res));
+    motor_driver_unlock(&drv);
+    CHECK_EQUAL(1000, res.start);
+}
+
+TEST(MotorDriverTrajectoryTestGroup, FinishedSegmentIsNotRepeated)
+{
+    motor_trajectory_segment_t res;
+    motor_driver_push_trajectory_segment(&drv, &segment);
+    pop(&res);
+
+    motor_driver_lock(&drv);
+    CHECK_TRUE(motor_driver_get_last_trajectory_segment(&drv, 11000, &res));
+    CHECK_FALSE(motor_driver_get_last_trajectory_segment(&drv, 11001, &res));
+    motor_driver_unlock(&drv);
+}
+
+static float position(const motor_trajectory_segment_t& s, float t)
+{
+    return s.coeffs[0] + s.coeffs[1] * t + s.coeffs[2] * t * t + s.coeffs[3] * t * t * t;
+}
+
+static float velocity(const motor_trajectory_segment_t& s, float t)
+{
+    return s.coeffs[1] + 2 * s.coeffs[2] * t + 3 * s.coeffs[3] * t * t;
+}
+
+TEST(MotorDriverTrajectoryTestGroup, HermiteSegmentMatchesEndpoints)
+{
+    motor_trajectory_segment_hermite(&segment, 0, 500000, 1, 2, 3, -1);
+
+    DOUBLES_EQUAL(1, position(segment, 0), 1e-5);
+    DOUBLES_EQUAL(2, velocity(segment, 0), 1e-5);
+    DOUBLES_EQUAL(3, position(segment, 0.5), 1e-5);
+    DOUBLES_EQUAL(-1, velocity(segment, 0.5), 1e-5);
+    CHECK_EQUAL(500000, segment.duration);
+}
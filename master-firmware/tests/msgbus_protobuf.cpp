@@ -55,6 +55,23 @@ TEST(MessagebusProtobufIntegration, CanCreateTopic)
     CHECK_EQUAL(Timestamp_msgid, topic.metadata.msgid);
 }
 
+TEST(MessagebusProtobufIntegration, TopicDoesNotUseSeqlockByDefault)
+{
+    TOPIC_DECL(topic, Timestamp);
+
+    CHECK_FALSE(topic.topic.seqlock);
+}
+
+TEST(MessagebusProtobufIntegration, CanCreateSeqlockTopic)
+{
+    TOPIC_DECL_SEQLOCK(topic, Timestamp);
+
+    CHECK_TRUE(topic.topic.seqlock);
+    POINTERS_EQUAL(&topic.var, topic.topic.lock);
+    POINTERS_EQUAL(&topic.value, topic.topic.buffer);
+    POINTERS_EQUAL(&topic.metadata, topic.topic.metadata);
+}
+
 TEST(MessagebusProtobufIntegration, CanPublishThenEncodeData)
 {
     Timestamp foo;
@@ -25,6 +25,34 @@ TEST(EnableLighthouseTestCase, EnablesTheLightHouse)
     CHECK_TRUE(state.lighthouse_is_on);
 }
 
+TEST(EnableLighthouseTestCase, EndsNextToTheLighthouse)
+{
+    action.plan_effects(state);
+    CHECK_TRUE(state.robot.has_x);
+    CHECK_EQUAL(EnableLighthouse::end.x, state.robot.x);
+    CHECK_EQUAL(EnableLighthouse::end.y, state.robot.y);
+}
+
+TEST(EnableLighthouseTestCase, CostsMoreFromFarAway)
+{
+    set_robot_position(state, EnableLighthouse::start);
+    auto near_cost = action.cost(state);
+    CHECK_TRUE(near_cost > 1);
+
+    set_robot_position(state, {2500, 1500});
+    CHECK_TRUE(action.cost(state) > near_cost);
+}
+
+TEST(EnableLighthouseTestCase, OnlyCountsTheWorkWithoutAPosition)
+{
+    state.robot.has_x = false;
+    state.robot.has_y = false;
+    auto cost = action.cost(state);
+
+    set_robot_position(state, EnableLighthouse::start);
+    CHECK_EQUAL(cost, action.cost(state));
+}
+
 bool RaiseWindsock::execute(StrategyState& state)
 {
     plan_effects(state);
@@ -62,6 +90,22 @@ TEST(RaiseWindsockTestCase, RaisesSock)
     CHECK_TRUE(state.windsocks_are_up[1]);
 }
 
+TEST(RaiseWindsockTestCase, EndsAfterPushingTheSock)
+{
+    near.plan_effects(state);
+    CHECK_EQUAL(near.end().x, state.robot.x);
+    CHECK_EQUAL(near.end().y, state.robot.y);
+}
+
+TEST(RaiseWindsockTestCase, CheaperToRaiseTheClosestSock)
+{
+    set_robot_position(state, far.start());
+    CHECK_TRUE(far.cost(state) < near.cost(state));
+
+    set_robot_position(state, near.start());
+    CHECK_TRUE(near.cost(state) < far.cost(state));
+}
+
 bool BackwardReefPickup::execute(StrategyState& state)
 {
     return true;
@@ -115,6 +159,19 @@ TEST(BackwardReefPickupGroup, ExpectsToCopyGlassesContent)
     CHECK_EQUAL(state.robot.back_right_glass, GlassColor_GREEN);
 }
 
+TEST(BackwardReefPickupGroup, EndsInFrontOfTheReef)
+{
+    pickup.plan_effects(state);
+    CHECK_EQUAL(BackwardReefPickup::end.x, state.robot.x);
+    CHECK_EQUAL(BackwardReefPickup::end.y, state.robot.y);
+}
+
+TEST(BackwardReefPickupGroup, IncludesTheWaitsInTheCost)
+{
+    set_robot_position(state, BackwardReefPickup::start);
+    CHECK_TRUE(pickup.cost(state) > 900);
+}
+
 TEST(BackwardReefPickupGroup, ExpectsToEmptyDispenser)
 {
     pickup.plan_effects(state);
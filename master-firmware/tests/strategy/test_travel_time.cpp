@@ -0,0 +1,149 @@
+#include <CppUTest/TestHarness.h>
+#include <cmath>
+#include "strategy/travel_time.h"
+
+TEST_GROUP (TrapezoidalTravelTime) {
+};
+
+TEST(TrapezoidalTravelTime, ReachesFullSpeedOnLongDistances)
+{
+    // 0.2s to accelerate and 0.2s to stop, covering 120mm each
+    DOUBLES_EQUAL(2.2, travel_time_trapezoidal(1200, 600, 3000), 1e-5);
+}
+
+TEST(TrapezoidalTravelTime, NeverReachesFullSpeedOnShortDistances)
+{
+    // Accelerates over 15mm then stops
+    DOUBLES_EQUAL(0.2, travel_time_trapezoidal(30, 600, 3000), 1e-5);
+}
+
+TEST(TrapezoidalTravelTime, BackwardTakesAsLong)
+{
+    DOUBLES_EQUAL(travel_time_trapezoidal(500, 600, 3000),
+                  travel_time_trapezoidal(-500, 600, 3000), 1e-5);
+}
+
+TEST_GROUP (TravelTimeOracle) {
+    TravelTimeOracle oracle;
+    struct obstacle_avoidance oa;
+
+    void setup() override
+    {
+        polygon_set_boundingbox(0, 0, 3000, 2000);
+        oa_init(&oa);
+    }
+
+    void add_square(int x, int y, int half_size)
+    {
+        auto poly = oa_new_poly(&oa, 4);
+        oa_poly_set_point(&oa, poly, x + half_size, y - half_size, 0);
+        oa_poly_set_point(&oa, poly, x + half_size, y + half_size, 1);
+        oa_poly_set_point(&oa, poly, x - half_size, y + half_size, 2);
+        oa_poly_set_point(&oa, poly, x - half_size, y - half_size, 3);
+    }
+};
+
+TEST(TravelTimeOracle, GoesStraightWithoutObstacles)
+{
+    CHECK_EQUAL(2200, oracle.time_ms(200, 1000, 1400, 1000));
+}
+
+TEST(TravelTimeOracle, NoTimeToStayInPlace)
+{
+    CHECK_EQUAL(0, oracle.time_ms(200, 1000, 200, 1000));
+}
+
+TEST(TravelTimeOracle, FollowsTheObstacleAvoidancePath)
+{
+    oracle.set_obstacles(&oa);
+    CHECK_EQUAL(2200, oracle.time_ms(200, 1000, 1400, 1000));
+
+    add_square(800, 1000, 100);
+    oracle.set_obstacles(&oa);
+
+    // Follows the side of the obstacle, turning at both of its corners
+    auto around_ms = oracle.time_ms(200, 1000, 1400, 1000);
+    auto distance_ms = 2 * oracle.straight_ms(std::hypot(500, 100)) + oracle.straight_ms(200);
+    auto turn_ms = 2 * oracle.turn_ms(std::atan2(100, 500));
+    DOUBLES_EQUAL(distance_ms + turn_ms, around_ms, 2);
+}
+
+TEST(TravelTimeOracle, UnreachableInsideAnObstacle)
+{
+    add_square(800, 1000, 100);
+    oracle.set_obstacles(&oa);
+
+    CHECK_EQUAL(TravelTimeOracle::UNREACHABLE_MS, oracle.time_ms(200, 1000, 800, 1000));
+}
+
+TEST(TravelTimeOracle, UsesTheLimits)
+{
+    oracle.set_limits({1200, 3000, 6, 30});
+
+    CHECK_EQUAL(1400, oracle.time_ms(200, 1000, 1400, 1000));
+}
+
+TEST(TravelTimeOracle, CachesPathsOnAGrid)
+{
+    auto ms = oracle.time_ms(200, 1000, 1400, 1000);
+    CHECK_EQUAL(1, oracle.cache_misses());
+
+    CHECK_EQUAL(ms, oracle.time_ms(202, 998, 1401, 1000));
+    CHECK_EQUAL(1, oracle.cache_hits());
+    CHECK_EQUAL(1, oracle.cache_misses());
+
+    oracle.time_ms(1400, 1000, 200, 1000);
+    CHECK_EQUAL(2, oracle.cache_misses());
+}
+
+TEST(TravelTimeOracle, NewObstaclesClearTheCache)
+{
+    oracle.time_ms(200, 1000, 1400, 1000);
+
+    add_square(800, 1000, 100);
+    oracle.set_obstacles(&oa);
+
+    CHECK_TRUE(oracle.time_ms(200, 1000, 1400, 1000) > 2200);
+    CHECK_EQUAL(2, oracle.cache_misses());
+}
+
+TEST(TravelTimeOracle, SameLimitsKeepTheCache)
+{
+    oracle.time_ms(200, 1000, 1400, 1000);
+
+    oracle.set_limits(travel_limits_default());
+    oracle.time_ms(200, 1000, 1400, 1000);
+    CHECK_EQUAL(1, oracle.cache_hits());
+
+    oracle.set_limits({1200, 3000, 6, 30});
+    oracle.time_ms(200, 1000, 1400, 1000);
+    CHECK_EQUAL(2, oracle.cache_misses());
+}
+
+TEST(TravelTimeOracle, ReportsWhenTheLimitsChange)
+{
+    CHECK_FALSE(oracle.set_limits(travel_limits_default()));
+    CHECK_TRUE(oracle.set_limits({1200, 3000, 6, 30}));
+    CHECK_FALSE(oracle.set_limits({1200, 3000, 6, 30}));
+}
+
+TEST(TravelTimeOracle, ReportsWhenTheObstaclesChange)
+{
+    CHECK_TRUE(oracle.set_obstacles(&oa));
+    CHECK_FALSE(oracle.set_obstacles(&oa));
+
+    add_square(800, 1000, 100);
+    CHECK_TRUE(oracle.set_obstacles(&oa));
+    CHECK_FALSE(oracle.set_obstacles(&oa));
+}
+
+TEST(TravelTimeOracle, SameObstaclesKeepTheCache)
+{
+    add_square(800, 1000, 100);
+    oracle.set_obstacles(&oa);
+    oracle.time_ms(200, 1000, 1400, 1000);
+
+    oracle.set_obstacles(&oa);
+    oracle.time_ms(200, 1000, 1400, 1000);
+    CHECK_EQUAL(1, oracle.cache_hits());
+}
@@ -0,0 +1,331 @@
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <CppUTest/TestHarness.h>
+
+#include <error/error.h>
+#include "debug/log.h"
+
+static std::string message_of(const std::string& line)
+{
+    return line.substr(line.find('\t') + 1);
+}
+
+/* Output keeping the lines written by the log thread */
+struct CapturedLines {
+    std::mutex lock;
+    std::vector<std::string> lines;
+
+    static void write(void* arg, const char* line, size_t len)
+    {
+        auto self = static_cast<CapturedLines*>(arg);
+        std::lock_guard<std::mutex> _(self->lock);
+        self->lines.emplace_back(line, len);
+    }
+};
+
+TEST_GROUP (Log) {
+    log_config_t config;
+    CapturedLines captured;
+
+    void setup() override
+    {
+        log_config_default(&config);
+        config.console = false;
+        start();
+    }
+
+    void start()
+    {
+        log_init(&config);
+        log_add_output(CapturedLines::write, &captured);
+    }
+
+    void teardown() override
+    {
+        log_shutdown();
+    }
+
+    std::vector<std::string> written()
+    {
+        log_flush();
+        std::lock_guard<std::mutex> _(captured.lock);
+        return captured.lines;
+    }
+};
+
+TEST(Log, WritesSeverityFileAndLine)
+{
+    int line = __LINE__ + 1;
+    NOTICE("hello");
+
+    auto lines = written();
+    CHECK_EQUAL(1, lines.size());
+
+    auto expected = "NOTICE test_log.cpp:" + std::to_string(line) + "\thello\n";
+    CHECK_TRUE(lines[0].find(expected) != std::string::npos);
+}
+
+TEST(Log, FormatsLikePrintf)
+{
+    const char* name = "base";
+    char expected[256];
+    snprintf(expected, sizeof(expected), "%d %5.2f %s %c %x %lu %lld %% %*d|%.*s|%-4hhu|%p|%zu\n",
+             -42, 3.14159, name, 'z', 255u, 123456789ul, -1234567890123ll, 6, 7, 2, "abcd", 300, (void*)&expected, sizeof(expected));
+
+    NOTICE("%d %5.2f %s %c %x %lu %lld %% %*d|%.*s|%-4hhu|%p|%zu",
+           -42, 3.14159, name, 'z', 255u, 123456789ul, -1234567890123ll, 6, 7, 2, "abcd", 300, (void*)&expected, sizeof(expected));
+
+    STRCMP_EQUAL(expected, message_of(written()[0]).c_str());
+}
+
+TEST(Log, CopiesTheStrings)
+{
+    char name[] = "before";
+    NOTICE("%s", name);
+    strcpy(name, "after");
+
+    STRCMP_EQUAL("before\n", message_of(written()[0]).c_str());
+}
+
+TEST(Log, FormatsWhatItCannotPack)
+{
+    std::string long_string(200, 'x');
+    NOTICE("%s", long_string.c_str());
+    NOTICE("%.1Lf", (long double)2.5);
+
+    auto lines = written();
+    CHECK_TRUE(lines[0].find(long_string.substr(0, 100)) != std::string::npos);
+    STRCMP_EQUAL("2.5\n", message_of(lines[1]).c_str());
+}
+
+TEST(Log, TruncatesLongLines)
+{
+    NOTICE("%300d", 42);
+
+    auto line = written()[0];
+    CHECK_EQUAL(LOG_LINE_SIZE - 1, line.size());
+    CHECK_EQUAL('\n', line.back());
+}
+
+TEST(Log, DebugOnlyWhenVerbose)
+{
+    DEBUG("hidden");
+    CHECK_EQUAL(0, written().size());
+
+    log_shutdown();
+    config.verbose = true;
+    start();
+
+    DEBUG("shown");
+    CHECK_EQUAL(1, written().size());
+}
+
+TEST(Log, KeepsTheOrderOfEachThread)
+{
+    const int count = 50;
+    auto worker = [](int id) {
+        for (int i = 0; i < count; i++) {
+            NOTICE("%d %d", id, i);
+        }
+    };
+    std::thread a(worker, 0), b(worker, 1);
+    a.join();
+    b.join();
+
+    auto lines = written();
+    CHECK_EQUAL(2 * count, lines.size());
+
+    int next[2] = {0, 0};
+    for (auto& line : lines) {
+        int id, i;
+        CHECK_EQUAL(2, sscanf(message_of(line).c_str(), "%d %d", &id, &i));
+        CHECK_EQUAL(next[id], i);
+        next[id]++;
+    }
+}
+
+/* Blocks the log thread in the output until released */
+static std::mutex blocked_lock;
+static std::condition_variable blocked_cv;
+static bool blocked_writing, blocked_released;
+
+static void blocking_output(void*, const char*, size_t)
+{
+    std::unique_lock<std::mutex> lock(blocked_lock);
+    blocked_writing = true;
+    blocked_cv.notify_all();
+    blocked_cv.wait(lock, [] { return blocked_released; });
+}
+
+TEST(Log, DropsAndReportsMessagesWhenFull)
+{
+    blocked_writing = blocked_released = false;
+    log_add_output(blocking_output, nullptr);
+    uint32_t dropped = log_dropped_count();
+
+    NOTICE("first");
+    {
+        std::unique_lock<std::mutex> lock(blocked_lock);
+        blocked_cv.wait(lock, [] { return blocked_writing; });
+    }
+
+    // The first message is still in the ring while it is being written
+    for (int i = 0; i < LOG_RING_SIZE + 5; i++) {
+        NOTICE("%d", i);
+    }
+    CHECK_EQUAL(6, log_dropped_count() - dropped);
+
+    {
+        std::lock_guard<std::mutex> lock(blocked_lock);
+        blocked_released = true;
+    }
+    blocked_cv.notify_all();
+
+    auto lines = written();
+    CHECK_EQUAL(LOG_RING_SIZE + 1, lines.size());
+    CHECK_TRUE(lines.back().find("6 messages dropped") != std::string::npos);
+}
+
+TEST(Log, WaitsForRoomInsteadOfDroppingErrors)
+{
+    char dir[] = "/tmp/log_test_XXXXXX";
+    CHECK_TRUE(mkdtemp(dir) != nullptr);
+    std::string path = std::string(dir) + "/master.log";
+
+    // ERROR exits, so it is logged from a child process
+    log_shutdown();
+    blocked_writing = blocked_released = false;
+    pid_t pid = fork();
+    if (pid == 0) {
+        config.file = path.c_str();
+        start();
+        log_add_output(blocking_output, nullptr);
+
+        NOTICE("first");
+        {
+            std::unique_lock<std::mutex> lock(blocked_lock);
+            blocked_cv.wait(lock, [] { return blocked_writing; });
+        }
+        for (int i = 0; i < LOG_RING_SIZE; i++) {
+            NOTICE("%d", i);
+        }
+
+        std::thread([]() {
+            usleep(100000);
+            {
+                std::lock_guard<std::mutex> lock(blocked_lock);
+                blocked_released = true;
+            }
+            blocked_cv.notify_all();
+        }).detach();
+
+        ERROR("fatal %d", 42);
+    }
+
+    int status;
+    CHECK_EQUAL(pid, waitpid(pid, &status, 0));
+    CHECK_TRUE(WIFSIGNALED(status));
+    CHECK_EQUAL(SIGINT, WTERMSIG(status));
+
+    std::ifstream file(path);
+    std::string line;
+    bool found = false;
+    while (std::getline(file, line)) {
+        found = found || message_of(line) == "fatal 42";
+    }
+    CHECK_TRUE(found);
+
+    start();
+    unlink(path.c_str());
+    rmdir(dir);
+}
+
+TEST(Log, ReusesTheRingOfExitedThreads)
+{
+    for (int i = 0; i < 10; i++) {
+        std::thread([i]() { NOTICE("%d", i); }).join();
+    }
+
+    CHECK_EQUAL(10, written().size());
+}
+
+TEST(Log, RotatesTheFile)
+{
+    char dir[] = "/tmp/log_test_XXXXXX";
+    CHECK_TRUE(mkdtemp(dir) != nullptr);
+    std::string path = std::string(dir) + "/master.log";
+
+    log_shutdown();
+    config.file = path.c_str();
+    config.file_size = 1000;
+    config.file_count = 2;
+    start();
+
+    for (int i = 0; i < 100; i++) {
+        NOTICE("message %d", i);
+    }
+    log_shutdown();
+
+    std::ifstream current(path), first(path + ".1"), second(path + ".2"), third(path + ".3");
+    CHECK_TRUE(current.good());
+    CHECK_TRUE(first.good());
+    CHECK_TRUE(second.good());
+    CHECK_FALSE(third.good());
+
+    // The last message is in the current file, and the file is small enough
+    std::string line, last;
+    size_t size = 0;
+    while (std::getline(current, line)) {
+        size += line.size() + 1;
+        last = line;
+    }
+    STRCMP_EQUAL("message 99", message_of(last).c_str());
+    CHECK_TRUE(size <= 1000);
+
+    config.file = nullptr;
+    start();
+
+    for (auto name : {path, path + ".1", path + ".2"}) {
+        unlink(name.c_str());
+    }
+    rmdir(dir);
+}
+
+TEST(Log, SendsUdpDatagrams)
+{
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK_EQUAL(0, bind(sock, (struct sockaddr*)&address, sizeof(address)));
+
+    socklen_t len = sizeof(address);
+    getsockname(sock, (struct sockaddr*)&address, &len);
+    struct timeval timeout = {1, 0};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    log_shutdown();
+    config.udp_host = "127.0.0.1";
+    config.udp_port = ntohs(address.sin_port);
+    start();
+
+    NOTICE("over the network");
+
+    char buffer[LOG_LINE_SIZE];
+    ssize_t n = recv(sock, buffer, sizeof(buffer), 0);
+    CHECK_TRUE(n > 0);
+    STRCMP_EQUAL("over the network\n", message_of(std::string(buffer, n)).c_str());
+
+    close(sock);
+}
@@ -0,0 +1,268 @@
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+#include <CppUTest/TestHarness.h>
+
+#include "base/opponent_tracker.h"
+#include "base/pose_history.h"
+
+/* Measurement of an opponent at (x, y) by a robot at the origin facing x */
+static int measure(opponent_tracker_t* tracker, timestamp_t t, float x, float y)
+{
+    return opponent_tracker_add_measurement(tracker, t, 0, 0, 0, std::hypot(x, y), std::atan2(y, x));
+}
+
+TEST_GROUP (OpponentTracker) {
+    opponent_tracker_t tracker;
+    opponent_estimate_t estimates[OPPONENT_TRACKER_MAX_TRACKS];
+
+    void setup() override
+    {
+        opponent_tracker_init(&tracker);
+    }
+};
+
+TEST(OpponentTracker, NothingToReportAtFirst)
+{
+    opponent_tracker_get(&tracker, 0, estimates);
+    for (auto& e : estimates) {
+        CHECK_FALSE(e.valid);
+    }
+}
+
+TEST(OpponentTracker, ReportsConfirmedTracksOnly)
+{
+    CHECK_EQUAL(0, measure(&tracker, 0, 1000, 500));
+    opponent_tracker_get(&tracker, 0, estimates);
+    CHECK_FALSE(estimates[0].valid);
+
+    CHECK_EQUAL(0, measure(&tracker, 100000, 1000, 500));
+    opponent_tracker_get(&tracker, 100000, estimates);
+    CHECK_TRUE(estimates[0].valid);
+    DOUBLES_EQUAL(1000, estimates[0].x, 1);
+    DOUBLES_EQUAL(500, estimates[0].y, 1);
+}
+
+TEST(OpponentTracker, ConvertsFromTheRobotPose)
+{
+    for (int i = 0; i < 2; i++) {
+        // Robot at (1000, 1000) facing y, opponent 500mm on its right
+        opponent_tracker_add_measurement(&tracker, i * 100000, 1000, 1000, M_PI / 2, 500, -M_PI / 2);
+    }
+
+    opponent_tracker_get(&tracker, 100000, estimates);
+    DOUBLES_EQUAL(1500, estimates[0].x, 1);
+    DOUBLES_EQUAL(1000, estimates[0].y, 1);
+}
+
+TEST(OpponentTracker, EstimatesTheVelocity)
+{
+    // Moving along x at 200 mm/s
+    for (int i = 0; i < 30; i++) {
+        measure(&tracker, i * 100000, 1000 + 20 * i, 500);
+    }
+
+    opponent_tracker_get(&tracker, 2900000, estimates);
+    DOUBLES_EQUAL(200, estimates[0].vx, 10);
+    DOUBLES_EQUAL(0, estimates[0].vy, 10);
+    CHECK_TRUE(estimates[0].position_stddev < 100);
+}
+
+TEST(OpponentTracker, PredictsWhereTheOpponentIsNow)
+{
+    for (int i = 0; i < 30; i++) {
+        measure(&tracker, i * 100000, 1000 + 20 * i, 500);
+    }
+
+    opponent_tracker_get(&tracker, 3400000, estimates);
+    DOUBLES_EQUAL(1000 + 20 * 34, estimates[0].x, 10);
+}
+
+TEST(OpponentTracker, TracksTwoOpponentsSeparately)
+{
+    for (int i = 0; i < 10; i++) {
+        CHECK_EQUAL(0, measure(&tracker, i * 100000, 1000, 500));
+        CHECK_EQUAL(1, measure(&tracker, i * 100000 + 50000, 500, -1000));
+    }
+
+    opponent_tracker_get(&tracker, 1000000, estimates);
+    DOUBLES_EQUAL(1000, estimates[0].x, 5);
+    DOUBLES_EQUAL(500, estimates[0].y, 5);
+    DOUBLES_EQUAL(500, estimates[1].x, 5);
+    DOUBLES_EQUAL(-1000, estimates[1].y, 5);
+}
+
+TEST(OpponentTracker, DropsMeasurementsWhenAllOpponentsAreTracked)
+{
+    measure(&tracker, 0, 1000, 500);
+    measure(&tracker, 0, 500, -1000);
+
+    CHECK_EQUAL(-1, measure(&tracker, 0, -1000, 0));
+}
+
+TEST(OpponentTracker, TracksTimeOut)
+{
+    measure(&tracker, 0, 1000, 500);
+    measure(&tracker, 100000, 1000, 500);
+
+    opponent_tracker_get(&tracker, 1200000, estimates);
+    CHECK_FALSE(estimates[0].valid);
+
+    // The slot can be used by a new opponent
+    CHECK_EQUAL(0, measure(&tracker, 1200000, 500, -1000));
+}
+
+/* Replays a simulated match, with the same beacon model as the hitl proximity
+ * beacon emulator: the robot spins in place while two opponents move, and
+ * each beacon measurement is processed some time after it was taken. */
+TEST_GROUP (OpponentTrackerReplay) {
+    struct Waypoint {
+        float time; // [s]
+        float x, y; // [mm]
+    };
+
+    /* Same interpolation as the hitl OpponentScript */
+    static void position_at(const std::vector<Waypoint>& script, float t, float* x, float* y)
+    {
+        if (t <= script.front().time) {
+            *x = script.front().x;
+            *y = script.front().y;
+            return;
+        }
+        for (size_t i = 1; i < script.size(); i++) {
+            if (t < script[i].time) {
+                auto& a = script[i - 1];
+                auto& b = script[i];
+                float f = (t - a.time) / (b.time - a.time);
+                *x = a.x + f * (b.x - a.x);
+                *y = a.y + f * (b.y - a.y);
+                return;
+            }
+        }
+        *x = script.back().x;
+        *y = script.back().y;
+    }
+
+    std::vector<Waypoint> opponents[2] = {
+        {{0, 2200, 1000}, {4, 2200, 1600}, {8, 1600, 1600}},
+        {{0, 600, 300}, {3, 600, 300}, {6, 300, 800}},
+    };
+
+    const float robot_x = 1200, robot_y = 1000;
+    const float robot_speed = 4; // [rad/s]
+    const timestamp_t latency_us = 60000;
+
+    std::unique_ptr<pose_history_t> history{new pose_history_t};
+    std::unique_ptr<pose_history_reader_t> reader{new pose_history_reader_t};
+    opponent_tracker_t tracker;
+    opponent_estimate_t estimates[OPPONENT_TRACKER_MAX_TRACKS];
+
+    std::mt19937 rng{42};
+    std::normal_distribution<float> normal;
+
+    float max_naive_error = 0;
+    timestamp_t t = 0;
+
+    void setup() override
+    {
+        pose_history_init(history.get());
+        pose_history_reader_init(reader.get(), &history->topic);
+        opponent_tracker_init(&tracker);
+    }
+
+    static float heading_at(float speed, timestamp_t t)
+    {
+        return std::remainder(speed * t / 1e6f, 2 * M_PI);
+    }
+
+    /* Runs the odometry at 100Hz and the beacon at 10Hz per opponent, until
+     * the given time */
+    void replay(timestamp_t end_us)
+    {
+        for (; t <= end_us; t += 10000) {
+            pose_history_push(history.get(), t, robot_x, robot_y, heading_at(robot_speed, t));
+
+            // The beacon measurement taken latency_us ago is processed now
+            if (t < latency_us || (t - latency_us) % 50000 != 0) {
+                continue;
+            }
+
+            timestamp_t measured = t - latency_us;
+            int index = (measured / 50000) % 2;
+            float x, y;
+            position_at(opponents[index], measured / 1e6f, &x, &y);
+
+            float distance = std::hypot(x - robot_x, y - robot_y) + 30 * normal(rng);
+            float angle = std::atan2(y - robot_y, x - robot_x) - heading_at(robot_speed, measured)
+                + 0.02f * normal(rng);
+
+            pose_history_entry_t pose;
+            CHECK_TRUE(pose_history_get(reader.get(), measured, &pose));
+            opponent_tracker_add_measurement(&tracker, measured, pose.x, pose.y, pose.a, distance, angle);
+
+            // What the map used to do, with the pose at processing time
+            float a = heading_at(robot_speed, t) + angle;
+            float naive_error = std::hypot(robot_x + distance * std::cos(a) - x,
+                                           robot_y + distance * std::sin(a) - y);
+            max_naive_error = std::max(max_naive_error, naive_error);
+        }
+    }
+
+    /* Distance from each opponent to the closest estimate */
+    void check_estimates(timestamp_t now, float tolerance)
+    {
+        opponent_tracker_get(&tracker, now, estimates);
+
+        for (auto& script : opponents) {
+            float x, y;
+            position_at(script, now / 1e6f, &x, &y);
+
+            float error = 1e9;
+            for (auto& e : estimates) {
+                if (e.valid) {
+                    error = std::min(error, std::hypot(e.x - x, e.y - y));
+                }
+            }
+            CHECK_TRUE_TEXT(error < tolerance, "Opponent not tracked");
+        }
+    }
+};
+
+TEST(OpponentTrackerReplay, TracksBothMovingOpponents)
+{
+    for (timestamp_t end = 1000000; end <= 10000000; end += 1000000) {
+        replay(end);
+        check_estimates(end, 80);
+    }
+}
+
+TEST(OpponentTrackerReplay, NaiveProjectionWasOff)
+{
+    replay(5000000);
+
+    // Turning at 4 rad/s for 60ms puts a measurement 1m away 240mm off
+    CHECK_TRUE(max_naive_error > 200);
+}
+
+TEST(OpponentTrackerReplay, EstimatesTheOpponentVelocity)
+{
+    // The first opponent is moving along y at 150 mm/s, the noise on a single
+    // estimate is averaged out over a second
+    float vx = 0, vy = 0;
+    const int samples = 10;
+
+    replay(2000000);
+    for (int i = 1; i <= samples; i++) {
+        timestamp_t now = 2000000 + i * 100000;
+        replay(now);
+        opponent_tracker_get(&tracker, now, estimates);
+
+        int index = std::fabs(estimates[0].x - 2200) < std::fabs(estimates[1].x - 2200) ? 0 : 1;
+        vx += estimates[index].vx / samples;
+        vy += estimates[index].vy / samples;
+    }
+
+    DOUBLES_EQUAL(0, vx, 30);
+    DOUBLES_EQUAL(150, vy, 30);
+}
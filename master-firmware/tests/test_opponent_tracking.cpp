@@ -0,0 +1,50 @@
+#include <cmath>
+#include <CppUTest/TestHarness.h>
+
+#include "base/opponent_tracking.h"
+
+TEST_GROUP (OpponentTracking) {
+    opponent_estimate_t estimates[OPPONENT_TRACKER_MAX_TRACKS];
+
+    void setup() override
+    {
+        opponent_tracking_init(0.5);
+    }
+
+    void measure(timestamp_t t)
+    {
+        // Robot at (1000, 1000) facing y, opponent 500mm in front of it
+        opponent_tracking_add_measurement(t, 1000, 1000, M_PI / 2, 500, 0);
+    }
+};
+
+TEST(OpponentTracking, ReportsMeasuredOpponents)
+{
+    measure(0);
+    measure(100000);
+
+    opponent_tracking_get(100000, estimates);
+    CHECK_TRUE(estimates[0].valid);
+    DOUBLES_EQUAL(1000, estimates[0].x, 1);
+    DOUBLES_EQUAL(1500, estimates[0].y, 1);
+}
+
+TEST(OpponentTracking, UsesTheGivenTimeout)
+{
+    measure(0);
+    measure(100000);
+
+    opponent_tracking_get(700000, estimates);
+    CHECK_FALSE(estimates[0].valid);
+}
+
+TEST(OpponentTracking, InitForgetsTheTracks)
+{
+    measure(0);
+    measure(100000);
+
+    opponent_tracking_init(0.5);
+
+    opponent_tracking_get(100000, estimates);
+    CHECK_FALSE(estimates[0].valid);
+}
@@ -0,0 +1,191 @@
+#include <CppUTest/TestHarness.h>
+#include <thread>
+#include <vector>
+#include "periodic_executor.h"
+
+using namespace std::chrono_literals;
+
+TEST_GROUP (PeriodicDeadline) {
+    const int64_t period_ns = 10000000;
+    struct timespec deadline = {10, 0};
+};
+
+TEST(PeriodicDeadline, AdvancesByOnePeriodWhenOnTime)
+{
+    struct timespec now = {10, 5000000};
+
+    auto skipped = periodic_deadline_advance(&deadline, period_ns, &now);
+
+    CHECK_EQUAL(0, skipped);
+    CHECK_EQUAL(10, deadline.tv_sec);
+    CHECK_EQUAL(10000000, deadline.tv_nsec);
+}
+
+TEST(PeriodicDeadline, CarriesNanosecondsIntoSeconds)
+{
+    deadline = {10, 995000000};
+    struct timespec now = {10, 996000000};
+
+    periodic_deadline_advance(&deadline, period_ns, &now);
+
+    CHECK_EQUAL(11, deadline.tv_sec);
+    CHECK_EQUAL(5000000, deadline.tv_nsec);
+}
+
+TEST(PeriodicDeadline, SkipsMissedDeadlinesKeepingThePhase)
+{
+    struct timespec now = {10, 35000000};
+
+    auto skipped = periodic_deadline_advance(&deadline, period_ns, &now);
+
+    CHECK_EQUAL(3, skipped);
+    CHECK_EQUAL(10, deadline.tv_sec);
+    CHECK_EQUAL(40000000, deadline.tv_nsec);
+}
+
+TEST(PeriodicDeadline, DeadlineReachedExactlyIsMissed)
+{
+    struct timespec now = {10, 10000000};
+
+    auto skipped = periodic_deadline_advance(&deadline, period_ns, &now);
+
+    CHECK_EQUAL(1, skipped);
+    CHECK_EQUAL(20000000, deadline.tv_nsec);
+}
+
+TEST_GROUP (DurationHistogramTestGroup) {
+    DurationHistogram histogram;
+};
+
+TEST(DurationHistogramTestGroup, PutsDurationsInPowerOfTwoBuckets)
+{
+    histogram.add(0);
+    histogram.add(1);
+    histogram.add(3);
+    histogram.add(4);
+    histogram.add(7);
+
+    CHECK_EQUAL(1, histogram.count(0));
+    CHECK_EQUAL(1, histogram.count(1));
+    CHECK_EQUAL(1, histogram.count(2));
+    CHECK_EQUAL(2, histogram.count(3));
+    CHECK_EQUAL(7, histogram.max());
+}
+
+TEST(DurationHistogramTestGroup, LastBucketCountsLongDurations)
+{
+    histogram.add(1000000000);
+
+    CHECK_EQUAL(1, histogram.count(DurationHistogram::BUCKET_COUNT - 1));
+}
+
+TEST(DurationHistogramTestGroup, CanBeReset)
+{
+    histogram.add(3);
+    histogram.reset();
+
+    CHECK_EQUAL(0, histogram.count(2));
+    CHECK_EQUAL(0, histogram.max());
+}
+
+TEST_GROUP (PeriodicExecutorTestGroup) {
+    PeriodicExecutor executor{"test", 1000us};
+};
+
+TEST(PeriodicExecutorTestGroup, RunsTasksInOrderOnEachTick)
+{
+    std::vector<int> calls;
+    executor.add_task("first", [&]() { calls.push_back(1); });
+    executor.add_task("second", [&]() { calls.push_back(2); });
+
+    executor.run_ticks(2);
+
+    CHECK_TRUE((calls == std::vector<int>{1, 2, 1, 2}));
+    CHECK_EQUAL(2, executor.tick_count());
+}
+
+TEST(PeriodicExecutorTestGroup, RefusesTooManyTasks)
+{
+    for (int i = 0; i < PeriodicExecutor::MAX_TASKS; i++) {
+        CHECK_TRUE(executor.add_task("task", []() {}));
+    }
+
+    CHECK_FALSE(executor.add_task("task", []() {}));
+}
+
+TEST(PeriodicExecutorTestGroup, CountsOverruns)
+{
+    executor.add_task("slow", []() { std::this_thread::sleep_for(3ms); });
+
+    executor.run_ticks(2);
+
+    CHECK_EQUAL(2, executor.overrun_count());
+    CHECK_TRUE(executor.missed_tick_count() >= 4);
+}
+
+TEST(PeriodicExecutorTestGroup, RecordsExecutionTimeOfEachTask)
+{
+    executor.add_task("slow", []() { std::this_thread::sleep_for(2ms); });
+
+    executor.run_ticks(1);
+
+    const auto& histogram = executor.task(0).execution_time;
+    CHECK_TRUE(histogram.max() >= 2000);
+    CHECK_EQUAL(0, histogram.count(0));
+}
+
+TEST(PeriodicExecutorTestGroup, RecordsJitterOfEachTick)
+{
+    executor.run_ticks(3);
+
+    uint32_t total = 0;
+    for (int i = 0; i < DurationHistogram::BUCKET_COUNT; i++) {
+        total += executor.jitter().count(i);
+    }
+    CHECK_EQUAL(3, total);
+}
+
+TEST(PeriodicExecutorTestGroup, CanResetStatistics)
+{
+    executor.add_task("slow", []() { std::this_thread::sleep_for(2ms); });
+    executor.run_ticks(1);
+
+    executor.reset_stats();
+
+    CHECK_EQUAL(0, executor.tick_count());
+    CHECK_EQUAL(0, executor.overrun_count());
+    CHECK_EQUAL(0, executor.task(0).execution_time.max());
+}
+
+TEST_GROUP (PeriodicExecutorVirtualClockTestGroup) {
+    virtual_clock_t clock;
+    PeriodicExecutor executor{"test", 1000us};
+
+    void setup() override
+    {
+        virtual_clock_init(&clock, 1, false);
+        executor.use_virtual_clock(&clock, 0);
+    }
+};
+
+TEST(PeriodicExecutorVirtualClockTestGroup, TicksOnSimulatedTime)
+{
+    std::vector<uint64_t> times;
+    executor.add_task("task", [&]() { times.push_back(virtual_clock_now(&clock)); });
+
+    executor.run_ticks(3);
+
+    CHECK_TRUE((times == std::vector<uint64_t>{0, 1000, 2000}));
+}
+
+TEST(PeriodicExecutorVirtualClockTestGroup, SlowTasksDoNotOverrun)
+{
+    /* Simulated time does not advance while a task runs */
+    executor.add_task("slow", []() { std::this_thread::sleep_for(2ms); });
+
+    executor.run_ticks(3);
+
+    CHECK_EQUAL(0, executor.overrun_count());
+    CHECK_EQUAL(0, executor.task(0).execution_time.max());
+    CHECK_EQUAL(3, executor.jitter().count(0));
+}
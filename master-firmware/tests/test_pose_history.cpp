@@ -0,0 +1,125 @@
+#include <cmath>
+#include <memory>
+#include <CppUTest/TestHarness.h>
+
+#include "base/pose_history.h"
+
+TEST_GROUP (PoseHistory) {
+    std::unique_ptr<pose_history_t> history{new pose_history_t};
+    std::unique_ptr<pose_history_reader_t> reader{new pose_history_reader_t};
+    pose_history_entry_t pose;
+
+    void setup() override
+    {
+        pose_history_init(history.get());
+        pose_history_reader_init(reader.get(), &history->topic);
+    }
+};
+
+TEST(PoseHistory, EmptyHistoryHasNoPose)
+{
+    CHECK_FALSE(pose_history_get(reader.get(), 1000, &pose));
+}
+
+TEST(PoseHistory, GetsTheExactPose)
+{
+    pose_history_push(history.get(), 1000, 10, 20, 0.5);
+    pose_history_push(history.get(), 2000, 30, 40, 0.6);
+
+    CHECK_TRUE(pose_history_get(reader.get(), 1000, &pose));
+    CHECK_EQUAL(1000, pose.timestamp);
+    DOUBLES_EQUAL(10, pose.x, 1e-5);
+    DOUBLES_EQUAL(20, pose.y, 1e-5);
+    DOUBLES_EQUAL(0.5, pose.a, 1e-5);
+}
+
+TEST(PoseHistory, InterpolatesBetweenPoses)
+{
+    pose_history_push(history.get(), 1000, 10, 20, 0.5);
+    pose_history_push(history.get(), 2000, 30, 40, 0.6);
+
+    CHECK_TRUE(pose_history_get(reader.get(), 1250, &pose));
+    CHECK_EQUAL(1250, pose.timestamp);
+    DOUBLES_EQUAL(15, pose.x, 1e-5);
+    DOUBLES_EQUAL(25, pose.y, 1e-5);
+    DOUBLES_EQUAL(0.525, pose.a, 1e-5);
+}
+
+TEST(PoseHistory, InterpolatesAnglesAcrossPi)
+{
+    pose_history_push(history.get(), 1000, 0, 0, M_PI - 0.1);
+    pose_history_push(history.get(), 2000, 0, 0, -M_PI + 0.1);
+
+    CHECK_TRUE(pose_history_get(reader.get(), 1500, &pose));
+    DOUBLES_EQUAL(M_PI, std::fabs(pose.a), 1e-5);
+}
+
+TEST(PoseHistory, FutureGivesTheLatestPose)
+{
+    pose_history_push(history.get(), 1000, 10, 20, 0.5);
+    pose_history_push(history.get(), 2000, 30, 40, 0.6);
+
+    CHECK_TRUE(pose_history_get(reader.get(), 5000, &pose));
+    CHECK_EQUAL(2000, pose.timestamp);
+    DOUBLES_EQUAL(30, pose.x, 1e-5);
+}
+
+TEST(PoseHistory, ForgetsTheOldestPoses)
+{
+    for (int i = 0; i < POSE_HISTORY_SIZE + 10; i++) {
+        pose_history_push(history.get(), 1000 * (i + 1), i, 0, 0);
+    }
+
+    CHECK_FALSE(pose_history_get(reader.get(), 5000, &pose));
+
+    CHECK_TRUE(pose_history_get(reader.get(), 1000 * 11, &pose));
+    DOUBLES_EQUAL(10, pose.x, 1e-5);
+}
+
+TEST(PoseHistory, HandlesTimestampOverflow)
+{
+    pose_history_push(history.get(), UINT32_MAX - 499, 0, 0, 0);
+    pose_history_push(history.get(), 500, 100, 0, 0);
+
+    CHECK_TRUE(pose_history_get(reader.get(), 0, &pose));
+    DOUBLES_EQUAL(50, pose.x, 1e-3);
+}
+
+TEST(PoseHistory, ReaderOnlyKnowsPosesPublishedAfterItStarted)
+{
+    pose_history_push(history.get(), 1000, 10, 20, 0.5);
+    pose_history_reader_init(reader.get(), &history->topic);
+
+    CHECK_FALSE(pose_history_get(reader.get(), 1000, &pose));
+
+    pose_history_push(history.get(), 2000, 30, 40, 0.6);
+    CHECK_TRUE(pose_history_get(reader.get(), 2000, &pose));
+    CHECK_FALSE(pose_history_get(reader.get(), 1500, &pose));
+}
+
+TEST(PoseHistory, ReaderCatchesUpAfterFallingBehind)
+{
+    pose_history_push(history.get(), 1000, 0, 0, 0);
+    CHECK_TRUE(pose_history_get(reader.get(), 1000, &pose));
+
+    for (int i = 1; i < 3 * POSE_HISTORY_SIZE; i++) {
+        pose_history_push(history.get(), 1000 * (i + 1), i, 0, 0);
+    }
+
+    CHECK_FALSE(pose_history_get(reader.get(), 1000, &pose));
+    CHECK_TRUE(pose_history_get(reader.get(), 1000 * 2 * POSE_HISTORY_SIZE + 1500, &pose));
+    DOUBLES_EQUAL(2 * POSE_HISTORY_SIZE + 0.5, pose.x, 1e-3);
+}
+
+TEST(PoseHistory, ReadersAreIndependent)
+{
+    std::unique_ptr<pose_history_reader_t> other{new pose_history_reader_t};
+    pose_history_reader_init(other.get(), &history->topic);
+
+    pose_history_push(history.get(), 1000, 10, 20, 0.5);
+    pose_history_push(history.get(), 2000, 30, 40, 0.6);
+
+    CHECK_TRUE(pose_history_get(reader.get(), 1500, &pose));
+    CHECK_TRUE(pose_history_get(other.get(), 1500, &pose));
+    DOUBLES_EQUAL(20, pose.x, 1e-5);
+}
@@ -0,0 +1,54 @@
+#include <CppUTest/TestHarness.h>
+#include <thread>
+
+#include "robot_helpers/sleep_helpers.h"
+
+using namespace std::chrono_literals;
+
+TEST_GROUP (SleepHelpersTestGroup) {
+    virtual_clock_t clock;
+
+    void setup() override
+    {
+        virtual_clock_init(&clock, 1, false);
+    }
+};
+
+TEST(SleepHelpersTestGroup, SleepsInSimulatedTimeOnceJoined)
+{
+    uint64_t woke_up_at = 0;
+
+    // The participant is a property of the thread, as in the firmware
+    std::thread participant([&]() {
+        robot_sleep_join_virtual_clock(&clock, 0);
+        robot_sleep(10ms);
+        robot_sleep(2s);
+        woke_up_at = virtual_clock_now(&clock);
+        virtual_clock_leave(&clock, 0);
+    });
+    participant.join();
+
+    CHECK_EQUAL(2010000, woke_up_at);
+}
+
+TEST(SleepHelpersTestGroup, OtherThreadsSleepInRealTime)
+{
+    std::thread participant([&]() {
+        robot_sleep_join_virtual_clock(&clock, 0);
+        robot_sleep(10ms);
+        virtual_clock_leave(&clock, 0);
+    });
+    participant.join();
+
+    auto start = std::chrono::steady_clock::now();
+    robot_sleep(1ms);
+
+    CHECK_TRUE(std::chrono::steady_clock::now() - start >= 1ms);
+    CHECK_EQUAL(10000, virtual_clock_now(&clock));
+}
+
+TEST(SleepHelpersTestGroup, JoiningWithoutClockDoesNothing)
+{
+    robot_sleep_join_virtual_clock(nullptr, 0);
+    robot_sleep(1ms);
+}
@@ -15,7 +15,7 @@ int compute_and_execute_plan(goap::Goal<StrategyState>& goal, StrategyState& sta
 {
     const int max_path_len = 40;
     goap::Action<StrategyState>* path[max_path_len] = {nullptr};
-    goap::Planner<StrategyState, GOAP_SPACE_SIZE> planner;
+    goap::Planner<StrategyState, StrategyStateHash, GOAP_SPACE_SIZE> planner;
 
     int len = planner.plan(state, goal, actions.data(), actions.size(), path, max_path_len);
     for (int i = 0; i < len; i++) {
@@ -53,3 +53,36 @@ TEST(Strategy, CanRunAllGoals)
         CHECK_TRUE_TEXT(goal->is_reached(state), "Consistency issue: goal not reached with what the steps planned.");
     }
 }
+
+static int plan_cost(StrategyState state, goap::Action<StrategyState>** path, int len)
+{
+    int cost = 0;
+    for (int i = 0; i < len; i++) {
+        cost += path[i]->cost(state);
+        path[i]->plan_effects(state);
+    }
+    return cost;
+}
+
+TEST(Strategy, PlansTheFastestOrder)
+{
+    actions::RaiseWindsock windsock_far{1}, windsock_near{0};
+    goap::Action<StrategyState>* actions[] = {&windsock_near, &windsock_far};
+    goap::Action<StrategyState>* path[10];
+    goap::Planner<StrategyState, StrategyStateHash, GOAP_SPACE_SIZE> planner;
+    goals::WindsocksUp windsocks;
+
+    for (auto x = 200; x < 3000; x += 400) {
+        for (auto y = 200; y < 2000; y += 400) {
+            actions::set_robot_position(state, {x, y});
+            CHECK_EQUAL(2, planner.plan(state, windsocks, actions, 2, path, 10));
+
+            goap::Action<StrategyState>* reversed[] = {path[1], path[0]};
+            CHECK_TRUE(plan_cost(state, path, 2) <= plan_cost(state, reversed, 2));
+        }
+    }
+
+    actions::set_robot_position(state, windsock_far.start());
+    planner.plan(state, windsocks, actions, 2, path, 10);
+    POINTERS_EQUAL(&windsock_far, path[0]);
+}
@@ -1,3 +1,5 @@
+#include <chrono>
+#include <cstdio>
 #include <absl/strings/str_cat.h>
 #include <uavcan_linux/uavcan_linux.hpp>
 #include "can/UavcanToMessagebusProxy.hpp"
@@ -21,13 +23,12 @@ struct Proxy : public ProxyBase {
         return absl::StrCat("/", board_name);
     }
 
-    absl::optional<BeaconSignal> translate(const cvra::proximity_beacon::Signal& in) override
+    bool translate(const cvra::proximity_beacon::Signal& in, BeaconSignal& out) override
     {
         // Example translation function. In general you would have a more
         // complicated translation function here
-        BeaconSignal out;
         out.range.range.distance = in.length;
-        return {out};
+        return true;
     }
 
     // for test only, expose process as a method, which would usually be called
@@ -91,11 +92,67 @@ TEST(ProxyTestGroup, ForwardsCANReceivedMessages)
     CHECK_EQUAL(topic_data.range.range.distance, signal.length);
 }
 
+TEST(ProxyTestGroup, SeveralBoardsGetTheirOwnTopic)
+{
+    bus_enumerator_add_node(&be, "otherboard", nullptr);
+    bus_enumerator_update_node_info(&be, "myboard", 42);
+    bus_enumerator_update_node_info(&be, "otherboard", 43);
+
+    signal.length = 1.;
+    proxy.process(signal, 42);
+    signal.length = 2.;
+    proxy.process(signal, 43);
+
+    BeaconSignal topic_data;
+    messagebus_topic_read(messagebus_find_topic(&bus, "/myboard"), &topic_data, sizeof topic_data);
+    CHECK_EQUAL(1., topic_data.range.range.distance);
+    messagebus_topic_read(messagebus_find_topic(&bus, "/otherboard"), &topic_data, sizeof topic_data);
+    CHECK_EQUAL(2., topic_data.range.range.distance);
+}
+
+TEST(ProxyTestGroup, FollowsNodeIDReassignment)
+{
+    bus_enumerator_add_node(&be, "otherboard", nullptr);
+    bus_enumerator_update_node_info(&be, "myboard", 42);
+    signal.length = 1.;
+    proxy.process(signal, 42);
+
+    // The ID now belongs to another board, e.g. after dynamic allocation
+    bus_enumerator_remove_can_id(&be, 42);
+    bus_enumerator_update_node_info(&be, "otherboard", 42);
+    signal.length = 2.;
+    proxy.process(signal, 42);
+
+    BeaconSignal topic_data;
+    messagebus_topic_read(messagebus_find_topic(&bus, "/myboard"), &topic_data, sizeof topic_data);
+    CHECK_EQUAL(1., topic_data.range.range.distance);
+    messagebus_topic_read(messagebus_find_topic(&bus, "/otherboard"), &topic_data, sizeof topic_data);
+    CHECK_EQUAL(2., topic_data.range.range.distance);
+}
+
+TEST(ProxyTestGroup, StopsForwardingForRemovedNodes)
+{
+    bus_enumerator_update_node_info(&be, "myboard", 42);
+    proxy.process(signal, 42);
+
+    bus_enumerator_remove_can_id(&be, 42);
+    proxy.process(signal, 42);
+
+    messagebus_topic_stats_t stats;
+    messagebus_topic_stats_get(messagebus_find_topic(&bus, "/myboard"), &stats);
+    CHECK_EQUAL(1, stats.messages);
+}
+
+TEST(ProxyTestGroup, IgnoresInvalidNodeID)
+{
+    proxy.process(signal, 200);
+}
+
 struct NonForwardingProxy : public Proxy {
-    absl::optional<BeaconSignal> translate(const cvra::proximity_beacon::Signal& /* in */) override
+    bool translate(const cvra::proximity_beacon::Signal& /* in */, BeaconSignal& /* out */) override
     {
-        // Do not forward message by returning an empty optional
-        return {};
+        // Do not forward message by returning false
+        return false;
     }
 
     NonForwardingProxy(bus_enumerator_t* be, messagebus_t* bus)
@@ -116,3 +173,42 @@ TEST(ProxyTestGroup, NonForwardingMessageStillCreatesTopic)
     auto success = messagebus_topic_read(topic, &topic_data, sizeof topic_data);
     CHECK_FALSE_TEXT(success, "The topic should not have been published");
 }
+
+TEST_GROUP (ProxyBenchmarkTestGroup) {
+    bus_enumerator_t be;
+    bus_enumerator_entry_allocator bea[10];
+    messagebus_t bus;
+    Proxy proxy{&be, &bus};
+    cvra::proximity_beacon::Signal signal;
+
+    void setup() override
+    {
+        bus_enumerator_init(&be, bea, 10);
+        bus_enumerator_add_node(&be, "myboard", nullptr);
+        bus_enumerator_update_node_info(&be, "myboard", 42);
+        messagebus_init(&bus, nullptr, nullptr);
+    }
+};
+
+// Not a functional test: measures the time spent in the proxy for each frame,
+// which is on the receive path of every sensor message.
+TEST(ProxyBenchmarkTestGroup, ForwardsOneMillionFrames)
+{
+    const int frame_count = 1000000;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frame_count; i++) {
+        signal.length = i;
+        proxy.process(signal, 42);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    auto* topic = messagebus_find_topic(&bus, "/myboard");
+    messagebus_topic_stats_t stats;
+    messagebus_topic_stats_get(topic, &stats);
+    CHECK_EQUAL(frame_count, stats.messages);
+
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    printf("\nUavcanToMessagebusProxy: %d frames in %.1f ms, %.1f ns/frame\n",
+           frame_count, ns * 1e-6, double(ns) / frame_count);
+}
@@ -6,6 +6,7 @@
 #include "analog.h"
 #include "encoder.h"
 #include <parameter/parameter.h>
+#include <parameter/parameter_snapshot.h>
 #include "main.h"
 #include "pid_cascade.h"
 #include <timestamp/timestamp.h>
@@ -26,6 +27,13 @@ struct pid_param_s {
     parameter_t i_limit;
 };
 
+struct pid_config_s {
+    float kp;
+    float ki;
+    float kd;
+    float i_limit;
+};
+
 struct feedback_s control_feedback;
 motor_protection_t control_motor_protection;
 
@@ -89,6 +97,104 @@ static struct {
     parameter_t phase;
 } rpm_params;
 
+/* Copies of the parameters used by the control loop. They are only updated
+ * when a parameter of their namespace changes, so that the loop does not take
+ * the parameter lock on every cycle. */
+static struct control_config_s {
+    float low_batt_th;
+    float vel_limit;
+    float acc_limit;
+    float torque_limit;
+    struct pid_config_s pos, vel, cur;
+    int32_t mode;
+} control_config;
+
+static const parameter_binding_t control_bindings[] = {
+    PARAMETER_BINDING(&control_params.low_batt_th, struct control_config_s, low_batt_th),
+    PARAMETER_BINDING(&control_params.limits.vel, struct control_config_s, vel_limit),
+    PARAMETER_BINDING(&control_params.limits.acc, struct control_config_s, acc_limit),
+    PARAMETER_BINDING(&control_params.limits.torque, struct control_config_s, torque_limit),
+    PARAMETER_BINDING(&control_params.pos.pid.kp, struct control_config_s, pos.kp),
+    PARAMETER_BINDING(&control_params.pos.pid.ki, struct control_config_s, pos.ki),
+    PARAMETER_BINDING(&control_params.pos.pid.kd, struct control_config_s, pos.kd),
+    PARAMETER_BINDING(&control_params.pos.pid.i_limit, struct control_config_s, pos.i_limit),
+    PARAMETER_BINDING(&control_params.vel.pid.kp, struct control_config_s, vel.kp),
+    PARAMETER_BINDING(&control_params.vel.pid.ki, struct control_config_s, vel.ki),
+    PARAMETER_BINDING(&control_params.vel.pid.kd, struct control_config_s, vel.kd),
+    PARAMETER_BINDING(&control_params.vel.pid.i_limit, struct control_config_s, vel.i_limit),
+    PARAMETER_BINDING(&control_params.cur.pid.kp, struct control_config_s, cur.kp),
+    PARAMETER_BINDING(&control_params.cur.pid.ki, struct control_config_s, cur.ki),
+    PARAMETER_BINDING(&control_params.cur.pid.kd, struct control_config_s, cur.kd),
+    PARAMETER_BINDING(&control_params.cur.pid.i_limit, struct control_config_s, cur.i_limit),
+    PARAMETER_BINDING(&control_params.mode, struct control_config_s, mode),
+};
+
+static struct motor_config_s {
+    float torque_cst;
+    float current_offset;
+} motor_config;
+
+static const parameter_binding_t motor_bindings[] = {
+    PARAMETER_BINDING(&motor_params.torque_cst, struct motor_config_s, torque_cst),
+    PARAMETER_BINDING(&motor_params.current_offset, struct motor_config_s, current_offset),
+};
+
+static struct thermal_config_s {
+    float current_gain;
+    float Rth;
+    float Cth;
+    float max_temp;
+} thermal_config;
+
+static const parameter_binding_t thermal_bindings[] = {
+    PARAMETER_BINDING(&thermal_params.current_gain, struct thermal_config_s, current_gain),
+    PARAMETER_BINDING(&thermal_params.Rth, struct thermal_config_s, Rth),
+    PARAMETER_BINDING(&thermal_params.Cth, struct thermal_config_s, Cth),
+    PARAMETER_BINDING(&thermal_params.max_temp, struct thermal_config_s, max_temp),
+};
+
+static struct encoder_config_s {
+    struct {
+        int32_t p;
+        int32_t q;
+        int32_t ticks_per_rev;
+    } primary, secondary;
+} encoder_config;
+
+static const parameter_binding_t encoder_bindings[] = {
+    PARAMETER_BINDING(&encoder_params.primary.p, struct encoder_config_s, primary.p),
+    PARAMETER_BINDING(&encoder_params.primary.q, struct encoder_config_s, primary.q),
+    PARAMETER_BINDING(&encoder_params.primary.ticks_per_rev, struct encoder_config_s, primary.ticks_per_rev),
+    PARAMETER_BINDING(&encoder_params.secondary.p, struct encoder_config_s, secondary.p),
+    PARAMETER_BINDING(&encoder_params.secondary.q, struct encoder_config_s, secondary.q),
+    PARAMETER_BINDING(&encoder_params.secondary.ticks_per_rev, struct encoder_config_s, secondary.ticks_per_rev),
+};
+
+static struct sensor_config_s {
+    float gain;
+    float zero;
+    float phase;
+} sensor_config;
+
+static const parameter_binding_t potentiometer_bindings[] = {
+    PARAMETER_BINDING(&potentiometer_params.gain, struct sensor_config_s, gain),
+    PARAMETER_BINDING(&potentiometer_params.zero, struct sensor_config_s, zero),
+};
+
+static const parameter_binding_t rpm_bindings[] = {
+    PARAMETER_BINDING(&rpm_params.phase, struct sensor_config_s, phase),
+};
+
+static parameter_snapshot_t control_snapshot;
+static parameter_snapshot_t motor_snapshot;
+static parameter_snapshot_t thermal_snapshot;
+static parameter_snapshot_t encoder_snapshot;
+static parameter_snapshot_t potentiometer_snapshot;
+static parameter_snapshot_t rpm_snapshot;
+
+#define SNAPSHOT_INIT(snapshot, ns, bindings) \
+    parameter_snapshot_init(&snapshot, &ns, bindings, sizeof(bindings) / sizeof(bindings[0]))
+
 static timestamp_t last_setpoint_update;
 
 static float low_batt_th = LOW_BATT_TH;
@@ -150,6 +256,25 @@ void control_update_voltage_setpoint(float voltage)
     last_setpoint_update = timestamp_get();
 }
 
+void control_update_trajectory_segment(timestamp_t master_ts,
+                                       timestamp_t start,
+                                       float duration,
+                                       const float coeffs[4],
+                                       float torque)
+{
+    timestamp_t now = timestamp_get();
+    chBSemWait(&setpoint_interpolation_lock);
+    bool running = setpoint_update_stream(&setpoint_interpolation, master_ts, start, duration, coeffs, torque, now);
+    chBSemSignal(&setpoint_interpolation_lock);
+
+    /* A segment which already ended does not keep the motor enabled. */
+    if (running) {
+        last_setpoint_update = now;
+    }
+
+    ctrl.current_setpoint = torque * ctrl.motor_current_constant;
+}
+
 float control_get_motor_voltage(void)
 {
     return ctrl.motor_voltage;
@@ -229,17 +354,15 @@ static void pid_param_declare(struct pid_param_s* p, parameter_namespace_t* ns)
     parameter_scalar_declare_with_default(&p->i_limit, ns, "i_limit", INFINITY);
 }
 
-static void pid_param_update(struct pid_param_s* p, pid_ctrl_t* ctrl)
+static void pid_config_apply(const struct pid_config_s* config, pid_ctrl_t* ctrl)
 {
-    if (parameter_changed(&p->kp) || parameter_changed(&p->ki) || parameter_changed(&p->kd)) {
-        pid_set_gains(ctrl, parameter_scalar_get(&p->kp),
-                      parameter_scalar_get(&p->ki),
-                      parameter_scalar_get(&p->kd));
+    float kp, ki, kd;
+    pid_get_gains(ctrl, &kp, &ki, &kd);
+    if (kp != config->kp || ki != config->ki || kd != config->kd) {
+        pid_set_gains(ctrl, config->kp, config->ki, config->kd);
         pid_reset_integral(ctrl);
     }
-    if (parameter_changed(&p->i_limit)) {
-        pid_set_integral_limit(ctrl, parameter_scalar_get(&p->i_limit));
-    }
+    pid_set_integral_limit(ctrl, config->i_limit);
 }
 
 static void declare_parameters(void)
@@ -293,6 +416,13 @@ static void declare_parameters(void)
 
     parameter_namespace_declare(&rpm_params.ns, &parameter_root_ns, "rpm");
     parameter_scalar_declare_with_default(&rpm_params.phase, &rpm_params.ns, "phase", 0.);
+
+    SNAPSHOT_INIT(control_snapshot, control_params.ns, control_bindings);
+    SNAPSHOT_INIT(motor_snapshot, motor_params.ns, motor_bindings);
+    SNAPSHOT_INIT(thermal_snapshot, thermal_params.ns, thermal_bindings);
+    SNAPSHOT_INIT(encoder_snapshot, encoder_params.ns, encoder_bindings);
+    SNAPSHOT_INIT(potentiometer_snapshot, potentiometer_params.ns, potentiometer_bindings);
+    SNAPSHOT_INIT(rpm_snapshot, rpm_params.ns, rpm_bindings);
 }
 
 static void update_parameters(void);
@@ -319,80 +449,66 @@ void control_init(void)
 
     last_setpoint_update = timestamp_get();
 
-    control_feedback.primary_encoder.transmission_p = parameter_integer_get(&encoder_params.primary.p);
-    control_feedback.primary_encoder.transmission_q = parameter_integer_get(&encoder_params.primary.q);
-
-    ctrl.torque_limit = parameter_scalar_get(&control_params.limits.torque);
-    ctrl.current_limit = ctrl.torque_limit / parameter_scalar_get(&motor_params.torque_cst);
-    ctrl.velocity_limit = parameter_scalar_get(&control_params.limits.vel);
-
-    float transmission = (float)control_feedback.primary_encoder.transmission_p / control_feedback.primary_encoder.transmission_q;
-    ctrl.motor_current_constant = 1.f / (parameter_scalar_get(&motor_params.torque_cst) * transmission);
-
+    // The first update applies all the parameters
     update_parameters();
 }
 
 static void update_parameters(void)
 {
-    control_feedback.input_selection = parameter_integer_get(&control_params.mode);
+    bool encoders_changed = parameter_snapshot_update(&encoder_snapshot, &encoder_config);
+    if (encoders_changed) {
+        control_feedback.primary_encoder.transmission_p = encoder_config.primary.p;
+        control_feedback.primary_encoder.transmission_q = encoder_config.primary.q;
+        control_feedback.primary_encoder.ticks_per_rev = encoder_config.primary.ticks_per_rev;
+
+        control_feedback.secondary_encoder.transmission_p = encoder_config.secondary.p;
+        control_feedback.secondary_encoder.transmission_q = encoder_config.secondary.q;
+        control_feedback.secondary_encoder.ticks_per_rev = encoder_config.secondary.ticks_per_rev;
+    }
 
-    control_feedback.primary_encoder.transmission_p = parameter_integer_get(&encoder_params.primary.p);
-    control_feedback.primary_encoder.transmission_q = parameter_integer_get(&encoder_params.primary.q);
-    control_feedback.primary_encoder.ticks_per_rev = parameter_integer_get(&encoder_params.primary.ticks_per_rev);
+    if (parameter_snapshot_update(&potentiometer_snapshot, &sensor_config)) {
+        control_feedback.potentiometer.gain = sensor_config.gain;
+        control_feedback.potentiometer.zero = sensor_config.zero;
+    }
 
-    control_feedback.secondary_encoder.transmission_p = parameter_integer_get(&encoder_params.secondary.p);
-    control_feedback.secondary_encoder.transmission_q = parameter_integer_get(&encoder_params.secondary.q);
-    control_feedback.secondary_encoder.ticks_per_rev = parameter_integer_get(&encoder_params.secondary.ticks_per_rev);
+    if (parameter_snapshot_update(&rpm_snapshot, &sensor_config)) {
+        control_feedback.rpm.phase = sensor_config.phase;
+    }
 
-    control_feedback.potentiometer.gain = parameter_scalar_get(&potentiometer_params.gain);
-    control_feedback.potentiometer.zero = parameter_scalar_get(&potentiometer_params.zero);
+    bool control_changed = parameter_snapshot_update(&control_snapshot, &control_config);
+    if (control_changed) {
+        control_feedback.input_selection = control_config.mode;
 
-    control_feedback.rpm.phase = parameter_scalar_get(&rpm_params.phase);
+        pid_config_apply(&control_config.pos, &ctrl.position_pid);
+        pid_config_apply(&control_config.vel, &ctrl.velocity_pid);
+        pid_config_apply(&control_config.cur, &ctrl.current_pid);
 
-    if (parameter_namespace_contains_changed(&control_params.ns)) {
-        if (parameter_namespace_contains_changed(&control_params.pos.ns)) {
-            pid_param_update(&control_params.pos.pid, &ctrl.position_pid);
-        }
-        if (parameter_namespace_contains_changed(&control_params.vel.ns)) {
-            pid_param_update(&control_params.vel.pid, &ctrl.velocity_pid);
-        }
-        if (parameter_namespace_contains_changed(&control_params.cur.ns)) {
-            pid_param_update(&control_params.cur.pid, &ctrl.current_pid);
-        }
-        if (parameter_changed(&control_params.low_batt_th)) {
-            low_batt_th = parameter_scalar_get(&control_params.low_batt_th);
-        }
-        if (parameter_changed(&control_params.limits.vel)) {
-            ctrl.velocity_limit = parameter_scalar_get(&control_params.limits.vel);
-            chBSemWait(&setpoint_interpolation_lock);
-            setpoint_set_velocity_limit(&setpoint_interpolation, ctrl.velocity_limit);
-            chBSemSignal(&setpoint_interpolation_lock);
-        }
-        if (parameter_changed(&control_params.limits.torque)) {
-            ctrl.torque_limit = parameter_scalar_get(&control_params.limits.torque);
-            ctrl.current_limit = ctrl.torque_limit / parameter_scalar_get(&motor_params.torque_cst);
-        }
-        if (parameter_changed(&control_params.limits.acc)) {
-            chBSemWait(&setpoint_interpolation_lock);
-            setpoint_set_acceleration_limit(&setpoint_interpolation, parameter_scalar_get(&control_params.limits.acc));
-            chBSemSignal(&setpoint_interpolation_lock);
-        }
+        low_batt_th = control_config.low_batt_th;
+        ctrl.velocity_limit = control_config.vel_limit;
+        ctrl.torque_limit = control_config.torque_limit;
+
+        chBSemWait(&setpoint_interpolation_lock);
+        setpoint_set_velocity_limit(&setpoint_interpolation, ctrl.velocity_limit);
+        setpoint_set_acceleration_limit(&setpoint_interpolation, control_config.acc_limit);
+        chBSemSignal(&setpoint_interpolation_lock);
     }
-    if (parameter_namespace_contains_changed(&motor_params.ns)) {
-        if (parameter_changed(&motor_params.torque_cst)) {
-            float transmission = (float)control_feedback.primary_encoder.transmission_p / control_feedback.primary_encoder.transmission_q;
-            ctrl.motor_current_constant = 1.f / (parameter_scalar_get(&motor_params.torque_cst) * transmission);
-        }
-        if (parameter_changed(&motor_params.current_offset)) {
-            ctrl.motor_current_offset = parameter_scalar_get(&motor_params.current_offset);
-        }
+
+    bool motor_changed = parameter_snapshot_update(&motor_snapshot, &motor_config);
+    if (motor_changed || encoders_changed) {
+        float transmission = (float)control_feedback.primary_encoder.transmission_p / control_feedback.primary_encoder.transmission_q;
+        ctrl.motor_current_constant = 1.f / (motor_config.torque_cst * transmission);
+        ctrl.motor_current_offset = motor_config.current_offset;
+    }
+    if (motor_changed || control_changed) {
+        ctrl.current_limit = ctrl.torque_limit / motor_config.torque_cst;
     }
-    if (parameter_namespace_contains_changed(&thermal_params.ns)) {
+
+    if (parameter_snapshot_update(&thermal_snapshot, &thermal_config)) {
         motor_protection_init(&control_motor_protection,
-                              parameter_scalar_get(&thermal_params.max_temp),
-                              parameter_scalar_get(&thermal_params.Rth),
-                              parameter_scalar_get(&thermal_params.Cth),
-                              parameter_scalar_get(&thermal_params.current_gain));
+                              thermal_config.max_temp,
+                              thermal_config.Rth,
+                              thermal_config.Cth,
+                              thermal_config.current_gain);
     }
 }
 
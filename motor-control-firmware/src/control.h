@@ -23,6 +23,11 @@ void control_update_velocity_setpoint(float vel);
 void control_update_torque_setpoint(float torque);
 void control_update_trajectory_setpoint(float pos, float vel, float acc, float torque, timestamp_t ts);
 void control_update_voltage_setpoint(float voltage);
+void control_update_trajectory_segment(timestamp_t master_ts,
+                                       timestamp_t start,
+                                       float duration,
+                                       const float coeffs[4],
+                                       float torque);
 
 float control_get_motor_voltage(void);
 float control_get_vel_ctrl_out(void);
@@ -13,6 +13,17 @@ static float vel_setpt_interpolation(float vel, float acc, float delta_t)
     return vel + acc * delta_t;
 }
 
+// evaluates a cubic polynomial and its derivative at t
+static float segment_position(const setpoint_segment_t* seg, float t)
+{
+    return seg->coeffs[0] + t * (seg->coeffs[1] + t * (seg->coeffs[2] + t * seg->coeffs[3]));
+}
+
+static float segment_velocity(const setpoint_segment_t* seg, float t)
+{
+    return seg->coeffs[1] + t * (2 * seg->coeffs[2] + t * 3 * seg->coeffs[3]);
+}
+
 // returns acceleration to be applied for the next delta_t
 float vel_ramp(float pos, float vel, float target_pos, float delta_t, float max_vel, float max_acc, bool periodic)
 {
@@ -69,7 +80,7 @@ void setpoint_update_position(setpoint_interpolator_t* ip,
                               float current_vel,
                               bool periodic)
 {
-    if (ip->setpt_mode == SETPT_MODE_TORQUE) {
+    if (ip->setpt_mode == SETPT_MODE_TORQUE || ip->setpt_mode == SETPT_MODE_STREAM) {
         ip->setpt_pos = current_pos;
         ip->setpt_vel = current_vel;
     }
@@ -85,7 +96,7 @@ void setpoint_update_velocity(setpoint_interpolator_t* ip,
                               float vel,
                               float current_vel)
 {
-    if (ip->setpt_mode == SETPT_MODE_TORQUE) {
+    if (ip->setpt_mode == SETPT_MODE_TORQUE || ip->setpt_mode == SETPT_MODE_STREAM) {
         ip->setpt_vel = current_vel;
     }
     ip->setpt_mode = SETPT_MODE_VEL;
@@ -119,6 +130,126 @@ void setpoint_update_voltage(setpoint_interpolator_t* ip, float voltage)
     ip->setpt_voltage = voltage;
 }
 
+static void stream_update_clock_offset(setpoint_stream_t* stream,
+                                      timestamp_t master_ts,
+                                      timestamp_t now)
+{
+    // The transfer delay is always positive, so the smallest offset seen is
+    // the closest to the real one. The estimate slowly increases to follow the
+    // drift between the two clocks.
+    uint32_t offset = now - master_ts;
+    if (!stream->clock_offset_valid) {
+        stream->clock_offset = offset;
+        stream->clock_offset_valid = true;
+        return;
+    }
+
+    stream->clock_offset += SETPOINT_STREAM_CLOCK_LEAK;
+    if ((int32_t)(offset - stream->clock_offset) < 0) {
+        stream->clock_offset = offset;
+    }
+}
+
+bool setpoint_update_stream(setpoint_interpolator_t* ip,
+                            timestamp_t master_ts,
+                            timestamp_t start,
+                            float duration,
+                            const float coeffs[4],
+                            float torque,
+                            timestamp_t now)
+{
+    setpoint_stream_t* stream = &ip->stream;
+
+    if (ip->setpt_mode != SETPT_MODE_STREAM) {
+        ip->setpt_mode = SETPT_MODE_STREAM;
+        stream->head = 0;
+        stream->count = 0;
+        stream->clock_offset_valid = false;
+        stream->underrun = false;
+    }
+
+    stream_update_clock_offset(stream, master_ts, now);
+
+    setpoint_segment_t seg;
+    seg.start = start + stream->clock_offset;
+    seg.duration = duration;
+    for (int i = 0; i < 4; i++) {
+        seg.coeffs[i] = coeffs[i];
+    }
+    seg.torque = torque;
+
+    // segments starting after this one were replanned by the master
+    while (stream->count > 0) {
+        unsigned int last = (stream->head + stream->count - 1) % SETPOINT_STREAM_LEN;
+        if (timestamp_duration_us(seg.start, stream->segments[last].start) < 0) {
+            break;
+        }
+        stream->count--;
+    }
+
+    // when full, the oldest segment is dropped
+    if (stream->count == SETPOINT_STREAM_LEN) {
+        stream->head = (stream->head + 1) % SETPOINT_STREAM_LEN;
+        stream->count--;
+    }
+
+    stream->segments[(stream->head + stream->count) % SETPOINT_STREAM_LEN] = seg;
+    stream->count++;
+
+    return timestamp_duration_s(seg.start, now) <= seg.duration;
+}
+
+void setpoint_stream_sample(setpoint_stream_t* stream,
+                            struct setpoint_s* setpts,
+                            timestamp_t now)
+{
+    // skip to the last segment which already started
+    while (stream->count > 1) {
+        unsigned int next = (stream->head + 1) % SETPOINT_STREAM_LEN;
+        if (timestamp_duration_us(stream->segments[next].start, now) < 0) {
+            break;
+        }
+        stream->head = next;
+        stream->count--;
+    }
+
+    if (stream->count == 0) {
+        setpts->position_control_enabled = false;
+        setpts->velocity_control_enabled = false;
+        setpts->feedforward_torque = 0;
+        return;
+    }
+
+    const setpoint_segment_t* seg = &stream->segments[stream->head];
+    float t = timestamp_duration_s(seg->start, now);
+
+    setpts->position_control_enabled = true;
+    setpts->velocity_control_enabled = true;
+    setpts->feedforward_torque = seg->torque;
+
+    if (t < 0) {
+        // waiting for the start of the trajectory
+        setpts->position_setpt = segment_position(seg, 0);
+        setpts->velocity_setpt = 0;
+        setpts->feedforward_torque = 0;
+    } else if (t <= seg->duration) {
+        stream->underrun = false;
+        setpts->position_setpt = segment_position(seg, t);
+        setpts->velocity_setpt = segment_velocity(seg, t);
+    } else {
+        // The trajectory is over, or the next segment is late or was lost.
+        // Hold the end position rather than extrapolating, as nothing bounds
+        // how far the extrapolation would go. The control timeout disables
+        // the motor if no segment arrives anymore.
+        if (!stream->underrun) {
+            stream->underrun = true;
+            stream->underrun_count++;
+        }
+        setpts->position_setpt = segment_position(seg, seg->duration);
+        setpts->velocity_setpt = 0;
+    }
+}
+
 void setpoint_compute(setpoint_interpolator_t* ip,
                       struct setpoint_s* setpts,
                       float delta_t)
@@ -138,6 +269,9 @@ void setpoint_compute(setpoint_interpolator_t* ip,
                                                          ip_delta_t);
         setpts->feedforward_torque = ip->setpt_torque;
 
+    } else if (ip->setpt_mode == SETPT_MODE_STREAM) {
+        setpoint_stream_sample(&ip->stream, setpts, timestamp_get());
+
     } else if (ip->setpt_mode == SETPT_MODE_TORQUE) {
         setpts->position_control_enabled = false;
         setpts->velocity_control_enabled = false;
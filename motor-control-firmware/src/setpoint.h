@@ -2,6 +2,7 @@
 #define SETPOINT_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <timestamp/timestamp.h>
 
 #ifdef __cplusplus
@@ -13,6 +14,33 @@ extern "C" {
 #define SETPT_MODE_TORQUE 2
 #define SETPT_MODE_TRAJ 3
 #define SETPT_MODE_VOLT 4
+#define SETPT_MODE_STREAM 5
+
+#define SETPOINT_STREAM_LEN 8
+
+// Increase of the clock offset estimate for each received segment [us], to
+// follow the drift between the master and board clocks.
+#define SETPOINT_STREAM_CLOCK_LEAK 2
+
+// Segment of a streamed trajectory. The position setpoint is the cubic
+// polynomial coeffs[0] + coeffs[1] t + coeffs[2] t^2 + coeffs[3] t^3, with t
+// the time since start in seconds.
+typedef struct {
+    timestamp_t start; // local time of the start of the segment
+    float duration; // [s]
+    float coeffs[4];
+    float torque; // feedforward torque
+} setpoint_segment_t;
+
+typedef struct {
+    setpoint_segment_t segments[SETPOINT_STREAM_LEN]; // ring, ordered by start time
+    unsigned int head; // index of the segment being executed
+    unsigned int count;
+    uint32_t clock_offset; // local time - master time [us], modulo 2^32
+    bool clock_offset_valid;
+    bool underrun; // holding the end of the last segment
+    uint32_t underrun_count;
+} setpoint_stream_t;
 
 typedef struct {
     int setpt_mode;
@@ -27,6 +55,7 @@ typedef struct {
     float acc_limit; // acceleration limit
     float vel_limit; // velocity limit
     bool periodic_actuator;
+    setpoint_stream_t stream; // valid only in stream mode
 } setpoint_interpolator_t;
 
 struct setpoint_s {
@@ -65,6 +94,24 @@ void setpoint_update_trajectory(setpoint_interpolator_t* ip,
 
 void setpoint_update_voltage(setpoint_interpolator_t* ip, float voltage);
 
+// Adds a segment to the streamed trajectory, switching to stream mode if
+// needed. master_ts and start are in the master clock, now in the local one.
+// A segment starting before the ones already buffered replaces them.
+// Returns false if the segment has already ended at now, in which case it
+// must not refresh the control timeout.
+bool setpoint_update_stream(setpoint_interpolator_t* ip,
+                            timestamp_t master_ts,
+                            timestamp_t start,
+                            float duration,
+                            const float coeffs[4],
+                            float torque,
+                            timestamp_t now);
+
+// Computes the setpoints of the streamed trajectory at local time now.
+void setpoint_stream_sample(setpoint_stream_t* stream,
+                            struct setpoint_s* setpts,
+                            timestamp_t now);
+
 void setpoint_compute(setpoint_interpolator_t* ip,
                       struct setpoint_s* setpts,
                       float delta_t);
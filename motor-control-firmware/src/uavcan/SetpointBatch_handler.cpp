@@ -0,0 +1,42 @@
+#include <cvra/motor/control/SetpointBatch.hpp>
+#include "SetpointBatch_handler.hpp"
+#include "uavcan_node.h"
+#include "control.h"
+
+using cvra::motor::control::Setpoint;
+
+int SetpointBatch_handler_start(Node& node)
+{
+    int ret;
+    static uavcan::Subscriber<cvra::motor::control::SetpointBatch> sub(node);
+
+    ret = sub.start(
+        [&](const uavcan::ReceivedDataStructure<cvra::motor::control::SetpointBatch>& msg) {
+            for (const auto& setpoint : msg.setpoints) {
+                if (uavcan::NodeID(setpoint.node_id) != node.getNodeID()) {
+                    continue;
+                }
+
+                switch (setpoint.mode) {
+                    case Setpoint::MODE_VELOCITY:
+                        control_update_velocity_setpoint(setpoint.value);
+                        break;
+
+                    case Setpoint::MODE_POSITION:
+                        control_update_position_setpoint(setpoint.value);
+                        break;
+
+                    case Setpoint::MODE_TORQUE:
+                        control_update_torque_setpoint(setpoint.value);
+                        break;
+
+                    case Setpoint::MODE_VOLTAGE:
+                        control_update_voltage_setpoint(setpoint.value);
+                        break;
+                }
+                break;
+            }
+        });
+
+    return ret;
+}
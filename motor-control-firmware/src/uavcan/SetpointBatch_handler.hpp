@@ -0,0 +1,8 @@
+#ifndef SETPOINT_BATCH_HANDLER_HPP
+#define SETPOINT_BATCH_HANDLER_HPP
+
+#include "uavcan_node.h"
+
+int SetpointBatch_handler_start(Node& node);
+
+#endif
@@ -0,0 +1,27 @@
+#include <cvra/motor/control/TrajectorySegment.hpp>
+#include "TrajectorySegment_handler.hpp"
+#include "uavcan_node.h"
+#include "control.h"
+
+int TrajectorySegment_handler_start(Node& node)
+{
+    int ret;
+    static uavcan::Subscriber<cvra::motor::control::TrajectorySegment> sub(node);
+
+    ret = sub.start(
+        [&](const uavcan::ReceivedDataStructure<cvra::motor::control::TrajectorySegment>& msg) {
+            if (uavcan::NodeID(msg.node_id) == node.getNodeID()) {
+                float coeffs[4];
+                for (int i = 0; i < 4; i++) {
+                    coeffs[i] = msg.coefficients[i];
+                }
+                control_update_trajectory_segment(msg.timestamp,
+                                                  msg.start_time,
+                                                  msg.duration / 1e6f,
+                                                  coeffs,
+                                                  msg.torque);
+            }
+        });
+
+    return ret;
+}
@@ -0,0 +1,8 @@
+#ifndef TRAJECTORYSEGMENT_HANDLER_HPP
+#define TRAJECTORYSEGMENT_HANDLER_HPP
+
+#include "uavcan_node.h"
+
+int TrajectorySegment_handler_start(Node& node);
+
+#endif
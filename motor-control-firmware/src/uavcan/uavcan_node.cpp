@@ -20,6 +20,8 @@
 #include "Position_handler.hpp"
 #include "Torque_handler.hpp"
 #include "Voltage_handler.hpp"
+#include "SetpointBatch_handler.hpp"
+#include "TrajectorySegment_handler.hpp"
 #include "stream.h"
 
 #define CAN_BITRATE 1000000
@@ -54,6 +56,8 @@ static void uavcan_services_start(Node& node)
         {Position_handler_start, "cvra::motor::control::Position subscriber"},
         {Torque_handler_start, "cvra::motor::control::Torque subscriber"},
         {Voltage_handler_start, "cvra::motor::control::Voltage subscriber"},
+        {SetpointBatch_handler_start, "cvra::motor::control::SetpointBatch subscriber"},
+        {TrajectorySegment_handler_start, "cvra::motor::control::TrajectorySegment subscriber"},
         {parameter_server_start, "UAVCAN parameter server"},
         {uavcan_streams_start, "UAVCAN state streamer"},
         {NULL, NULL} /* Must be last */
@@ -272,3 +272,161 @@ TEST(SetpointVelocityRamp, Overshot)
                   vel_ramp(pos, vel, target_pos, delta_t, max_vel, max_acc, false),
                   FLOAT_TOLERANCE);
 }
+
+TEST_GROUP (SetpointStream) {
+    struct setpoint_s setpoint;
+    setpoint_interpolator_t interpolator;
+
+    // the board clock is 1 s ahead of the master one
+    const timestamp_t offset = 1000000;
+
+    void setup(void)
+    {
+        setpoint_init(&interpolator);
+    }
+
+    // pushes a segment starting at master time start and received 100 us
+    // after being sent at master time sent
+    void push(timestamp_t sent, timestamp_t start, float duration, float c0, float c1, float c2 = 0, float c3 = 0)
+    {
+        const float coeffs[4] = {c0, c1, c2, c3};
+        setpoint_update_stream(&interpolator, sent, start, duration, coeffs, 0.1, sent + offset + 100);
+    }
+
+    void sample(timestamp_t master_time)
+    {
+        setpoint_stream_sample(&interpolator.stream, &setpoint, master_time + offset + 100);
+    }
+};
+
+TEST(SetpointStream, SwitchesToStreamMode)
+{
+    push(0, 1000, 0.01, 0, 1);
+
+    CHECK_EQUAL(SETPT_MODE_STREAM, interpolator.setpt_mode);
+    CHECK_EQUAL(1, interpolator.stream.count);
+    CHECK_EQUAL(offset + 100, interpolator.stream.clock_offset);
+}
+
+TEST(SetpointStream, InterpolatesCubicPolynomial)
+{
+    push(0, 1000, 1, 1, 2, 3, 4);
+
+    sample(1000 + 500000);
+
+    CHECK_TRUE(setpoint.position_control_enabled);
+    CHECK_TRUE(setpoint.velocity_control_enabled);
+    DOUBLES_EQUAL(1 + 2 * 0.5 + 3 * 0.25 + 4 * 0.125, setpoint.position_setpt, FLOAT_TOLERANCE);
+    DOUBLES_EQUAL(2 + 2 * 3 * 0.5 + 3 * 4 * 0.25, setpoint.velocity_setpt, FLOAT_TOLERANCE);
+    DOUBLES_EQUAL(0.1, setpoint.feedforward_torque, FLOAT_TOLERANCE);
+}
+
+TEST(SetpointStream, HoldsStartPositionBeforeTheFirstSegment)
+{
+    push(0, 10000, 0.01, 3, 1);
+
+    sample(5000);
+
+    DOUBLES_EQUAL(3, setpoint.position_setpt, FLOAT_TOLERANCE);
+    DOUBLES_EQUAL(0, setpoint.velocity_setpt, FLOAT_TOLERANCE);
+}
+
+TEST(SetpointStream, MovesToTheNextSegment)
+{
+    push(0, 0, 0.01, 0, 1);
+    push(1000, 10000, 0.01, 0.01, 2);
+
+    sample(15000);
+
+    CHECK_EQUAL(1, interpolator.stream.count);
+    DOUBLES_EQUAL(0.02, setpoint.position_setpt, FLOAT_TOLERANCE);
+    DOUBLES_EQUAL(2, setpoint.velocity_setpt, FLOAT_TOLERANCE);
+}
+
+TEST(SetpointStream, HoldsTheEndPositionWhenSegmentsAreMissing)
+{
+    push(0, 0, 0.01, 0, 1, 10);
+
+    sample(20000);
+
+    // at the end of the segment: p = 0.01 + 0.001
+    DOUBLES_EQUAL(0, setpoint.velocity_setpt, FLOAT_TOLERANCE);
+    DOUBLES_EQUAL(0.011, setpoint.position_setpt, FLOAT_TOLERANCE);
+    CHECK_TRUE(interpolator.stream.underrun);
+    CHECK_EQUAL(1, interpolator.stream.underrun_count);
+
+    sample(21000);
+    CHECK_EQUAL(1, interpolator.stream.underrun_count);
+}
+
+TEST(SetpointStream, ResentExpiredSegmentDoesNotMoveTheSetpoint)
+{
+    const float coeffs[4] = {0, 1, 10, 0};
+    CHECK_TRUE(setpoint_update_stream(&interpolator, 0, 0, 0.01, coeffs, 0.1, offset + 100));
+    sample(20000);
+    float position = setpoint.position_setpt;
+
+    // keepalive repeating the segment long after it ended
+    for (timestamp_t t = 50000; t <= 500000; t += 50000) {
+        CHECK_FALSE(setpoint_update_stream(&interpolator, t, 0, 0.01, coeffs, 0.1, t + offset + 100));
+        sample(t + 1000);
+        DOUBLES_EQUAL(position, setpoint.position_setpt, FLOAT_TOLERANCE);
+        DOUBLES_EQUAL(0, setpoint.velocity_setpt, FLOAT_TOLERANCE);
+    }
+}
+
+TEST(SetpointStream, LateSegmentResumesTheTrajectory)
+{
+    push(0, 0, 0.01, 0, 1);
+    sample(15000);
+
+    push(15000, 10000, 0.01, 0.01, 1);
+    sample(16000);
+
+    CHECK_FALSE(interpolator.stream.underrun);
+    DOUBLES_EQUAL(0.016, setpoint.position_setpt, FLOAT_TOLERANCE);
+}
+
+TEST(SetpointStream, ReplanningReplacesLaterSegments)
+{
+    push(0, 0, 0.01, 0, 1);
+    push(0, 10000, 0.01, 0.01, 1);
+    push(0, 20000, 0.01, 0.02, 1);
+
+    push(1000, 10000, 0.01, 0.01, -1);
+
+    CHECK_EQUAL(2, interpolator.stream.count);
+    sample(15000);
+    DOUBLES_EQUAL(-1, setpoint.velocity_setpt, FLOAT_TOLERANCE);
+}
+
+TEST(SetpointStream, DropsOldestSegmentWhenFull)
+{
+    for (int i = 0; i < SETPOINT_STREAM_LEN + 1; i++) {
+        push(0, 10000 * i, 0.01, i, 0);
+    }
+
+    CHECK_EQUAL(SETPOINT_STREAM_LEN, interpolator.stream.count);
+    sample(0);
+    DOUBLES_EQUAL(1, setpoint.position_setpt, FLOAT_TOLERANCE);
+}
+
+TEST(SetpointStream, ClockOffsetUsesTheFastestTransfer)
+{
+    const float coeffs[4] = {0, 0, 0, 0};
+    setpoint_update_stream(&interpolator, 0, 0, 0.01, coeffs, 0, offset + 500);
+    setpoint_update_stream(&interpolator, 1000, 0, 0.01, coeffs, 0, 1000 + offset + 100);
+    setpoint_update_stream(&interpolator, 2000, 0, 0.01, coeffs, 0, 2000 + offset + 800);
+
+    CHECK_EQUAL(offset + 100 + SETPOINT_STREAM_CLOCK_LEAK, interpolator.stream.clock_offset);
+}
+
+TEST(SetpointStream, PositionModeStartsFromCurrentState)
+{
+    push(0, 0, 0.01, 0, 1);
+
+    setpoint_update_position(&interpolator, 2, 0.5, 0.3, false);
+
+    DOUBLES_EQUAL(0.5, interpolator.setpt_pos, FLOAT_TOLERANCE);
+    DOUBLES_EQUAL(0.3, interpolator.setpt_vel, FLOAT_TOLERANCE);
+}
@@ -0,0 +1,312 @@
+#!/usr/bin/env python3
+"""
+Runs many simulated matches in parallel, with the simulator (hitl) and the
+master firmware in lockstep on simulated time, and collects their statistics
+in a single results file, with one row per match and one column per metric.
+
+Each match has its own CAN bus in shared memory, so that matches do not see
+each other's CAN frames.
+
+The matches are described by a YAML file:
+
+    duration: 100              # simulated seconds, default for all matches
+    matches:
+      - name: baseline
+        seeds: [0, 1, 2]       # one match per seed
+        opponent_script: opponents/still.csv
+        beacon_angle_noise: 0.02
+        config:                # overrides of config_simulation.yaml
+          master:
+            ...
+
+Relative paths are relative to the YAML file.
+
+Besides the statistics reported by the programs, each row has the seed of
+the match, the real time it took (wall_time_s), the simulated time it covered
+(match_time_s, from the simulator) and a hash of the simulated robot
+trajectory (position_log_sha256). A match only depends on its seed and
+parameters, so running it again must give the same hash.
+"""
+
+import argparse
+import concurrent.futures
+import csv
+import hashlib
+import json
+import os
+import shlex
+import shutil
+import signal
+import subprocess
+import sys
+import tempfile
+import time
+
+import yaml
+
+MATCH_DEFAULTS = {
+    "duration": 100.0,
+    "seeds": [0],
+    "opponent_script": None,
+    "beacon_angle_noise": 0.0,
+    "config": {},
+}
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter
+    )
+    parser.add_argument("matches", type=argparse.FileType(), help="YAML match list")
+    parser.add_argument(
+        "--build-dir", default="build", help="CMake build directory (default: build)"
+    )
+    parser.add_argument(
+        "--output",
+        "-o",
+        default="results.csv",
+        help="Results file, CSV or Parquet (.parquet, requires pyarrow)",
+    )
+    parser.add_argument(
+        "--jobs",
+        "-j",
+        type=int,
+        default=os.cpu_count(),
+        help="Number of matches to run at the same time (default: one per CPU)",
+    )
+    parser.add_argument(
+        "--timeout",
+        type=float,
+        default=600,
+        help="Real time after which a match is killed, in seconds (default: 600)",
+    )
+    parser.add_argument(
+        "--keep", help="Directory in which to keep the logs of each match"
+    )
+    return parser.parse_args()
+
+
+def expand_matches(spec, base_dir="."):
+    """Returns one job per match and seed, with the defaults filled in."""
+    defaults = dict(MATCH_DEFAULTS)
+    defaults.update({k: v for k, v in spec.items() if k != "matches"})
+
+    jobs = []
+    for index, match in enumerate(spec["matches"]):
+        params = dict(defaults)
+        params.update(match)
+        params.setdefault("name", "match{}".format(index))
+
+        if params["opponent_script"]:
+            params["opponent_script"] = os.path.join(
+                base_dir, params["opponent_script"]
+            )
+
+        for seed in params.pop("seeds"):
+            job = dict(params)
+            job["seed"] = seed
+            job["id"] = len(jobs)
+            jobs.append(job)
+
+    return jobs
+
+
+def keys_to_str(to_convert):
+    """Same as in tools/config/config_to_msgpack.py: YAML reads numerical keys
+    as integers, but parameter names are strings."""
+    if not isinstance(to_convert, dict):
+        return to_convert
+
+    return {str(k): keys_to_str(v) for k, v in to_convert.items()}
+
+
+def write_config_override(config, path):
+    import msgpack
+
+    with open(path, "wb") as f:
+        f.write(msgpack.packb(keys_to_str(config), use_single_float=True))
+
+
+def clock_name(job):
+    """Name of the shared memory holding the virtual clock of the match."""
+    return "/cvra_batch_{}_{}".format(os.getpid(), job["id"])
+
+
+def can_bus_name(job):
+    """Name of the shared memory holding the CAN bus of the match."""
+    return clock_name(job) + "_can"
+
+
+def match_script(job, build_dir, workdir):
+    """Returns the shell script running one match."""
+    clock = clock_name(job)
+    can_iface = "--can_iface=shm:" + can_bus_name(job)
+
+    hitl = [
+        os.path.join(build_dir, "hitl", "motor_board_emulator"),
+        "--lockstep",
+        # simulator, and the master's control loop, UAVCAN thread and strategy
+        "--lockstep_participants=4",
+        "--enable_gui=false",
+        "--virtual_clock=" + clock,
+        can_iface,
+        "--duration={}".format(job["duration"]),
+        "--seed={}".format(job["seed"]),
+        "--beacon_angle_noise={}".format(job["beacon_angle_noise"]),
+        "--position_log=" + os.path.join(workdir, "position.bin"),
+        "--match_report=" + os.path.join(workdir, "hitl.json"),
+    ]
+    if job["opponent_script"]:
+        hitl.append("--opponent_script=" + job["opponent_script"])
+
+    master = [
+        os.path.join(build_dir, "master-firmware", "master-firmware"),
+        "--virtual_clock=" + clock,
+        can_iface,
+        "--enable_gui=false",
+        "--play_game",
+        "--match_report=" + os.path.join(workdir, "master.json"),
+    ]
+    if job["config"]:
+        master.append("--config_override=" + os.path.join(workdir, "config.msgpack"))
+
+    def run(cmd, log, pid):
+        return "{} > {} 2>&1 & {}=$!".format(
+            " ".join(shlex.quote(c) for c in cmd),
+            shlex.quote(os.path.join(workdir, log)),
+            pid,
+        )
+
+    # With set -e, the script exits as soon as one of them fails, and the trap
+    # stops the other one, which would otherwise wait forever in lockstep.
+    return "\n".join(
+        [
+            "set -e",
+            "trap 'kill $HITL $MASTER 2>/dev/null || true' EXIT",
+            run(hitl, "hitl.log", "HITL"),
+            run(master, "master.log", "MASTER"),
+            "wait $HITL",
+            "wait $MASTER",
+        ]
+    )
+
+
+def read_report(path):
+    try:
+        with open(path) as f:
+            return json.load(f)
+    except (OSError, ValueError):
+        return {}
+
+
+def file_digest(path):
+    """SHA-256 of a file, None if it cannot be read."""
+    digest = hashlib.sha256()
+    try:
+        with open(path, "rb") as f:
+            for chunk in iter(lambda: f.read(1 << 16), b""):
+                digest.update(chunk)
+    except OSError:
+        return None
+    return digest.hexdigest()
+
+
+def run_match(job, args):
+    workdir = tempfile.mkdtemp(prefix="hitl_batch_", dir=args.keep)
+    if job["config"]:
+        write_config_override(job["config"], os.path.join(workdir, "config.msgpack"))
+
+    script = match_script(job, os.path.abspath(args.build_dir), workdir)
+    cmd = ["sh", "-c", script]
+
+    status = "ok"
+    start = time.monotonic()
+    process = subprocess.Popen(cmd, start_new_session=True)
+    try:
+        if process.wait(timeout=args.timeout) != 0:
+            status = "failed"
+    except subprocess.TimeoutExpired:
+        status = "timeout"
+    finally:
+        # Also stops what the script left behind, on failures and on
+        # interrupts of the batch itself
+        try:
+            os.killpg(process.pid, signal.SIGKILL)
+        except ProcessLookupError:
+            pass
+        process.wait()
+
+    if status != "ok":
+        # Normally removed by the simulator when the match ends
+        for name in (clock_name(job), can_bus_name(job)):
+            try:
+                os.unlink("/dev/shm" + name)
+            except OSError:
+                pass
+
+    row = {
+        "match": job["name"],
+        "seed": job["seed"],
+        "status": status,
+        "wall_time_s": round(time.monotonic() - start, 3),
+        "position_log_sha256": file_digest(os.path.join(workdir, "position.bin")),
+    }
+    row.update(read_report(os.path.join(workdir, "hitl.json")))
+    row.update(read_report(os.path.join(workdir, "master.json")))
+
+    if args.keep:
+        row["workdir"] = workdir
+    else:
+        shutil.rmtree(workdir)
+
+    return row
+
+
+def to_columns(rows):
+    """Turns a list of result rows into columns, in order of first appearance.
+    Metrics missing from a row (for example when a match failed) are None."""
+    names = []
+    for row in rows:
+        names += [k for k in row if k not in names]
+
+    return {name: [row.get(name) for row in rows] for name in names}
+
+
+def write_results(columns, path):
+    if path.endswith(".parquet"):
+        import pyarrow
+        import pyarrow.parquet
+
+        pyarrow.parquet.write_table(pyarrow.table(columns), path)
+        return
+
+    with open(path, "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(columns.keys())
+        writer.writerows(zip(*columns.values()))
+
+
+def main():
+    args = parse_args()
+    if args.keep:
+        os.makedirs(args.keep, exist_ok=True)
+
+    jobs = expand_matches(
+        yaml.safe_load(args.matches), os.path.dirname(os.path.abspath(args.matches.name))
+    )
+    print("Running {} matches, {} at a time".format(len(jobs), args.jobs))
+
+    rows = []
+    with concurrent.futures.ThreadPoolExecutor(max_workers=args.jobs) as executor:
+        futures = [executor.submit(run_match, job, args) for job in jobs]
+        for future in concurrent.futures.as_completed(futures):
+            row = future.result()
+            print("{match} (seed {seed}): {status}".format(**row), file=sys.stderr)
+            rows.append(row)
+
+    rows.sort(key=lambda row: (row["match"], row["seed"]))
+    write_results(to_columns(rows), args.output)
+
+
+if __name__ == "__main__":
+    main()
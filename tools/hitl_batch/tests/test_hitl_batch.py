@@ -0,0 +1,123 @@
+import os
+import subprocess
+import tempfile
+import time
+import unittest
+
+from hitl_batch import expand_matches, match_script, to_columns
+
+
+def is_running(pid):
+    """False once the process exited, even if nobody reaped it yet."""
+    try:
+        with open("/proc/{}/stat".format(pid)) as f:
+            return f.read().split(")")[-1].split()[0] != "Z"
+    except FileNotFoundError:
+        return False
+
+
+class TestExpandMatches(unittest.TestCase):
+    def test_one_job_per_seed(self):
+        spec = {"matches": [{"name": "a", "seeds": [1, 2]}, {"name": "b"}]}
+
+        jobs = expand_matches(spec)
+
+        self.assertEqual(
+            [(j["name"], j["seed"]) for j in jobs], [("a", 1), ("a", 2), ("b", 0)]
+        )
+
+    def test_jobs_have_unique_ids(self):
+        spec = {"matches": [{"name": "a", "seeds": [1, 2]}, {"name": "a"}]}
+
+        jobs = expand_matches(spec)
+
+        self.assertEqual(len(set(j["id"] for j in jobs)), 3)
+
+    def test_top_level_values_are_defaults(self):
+        spec = {"duration": 20, "matches": [{}, {"duration": 5}]}
+
+        jobs = expand_matches(spec)
+
+        self.assertEqual([j["duration"] for j in jobs], [20, 5])
+        self.assertEqual(jobs[0]["name"], "match0")
+
+    def test_opponent_script_is_relative_to_the_spec(self):
+        spec = {"matches": [{"opponent_script": "opp.csv"}]}
+
+        jobs = expand_matches(spec, "/specs")
+
+        self.assertEqual(jobs[0]["opponent_script"], "/specs/opp.csv")
+
+
+class TestMatchScript(unittest.TestCase):
+    def setUp(self):
+        self.job = expand_matches({"matches": [{"seeds": [42]}]})[0]
+
+    def test_both_programs_share_the_clock(self):
+        script = match_script(self.job, "/build", "/work")
+
+        clocks = [w for w in script.split() if w.startswith("--virtual_clock=")]
+        self.assertEqual(len(clocks), 2)
+        self.assertEqual(clocks[0], clocks[1])
+
+    def test_both_programs_share_the_can_bus(self):
+        script = match_script(self.job, "/build", "/work")
+
+        buses = [w for w in script.split() if w.startswith("--can_iface=")]
+        self.assertEqual(len(buses), 2)
+        self.assertEqual(buses[0], buses[1])
+        self.assertTrue(buses[0].startswith("--can_iface=shm:/"))
+
+    def test_passes_seed_to_the_simulator(self):
+        script = match_script(self.job, "/build", "/work")
+
+        self.assertIn("--seed=42", script)
+
+    def test_config_override_only_when_needed(self):
+        self.assertNotIn("--config_override", match_script(self.job, "/b", "/w"))
+
+        self.job["config"] = {"master": {"foo": 1}}
+        self.assertIn("--config_override", match_script(self.job, "/b", "/w"))
+
+    def test_failing_program_stops_the_other(self):
+        with tempfile.TemporaryDirectory() as build:
+            pidfile = os.path.join(build, "master.pid")
+            programs = {
+                "hitl/motor_board_emulator": "sleep 0.5; exit 1",
+                "master-firmware/master-firmware": "echo $$ > {}; exec sleep 30".format(
+                    pidfile
+                ),
+            }
+            for path, body in programs.items():
+                path = os.path.join(build, path)
+                os.makedirs(os.path.dirname(path))
+                with open(path, "w") as f:
+                    f.write("#!/bin/sh\n" + body + "\n")
+                os.chmod(path, 0o755)
+
+            status = subprocess.call(["sh", "-c", match_script(self.job, build, build)])
+            time.sleep(0.1)
+
+            self.assertNotEqual(status, 0)
+            with open(pidfile) as f:
+                self.assertFalse(is_running(int(f.read())))
+
+
+class TestToColumns(unittest.TestCase):
+    def test_missing_metrics_are_none(self):
+        rows = [{"match": "a", "score": 10}, {"match": "b", "status": "timeout"}]
+
+        columns = to_columns(rows)
+
+        self.assertEqual(
+            columns,
+            {
+                "match": ["a", "b"],
+                "score": [10, None],
+                "status": [None, "timeout"],
+            },
+        )
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+"""
+Reads the binary position log written by the simulator (hitl), and converts
+it to CSV, or replays it as /position messages for plot_position.py.
+
+The format is defined in lib/position_log/include/position_log/position_log.h.
+"""
+
+import argparse
+import collections
+import csv
+import mmap
+import socket
+import struct
+import sys
+import time
+
+MAGIC = b"CVRAPLOG"
+VERSION = 1
+
+HEADER = struct.Struct("=8sII")
+RECORD = struct.Struct("=Q8f2i")
+
+Record = collections.namedtuple(
+    "Record",
+    [
+        "timestamp_us",
+        "x",
+        "y",
+        "heading",
+        "vx",
+        "vy",
+        "omega",
+        "left_voltage",
+        "right_voltage",
+        "left_encoder",
+        "right_encoder",
+    ],
+)
+
+
+class FormatError(Exception):
+    pass
+
+
+def check_header(data):
+    if len(data) < HEADER.size:
+        raise FormatError("File too short for a position log")
+
+    magic, version, record_size = HEADER.unpack_from(data)
+    if magic != MAGIC:
+        raise FormatError("Not a position log")
+    if version != VERSION or record_size != RECORD.size:
+        raise FormatError(
+            "Unsupported position log version {} (record size {})".format(
+                version, record_size
+            )
+        )
+
+
+def records(data):
+    """Iterates over the records of a log held in a buffer (for example a
+    mmap). A record cut short at the end of the log is ignored."""
+    check_header(data)
+
+    count = (len(data) - HEADER.size) // RECORD.size
+    end = HEADER.size + count * RECORD.size
+    for fields in RECORD.iter_unpack(memoryview(data)[HEADER.size : end]):
+        yield Record(*fields)
+
+
+def read(path):
+    """Returns the records of a log file as a list."""
+    with open(path, "rb") as f:
+        with mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as data:
+            return list(records(data))
+
+
+def read_array(path):
+    """Maps a log file as a numpy structured array, without copying it."""
+    import numpy as np
+
+    dtype = np.dtype(
+        [("timestamp_us", "u8")]
+        + [(name, "f4") for name in Record._fields[1:9]]
+        + [(name, "i4") for name in Record._fields[9:]]
+    )
+
+    with open(path, "rb") as f:
+        check_header(f.read(HEADER.size))
+
+    data = np.memmap(path, dtype=np.uint8, mode="r")
+    count = (len(data) - HEADER.size) // RECORD.size
+    return np.ndarray(count, dtype=dtype, buffer=data, offset=HEADER.size)
+
+
+def write_csv(log, f):
+    writer = csv.writer(f)
+    writer.writerow(Record._fields)
+    writer.writerows(log)
+
+
+def position_packet(record, topic):
+    """Encodes a record as a /position topic message, in the format sent by
+    the master firmware (see msgbus_protobuf.c), in millimeters."""
+    import messages
+
+    header = messages.TopicHeader()
+    header.name = topic
+    header.msgid = messages.msgid(messages.RobotPosition)
+
+    msg = messages.RobotPosition()
+    msg.x = record.x * 1000
+    msg.y = record.y * 1000
+    msg.a = record.heading
+
+    def with_size(m):
+        data = m.SerializeToString()
+        return messages.MessageSize(bytes=len(data)).SerializeToString() + data
+
+    return with_size(header) + with_size(msg)
+
+
+def replay(log, host, port, topic, speed):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+
+    start = time.monotonic()
+    for record in log:
+        delay = record.timestamp_us / 1e6 / speed - (time.monotonic() - start)
+        if delay > 0:
+            time.sleep(delay)
+
+        sock.sendto(position_packet(record, topic), (host, port))
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("log", help="Position log written by the simulator")
+    parser.add_argument(
+        "--csv",
+        type=argparse.FileType("w"),
+        help="Converts the log to CSV (- for stdout)",
+    )
+    parser.add_argument(
+        "--replay", action="store_true", help="Sends the log to plot_position.py"
+    )
+    parser.add_argument("--host", default="127.0.0.1", help="Host to send to")
+    parser.add_argument("--port", "-p", type=int, default=10000, help="UDP port")
+    parser.add_argument("--topic", "-t", default="/position", help="Topic name")
+    parser.add_argument(
+        "--speed", type=float, default=1.0, help="Replay speed (default: 1)"
+    )
+
+    return parser.parse_args()
+
+
+def main():
+    args = parse_args()
+
+    try:
+        log = read(args.log)
+    except FormatError as e:
+        sys.exit("{}: {}".format(args.log, e))
+
+    if args.csv:
+        write_csv(log, args.csv)
+
+    if args.replay:
+        replay(log, args.host, args.port, args.topic, args.speed)
+
+    if not args.csv and not args.replay:
+        print("{} records".format(len(log)))
+        if log:
+            print("from {} to {} us".format(log[0].timestamp_us, log[-1].timestamp_us))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,61 @@
+import io
+import unittest
+
+from position_log import (
+    HEADER,
+    MAGIC,
+    RECORD,
+    VERSION,
+    FormatError,
+    Record,
+    records,
+    write_csv,
+)
+
+
+def make_log(*recs):
+    data = HEADER.pack(MAGIC, VERSION, RECORD.size)
+    for r in recs:
+        data += RECORD.pack(*r)
+    return data
+
+
+def make_record(i):
+    return Record(10000 * i, 0.5 * i, 1.0, 0.0, 0.25, 0.0, 0.0, 3.0, -3.0, i, -i)
+
+
+class TestRecords(unittest.TestCase):
+    def test_empty_log(self):
+        self.assertEqual(list(records(make_log())), [])
+
+    def test_reads_back_records(self):
+        log = make_log(make_record(1), make_record(2))
+
+        self.assertEqual(list(records(log)), [make_record(1), make_record(2)])
+
+    def test_ignores_truncated_record(self):
+        log = make_log(make_record(1), make_record(2))[:-5]
+
+        self.assertEqual(list(records(log)), [make_record(1)])
+
+    def test_rejects_other_files(self):
+        with self.assertRaises(FormatError):
+            list(records(b"0.2,1.0,0.0,0.0\n0.2,1.0,0.0,0.0\n"))
+
+    def test_rejects_other_versions(self):
+        log = HEADER.pack(MAGIC, VERSION + 1, RECORD.size)
+
+        with self.assertRaises(FormatError):
+            list(records(log))
+
+
+class TestCsv(unittest.TestCase):
+    def test_one_line_per_record_after_header(self):
+        f = io.StringIO()
+
+        write_csv(records(make_log(make_record(1), make_record(2))), f)
+
+        lines = f.getvalue().splitlines()
+        self.assertEqual(len(lines), 3)
+        self.assertTrue(lines[0].startswith("timestamp_us,x,y,heading"))
+        self.assertTrue(lines[2].startswith("20000,1.0,1.0"))
@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+"""
+Converts a binary trace dump (see lib/trace/include/trace/trace_ring.h) to
+the Chrome trace event JSON format, which can be opened in Perfetto
+(ui.perfetto.dev) or chrome://tracing.
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+RECORD_NAME = 1
+RECORD_RING = 2
+RECORD_EVENT = 3
+RECORD_STRING = 4
+RECORD_LOST = 5
+RECORD_END = 6
+
+TYPE_STRING = 0
+TYPE_ADDRESS = 1
+TYPE_SCALAR = 2
+TYPE_INTEGER = 3
+TYPE_BEGIN = 4
+TYPE_END = 5
+
+PID = 1
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("dump", type=argparse.FileType("rb"), help="Binary trace dump")
+    parser.add_argument(
+        "--output",
+        "-o",
+        type=argparse.FileType("w"),
+        default=sys.stdout,
+        help="Output JSON file (default: stdout)",
+    )
+    return parser.parse_args()
+
+
+class Timestamps:
+    """Extends the 32 bit microsecond timestamps of each ring so that they
+    do not wrap around."""
+
+    def __init__(self):
+        self.last = {}
+        self.offset = {}
+
+    def extend(self, ring, timestamp):
+        if ring in self.last and timestamp < self.last[ring]:
+            self.offset[ring] = self.offset.get(ring, 0) + (1 << 32)
+        self.last[ring] = timestamp
+        return timestamp + self.offset.get(ring, 0)
+
+
+def read_records(data):
+    """Yields the records of a dump as tuples, the first item being the
+    record type."""
+    if data[:4] != b"CVTR":
+        raise ValueError("Not a trace dump")
+    if data[4] != 1:
+        raise ValueError("Unsupported dump version {}".format(data[4]))
+
+    pos = 5
+    while pos < len(data):
+        tag = data[pos]
+        if tag in (RECORD_NAME, RECORD_RING):
+            ident, length = data[pos + 1], data[pos + 2]
+            name = data[pos + 3 : pos + 3 + length].decode(errors="replace")
+            yield (tag, ident, name)
+            pos += 3 + length
+        elif tag == RECORD_EVENT:
+            ring, event, kind, timestamp, value = struct.unpack_from(
+                "<BBBII", data, pos + 1
+            )
+            if kind == TYPE_SCALAR:
+                value = struct.unpack("<f", struct.pack("<I", value))[0]
+            elif kind == TYPE_INTEGER:
+                value = struct.unpack("<i", struct.pack("<I", value))[0]
+            yield (tag, ring, event, kind, timestamp, value)
+            pos += 12
+        elif tag == RECORD_STRING:
+            ring, event, timestamp, length = struct.unpack_from("<BBIB", data, pos + 1)
+            string = data[pos + 8 : pos + 8 + length].decode(errors="replace")
+            yield (tag, ring, event, TYPE_STRING, timestamp, string)
+            pos += 8 + length
+        elif tag == RECORD_LOST:
+            ring, count = struct.unpack_from("<BI", data, pos + 1)
+            yield (tag, ring, count)
+            pos += 6
+        elif tag == RECORD_END:
+            # Anything after it, such as a shell prompt, is not part of the dump
+            return
+        else:
+            raise ValueError("Unknown record {} at offset {}".format(tag, pos))
+
+
+def convert(data):
+    """Converts a binary dump to a list of trace events."""
+    names = {}
+    events = []
+    timestamps = Timestamps()
+
+    for record in read_records(data):
+        tag = record[0]
+        if tag == RECORD_NAME:
+            names[record[1]] = record[2]
+        elif tag == RECORD_RING:
+            events.append(
+                {
+                    "name": "thread_name",
+                    "ph": "M",
+                    "pid": PID,
+                    "tid": record[1],
+                    "args": {"name": record[2]},
+                }
+            )
+        elif tag == RECORD_LOST:
+            events.append(
+                {
+                    "name": "lost events",
+                    "ph": "i",
+                    "s": "t",
+                    "pid": PID,
+                    "tid": record[1],
+                    "ts": timestamps.last.get(record[1], 0)
+                    + timestamps.offset.get(record[1], 0),
+                    "args": {"count": record[2]},
+                }
+            )
+        else:
+            _, ring, event, kind, timestamp, value = record
+            name = names.get(event, "event {}".format(event))
+            e = {
+                "name": name,
+                "pid": PID,
+                "tid": ring,
+                "ts": timestamps.extend(ring, timestamp),
+            }
+
+            if kind == TYPE_BEGIN:
+                e["ph"] = "B"
+            elif kind == TYPE_END:
+                e["ph"] = "E"
+            elif kind in (TYPE_SCALAR, TYPE_INTEGER):
+                e["ph"] = "C"
+                e["args"] = {name: value}
+            else:
+                e["ph"] = "i"
+                e["s"] = "t"
+                if kind == TYPE_ADDRESS:
+                    value = "0x{:08x}".format(value)
+                e["args"] = {"value": value}
+
+            events.append(e)
+
+    return events
+
+
+def main():
+    args = parse_args()
+    events = convert(args.dump.read())
+    json.dump({"traceEvents": events, "displayTimeUnit": "ms"}, args.output)
+
+
+if __name__ == "__main__":
+    main()
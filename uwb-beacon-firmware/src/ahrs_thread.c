@@ -1,4 +1,5 @@
 #include <math.h>
+#include <stdbool.h>
 #include <ch.h>
 
 #include "main.h"
@@ -40,8 +41,10 @@ static void ahrs_thd(void* p)
     madgwick_filter_init(&filter);
     madgwick_filter_set_gain(&filter, parameter_scalar_get(&ahrs_params.beta));
 
-    // TODO: Measure sample frequency instead
+    // Nominal rate, then measured from the IMU timestamps
     madgwick_filter_set_sample_frequency(&filter, 250);
+    uint32_t last_timestamp = 0;
+    bool first_sample = true;
 
     while (1) {
         if (parameter_changed(&ahrs_params.beta)) {
@@ -51,6 +54,21 @@ static void ahrs_thd(void* p)
         imu_msg_t imu;
         messagebus_topic_wait(imu_topic, &imu, sizeof(imu));
 
+        uint32_t dt = imu.timestamp - last_timestamp;
+        if (!first_sample && dt > 0) {
+            madgwick_filter_set_sample_frequency(&filter, 1e6f / dt);
+        }
+        last_timestamp = imu.timestamp;
+        first_sample = false;
+
+        /* The magnetometer is not calibrated, so only roll and pitch are
+         * corrected, which is what removing gravity needs. The heading comes
+         * from the gyro alone, relative to the heading at startup, and drifts
+         * slowly: its error is part of ekf/process_variance. */
+        madgwick_filter_updateIMU(&filter,
+                                  imu.gyro.x, imu.gyro.y, imu.gyro.z,
+                                  imu.acc.x, imu.acc.y, imu.acc.z);
+
         attitude_msg_t msg;
 
         msg.q.w = filter.q[0];
@@ -442,6 +442,70 @@ static void cmd_trace(BaseSequentialStream* chp, int argc, char* argv[])
     trace_clear();
 }
 
+/* Groups the small writes of a dump into fewer USB packets */
+static struct {
+    BaseSequentialStream* chp;
+    uint8_t data[64];
+    size_t len;
+} trace_stream_buffer;
+
+static void trace_stream_flush(void)
+{
+    streamWrite(trace_stream_buffer.chp, trace_stream_buffer.data, trace_stream_buffer.len);
+    trace_stream_buffer.len = 0;
+}
+
+static void trace_stream_write(void* arg, const void* data, size_t len)
+{
+    (void)arg;
+    const uint8_t* bytes = data;
+
+    while (len > 0) {
+        size_t n = sizeof(trace_stream_buffer.data) - trace_stream_buffer.len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(&trace_stream_buffer.data[trace_stream_buffer.len], bytes, n);
+        trace_stream_buffer.len += n;
+        bytes += n;
+        len -= n;
+
+        if (trace_stream_buffer.len == sizeof(trace_stream_buffer.data)) {
+            trace_stream_flush();
+        }
+    }
+}
+
+/* Streams the trace rings as a binary dump (see trace_ring.h) for the given
+ * number of seconds, while tracing continues. tools/read_trace.py records
+ * it. */
+static void cmd_trace_stream(BaseSequentialStream* chp, int argc, char* argv[])
+{
+    static struct trace_ring_reader reader;
+    int seconds = 5;
+
+    if (argc > 0) {
+        seconds = atoi(argv[0]);
+    }
+
+    trace_stream_buffer.chp = chp;
+    trace_stream_buffer.len = 0;
+
+    trace_ring_reader_init(&reader);
+    trace_ring_dump_header(trace_stream_write, NULL, trace_point_names, TRACE_POINT_COUNT);
+
+    systime_t start = chVTGetSystemTime();
+    while (chVTTimeElapsedSinceX(start) < TIME_S2I(seconds)) {
+        trace_ring_dump(&reader, trace_stream_write, NULL);
+        trace_stream_flush();
+        chThdSleepMilliseconds(10);
+    }
+
+    trace_ring_dump(&reader, trace_stream_write, NULL);
+    trace_ring_dump_end(trace_stream_write, NULL);
+    trace_stream_flush();
+}
+
 static void cmd_set_pos(BaseSequentialStream* chp, int argc, char* argv[])
 {
     if (argc < 2) {
@@ -505,6 +569,7 @@ const ShellCommand shell_commands[] = {
     {"reboot", cmd_reboot},
     {"topics", cmd_topics},
     {"trace", cmd_trace},
+    {"trace_stream", cmd_trace_stream},
     {"imu", cmd_imu},
     {"ahrs", cmd_ahrs},
     {"temp", cmd_temp},
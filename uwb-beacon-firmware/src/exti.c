@@ -21,6 +21,7 @@ static void uwb_cb(void* arg)
 {
     (void)arg;
     trace(TRACE_POINT_UWB_IRQ);
+    trace_ring_point(&trace_ring_uwb_irq, TRACE_POINT_UWB_IRQ);
 
     chSysLockFromISR();
 
@@ -4,6 +4,7 @@
 #include <parameter_flash_storage/parameter_flash_storage.h>
 #include <trace/trace.h>
 #include <error/error.h>
+#include "trace_points.h"
 
 #include "main.h"
 #include "usbconf.h"
@@ -33,6 +34,7 @@ void __late_init(void)
     chSysInit();
 
     trace_init();
+    trace_rings_init();
     trace_enable();
 }
 
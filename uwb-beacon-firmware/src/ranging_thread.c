@@ -16,6 +16,11 @@
 /** Speed of light in Decawave units */
 #define SPEED_OF_LIGHT (299792458.0 / (128 * 499.2e6))
 
+/* DW1000 timestamps are 40 bits, with a 128 * 499.2 MHz clock, which is
+ * 319488 ticks every 5 us */
+#define UWB_TIMESTAMP_MASK ((1ULL << 40) - 1)
+#define UWB_TICKS_TO_US(ticks) ((ticks) * 5 / 319488)
+
 /* Antenna delay for our UWB board. */
 #define RX_ANT_DLY 32915
 
@@ -70,6 +75,9 @@ static const uint8_t* data_packet;
 static uint16_t data_packet_dst_mac;
 static size_t data_packet_size;
 
+/* System time at which the frame being processed was received [us] */
+static uint32_t frame_rx_system_time;
+
 static struct {
     parameter_namespace_t ns;
     parameter_t mac_addr;
@@ -176,6 +184,7 @@ static void ranging_thread(void* p)
         if (flags & EVENT_ADVERTISE_TIMER) {
             if (!handler.is_anchor && nb_anchor_macs > 0) {
                 trace(TRACE_POINT_UWB_SEND_ADVERTISEMENT);
+                trace_ring_point(&trace_ring_ranging, TRACE_POINT_UWB_SEND_ADVERTISEMENT);
                 /* First disable transceiver */
                 dwt_forcetrxoff();
 
@@ -229,6 +238,22 @@ static void frame_tx_done_cb(const dwt_cb_data_t* data)
 {
     (void)data;
     trace(TRACE_POINT_UWB_TX_DONE);
+    trace_ring_point(&trace_ring_ranging, TRACE_POINT_UWB_TX_DONE);
+}
+
+/** Converts a DW1000 timestamp in the last 17 seconds to system time [us].
+ *
+ * The DW1000 clock gives how long ago it was, which is subtracted from the
+ * current system time. Both clocks are not read at the same instant, and the
+ * system time has a resolution of one tick, so the result can be up to one
+ * tick (100 us) plus the SPI read (a few us) late.
+ */
+static uint32_t uwb_to_system_time(uint64_t uwb_ts)
+{
+    uint32_t now = chVTGetSystemTime() * (1000000 / CH_CFG_ST_FREQUENCY);
+    uint64_t age = (uwb_timestamp_get() - uwb_ts) & UWB_TIMESTAMP_MASK;
+
+    return now - (uint32_t)UWB_TICKS_TO_US(age);
 }
 
 /* TODO: Handle RX errors as well, especially timeouts. */
@@ -236,11 +261,14 @@ static void frame_rx_cb(const dwt_cb_data_t* data)
 {
     static uint8_t frame[1024];
     trace(TRACE_POINT_UWB_RX);
+    trace_ring_begin(&trace_ring_ranging, TRACE_POINT_UWB_RX);
     uint64_t rx_ts = decawave_get_rx_timestamp_u64();
+    frame_rx_system_time = uwb_to_system_time(rx_ts);
 
     dwt_readrxdata(frame, data->datalength, 0);
 
     uwb_process_incoming_frame(&handler, frame, data->datalength, rx_ts);
+    trace_ring_end(&trace_ring_ranging, TRACE_POINT_UWB_RX);
 
     dwt_rxenable(DWT_START_RX_IMMEDIATE);
 }
@@ -295,10 +323,10 @@ static void tag_position_received_cb(uint16_t addr, float x, float y)
 static void ranging_found_cb(uint16_t addr, uint64_t time)
 {
     range_msg_t msg;
-    /* TODO: For some reason the macro ST2US creates an overflow. */
-    uint32_t ts = chVTGetSystemTime() * (1000000 / CH_CFG_ST_FREQUENCY);
 
-    msg.timestamp = ts;
+    /* Called while processing the last frame of the exchange, which is when
+     * the measurement ends. */
+    msg.timestamp = frame_rx_system_time;
     msg.anchor_addr = addr;
     msg.range = time * SPEED_OF_LIGHT;
 
@@ -9,7 +9,7 @@ extern "C" {
 #include <stdlib.h>
 
 typedef struct {
-    uint32_t timestamp; ///< Time at which the ranging solution was found (in us since boot)
+    uint32_t timestamp; ///< Time at which the last frame of the exchange was received (in us since boot)
     uint16_t anchor_addr; ///< Address of the anchor with which the measurement was done
     float range; ///< Distance to the anchor, in meters
 } range_msg_t;
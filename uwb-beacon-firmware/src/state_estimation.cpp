@@ -1,40 +1,34 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include "state_estimation.hpp"
-#include "ekf.hpp"
-
-struct UWBOnlyModel : EKF::Corrector<3, 1> {
-    Eigen::Vector3f anchor_pos;
-    UWBOnlyModel(float bx, float by, float bz, float variance)
-        : EKF::Corrector<3, 1>(Measurement::Identity() * variance)
-        , anchor_pos(bx, by, bz)
-    {
-    }
-
-    Measurement h(State mu) override
-    {
-        float dst = (mu - anchor_pos).norm();
-        return dst * Measurement::Identity();
-    }
 
-    Jacobian H(State mu) override
-    {
-        float dst = (mu - anchor_pos).norm();
-        return (mu - anchor_pos).transpose() * 1 / dst;
-    }
-};
+/** Standard gravity [m/s^2] */
+static const float GRAVITY = 9.81;
 
-struct IdentityPredictor : EKF::Predictor<3, 0> {
-    IdentityPredictor(float variance)
-        : EKF::Predictor<3, 0>(variance * Covariance::Identity())
-    {
-    }
-};
+/** Signed difference between two timestamps in us, robust to overflow */
+static int32_t time_difference(uint32_t from, uint32_t to)
+{
+    return (int32_t)(to - from);
+}
 
 RadioPositionEstimator::RadioPositionEstimator()
-    : covariance(Eigen::Matrix3f::Identity())
+    : covariance(Covariance::Identity())
     , measurementVariance(0.05 * 0.05)
-    , processVariance(0.001)
+    , processVariance(1.)
+    , headingVariance(1e-4)
+    , delayedMeasurements(0)
+    , droppedMeasurements(0)
+    , time(0)
+    , timeValid(false)
+    , acceleration(Eigen::Vector3f::Zero())
+    , historyCount(0)
 {
+    state = State::Zero();
     setPosition(1.0, 1.0, -0.5);
+
+    /* Any heading is as likely */
+    covariance(YAW, YAW) = M_PI * M_PI / 3;
 }
 
 void RadioPositionEstimator::setPosition(float x, float y, float z)
@@ -42,6 +36,9 @@ void RadioPositionEstimator::setPosition(float x, float y, float z)
     state[0] = x;
     state[1] = y;
     state[2] = z;
+
+    /* The steps kept would bring back the previous position */
+    historyCount = 0;
 }
 
 std::tuple<float, float, float> RadioPositionEstimator::getPosition()
@@ -49,19 +46,161 @@ std::tuple<float, float, float> RadioPositionEstimator::getPosition()
     return std::tuple<float, float, float>(state[0], state[1], state[2]);
 }
 
-void RadioPositionEstimator::processDistanceMeasurement(const float anchor_position[3],
+void RadioPositionEstimator::processDistanceMeasurement(uint32_t timestamp,
+                                                        const float anchor_position[3],
                                                         float distance)
 {
-    UWBOnlyModel m(anchor_position[0], anchor_position[1], anchor_position[2], measurementVariance);
-    Eigen::Matrix<float, 1, 1> z;
-    z << distance;
-    std::tie(state, covariance) = m.correct(state, covariance, z);
+    Step step;
+    step.type = Step::RANGE;
+    step.timestamp = timestamp;
+    memcpy(step.values, anchor_position, 3 * sizeof(float));
+    step.values[3] = distance;
+    add(step);
+}
+
+void RadioPositionEstimator::predict(uint32_t timestamp, const float ahrs_acceleration[3])
+{
+    Step step;
+    step.type = Step::PREDICTION;
+    step.timestamp = timestamp;
+    memcpy(step.values, ahrs_acceleration, 3 * sizeof(float));
+    add(step);
+}
+
+void RadioPositionEstimator::add(const Step& step)
+{
+    if (!timeValid) {
+        time = step.timestamp;
+        timeValid = true;
+    }
+
+    /* Steps are kept sorted by time, late ones are inserted before the newer
+     * steps, which are then applied again. */
+    int index = historyCount;
+    while (index > 0 && time_difference(step.timestamp, history[index - 1].timestamp) > 0) {
+        index--;
+    }
+
+    if (index < historyCount) {
+        if (index == 0 && time_difference(history[0].time, step.timestamp) < 0) {
+            /* The state at that time is gone */
+            if (step.type == Step::RANGE) {
+                droppedMeasurements++;
+            }
+            return;
+        }
+        if (step.type == Step::RANGE) {
+            delayedMeasurements++;
+        }
+
+        state = history[index].state;
+        covariance = history[index].covariance;
+        time = history[index].time;
+        acceleration = history[index].acceleration;
+
+        std::copy_backward(&history[index], &history[historyCount], &history[historyCount + 1]);
+    }
+
+    history[index] = step;
+    historyCount++;
+
+    for (int i = index; i < historyCount; i++) {
+        history[i].state = state;
+        history[i].covariance = covariance;
+        history[i].time = time;
+        history[i].acceleration = acceleration;
+        apply(history[i]);
+    }
+
+    if (historyCount > HISTORY_LENGTH) {
+        std::copy(&history[1], &history[HISTORY_LENGTH + 1], &history[0]);
+        historyCount = HISTORY_LENGTH;
+    }
+}
+
+void RadioPositionEstimator::apply(const Step& step)
+{
+    propagate(step.timestamp);
+
+    if (step.type == Step::PREDICTION) {
+        acceleration << step.values[0], step.values[1], step.values[2];
+    } else {
+        correct(step.values, step.values[3]);
+    }
+}
+
+/* Constant acceleration model, with the acceleration rotated by the yaw.
+ * Done by hand for F = [I dt*I dt^2/2*g; 0 I dt*g; 0 0 1], g being the
+ * derivative of the rotated acceleration with respect to the yaw. */
+void RadioPositionEstimator::propagate(uint32_t timestamp)
+{
+    float dt = time_difference(time, timestamp) * 1e-6f;
+    if (dt <= 0) {
+        return;
+    }
+
+    const float c = std::cos(state(YAW)), s = std::sin(state(YAW));
+    Eigen::Vector3f a(c * acceleration[0] - s * acceleration[1],
+                      s * acceleration[0] + c * acceleration[1],
+                      acceleration[2]);
+    Eigen::Vector3f g(-a[1], a[0], 0);
+
+    state.head<3>() += dt * state.segment<3>(3) + 0.5f * dt * dt * a;
+    state.segment<3>(3) += dt * a;
+
+    /* P = F P F' + Q, Q coming from a white noise on the acceleration and on
+     * the heading. The position rows and columns are updated first, as they
+     * need the velocity ones before their update. */
+    covariance.topRows<3>() += dt * covariance.middleRows<3>(3) + 0.5f * dt * dt * g * covariance.row(YAW);
+    covariance.middleRows<3>(3) += dt * g * covariance.row(YAW);
+    covariance.leftCols<3>() += dt * covariance.middleCols<3>(3) + 0.5f * dt * dt * covariance.col(YAW) * g.transpose();
+    covariance.middleCols<3>(3) += dt * covariance.col(YAW) * g.transpose();
+
+    const float q = processVariance;
+    for (int i = 0; i < 3; i++) {
+        covariance(i, i) += q * dt * dt * dt * dt / 4;
+        covariance(i, i + 3) += q * dt * dt * dt / 2;
+        covariance(i + 3, i) += q * dt * dt * dt / 2;
+        covariance(i + 3, i + 3) += q * dt * dt;
+    }
+    covariance(YAW, YAW) += headingVariance * dt;
+
+    time = timestamp;
+}
+
+void RadioPositionEstimator::correct(const float anchor_position[3], float distance)
+{
+    Eigen::Vector3f delta = state.head<3>() - Eigen::Vector3f(anchor_position[0], anchor_position[1], anchor_position[2]);
+    float predicted = delta.norm();
+    if (predicted < 1e-6f) {
+        return;
+    }
+
+    /* H = [delta / |delta|, 0, 0, 0, 0], so only the position columns of P
+     * are needed */
+    Eigen::Vector3f H = delta / predicted;
+    State PHt = covariance.leftCols<3>() * H;
+    float s = H.dot(PHt.head<3>()) + measurementVariance;
+    State K = PHt / s;
+
+    state += K * (distance - predicted);
+    state(YAW) = std::remainder(state(YAW), 2 * (float)M_PI);
+
+    /* Joseph form, (I - K H) P (I - K H)' + K r K'. Computed as products, it
+     * stays positive with rounding errors, which its expanded form
+     * P - K PHt' - PHt K' + s K K' does not. */
+    Eigen::Matrix<float, 1, 7> Hrow = Eigen::Matrix<float, 1, 7>::Zero();
+    Hrow.head<3>() = H.transpose();
+    Covariance A = Covariance::Identity() - K * Hrow;
+    covariance = A * covariance * A.transpose() + measurementVariance * K * K.transpose();
 }
 
-void RadioPositionEstimator::predict()
+void imu_acceleration_to_world(const float q[4], const float body[3], float world[3])
 {
-    IdentityPredictor p(processVariance);
-    Eigen::Matrix<float, 0, 1> u;
+    Eigen::Quaternionf attitude(q[0], q[1], q[2], q[3]);
+    Eigen::Vector3f a = attitude.normalized() * Eigen::Vector3f(body[0], body[1], body[2]);
 
-    std::tie(state, covariance) = p.predict(state, covariance, u);
+    world[0] = a[0];
+    world[1] = a[1];
+    world[2] = a[2] - GRAVITY;
 }
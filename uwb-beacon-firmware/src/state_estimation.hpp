@@ -1,18 +1,86 @@
+#include <cstdint>
 #include <utility>
-#include "ekf.hpp"
+#include <tuple>
+#include <Eigen/Dense>
 
+/** Estimates the position and velocity of the beacon from its distance to the
+ * anchors and from its accelerometer.
+ *
+ * The AHRS has no magnetometer, so its heading is the one it had at boot, not
+ * the one of the anchors. The offset between both is part of the state, and
+ * it is found from the ranges once the beacon accelerates.
+ *
+ * The accelerometer drives the prediction, and each range corrects the state
+ * with a scalar update in Joseph form, which needs no matrix inversion.
+ *
+ * The last steps of the filter are kept, so that a range which arrives after
+ * newer IMU samples is fused at the time it was measured, and the newer
+ * samples are applied again on top of it.
+ */
 class RadioPositionEstimator {
 public:
-    typedef Eigen::Matrix<float, 3, 1> State;
+    /** Position (m) and velocity (m/s) in the anchor frame, and heading of
+     * the AHRS frame in the anchor frame (rad) */
+    typedef Eigen::Matrix<float, 7, 1> State;
+    typedef Eigen::Matrix<float, 7, 7> Covariance;
+    enum { YAW = 6 };
+
+    /** Number of steps kept for late measurements, 128ms of IMU at 250Hz */
+    static constexpr int HISTORY_LENGTH = 32;
+
     State state;
-    Eigen::Matrix3f covariance;
-    float measurementVariance;
-    float processVariance;
+    Covariance covariance;
+    float measurementVariance; ///< Variance of the ranges [m^2]
+    float processVariance; ///< Variance of the acceleration noise [m^2/s^4]
+    float headingVariance; ///< Variance of the AHRS heading drift [rad^2/s]
+
+    /** Ranges which were fused in the past, and ranges which were dropped
+     * because they were older than the history. */
+    uint32_t delayedMeasurements;
+    uint32_t droppedMeasurements;
 
     RadioPositionEstimator();
     void setPosition(float x, float y, float z);
     std::tuple<float, float, float> getPosition();
 
-    void processDistanceMeasurement(const float anchor_position[2], float distance);
-    void predict(void);
+    /** Fuses the distance to an anchor (m), measured at the given time (us
+     * since boot). */
+    void processDistanceMeasurement(uint32_t timestamp, const float anchor_position[3], float distance);
+
+    /** Predicts the state up to the given time (us since boot), then uses
+     * the given acceleration (m/s^2, AHRS frame, without gravity) until the
+     * next prediction. */
+    void predict(uint32_t timestamp, const float ahrs_acceleration[3]);
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+private:
+    struct Step {
+        enum { PREDICTION,
+               RANGE } type;
+        uint32_t timestamp;
+        float values[4]; ///< Acceleration, or anchor position and distance
+
+        /* Filter before the step */
+        State state;
+        Covariance covariance;
+        uint32_t time;
+        Eigen::Vector3f acceleration;
+    };
+
+    uint32_t time;
+    bool timeValid;
+    Eigen::Vector3f acceleration;
+
+    Step history[HISTORY_LENGTH + 1];
+    int historyCount;
+
+    void add(const Step& step);
+    void apply(const Step& step);
+    void propagate(uint32_t timestamp);
+    void correct(const float anchor_position[3], float distance);
 };
+
+/** Rotates an accelerometer reading (m/s^2) to the world frame of the AHRS,
+ * using its attitude quaternion (w, x, y, z), and removes gravity. */
+void imu_acceleration_to_world(const float q[4], const float body[3], float world[3]);
@@ -6,23 +6,25 @@
 #include "state_estimation_thread.h"
 #include "anchor_position_cache.h"
 #include "imu_thread.h"
+#include "ahrs_thread.h"
 
 /** Parameters for this service. */
 static struct {
     parameter_namespace_t ns;
     parameter_t process_variance;
     parameter_t range_variance;
+    parameter_t heading_variance;
 } params;
 
 /** Creates the parameters. */
 static void parameters_init(parameter_namespace_t* parent);
 
-static THD_WORKING_AREA(state_estimation_wa, 1024);
+static THD_WORKING_AREA(state_estimation_wa, 2048);
 static THD_FUNCTION(state_estimation_thd, arg)
 {
     (void)arg;
 
-    messagebus_topic_t *range_topic, *imu_topic;
+    messagebus_topic_t *range_topic, *imu_topic, *attitude_topic;
     struct {
         mutex_t lock;
         condition_variable_t cv;
@@ -43,11 +45,12 @@ static THD_FUNCTION(state_estimation_thd, arg)
 
     parameters_init(&parameter_root);
 
-    // TODO configure variance
-    RadioPositionEstimator estimator;
+    /* Static because its history does not fit on the stack */
+    static RadioPositionEstimator estimator;
 
     range_topic = messagebus_find_topic_blocking(&bus, "/range");
     imu_topic = messagebus_find_topic_blocking(&bus, "/imu");
+    attitude_topic = messagebus_find_topic_blocking(&bus, "/attitude");
 
     /* Prepare to listen on all groups. */
     chMtxObjectInit(&watchgroup.lock);
@@ -83,16 +86,25 @@ static THD_FUNCTION(state_estimation_thd, arg)
 
             if (anchor_pos) {
                 float pos[3] = {anchor_pos->x, anchor_pos->y, anchor_pos->z};
-                estimator.processDistanceMeasurement(pos, msg.range);
+                // Fused at the time it was measured, even if newer IMU
+                // samples were already processed
+                estimator.processDistanceMeasurement(msg.timestamp, pos, msg.range);
             }
 
         } else if (topic == imu_topic) {
-            // TODO: Better source of periodic interrupts than IMU?
             imu_msg_t imu_msg;
+            attitude_msg_t attitude = {0, {1, 0, 0, 0}};
             messagebus_topic_read(topic, &imu_msg, sizeof(imu_msg));
+            messagebus_topic_read(attitude_topic, &attitude, sizeof(attitude));
+
+            const float q[4] = {attitude.q.w, attitude.q.x, attitude.q.y, attitude.q.z};
+            const float acc[3] = {imu_msg.acc.x, imu_msg.acc.y, imu_msg.acc.z};
+            float world_acc[3];
+            imu_acceleration_to_world(q, acc, world_acc);
 
             estimator.processVariance = parameter_scalar_read(&params.process_variance);
-            estimator.predict();
+            estimator.headingVariance = parameter_scalar_read(&params.heading_variance);
+            estimator.predict(imu_msg.timestamp, world_acc);
             position_estimation_msg_t pos_msg;
             pos_msg.timestamp = imu_msg.timestamp;
             pos_msg.x = estimator.state(0);
@@ -118,10 +130,14 @@ void state_estimation_start(void)
 static void parameters_init(parameter_namespace_t* parent)
 {
     parameter_namespace_declare(&params.ns, parent, "ekf");
+    // Variance of the acceleration noise, including attitude errors [m^2/s^4]
     parameter_scalar_declare_with_default(&params.process_variance,
                                           &params.ns,
                                           "process_variance",
-                                          4e-6);
+                                          1.);
     parameter_scalar_declare_with_default(&params.range_variance, &params.ns, "range_variance",
                                           9e-4);
+    // Drift of the AHRS heading, which has no magnetometer [rad^2/s]
+    parameter_scalar_declare_with_default(&params.heading_variance, &params.ns, "heading_variance",
+                                          1e-4);
 }
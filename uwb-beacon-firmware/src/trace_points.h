@@ -1,6 +1,7 @@
 #ifndef TRACE_POINTS_H
 #define TRACE_POINTS_H
 #include <trace/trace.h>
+#include <trace/trace_ring.h>
 
 #define TRACE_POINTS                      \
     C(TRACE_POINT_UWB_IRQ)                \
@@ -14,6 +15,15 @@
 #define C(x) x,
 enum {
     TRACE_POINTS
+    TRACE_POINT_COUNT
 };
 
+/** Lock-free trace rings, streamed out by the trace_stream shell command.
+ * Each one must only be written from its own context. */
+extern struct trace_ring trace_ring_uwb_irq; /**< UWB interrupt */
+extern struct trace_ring trace_ring_ranging; /**< Ranging thread */
+
+/** Registers the trace rings and starts the timer of their timestamps */
+void trace_rings_init(void);
+
 #endif /* TRACE_POINTS_H */
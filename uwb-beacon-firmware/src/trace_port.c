@@ -1,6 +1,7 @@
 #include <ch.h>
 #include <hal.h>
 #include <trace/trace.h>
+#include <trace/trace_ring.h>
 #include "trace_points.h"
 
 extern int32_t trace_lock(void)
@@ -18,6 +19,43 @@ extern int32_t trace_timestamp_ms_get(void)
     return TIME_I2MS(chVTGetSystemTimeX());
 }
 
+/* The system tick only has a 100us resolution, so the trace rings use TIM5,
+ * a free-running 32 bit timer counting microseconds. It wraps around like a
+ * uint32_t of microseconds, and is read without locking, from any context. */
+#define TRACE_TIMER STM32_TIM5
+
+// CK_CNT = CK_INT / (PSC[15:0] + 1)
+#if STM32_PPRE1 == STM32_PPRE1_DIV1
+#define TRACE_TIMER_PRESCALER (STM32_PCLK1 / 1000000 - 1)
+#else
+#define TRACE_TIMER_PRESCALER (2 * STM32_PCLK1 / 1000000 - 1)
+#endif
+
+static void trace_timer_init(void)
+{
+    rccEnableTIM5(FALSE);
+    rccResetTIM5();
+    TRACE_TIMER->PSC = TRACE_TIMER_PRESCALER;
+    TRACE_TIMER->ARR = 0xffffffff;
+    TRACE_TIMER->EGR = STM32_TIM_EGR_UG; // load the prescaler
+    TRACE_TIMER->CR1 |= STM32_TIM_CR1_CEN;
+}
+
+extern uint32_t trace_timestamp_us_get(void)
+{
+    return TRACE_TIMER->CNT;
+}
+
+struct trace_ring trace_ring_uwb_irq;
+struct trace_ring trace_ring_ranging;
+
+void trace_rings_init(void)
+{
+    trace_timer_init();
+    trace_ring_init(&trace_ring_uwb_irq, "uwb_irq");
+    trace_ring_init(&trace_ring_ranging, "ranging");
+}
+
 #undef C
 #define C(x) #x,
 
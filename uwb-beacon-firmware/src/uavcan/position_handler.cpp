@@ -11,11 +11,13 @@ template <typename T>
 using ReceivedDataStructure = uavcan::ReceivedDataStructure<T>;
 using TagPosition = cvra::uwb_beacon::TagPosition;
 
+static constexpr messagebus::TopicId state_topic_id{"/ekf/state"};
+
 static void tag_pos_cb(const ReceivedDataStructure<TagPosition>& msg)
 {
-    auto topic = messagebus_find_topic(&bus, "/ekf/state");
+    auto topic = messagebus::find_topic<position_estimation_msg_t>(bus, state_topic_id);
 
-    if (topic == nullptr) {
+    if (!topic) {
         return;
     }
 
@@ -25,7 +27,7 @@ static void tag_pos_cb(const ReceivedDataStructure<TagPosition>& msg)
     state_msg.variance_x = 0.01;
     state_msg.variance_y = 0.01;
 
-    messagebus_topic_publish(topic, &state_msg, sizeof(state_msg));
+    topic.publish(state_msg);
 }
 
 int position_handler_init(Node& node)
@@ -31,6 +31,13 @@ static BSEMAPHORE_DECL(range_topic_signaled, true);
 static BSEMAPHORE_DECL(tag_pos_topic_signaled, true);
 static BSEMAPHORE_DECL(data_packet_topic_signaled, true);
 
+/* Looked up each time a message is forwarded, so hashed at compile time */
+static constexpr messagebus::TopicId imu_topic_id{"/imu"};
+static constexpr messagebus::TopicId attitude_topic_id{"/attitude"};
+static constexpr messagebus::TopicId range_topic_id{"/range"};
+static constexpr messagebus::TopicId tag_pos_topic_id{"/ekf/state"};
+static constexpr messagebus::TopicId data_packet_topic_id{"/uwb_data"};
+
 static parameter_t publish_imu;
 static parameter_t publish_attitude;
 static parameter_t publish_range;
@@ -134,10 +141,8 @@ void topics_publisher_spin(Node& node)
     (void)node;
 
     if (chBSemWaitTimeout(&imu_topic_signaled, TIME_IMMEDIATE) == MSG_OK) {
-        messagebus_topic_t* topic;
         imu_msg_t imu_data;
-        topic = messagebus_find_topic(&bus, "/imu");
-        messagebus_topic_read(topic, &imu_data, sizeof(imu_data));
+        messagebus::find_topic<imu_msg_t>(bus, imu_topic_id).read(imu_data);
 
         uavcan::equipment::ahrs::RawIMU msg;
         msg.integration_interval = -1;
@@ -155,11 +160,9 @@ void topics_publisher_spin(Node& node)
     }
 
     if (chBSemWaitTimeout(&attitude_topic_signaled, TIME_IMMEDIATE) == MSG_OK) {
-        messagebus_topic_t* topic;
         attitude_msg_t attitude;
 
-        topic = messagebus_find_topic(&bus, "/attitude");
-        messagebus_topic_read(topic, &attitude, sizeof(attitude));
+        messagebus::find_topic<attitude_msg_t>(bus, attitude_topic_id).read(attitude);
 
         uavcan::equipment::ahrs::Solution msg;
         msg.timestamp.usec = attitude.timestamp;
@@ -171,11 +174,9 @@ void topics_publisher_spin(Node& node)
     }
 
     if (chBSemWaitTimeout(&range_topic_signaled, TIME_IMMEDIATE) == MSG_OK) {
-        messagebus_topic_t* topic;
         range_msg_t range_msg;
 
-        topic = messagebus_find_topic(&bus, "/range");
-        messagebus_topic_read(topic, &range_msg, sizeof(range_msg));
+        messagebus::find_topic<range_msg_t>(bus, range_topic_id).read(range_msg);
 
         RadioRange msg;
         msg.range = range_msg.range;
@@ -185,11 +186,9 @@ void topics_publisher_spin(Node& node)
     }
 
     if (chBSemWaitTimeout(&tag_pos_topic_signaled, TIME_IMMEDIATE) == MSG_OK) {
-        messagebus_topic_t* topic;
         position_estimation_msg_t tag_pos_msg;
 
-        topic = messagebus_find_topic(&bus, "/ekf/state");
-        messagebus_topic_read(topic, &tag_pos_msg, sizeof(tag_pos_msg));
+        messagebus::find_topic<position_estimation_msg_t>(bus, tag_pos_topic_id).read(tag_pos_msg);
 
         TagPosition msg;
         msg.timestamp.usec = tag_pos_msg.timestamp;
@@ -199,11 +198,9 @@ void topics_publisher_spin(Node& node)
     }
 
     if (chBSemWaitTimeout(&data_packet_topic_signaled, TIME_IMMEDIATE) == MSG_OK) {
-        messagebus_topic_t* topic;
         static data_packet_msg_t data_msg;
 
-        topic = messagebus_find_topic(&bus, "/uwb_data");
-        messagebus_topic_read(topic, &data_msg, sizeof(data_msg));
+        messagebus::find_topic<data_packet_msg_t>(bus, data_packet_topic_id).read(data_msg);
 
         DataPacket msg;
         msg.src_addr = data_msg.src_mac;
@@ -0,0 +1,162 @@
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include "ekf_replay.hpp"
+#include <CppUTest/TestHarness.h>
+
+/* Beacon going around a circle, with a 250Hz IMU and 50Hz ranges, like on the
+ * robot. The ranges reach the estimator 40ms after they were measured. The
+ * AHRS heading is off by ahrs_yaw, as it is relative to the one at boot. */
+static ekf_replay::Log circle_log(float ahrs_yaw = 0)
+{
+    const float radius = 1., omega = 2 * M_PI / 4, cx = 1.5, cy = 1., z = 0.5;
+    const float anchors[4][3] = {{0, 0, 2}, {3, 0, 0}, {3, 2, 2}, {0, 2, 0}};
+
+    std::mt19937 generator(42);
+    std::normal_distribution<float> range_noise(0., 0.05), imu_noise(0., 0.1);
+
+    ekf_replay::Log log;
+    for (int i = 0; i < 4; i++) {
+        log.anchors[i] = {0, anchors[i][0], anchors[i][1], anchors[i][2]};
+    }
+
+    for (int i = 0; i < 250 * 20; i++) {
+        uint32_t t = i * 4000;
+        float a = omega * t * 1e-6f;
+        float x = cx + radius * std::cos(a), y = cy + radius * std::sin(a);
+
+        log.truth.push_back({t, x, y, z});
+
+        float ax = -omega * omega * radius * std::cos(a);
+        float ay = -omega * omega * radius * std::sin(a);
+        log.imu.push_back({t,
+                           {ax + imu_noise(generator), ay + imu_noise(generator), 9.81f + imu_noise(generator)},
+                           {std::cos(ahrs_yaw / 2), 0, 0, std::sin(ahrs_yaw / 2)}});
+
+        if (i % 5 == 0) {
+            int anchor = (i / 5) % 4;
+            float range = std::sqrt(std::pow(x - anchors[anchor][0], 2)
+                                    + std::pow(y - anchors[anchor][1], 2)
+                                    + std::pow(z - anchors[anchor][2], 2));
+            log.ranges.push_back({t + 1000, (uint16_t)anchor, range + range_noise(generator)});
+        }
+    }
+
+    return log;
+}
+
+TEST_GROUP (EKFReplayTestGroup) {
+    ekf_replay::Log log = circle_log();
+    ekf_replay::Options options;
+
+    void setup() override
+    {
+        options.range_delay_us = 40000;
+    }
+};
+
+TEST(EKFReplayTestGroup, TracksTheBeacon)
+{
+    auto result = ekf_replay::run(log, options);
+
+    CHECK_EQUAL(5000, result.predictions);
+    CHECK_EQUAL(1000, result.ranges);
+    CHECK_EQUAL(5000, result.error_samples);
+    CHECK_EQUAL(1000, result.delayed_ranges);
+    CHECK_EQUAL(0, result.dropped_ranges);
+
+    /* Including the first seconds, while the heading is found */
+    CHECK(result.rms_error < 0.06);
+
+    /* The estimator starts at rest while the beacon already moves */
+    CHECK(result.max_error < 0.3);
+}
+
+TEST(EKFReplayTestGroup, TracksTheBeaconWithAnUnalignedHeading)
+{
+    auto result = ekf_replay::run(circle_log(M_PI / 2), options);
+
+    CHECK(result.rms_error < 0.06);
+    CHECK(result.max_error < 0.3);
+}
+
+TEST(EKFReplayTestGroup, FusingLateRangesAtTheirTimestampIsMoreAccurate)
+{
+    auto delayed = ekf_replay::run(log, options);
+
+    options.fuse_at_arrival = true;
+    auto at_arrival = ekf_replay::run(log, options);
+
+    CHECK_EQUAL(0, at_arrival.delayed_ranges);
+    CHECK(delayed.rms_error < at_arrival.rms_error);
+}
+
+TEST(EKFReplayTestGroup, RangesOlderThanTheHistoryAreDropped)
+{
+    options.range_delay_us = 200000;
+
+    auto result = ekf_replay::run(log, options);
+
+    /* Only the first ones, while the history is not full yet, can be used */
+    CHECK_EQUAL(1000, result.dropped_ranges + result.delayed_ranges);
+    CHECK(result.delayed_ranges < 10);
+}
+
+TEST(EKFReplayTestGroup, RangesFromUnknownAnchorsAreIgnored)
+{
+    log.anchors.erase(0);
+
+    auto result = ekf_replay::run(log, options);
+
+    CHECK_EQUAL(750, result.ranges);
+}
+
+TEST(EKFReplayTestGroup, LoadsCSVLogs)
+{
+    char ranges[] = "/tmp/ekf_replay_rangesXXXXXX";
+    char imu[] = "/tmp/ekf_replay_imuXXXXXX";
+    char anchors[] = "/tmp/ekf_replay_anchorsXXXXXX";
+    FILE* f;
+
+    f = fdopen(mkstemp(ranges), "w");
+    fprintf(f, "ts,anchor_addr,range\n1000,42,1.5\n21000,43,2.5\n");
+    fclose(f);
+
+    f = fdopen(mkstemp(imu), "w");
+    fprintf(f, "ts,acc_x,acc_y,acc_z\n0,0.1,0.2,9.8\n");
+    fprintf(f, "4000,0.1,0.2,9.8,0.7071,0,0,0.7071\n");
+    fclose(f);
+
+    f = fdopen(mkstemp(anchors), "w");
+    fprintf(f, "anchor_addr,x,y,z\n42,1,2,3\n");
+    fclose(f);
+
+    ekf_replay::Log loaded;
+    bool ok = ekf_replay::load(loaded, ranges, imu, anchors, "");
+
+    remove(ranges);
+    remove(imu);
+    remove(anchors);
+
+    CHECK_TRUE(ok);
+    CHECK_EQUAL(2, loaded.ranges.size());
+    CHECK_EQUAL(21000, loaded.ranges[1].timestamp);
+    CHECK_EQUAL(43, loaded.ranges[1].anchor);
+    DOUBLES_EQUAL(2.5, loaded.ranges[1].range, 1e-6);
+
+    CHECK_EQUAL(2, loaded.imu.size());
+    DOUBLES_EQUAL(9.8, loaded.imu[0].acc[2], 1e-6);
+    DOUBLES_EQUAL(1., loaded.imu[0].q[0], 1e-6);
+    DOUBLES_EQUAL(0.7071, loaded.imu[1].q[3], 1e-6);
+
+    CHECK_EQUAL(1, loaded.anchors.size());
+    DOUBLES_EQUAL(3., loaded.anchors[42].z, 1e-6);
+    CHECK_TRUE(loaded.truth.empty());
+}
+
+TEST(EKFReplayTestGroup, MissingLogFails)
+{
+    ekf_replay::Log loaded;
+
+    CHECK_FALSE(ekf_replay::load(loaded, "/nonexistent", "/nonexistent", "/nonexistent", ""));
+}
@@ -1,3 +1,4 @@
+#include <cmath>
 #include "state_estimation.hpp"
 #include <CppUTest/TestHarness.h>
 #include <CppUTestExt/MockSupport.h>
@@ -21,42 +22,78 @@ TEST(StateEstimationTestGroup, PositionSetter)
 TEST(StateEstimationTestGroup, CanInputRadio)
 {
     RadioPositionEstimator est;
-    const float anchor_pos[2] = {1., 1};
+    const float anchor_pos[3] = {1., 1., 0.};
     const float distance = 1.;
-    est.processDistanceMeasurement(anchor_pos, distance);
+    est.processDistanceMeasurement(0, anchor_pos, distance);
 }
 
 TEST(StateEstimationTestGroup, CanPredict)
 {
     RadioPositionEstimator est;
+    const float acc[3] = {0., 0., 0.};
     float x, y, z;
 
     est.setPosition(10, 20, 30);
-    est.predict();
+    est.predict(0, acc);
+    est.predict(10000, acc);
     std::tie(x, y, z) = est.getPosition();
     CHECK_EQUAL(10, x);
     CHECK_EQUAL(20, y);
     CHECK_EQUAL(30, z);
 }
 
+TEST(StateEstimationTestGroup, PredictionIntegratesAcceleration)
+{
+    RadioPositionEstimator est;
+    const float acc[3] = {1., 0., -2.};
+
+    est.setPosition(10, 20, 30);
+    for (int i = 0; i <= 250; i++) {
+        est.predict(i * 4000, acc);
+    }
+
+    DOUBLES_EQUAL(10.5, est.state[0], 1e-3);
+    DOUBLES_EQUAL(20., est.state[1], 1e-3);
+    DOUBLES_EQUAL(29., est.state[2], 1e-3);
+    DOUBLES_EQUAL(1., est.state[3], 1e-3);
+    DOUBLES_EQUAL(0., est.state[4], 1e-3);
+    DOUBLES_EQUAL(-2., est.state[5], 1e-3);
+}
+
+TEST(StateEstimationTestGroup, PredictionIncreasesUncertainty)
+{
+    RadioPositionEstimator est;
+    const float acc[3] = {0., 0., 0.};
+
+    float before = est.covariance(0, 0);
+    est.predict(0, acc);
+    est.predict(100000, acc);
+
+    CHECK(est.covariance(0, 0) > before);
+}
+
 TEST(StateEstimationTestGroup, Converges)
 {
     RadioPositionEstimator est;
     const float distance = 1.;
+    const float acc[3] = {0., 0., 0.};
     const float anchor1_pos[3] = {1., 2, 1};
     const float anchor2_pos[3] = {3., 2, 1};
     const float anchor3_pos[3] = {2., 1, 1};
-    const float anchor4_pos[3] = {2., 3, 1};
+    /* Above the beacon, as the height cannot be observed with all the anchors
+     * in its plane: the range only changes quadratically with it. */
+    const float anchor4_pos[3] = {2., 2, 2};
+    uint32_t t = 0;
 
     for (int i = 0; i < 100; i++) {
-        est.predict();
-        est.processDistanceMeasurement(anchor1_pos, distance);
-        est.predict();
-        est.processDistanceMeasurement(anchor2_pos, distance);
-        est.predict();
-        est.processDistanceMeasurement(anchor3_pos, distance);
-        est.predict();
-        est.processDistanceMeasurement(anchor4_pos, distance);
+        est.predict(t += 1000, acc);
+        est.processDistanceMeasurement(t, anchor1_pos, distance);
+        est.predict(t += 1000, acc);
+        est.processDistanceMeasurement(t, anchor2_pos, distance);
+        est.predict(t += 1000, acc);
+        est.processDistanceMeasurement(t, anchor3_pos, distance);
+        est.predict(t += 1000, acc);
+        est.processDistanceMeasurement(t, anchor4_pos, distance);
     }
 
     float x, y, z;
@@ -66,9 +103,150 @@ TEST(StateEstimationTestGroup, Converges)
     DOUBLES_EQUAL(1., z, 0.1);
 }
 
+TEST(StateEstimationTestGroup, CovarianceStaysSymmetricAndPositive)
+{
+    RadioPositionEstimator est;
+    const float acc[3] = {0.1, -0.2, 0.};
+    const float anchors[4][3] = {{0, 0, 2}, {3, 0, 0}, {3, 2, 2}, {0, 2, 0}};
+
+    for (int i = 0; i < 1000; i++) {
+        est.predict(i * 4000, acc);
+        est.processDistanceMeasurement(i * 4000, anchors[i % 4], 1.5);
+    }
+
+    auto& P = est.covariance;
+    CHECK((P - P.transpose()).cwiseAbs().maxCoeff() < 1e-6);
+
+    Eigen::SelfAdjointEigenSolver<RadioPositionEstimator::Covariance> eigen(P);
+    CHECK(eigen.eigenvalues().minCoeff() > 0);
+}
+
+TEST(StateEstimationTestGroup, LateRangeIsFusedAtItsTimestamp)
+{
+    RadioPositionEstimator in_order, late;
+    const float acc[3] = {0.5, 0., 0.};
+    const float anchor[3] = {3., 2., 1.};
+
+    for (int i = 0; i < 10; i++) {
+        in_order.predict(i * 4000, acc);
+        late.predict(i * 4000, acc);
+
+        if (i == 3) {
+            in_order.processDistanceMeasurement(14000, anchor, 2.);
+        }
+    }
+
+    late.processDistanceMeasurement(14000, anchor, 2.);
+
+    CHECK_EQUAL(1, late.delayedMeasurements);
+    CHECK_EQUAL(0, in_order.delayedMeasurements);
+    for (int i = 0; i < 6; i++) {
+        DOUBLES_EQUAL(in_order.state[i], late.state[i], 1e-5);
+        for (int j = 0; j < 6; j++) {
+            DOUBLES_EQUAL(in_order.covariance(i, j), late.covariance(i, j), 1e-5);
+        }
+    }
+}
+
+TEST(StateEstimationTestGroup, RangeOlderThanTheHistoryIsDropped)
+{
+    RadioPositionEstimator est;
+    const float acc[3] = {0., 0., 0.};
+    const float anchor[3] = {3., 2., 1.};
+
+    for (int i = 0; i < 2 * RadioPositionEstimator::HISTORY_LENGTH; i++) {
+        est.predict(1000 + i * 4000, acc);
+    }
+
+    RadioPositionEstimator::State before = est.state;
+    est.processDistanceMeasurement(0, anchor, 10.);
+
+    CHECK_EQUAL(1, est.droppedMeasurements);
+    CHECK(before == est.state);
+}
+
+TEST(StateEstimationTestGroup, TimestampsCanOverflow)
+{
+    RadioPositionEstimator est;
+    const float acc[3] = {1., 0., 0.};
+
+    est.setPosition(0, 0, 0);
+    est.predict(UINT32_MAX - 49999, acc);
+    est.predict(50000, acc);
+
+    DOUBLES_EQUAL(0.1, est.state[3], 1e-4);
+}
+
 TEST(StateEstimationTestGroup, SetVariance)
 {
     RadioPositionEstimator est;
     est.processVariance = 0.3;
     est.measurementVariance = 0.3;
 }
+
+TEST(StateEstimationTestGroup, AccelerationAtRestIsZeroInWorld)
+{
+    const float q[4] = {1., 0., 0., 0.};
+    const float body[3] = {0., 0., 9.81};
+    float world[3];
+
+    imu_acceleration_to_world(q, body, world);
+
+    DOUBLES_EQUAL(0., world[0], 1e-5);
+    DOUBLES_EQUAL(0., world[1], 1e-5);
+    DOUBLES_EQUAL(0., world[2], 1e-5);
+}
+
+TEST(StateEstimationTestGroup, AccelerationIsRotatedToWorld)
+{
+    /* Yawed by 90 degrees */
+    const float q[4] = {0.70710678, 0., 0., 0.70710678};
+    const float body[3] = {1., 0., 9.81};
+    float world[3];
+
+    imu_acceleration_to_world(q, body, world);
+
+    DOUBLES_EQUAL(0., world[0], 1e-5);
+    DOUBLES_EQUAL(1., world[1], 1e-5);
+    DOUBLES_EQUAL(0., world[2], 1e-5);
+}
+
+TEST(StateEstimationTestGroup, AccelerationIsRotatedByTheHeading)
+{
+    RadioPositionEstimator est;
+    const float acc[3] = {1., 0., 0.};
+
+    est.setPosition(0, 0, 0);
+    est.state(RadioPositionEstimator::YAW) = M_PI / 2;
+    est.predict(0, acc);
+    est.predict(100000, acc);
+
+    DOUBLES_EQUAL(0., est.state[3], 1e-4);
+    DOUBLES_EQUAL(0.1, est.state[4], 1e-4);
+}
+
+TEST(StateEstimationTestGroup, HeadingUncertaintyGrowsWithTheAcceleration)
+{
+    RadioPositionEstimator est;
+    const float acc[3] = {1., 0., 0.};
+
+    est.predict(0, acc);
+    est.predict(100000, acc);
+
+    /* The velocity is then correlated with the heading, so that ranges can
+     * correct it */
+    CHECK(std::abs(est.covariance(4, RadioPositionEstimator::YAW)) > 0.01);
+    CHECK(est.covariance(4, 4) > est.covariance(3, 3));
+}
+
+TEST(StateEstimationTestGroup, HeadingIsNotCorrelatedAtRest)
+{
+    RadioPositionEstimator est;
+    const float acc[3] = {0., 0., 0.};
+
+    est.predict(0, acc);
+    est.predict(100000, acc);
+
+    DOUBLES_EQUAL(0., est.covariance(3, RadioPositionEstimator::YAW), 1e-6);
+    DOUBLES_EQUAL(0., est.covariance(4, RadioPositionEstimator::YAW), 1e-6);
+}
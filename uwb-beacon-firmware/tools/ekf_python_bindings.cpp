@@ -2,14 +2,14 @@
 
 static RadioPositionEstimator estimator;
 
-extern "C" void estimator_predict(void)
+extern "C" void estimator_predict(uint32_t timestamp, float acc[3])
 {
-    estimator.predict();
+    estimator.predict(timestamp, acc);
 }
 
-extern "C" void estimator_process_distance_measurement(float pos[2], float distance)
+extern "C" void estimator_process_distance_measurement(uint32_t timestamp, float pos[3], float distance)
 {
-    estimator.processDistanceMeasurement(pos, distance);
+    estimator.processDistanceMeasurement(timestamp, pos, distance);
 }
 
 extern "C" float estimator_get_x(void)
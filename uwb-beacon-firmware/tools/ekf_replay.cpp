@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include "state_estimation.hpp"
+#include "ekf_replay.hpp"
+
+namespace ekf_replay {
+
+/* Reads the numbers of each line after the header */
+static bool read_csv(const std::string& path, std::vector<std::vector<double>>& rows)
+{
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    std::string line;
+    std::getline(file, line);
+
+    while (std::getline(file, line)) {
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream fields(line);
+        std::vector<double> row;
+        double value;
+        while (fields >> value) {
+            row.push_back(value);
+        }
+        if (!row.empty()) {
+            rows.push_back(row);
+        }
+    }
+    return true;
+}
+
+bool load(Log& log,
+          const std::string& ranges,
+          const std::string& imu,
+          const std::string& anchors,
+          const std::string& truth)
+{
+    std::vector<std::vector<double>> rows;
+
+    if (!read_csv(ranges, rows)) {
+        return false;
+    }
+    for (auto& r : rows) {
+        if (r.size() >= 3) {
+            log.ranges.push_back({(uint32_t)r[0], (uint16_t)r[1], (float)r[2]});
+        }
+    }
+
+    rows.clear();
+    if (!read_csv(imu, rows)) {
+        return false;
+    }
+    for (auto& r : rows) {
+        if (r.size() >= 4) {
+            Imu sample = {(uint32_t)r[0], {(float)r[1], (float)r[2], (float)r[3]}, {1, 0, 0, 0}};
+            if (r.size() >= 8) {
+                for (int i = 0; i < 4; i++) {
+                    sample.q[i] = r[4 + i];
+                }
+            }
+            log.imu.push_back(sample);
+        }
+    }
+
+    rows.clear();
+    if (!read_csv(anchors, rows)) {
+        return false;
+    }
+    for (auto& r : rows) {
+        if (r.size() >= 4) {
+            log.anchors[(uint16_t)r[0]] = {0, (float)r[1], (float)r[2], (float)r[3]};
+        }
+    }
+
+    if (!truth.empty()) {
+        rows.clear();
+        if (!read_csv(truth, rows)) {
+            return false;
+        }
+        for (auto& r : rows) {
+            if (r.size() >= 4) {
+                log.truth.push_back({(uint32_t)r[0], (float)r[1], (float)r[2], (float)r[3]});
+            }
+        }
+    }
+
+    return true;
+}
+
+/* Linear interpolation of the truth, false outside of it */
+static bool truth_at(const std::vector<Position>& truth, uint32_t t, Position& p)
+{
+    auto after = std::lower_bound(truth.begin(), truth.end(), t,
+                                  [](const Position& sample, uint32_t time) { return sample.timestamp < time; });
+    if (after == truth.end() || (after == truth.begin() && after->timestamp != t)) {
+        return false;
+    }
+    if (after->timestamp == t) {
+        p = *after;
+        return true;
+    }
+
+    auto before = after - 1;
+    float f = float(t - before->timestamp) / (after->timestamp - before->timestamp);
+    p.timestamp = t;
+    p.x = before->x + f * (after->x - before->x);
+    p.y = before->y + f * (after->y - before->y);
+    p.z = before->z + f * (after->z - before->z);
+    return true;
+}
+
+Result run(const Log& log, const Options& options)
+{
+    using clock = std::chrono::steady_clock;
+
+    struct Event {
+        uint32_t arrival;
+        const Range* range;
+        const Imu* imu;
+    };
+
+    /* Messages in the order the estimator thread would get them, IMU first
+     * when they arrive together */
+    std::vector<Event> events;
+    for (auto& imu : log.imu) {
+        events.push_back({imu.timestamp, nullptr, &imu});
+    }
+    for (auto& range : log.ranges) {
+        events.push_back({range.timestamp + options.range_delay_us, &range, nullptr});
+    }
+    std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+        return a.arrival < b.arrival;
+    });
+
+    RadioPositionEstimator estimator;
+    estimator.processVariance = options.process_variance;
+    estimator.measurementVariance = options.measurement_variance;
+    if (!log.truth.empty()) {
+        estimator.setPosition(log.truth[0].x, log.truth[0].y, log.truth[0].z);
+    }
+
+    Result result;
+    double squared_error = 0;
+
+    for (auto& event : events) {
+        if (event.range) {
+            auto anchor = log.anchors.find(event.range->anchor);
+            if (anchor == log.anchors.end()) {
+                continue;
+            }
+
+            const float position[3] = {anchor->second.x, anchor->second.y, anchor->second.z};
+            uint32_t timestamp = options.fuse_at_arrival ? event.arrival : event.range->timestamp;
+
+            auto start = clock::now();
+            estimator.processDistanceMeasurement(timestamp, position, event.range->range);
+            double us = std::chrono::duration<double, std::micro>(clock::now() - start).count();
+
+            result.ranges++;
+            result.range_mean_us += us;
+            result.range_max_us = std::max(result.range_max_us, us);
+        } else {
+            float acc[3];
+            imu_acceleration_to_world(event.imu->q, event.imu->acc, acc);
+
+            auto start = clock::now();
+            estimator.predict(event.imu->timestamp, acc);
+            double us = std::chrono::duration<double, std::micro>(clock::now() - start).count();
+
+            result.predictions++;
+            result.prediction_mean_us += us;
+            result.prediction_max_us = std::max(result.prediction_max_us, us);
+
+            Position truth;
+            if (truth_at(log.truth, event.imu->timestamp, truth)) {
+                float error = std::sqrt(std::pow(estimator.state[0] - truth.x, 2)
+                                        + std::pow(estimator.state[1] - truth.y, 2)
+                                        + std::pow(estimator.state[2] - truth.z, 2));
+                squared_error += error * error;
+                result.max_error = std::max(result.max_error, error);
+                result.error_samples++;
+            }
+        }
+    }
+
+    if (result.error_samples > 0) {
+        result.rms_error = std::sqrt(squared_error / result.error_samples);
+    }
+    if (result.predictions > 0) {
+        result.prediction_mean_us /= result.predictions;
+    }
+    if (result.ranges > 0) {
+        result.range_mean_us /= result.ranges;
+    }
+    result.delayed_ranges = estimator.delayedMeasurements;
+    result.dropped_ranges = estimator.droppedMeasurements;
+
+    return result;
+}
+
+} // namespace ekf_replay
@@ -0,0 +1,86 @@
+#ifndef EKF_REPLAY_HPP
+#define EKF_REPLAY_HPP
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/** Replays recorded /range and /imu topics through RadioPositionEstimator,
+ * on the host, to compare its output with a ground truth and measure how long
+ * each update takes. */
+namespace ekf_replay {
+
+struct Range {
+    uint32_t timestamp; ///< us
+    uint16_t anchor;
+    float range; ///< m
+};
+
+struct Imu {
+    uint32_t timestamp; ///< us
+    float acc[3]; ///< Body frame, m/s^2
+    float q[4]; ///< Attitude from the AHRS, w x y z
+};
+
+struct Position {
+    uint32_t timestamp; ///< us
+    float x, y, z; ///< m
+};
+
+struct Log {
+    std::vector<Range> ranges;
+    std::vector<Imu> imu;
+    std::map<uint16_t, Position> anchors;
+    std::vector<Position> truth; ///< Optional
+};
+
+/** Loads the logs from CSV files with a header line:
+ *
+ * - ranges: ts,anchor_addr,range, as written by tools/read_range.py
+ * - imu: ts,acc_x,acc_y,acc_z and optionally q_w,q_x,q_y,q_z
+ * - anchors: anchor_addr,x,y,z
+ * - truth: ts,x,y,z, can be empty
+ *
+ * Returns false if a file cannot be read.
+ */
+bool load(Log& log,
+          const std::string& ranges,
+          const std::string& imu,
+          const std::string& anchors,
+          const std::string& truth);
+
+struct Options {
+    /** Time between a range measurement and its arrival at the estimator */
+    uint32_t range_delay_us = 0;
+
+    /** Fuse the ranges at the time they arrive, as the estimator used to do,
+     * instead of the time they were measured. */
+    bool fuse_at_arrival = false;
+
+    /** Process noise of the estimator, see RadioPositionEstimator */
+    float process_variance = 1.f;
+    float measurement_variance = 0.05f * 0.05f;
+};
+
+struct Result {
+    /** Position error after each IMU sample, against the interpolated truth */
+    int error_samples = 0;
+    float rms_error = 0; ///< m
+    float max_error = 0; ///< m
+
+    /** Host CPU time spent in each kind of update */
+    int predictions = 0, ranges = 0;
+    double prediction_mean_us = 0, prediction_max_us = 0;
+    double range_mean_us = 0, range_max_us = 0;
+
+    uint32_t delayed_ranges = 0, dropped_ranges = 0;
+};
+
+/** Feeds the log to an estimator in the order the messages arrive, starting
+ * from the first truth position if there is one. */
+Result run(const Log& log, const Options& options);
+
+} // namespace ekf_replay
+
+#endif
@@ -0,0 +1,48 @@
+#include <cstdio>
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/flags/usage.h"
+#include "ekf_replay.hpp"
+
+ABSL_FLAG(std::string, ranges, "ranges.csv", "Ranges, as written by read_range.py (ts,anchor_addr,range)");
+ABSL_FLAG(std::string, imu, "imu.csv", "IMU samples (ts,acc_x,acc_y,acc_z[,q_w,q_x,q_y,q_z])");
+ABSL_FLAG(std::string, anchors, "anchors.csv", "Anchor positions (anchor_addr,x,y,z)");
+ABSL_FLAG(std::string, truth, "", "Optional ground truth (ts,x,y,z), to report the accuracy");
+ABSL_FLAG(int, range_delay_us, 0, "Delay added between the measurement of a range and its arrival");
+ABSL_FLAG(bool, fuse_at_arrival, false, "Fuse ranges when they arrive instead of when they were measured");
+ABSL_FLAG(double, process_variance, 1., "Variance of the acceleration noise [m^2/s^4]");
+ABSL_FLAG(double, measurement_variance, 0.05 * 0.05, "Variance of the ranges [m^2]");
+
+int main(int argc, char** argv)
+{
+    absl::SetProgramUsageMessage("Replays recorded /range and /imu logs through the UWB position estimator.");
+    absl::ParseCommandLine(argc, argv);
+
+    ekf_replay::Log log;
+    if (!ekf_replay::load(log,
+                          absl::GetFlag(FLAGS_ranges),
+                          absl::GetFlag(FLAGS_imu),
+                          absl::GetFlag(FLAGS_anchors),
+                          absl::GetFlag(FLAGS_truth))) {
+        fprintf(stderr, "Could not read the logs\n");
+        return 1;
+    }
+
+    ekf_replay::Options options;
+    options.range_delay_us = absl::GetFlag(FLAGS_range_delay_us);
+    options.fuse_at_arrival = absl::GetFlag(FLAGS_fuse_at_arrival);
+    options.process_variance = absl::GetFlag(FLAGS_process_variance);
+    options.measurement_variance = absl::GetFlag(FLAGS_measurement_variance);
+
+    auto result = ekf_replay::run(log, options);
+
+    printf("%d IMU samples, %d ranges (%u fused late, %u dropped)\n",
+           result.predictions, result.ranges, result.delayed_ranges, result.dropped_ranges);
+    if (result.error_samples > 0) {
+        printf("error: rms %.3f m, max %.3f m\n", result.rms_error, result.max_error);
+    }
+    printf("prediction: mean %.2f us, max %.2f us\n", result.prediction_mean_us, result.prediction_max_us);
+    printf("range: mean %.2f us, max %.2f us\n", result.range_mean_us, result.range_max_us);
+
+    return 0;
+}
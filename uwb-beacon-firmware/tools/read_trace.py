@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+"""
+Records the trace rings streamed by the beacon's trace_stream shell command.
+
+The dump can then be converted with tools/trace_to_chrome.py.
+"""
+
+import argparse
+import time
+import serial
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("port", help="Serial port of the beacon shell")
+    parser.add_argument(
+        "--output",
+        "-o",
+        help="Binary dump file",
+        type=argparse.FileType("wb"),
+        required=True,
+    )
+    parser.add_argument(
+        "--duration",
+        "-d",
+        help="Recording duration in seconds (default: 5)",
+        type=int,
+        default=5,
+    )
+
+    return parser.parse_args()
+
+
+def main():
+    args = parse_args()
+
+    with serial.Serial(args.port, timeout=1) as port:
+        port.reset_input_buffer()
+        port.write("trace_stream {}\r\n".format(args.duration).encode())
+
+        # Nothing is sent while no event is traced, so wait for the duration
+        # to elapse, then until the end of the dump and the shell prompt.
+        deadline = time.monotonic() + args.duration + 1
+        data = b""
+        while True:
+            chunk = port.read(4096)
+            if not chunk and time.monotonic() > deadline:
+                break
+            data += chunk
+
+    start = data.find(b"CVTR")
+    if start < 0:
+        raise RuntimeError("No trace dump received")
+
+    args.output.write(data[start:])
+
+
+if __name__ == "__main__":
+    main()